@@ -36,6 +36,7 @@ typedef enum {
     AST_IF,
     AST_RESULT,
     AST_WHERE,
+    AST_NOT,
     
     AST_FOR_EACH,
     AST_FOR_RANGE,
@@ -64,6 +65,14 @@ typedef enum {
     OP_POW, OP_ABS, OP_MIN, OP_MAX, OP_SQRT
 } OpType;
 
+/* Relation attributes (REL name SORTED) */
+#define REL_ATTR_SORTED 0x01u       /* Sorted-array storage */
+#define REL_ATTR_HASH   0x02u       /* Hash storage */
+#define REL_ATTR_EQUIVALENCE 0x04u  /* Union-find storage of an equivalence */
+#define REL_ATTR_SYMMETRIC 0x08u    /* Each unordered pair stored once */
+
+#define REL_ATTR_STORAGE (REL_ATTR_SORTED | REL_ATTR_HASH | REL_ATTR_EQUIVALENCE)
+
 /* ─────────────────────────────────────────────────────────────────────────
  * AST Node Structure
  * ───────────────────────────────────────────────────────────────────────── */
@@ -78,9 +87,12 @@ typedef struct ASTNode {
             struct ASTNode *statements;
         } program;
         
-        /* REL declaration: REL name */
+        /* REL declaration: REL name [attribute...] [SIZE n] [DOMAIN n] */
         struct {
             char *name;
+            unsigned int attributes;    /* REL_ATTR_* flags */
+            int size_hint;              /* Expected facts, 0 = none */
+            int domain_hint;            /* Expected distinct values, 0 = none */
         } rel_decl;
         
         /* Fact: FACT relation a b */
@@ -106,10 +118,12 @@ typedef struct ASTNode {
             int match_var;              /* Only valid if has_match */
         } scan;
         
-        /* Join: JOIN relation var */
+        /* Join: JOIN relation var [var] */
         struct {
             char *relation;
             int match_var;
+            bool has_bind;
+            int bind_var;               /* Only valid if has_bind */
         } join;
         
         /* Emit: EMIT relation var_a var_b */
@@ -174,6 +188,11 @@ typedef struct ASTNode {
             struct ASTNode *condition;
         } where;
         
+        /* Negated body operation: NOT SCAN ... / NOT JOIN ... */
+        struct {
+            struct ASTNode *operation;
+        } negation;
+        
         /* FOR-EACH: FOR var IN (QUERY ...) */
         struct {
             int var;                    /* Loop variable */
@@ -262,6 +281,10 @@ ASTNode* ast_make_program(ASTNode *statements);
 /* Create relation declaration */
 ASTNode* ast_make_rel_decl(const char *name, int line, int column);
 
+/* Create relation declaration with REL_ATTR_* attributes */
+ASTNode* ast_make_rel_decl_with_attributes(const char *name, unsigned int attributes,
+                                           int line, int column);
+
 /* Create fact */
 ASTNode* ast_make_fact(const char *relation, int a, int b, int line, int column);
 
@@ -279,6 +302,9 @@ ASTNode* ast_make_scan(const char *relation, bool has_match, int match_var, int
 /* Create join operation */
 ASTNode* ast_make_join(const char *relation, int match_var, int line, int column);
 
+/* Create join operation with an explicit column B variable */
+ASTNode* ast_make_join_bind(const char *relation, int match_var, int bind_var, int line, int column);
+
 /* Create emit operation */
 ASTNode* ast_make_emit(const char *relation, int var_a, int var_b, int line, int column);
 
@@ -314,6 +340,9 @@ ASTNode* ast_make_result(ASTNode *expr, int line, int column);
 /* Create WHERE clause */
 ASTNode* ast_make_where(ASTNode *condition, int line, int column);
 
+/* Create negated body operation */
+ASTNode* ast_make_not(ASTNode *operation, int line, int column);
+
 /* Create FOR-EACH loop */
 ASTNode* ast_make_for_each(int var, ASTNode *query, ASTNode *body, int line, int column);
 
@@ -427,6 +456,7 @@ typedef struct ASTVisitor {
     void (*visit_expr_binop)(const ASTNode *node, void *context);
     void (*visit_expr_unary)(const ASTNode *node, void *context);
     void (*visit_condition)(const ASTNode *node, void *context);
+    void (*visit_not)(const ASTNode *node, void *context);
 } ASTVisitor;
 
 /* Walk AST tree with visitor pattern */
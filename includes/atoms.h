@@ -18,16 +18,21 @@
  * Atom Table Structure
  * ───────────────────────────────────────────────────────────────────────── */
 
+/* Initial bucket count; the table doubles once it holds as many atoms */
 #define ATOM_TABLE_SIZE 1024
 
 typedef struct AtomEntry {
     char *name;                 /* Atom name (malloc'd) */
     int id;                     /* Unique integer ID */
+    unsigned int hash;          /* Full hash of name, kept for resizing */
     struct AtomEntry *next;     /* Hash collision chain */
 } AtomEntry;
 
 typedef struct AtomTable {
-    AtomEntry *buckets[ATOM_TABLE_SIZE];
+    AtomEntry **buckets;        /* bucket_count chains, NULL until first intern */
+    int bucket_count;           /* Power of two */
+    AtomEntry **by_id;          /* Entries indexed by ID */
+    int by_id_capacity;
     int next_id;                /* Next ID to assign */
     int count;                  /* Number of atoms */
 } AtomTable;
@@ -0,0 +1,122 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bytelog.h - ByteLog Embedding API
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * The interface of libbytelog.a and libbytelog.so for programs that keep
+ * a solved database in-process instead of running the bytelogic binary.
+ * Handles are opaque and this header includes no other ByteLog header,
+ * so the engine's structures can change without breaking callers.
+ *
+ *     ByteLog *db = bytelog_create();
+ *     bytelog_load_source(db, "REL parent\nFACT parent alice bob\n...");
+ *     bytelog_solve(db);
+ *
+ *     ByteLogResults *results = bytelog_query(db, "ancestor", "alice", NULL);
+ *     int a, b;
+ *     while (bytelog_results_next(results, &a, &b)) {
+ *         printf("%s\n", bytelog_atom_name(db, b));
+ *     }
+ *     bytelog_results_free(results);
+ *     bytelog_free(db);
+ *
+ * A handle is not thread safe; separate handles are independent.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_BYTELOG_H
+#define BYTELOG_BYTELOG_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Symbols the shared library exports; everything else is hidden */
+#if defined(__GNUC__)
+#define BYTELOG_API __attribute__((visibility("default")))
+#else
+#define BYTELOG_API
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Handles
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Wildcard for the atom ID functions */
+#define BYTELOG_ANY (-1)
+
+typedef struct ByteLog ByteLog;
+typedef struct ByteLogResults ByteLogResults;
+
+/* Create an empty database, NULL when out of memory */
+BYTELOG_API ByteLog* bytelog_create(void);
+
+/* Free a database; its results must be freed first */
+BYTELOG_API void bytelog_free(ByteLog *db);
+
+/* Message of the last failed call */
+BYTELOG_API const char* bytelog_error(const ByteLog *db);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Loading and Solving
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Run ByteLog source: declarations and facts are added, rules are kept for
+ * every later solve, and a SOLVE statement solves with all rules loaded so
+ * far.  QUERY statements are ignored. */
+BYTELOG_API bool bytelog_load_source(ByteLog *db, const char *source);
+
+/* bytelog_load_source on the contents of a .bl file */
+BYTELOG_API bool bytelog_load_file(ByteLog *db, const char *path);
+
+/* Load a two-column TSV or CSV file into a relation */
+BYTELOG_API bool bytelog_load_facts(ByteLog *db, const char *relation, const char *path);
+
+/* Add one fact; arguments are atom names or integer literals */
+BYTELOG_API bool bytelog_insert(ByteLog *db, const char *relation, const char *a, const char *b);
+
+/* Derive every fact the loaded rules imply */
+BYTELOG_API bool bytelog_solve(ByteLog *db);
+
+/* Make the database read-only for faster queries; later loads fail */
+BYTELOG_API bool bytelog_freeze(ByteLog *db);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Atoms
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* ID of an atom name or integer literal, creating the atom if needed */
+BYTELOG_API int bytelog_atom(ByteLog *db, const char *name);
+
+/* Name of an atom ID, NULL for a plain integer */
+BYTELOG_API const char* bytelog_atom_name(const ByteLog *db, int id);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Queries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Facts of a relation matching atom names or integer literals, NULL
+ * matching anything.  Returns NULL only on error; no match gives empty
+ * results. */
+BYTELOG_API ByteLogResults* bytelog_query(ByteLog *db, const char *relation,
+                                          const char *a, const char *b);
+
+/* bytelog_query with atom IDs, BYTELOG_ANY matching anything */
+BYTELOG_API ByteLogResults* bytelog_query_ids(ByteLog *db, const char *relation, int a, int b);
+
+/* Number of facts in results */
+BYTELOG_API int bytelog_results_count(const ByteLogResults *results);
+
+/* Store the next fact's atom IDs; false once every fact was returned */
+BYTELOG_API bool bytelog_results_next(ByteLogResults *results, int *a, int *b);
+
+/* Free query results */
+BYTELOG_API void bytelog_results_free(ByteLogResults *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BYTELOG_BYTELOG_H */
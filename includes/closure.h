@@ -0,0 +1,62 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * closure.h - ByteLog Dense Transitive Closure
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Recursive relations whose rules all have one of the shapes
+ *
+ *     RULE r: SCAN base, EMIT r $1 $2                      (base)
+ *     RULE r: SCAN r, JOIN step $1 $2, EMIT r $0 $2        (right-linear)
+ *     RULE r: SCAN step, JOIN r $1 $2, EMIT r $0 $2        (left-linear)
+ *     RULE r: SCAN r, JOIN r $1 $2, EMIT r $0 $2           (non-linear)
+ *
+ * have a closed form: r = left* . r0 . right* (or r0+ when non-linear).
+ * When the atoms involved fit a small domain they are renumbered densely
+ * and the closure is computed over bit-matrix rows, then written back to
+ * the fact database.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_CLOSURE_H
+#define BYTELOG_CLOSURE_H
+
+#include "ast.h"
+#include "engine.h"
+#include <stdbool.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Closure Plan Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define CLOSURE_MAX_INPUTS 8
+
+/* Default atom budget: one 16384 x 16384 bit matrix is 32 MB */
+#define CLOSURE_DEFAULT_MAX_DOMAIN 16384
+
+typedef struct ClosurePlan {
+    const char *target;                         /* Recursive relation */
+    const char *bases[CLOSURE_MAX_INPUTS];      /* Copied into r0 */
+    int base_count;
+    const char *left[CLOSURE_MAX_INPUTS];       /* step(x, y), r(y, z) */
+    int left_count;
+    const char *right[CLOSURE_MAX_INPUTS];      /* r(x, y), step(y, z) */
+    int right_count;
+    bool nonlinear;                             /* r(x, y), r(y, z) */
+} ClosurePlan;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Closure Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Check that every rule emitting target has a closure shape and has at
+ * least one recursive rule.  Names are borrowed from the rule ASTs. */
+bool closure_plan(ClosurePlan *plan, const char *target,
+                  ASTNode *const *rules, int rule_count);
+
+/* Evaluate a plan whose inputs are final.  *applied is false (and nothing
+ * is written) when more than max_domain atoms are involved.  Returns false
+ * when out of memory. */
+bool closure_evaluate(const ClosurePlan *plan, FactDatabase *db,
+                      int max_domain, bool *applied);
+
+#endif /* BYTELOG_CLOSURE_H */
@@ -13,8 +13,13 @@
 
 #include "ast.h"
 #include "atoms.h"
+#include "factset.h"
+#include "frozen.h"
+#include "roaring.h"
+#include "unionfind.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Fact Database Structure
@@ -22,6 +27,13 @@
 
 #define FACT_DATABASE_SIZE 1024
 
+/* Undeclared relations bulk loaded with at least this many facts at once
+ * take sorted storage instead of chaining every fact in the hash table */
+#define FACTDB_BULK_SORTED_FACTS 8192
+
+/* Largest SIZE or DOMAIN hint a relation accepts */
+#define FACTDB_MAX_HINT UNIONFIND_MAX_VALUES
+
 typedef struct Fact {
     char *relation;             /* Relation name */
     int arg_a;                  /* First argument */
@@ -29,10 +41,61 @@ typedef struct Fact {
     struct Fact *next;          /* Hash collision chain */
 } Fact;
 
+/* Physical layout of a relation's facts */
+typedef enum {
+    RELATION_STORAGE_HASH,      /* Chained in the shared fact hash table */
+    RELATION_STORAGE_SORTED,    /* Sorted (arg_a, arg_b) array plus delta */
+    RELATION_STORAGE_EQUIVALENCE, /* Union-find classes, every pair within a class */
+    RELATION_STORAGE_FROZEN     /* Immutable rows in both directions, see factdb_freeze */
+} RelationStorage;
+
+typedef struct FactPair {
+    int arg_a;
+    int arg_b;
+} FactPair;
+
+#define RELATION_TABLE_SIZE 64
+
+/* Adjacency list of a high-degree key, stored as a compressed bitmap */
+typedef struct Posting {
+    int arg_a;                  /* Key */
+    RoaringBitmap values;       /* roaring_encode()d arg_b values */
+} Posting;
+
+typedef struct Relation {
+    char *name;                 /* Relation name */
+    RelationStorage storage;    /* Storage layout */
+    bool declared;              /* Layout fixed by a REL attribute */
+    bool symmetric;             /* Each pair stored once as (min, max) */
+    FactPair *tuples;           /* Sorted, duplicate-free (sorted storage) */
+    int count;                  /* Number of tuples in the array */
+    int capacity;               /* Allocated tuples */
+    Posting *postings;          /* Keys above ROARING_DEGREE_THRESHOLD, by arg_a */
+    int posting_count;          /* Number of postings */
+    int posting_capacity;       /* Allocated postings */
+    int posted;                 /* Facts held in postings */
+    uint64_t *delta;            /* Packed pending inserts, unsorted */
+    int delta_count;            /* Number of pending inserts */
+    int delta_capacity;         /* Allocated pending inserts */
+    FactSet pending;            /* Keys of the pending inserts, NULL table until needed */
+    int pending_indexed;        /* Pending inserts already in that set */
+    UnionFind classes;          /* Equivalence classes (equivalence storage) */
+    FrozenRelation frozen;      /* Both orientations of every fact (frozen storage) */
+    uint64_t version;           /* Database version of the last change to its facts */
+    int size_hint;              /* Expected facts (REL ... SIZE), 0 = unknown */
+    int domain_hint;            /* Expected distinct values (REL ... DOMAIN), 0 = unknown */
+    struct Relation *next;      /* Hash collision chain */
+} Relation;
+
 typedef struct FactDatabase {
     Fact *buckets[FACT_DATABASE_SIZE];
-    int count;                  /* Number of facts */
+    Relation *relations[RELATION_TABLE_SIZE];
+    long count;                 /* Number of facts (merged) */
     int capacity;               /* Total capacity */
+    bool defer_merge;           /* Queries skip merging pending inserts */
+    size_t memory_budget;       /* Bytes before relations spill to disk, 0 = off */
+    bool frozen;                /* Read-only since factdb_freeze */
+    uint64_t version;           /* Bumped by every change to any relation's facts */
 } FactDatabase;
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -49,14 +112,57 @@ typedef struct QueryResult {
  * Execution Engine Structure
  * ───────────────────────────────────────────────────────────────────────── */
 
+/* Evaluation strategy for compiled multi-way rule bodies */
+typedef enum {
+    JOIN_STRATEGY_AUTO,         /* Leapfrog triejoin for cyclic bodies, else pairwise */
+    JOIN_STRATEGY_LEAPFROG,     /* Always worst-case optimal leapfrog triejoin */
+    JOIN_STRATEGY_PAIRWISE      /* Always left-to-right binary joins */
+} JoinStrategy;
+
+/* Defined by epoch.h and querycache.h, which build on this header */
+struct EpochStore;
+struct QueryCache;
+struct QueryCacheStats;
+
 typedef struct ExecutionEngine {
     FactDatabase facts;         /* Fact database */
     AtomTable atoms;            /* Atom table for name resolution */
     char error[512];           /* Error message buffer */
     int error_count;           /* Number of errors encountered */
     bool debug;                /* Debug output flag */
+    JoinStrategy join_strategy; /* Strategy for multi-way rule bodies */
+    int closure_max_domain;     /* Atom budget for dense closures, 0 = off */
+    struct EpochStore *epochs;  /* Receives a snapshot per SOLVE, NULL = off */
+    struct QueryCache *query_cache; /* Answers of engine_query, made on first use */
+    int query_cache_entries;    /* Answers the cache holds, 0 = off */
 } ExecutionEngine;
 
+/* ─────────────────────────────────────────────────────────────────────────
+ * Prepared Query Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Whether a prepared query's argument is supplied at execution */
+typedef enum {
+    QUERY_FREE,                 /* Wildcard, matches any atom */
+    QUERY_BOUND                 /* Atom ID passed to prepared_query_execute */
+} QueryBinding;
+
+/* Access path chosen when a query is prepared */
+typedef enum {
+    QUERY_PLAN_PROBE,           /* Both bound: one membership test */
+    QUERY_PLAN_SEEK,            /* One bound: that column's index */
+    QUERY_PLAN_SCAN             /* Neither bound: every fact */
+} QueryPlan;
+
+typedef struct PreparedQuery {
+    ExecutionEngine *engine;
+    char *relation;
+    QueryBinding binding_a;
+    QueryBinding binding_b;
+    QueryPlan plan;
+    Relation *rel;              /* Looked up until the relation exists */
+} PreparedQuery;
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Engine Functions
  * ───────────────────────────────────────────────────────────────────────── */
@@ -73,9 +179,38 @@ bool engine_execute_program(ExecutionEngine *engine, const ASTNode *program);
 /* Execute a single statement */
 bool engine_execute_statement(ExecutionEngine *engine, const ASTNode *stmt);
 
-/* Answer a query and return results */
+/* Answer a query and return results.  Answers are cached until the
+ * queried relation changes (see querycache.h), except on a frozen
+ * database, which any number of threads may query at once. */
 QueryResult* engine_query(ExecutionEngine *engine, const ASTNode *query);
 
+/* Cache up to max_entries query answers, 0 to stop caching */
+void engine_set_query_cache(ExecutionEngine *engine, int max_entries);
+
+/* Copy the query cache's hit, miss and size counters */
+void engine_query_cache_stats(const ExecutionEngine *engine, struct QueryCacheStats *stats);
+
+/* Answer a batch of queries; results[i] receives what
+ * engine_query(engine, queries[i]) would.  Queries sharing a relation and
+ * binding pattern are answered together: fully bound ones probe as a
+ * group, and ones binding a column the relation has no index on share
+ * one pass over it.  Returns false if a query is invalid or memory runs
+ * out; every results[i] is set either way. */
+bool engine_query_batch(ExecutionEngine *engine, const ASTNode *const *queries, int count,
+                        QueryResult **results);
+
+/* Prepare a query shape over a relation, e.g. ancestor(BOUND, FREE).  The
+ * handle must be freed before the engine is cleaned up. */
+PreparedQuery* engine_prepare_query(ExecutionEngine *engine, const char *relation,
+                                    QueryBinding binding_a, QueryBinding binding_b);
+
+/* Answer a prepared query for atom IDs (see atom_table_intern); arguments
+ * prepared as QUERY_FREE are ignored.  Bypasses the query cache. */
+QueryResult* prepared_query_execute(PreparedQuery *prepared, int arg_a, int arg_b);
+
+/* Free a prepared query */
+void prepared_query_free(PreparedQuery *prepared);
+
 /* Check if engine encountered errors */
 bool engine_has_errors(ExecutionEngine *engine);
 
@@ -88,6 +223,31 @@ const char* engine_get_error(ExecutionEngine *engine);
 /* Set debug mode */
 void engine_set_debug(ExecutionEngine *engine, bool debug);
 
+/* Select how multi-way rule bodies are evaluated */
+void engine_set_join_strategy(ExecutionEngine *engine, JoinStrategy strategy);
+
+/* Set the atom budget for dense bit-matrix closures (0 disables them) */
+void engine_set_closure_domain(ExecutionEngine *engine, int max_atoms);
+
+/* Bound relation memory, spilling past it to temp files in spill_dir
+ * (see factdb_set_memory_budget) */
+void engine_set_memory_budget(ExecutionEngine *engine, size_t bytes, const char *spill_dir);
+
+/* Load a two-column TSV or CSV file into a relation (see factfile_load) */
+bool engine_load_facts(ExecutionEngine *engine, const char *relation, const char *path);
+
+/* Pre-size a relation for `facts` facts over `domain` distinct values
+ * (0 = unknown), see factdb_reserve */
+bool engine_reserve(ExecutionEngine *engine, const char *relation, int facts, int domain);
+
+/* Publish a snapshot to store after every SOLVE and every program, for
+ * readers on other threads (see epoch.h); NULL stops publishing */
+void engine_set_epochs(ExecutionEngine *engine, struct EpochStore *store);
+
+/* Make every relation read-only once solved (see factdb_freeze).  Later
+ * statements other than queries fail. */
+bool engine_freeze(ExecutionEngine *engine);
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Fact Database Functions
  * ───────────────────────────────────────────────────────────────────────── */
@@ -101,20 +261,105 @@ void factdb_cleanup(FactDatabase *db);
 /* Add fact to database */
 bool factdb_add_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b);
 
+/* Add fact, returns 1 if new, 0 if already present, -1 on error.
+ * Sorted relations buffer the fact until the next merge. */
+int factdb_insert(FactDatabase *db, const char *relation, int arg_a, int arg_b);
+
+/* Add facts as factdb_insert would, looking them up in prefetched groups
+ * so the cache misses of independent probes overlap.  inserted[i], when
+ * given, receives the result for pairs[i].  Returns the number of new
+ * facts, or -1 on error. */
+int factdb_insert_batch(FactDatabase *db, const char *relation, const FactPair *pairs,
+                        int count, int *inserted);
+
+/* Append base facts without per-fact duplicate checks: sorted relations
+ * take them as pending inserts that the next merge sorts, deduplicates
+ * and indexes in one pass.  Other layouts insert them as
+ * factdb_insert_batch would. */
+bool factdb_bulk_load(FactDatabase *db, const char *relation, const FactPair *pairs, int count);
+
+/* Record capacity hints for a relation and allocate for them: sorted
+ * relations reserve their postings and size their first pending buffer
+ * from the hint (within a bound) once an insert needs it, equivalence
+ * relations reserve classes for `domain` values, and an undeclared
+ * relation expecting at least FACTDB_BULK_SORTED_FACTS takes sorted
+ * storage as a bulk load would.  Hints of 0 are unknown and existing
+ * hints only grow; hints above FACTDB_MAX_HINT are refused. */
+bool factdb_reserve(FactDatabase *db, const char *relation, int facts, int domain);
+
+/* Remove a fact, returns 1 if it was present, 0 if not, -1 on error.
+ * Facts derived from it stay until rules are solved again from scratch.
+ * Equivalence relations cannot drop a single pair and always fail. */
+int factdb_retract(FactDatabase *db, const char *relation, int arg_a, int arg_b);
+
 /* Check if fact exists in database */
 bool factdb_has_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b);
 
+/* Check if fact exists without merging pending inserts (which it does not
+ * see) or compressing union-find paths, so threads may call it together
+ * while nothing writes */
+bool factdb_contains(const FactDatabase *db, const char *relation, int arg_a, int arg_b);
+
 /* Query facts matching pattern (wildcards = -1) */
 QueryResult* factdb_query(FactDatabase *db, const char *relation, int arg_a, int arg_b);
 
+/* Query a frozen relation's facts matching pattern (wildcards = -1) */
+QueryResult* factdb_query_frozen(const FrozenRelation *frozen, int arg_a, int arg_b);
+
 /* Get all facts for a relation */
 QueryResult* factdb_get_all(FactDatabase *db, const char *relation);
 
 /* Print all facts (for debugging) */
 void factdb_print(const FactDatabase *db, const AtomTable *atoms);
 
-/* Get fact count */
-int factdb_count(const FactDatabase *db);
+/* Get fact count (pending inserts are counted once merged) */
+long factdb_count(const FactDatabase *db);
+
+/* Number of pairs stored for a relation, before symmetric expansion and
+ * without pending inserts.  Frozen relations store both orientations. */
+long factdb_relation_size(const FactDatabase *db, const char *relation);
+
+/* Set a relation's storage layout, converting existing facts.
+ * Undeclared requests never override a declared layout. */
+bool factdb_set_storage(FactDatabase *db, const char *relation,
+                        RelationStorage storage, bool declared);
+
+/* Version of a relation's facts: it changes whenever a fact is added or
+ * removed (pending inserts included), 0 for a relation never written */
+uint64_t factdb_relation_version(const FactDatabase *db, const char *relation);
+
+/* Get a relation's storage layout */
+RelationStorage factdb_get_storage(const FactDatabase *db, const char *relation);
+
+/* Store a relation symmetrically: every fact also holds reversed, and
+ * each pair is kept once in its (min, max) orientation */
+bool factdb_set_symmetric(FactDatabase *db, const char *relation);
+
+/* Check if a relation is stored symmetrically */
+bool factdb_is_symmetric(const FactDatabase *db, const char *relation);
+
+/* Sort pending inserts into their relations, returns facts added or -1 */
+int factdb_merge(FactDatabase *db);
+
+/* Keep relation memory within `bytes` (0 = unlimited).  New relations are
+ * then stored sorted, and arrays past the budget are mapped from temp
+ * files in spill_dir (NULL for $TMPDIR or /tmp) that the kernel pages out
+ * under pressure.  The spill budget is shared by the whole process. */
+void factdb_set_memory_budget(FactDatabase *db, size_t bytes, const char *spill_dir);
+
+/* Defer merging while rules run so sorted arrays stay stable */
+void factdb_defer_merge(FactDatabase *db, bool defer);
+
+/* Copy a relation's facts into a new array, in (arg_a, arg_b) order for
+ * sorted and symmetric relations.  Returns the count, or -1 when out of
+ * memory. */
+int factdb_export(FactDatabase *db, const char *relation, FactPair **tuples);
+
+/* Rebuild every relation as frozen storage and release its mutable
+ * layout.  Afterwards inserts, retractions and layout changes fail, and
+ * every read is lock-free, so any number of threads may query at once.
+ * Returns false when out of memory, leaving the database unchanged. */
+bool factdb_freeze(FactDatabase *db);
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Query Result Functions
@@ -0,0 +1,104 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * epoch.h - ByteLog Epoch Snapshots
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Lets reader threads query a consistent database while the writer keeps
+ * loading facts and solving.  Each publish freezes the writer's relations
+ * into an immutable snapshot and swaps it in as the current epoch.
+ * Relations unchanged since the previous epoch share its frozen rows, so
+ * a publish only rebuilds what changed.
+ *
+ * Readers pin the current snapshot with two atomic stores and no locks,
+ * and it stays valid until they unpin it.  Replaced snapshots are freed by
+ * the writer once no reader still announces an epoch old enough to hold
+ * them (epoch-based reclamation).
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_EPOCH_H
+#define BYTELOG_EPOCH_H
+
+#include "engine.h"
+#include "frozen.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Epoch Structures
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Reader slots; each concurrent reader uses its own */
+#define EPOCH_MAX_READERS 64
+
+/* A frozen relation, shared by every snapshot it did not change in */
+typedef struct EpochRelation {
+    char *name;
+    uint64_t version;           /* Writer's relation version it was built from */
+    FrozenRelation frozen;
+    int refs;                   /* Snapshots holding it (writer only) */
+} EpochRelation;
+
+typedef struct EpochSnapshot {
+    uint64_t epoch;             /* Published epoch, from 1 */
+    EpochRelation **relations;  /* By name, ascending */
+    int relation_count;
+    long count;                 /* Facts over all relations */
+    uint64_t retired;           /* Epoch that replaced it, 0 while current */
+    struct EpochSnapshot *next; /* Retired list (writer only) */
+} EpochSnapshot;
+
+/* Announced epoch of one reader, alone on its cache line */
+typedef struct EpochReader {
+    uint64_t pinned;            /* 0 = not reading */
+    char padding[56];
+} EpochReader;
+
+typedef struct EpochStore {
+    EpochSnapshot *current;     /* Read atomically */
+    uint64_t epoch;             /* Epoch of current, read atomically */
+    EpochReader readers[EPOCH_MAX_READERS];
+    EpochSnapshot *retired;     /* Replaced, awaiting reclamation */
+} EpochStore;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Writer Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Start with an empty snapshot as epoch 1 */
+bool epoch_init(EpochStore *store);
+
+/* Free every snapshot; no reader may still be pinned */
+void epoch_free(EpochStore *store);
+
+/* Merge and freeze db's relations into a new current snapshot, then free
+ * the retired snapshots no reader can still see.  Only one thread may
+ * publish at a time.  Returns false when out of memory, leaving the
+ * current snapshot in place. */
+bool epoch_publish(EpochStore *store, FactDatabase *db);
+
+/* Free the retired snapshots no reader can still see; returns how many
+ * are still waiting */
+int epoch_reclaim(EpochStore *store);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Reader Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Pin and return the current snapshot for reader slot `reader`
+ * (0 .. EPOCH_MAX_READERS - 1).  Never blocks. */
+const EpochSnapshot* epoch_pin(EpochStore *store, int reader);
+
+/* Release the snapshot pinned by `reader` */
+void epoch_unpin(EpochStore *store, int reader);
+
+/* A snapshot's frozen relation, NULL when it has none by that name */
+const FrozenRelation* epoch_relation(const EpochSnapshot *snapshot, const char *relation);
+
+/* Check if fact exists in a snapshot */
+bool epoch_contains(const EpochSnapshot *snapshot, const char *relation, int arg_a, int arg_b);
+
+/* Query a snapshot's facts matching pattern (wildcards = -1) */
+QueryResult* epoch_query(const EpochSnapshot *snapshot, const char *relation, int arg_a, int arg_b);
+
+#endif /* BYTELOG_EPOCH_H */
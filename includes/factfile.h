@@ -0,0 +1,43 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factfile.h - ByteLog Delimited Fact Import
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Loads two-column TSV and CSV files straight into a relation instead of
+ * converting them to FACT statements for the parser.  The file is mapped
+ * and split at line boundaries across the parallel workers.  Each worker
+ * parses its lines and collects the distinct atom names it saw.  Every
+ * distinct name is then interned once and the columns are bulk loaded.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_FACTFILE_H
+#define BYTELOG_FACTFILE_H
+
+#include "atoms.h"
+#include "engine.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Configuration
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Files smaller than this are parsed on the calling thread */
+#define FACTFILE_PARALLEL_BYTES (1L << 20)
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Import Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Load the lines of `path` as facts of `relation`.  Each line holds two
+ * fields, integers or atom names as in FACT.  Fields are separated by
+ * commas in a .csv file and by tabs otherwise, and may be double-quoted.
+ * Blank lines and lines starting with '#' are skipped.  An undeclared
+ * relation is given sorted storage, and the facts are merged before
+ * returning.  Returns the number of new facts, or -1 with a
+ * "path:line: reason" message in error. */
+long factfile_load(FactDatabase *db, AtomTable *atoms, const char *relation,
+                   const char *path, char *error, size_t error_size);
+
+#endif /* BYTELOG_FACTFILE_H */
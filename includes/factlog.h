@@ -0,0 +1,80 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factlog.h - ByteLog Durable Fact Log
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Keeps base facts across restarts.  Insertions and retractions are
+ * appended to a checksummed write-ahead log and made durable in groups,
+ * one fsync per commit.  A checkpoint writes every base fact (and the
+ * atoms their IDs refer to) to a binary snapshot and empties the log, so
+ * recovery loads the snapshot and replays only the records after it.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_FACTLOG_H
+#define BYTELOG_FACTLOG_H
+
+#include "atoms.h"
+#include "engine.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Log Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Records buffered before a commit is forced */
+#define FACTLOG_GROUP_RECORDS 256
+
+/* Log size past which a commit also checkpoints */
+#define FACTLOG_CHECKPOINT_BYTES (64L << 20)
+
+typedef struct FactLog {
+    char *wal_path;             /* <dir>/facts.wal */
+    char *snapshot_path;        /* <dir>/facts.snapshot */
+    char *dir;
+    int fd;                     /* Write-ahead log, appended to */
+    unsigned char *buffer;      /* Records awaiting the next commit */
+    size_t used;
+    size_t capacity;
+    int pending;                /* Records in the buffer */
+    int group_records;          /* Pending records that force a commit */
+    long wal_bytes;             /* Committed log bytes since the checkpoint */
+    long checkpoint_bytes;      /* Log size that triggers a checkpoint, 0 = never */
+    uint64_t lsn;               /* Sequence number of the last record */
+    FactDatabase base;          /* Base facts as logged */
+    AtomTable atoms;            /* Atoms as logged, same IDs as the engine's */
+    const char *error;          /* Reason for the last failure */
+} FactLog;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Log Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Open or create the log in dir and load its base facts into the engine:
+ * the snapshot, then the log records after it.  A torn record at the end
+ * of the log is dropped.  Open before running programs, since the
+ * engine's atom table must agree with the logged atoms. */
+bool factlog_open(FactLog *log, const char *dir, ExecutionEngine *engine);
+
+/* Insert a base fact into the engine and log it.  Returns as
+ * factdb_insert; the fact is durable once committed. */
+int factlog_insert(FactLog *log, ExecutionEngine *engine, const char *relation,
+                   int arg_a, int arg_b);
+
+/* Retract a base fact from the engine and log it.  Returns as
+ * factdb_retract. */
+int factlog_retract(FactLog *log, ExecutionEngine *engine, const char *relation,
+                    int arg_a, int arg_b);
+
+/* Write buffered records and fsync them (group commit) */
+bool factlog_commit(FactLog *log);
+
+/* Snapshot every base fact and empty the log */
+bool factlog_checkpoint(FactLog *log);
+
+/* Commit, then release the log (the engine keeps its facts) */
+bool factlog_close(FactLog *log);
+
+#endif /* BYTELOG_FACTLOG_H */
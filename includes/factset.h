@@ -0,0 +1,67 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factset.h - ByteLog Concurrent Fact Set
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Insert-only open-addressing hash set of packed (a, b) tuple keys that
+ * many threads may insert into at once.  Slots are claimed with
+ * compare-and-swap, so parallel emitters deduplicate derived facts without
+ * a lock.  When the table fills, the inserting threads migrate it into one
+ * twice the size together, a chunk each.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_FACTSET_H
+#define BYTELOG_FACTSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Set Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Slots copied per claim during a migration */
+#define FACTSET_MIGRATE_CHUNK 1024
+
+typedef struct FactSetTable {
+    uint64_t *slots;            /* Empty, moved, or a key (see factset.c) */
+    size_t capacity;            /* Power of two */
+    struct FactSetTable *next;  /* Table being migrated into, or NULL */
+    size_t claimed;             /* Migration chunks handed out */
+    size_t migrated;            /* Migration chunks finished */
+    struct FactSetTable *older; /* Previously allocated table, freed last */
+} FactSetTable;
+
+typedef struct FactSet {
+    FactSetTable *table;        /* Table receiving inserts */
+    FactSetTable *tables;       /* Every table allocated, newest first */
+    long count;                 /* Keys held */
+    unsigned int reserved;      /* Bit per key equal to a slot sentinel */
+} FactSet;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Set Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Initialize a set sized for about `expected` keys (not thread-safe) */
+bool factset_init(FactSet *set, size_t expected);
+
+/* Free the set and every table it outgrew (not thread-safe) */
+void factset_free(FactSet *set);
+
+/* Drop every key, keeping the largest table for reuse (not thread-safe) */
+void factset_clear(FactSet *set);
+
+/* Add a parallel_pack_pair() key.  Safe to call from many threads at once.
+ * Returns 1 if this call added it, 0 if it was present, -1 on error. */
+int factset_insert(FactSet *set, uint64_t key);
+
+/* Check for a key; concurrent inserts may or may not be seen */
+bool factset_contains(FactSet *set, uint64_t key);
+
+/* Number of keys held */
+long factset_count(FactSet *set);
+
+#endif /* BYTELOG_FACTSET_H */
@@ -0,0 +1,71 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * frozen.h - ByteLog Frozen Relations
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Read-only layout for a relation that will not change again.  Facts are
+ * kept as compressed sparse rows in both directions (arg_a -> arg_b and
+ * arg_b -> arg_a), so a lookup on either column is one binary search over
+ * the distinct keys followed by a contiguous run of values.  A perfect
+ * hash over the pairs stores a 16-bit fingerprint per fact, which rejects
+ * almost every absent pair with a single probe.
+ *
+ * Nothing is written after frozen_build, so any number of threads may
+ * read a frozen relation without locks.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_FROZEN_H
+#define BYTELOG_FROZEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Frozen Relation Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Average facts per perfect hash bucket */
+#define FROZEN_BUCKET_KEYS 4
+
+/* One column's compressed sparse rows */
+typedef struct FrozenIndex {
+    int *keys;                  /* Distinct keys, ascending */
+    int *offsets;               /* key_count + 1 offsets into values */
+    int *values;                /* Each key's values, ascending */
+    int key_count;              /* Number of distinct keys */
+} FrozenIndex;
+
+typedef struct FrozenRelation {
+    FrozenIndex by_a;           /* arg_a -> arg_b */
+    FrozenIndex by_b;           /* arg_b -> arg_a */
+    int count;                  /* Number of facts */
+    uint16_t *fingerprints;     /* Perfect hash slot -> fact fingerprint */
+    uint32_t *displacements;    /* Perfect hash bucket -> slot displacement */
+    int slot_count;             /* Perfect hash slots, about 1.25 per fact */
+    int bucket_count;           /* Perfect hash buckets */
+    uint64_t seed;              /* Hash seed that placed every fact */
+} FrozenRelation;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Frozen Relation Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Build a frozen relation from parallel_pack_pair()ed facts.  keys is
+ * sorted and deduplicated in place.  Returns false when out of memory. */
+bool frozen_build(FrozenRelation *frozen, uint64_t *keys, int count);
+
+/* Free a frozen relation's arrays */
+void frozen_free(FrozenRelation *frozen);
+
+/* Check if (arg_a, arg_b) is a fact */
+bool frozen_contains(const FrozenRelation *frozen, int arg_a, int arg_b);
+
+/* Values stored under key, ascending; returns how many */
+int frozen_values(const FrozenIndex *index, int key, const int **values);
+
+/* Bytes held by a frozen relation's arrays */
+size_t frozen_bytes(const FrozenRelation *frozen);
+
+#endif /* BYTELOG_FROZEN_H */
@@ -0,0 +1,112 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * join.h - ByteLog Multi-way Join Evaluation
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Compiles rule bodies into conjunctive join queries and evaluates them
+ * either with worst-case optimal leapfrog triejoin over sorted per-relation
+ * tries, or with classic left-to-right pairwise joins.  Compilation gives
+ * every variable a dense frame slot, so bodies may use any number of atoms
+ * and variables.  WHERE comparisons and negated atoms become filters
+ * attached to the atom (or leapfrog depth) that binds the last variable
+ * they read; a negated atom is an anti-join probe of its relation's index.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_JOIN_H
+#define BYTELOG_JOIN_H
+
+#include "ast.h"
+#include "engine.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Join Query Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef struct JoinAtom {
+    const char *relation;       /* Relation name (borrowed from the rule AST) */
+    int slot_a;                 /* Frame slot bound to column A */
+    int slot_b;                 /* Frame slot bound to column B */
+    bool closes;                /* Both slots were already bound */
+} JoinAtom;
+
+/* Comparison outcomes a filter keeps: mask bit 0 for <, 1 for =, 2 for > */
+#define JOIN_FILTER_LT 0x1u
+#define JOIN_FILTER_EQ 0x2u
+#define JOIN_FILTER_GT 0x4u
+
+/* frame[slot_a] compared with frame[slot_b], or with value when slot_b < 0.
+ * With a relation it is an anti-join instead: no (frame[slot_a],
+ * frame[slot_b]) tuple, or no tuple keyed frame[slot_a] when slot_b < 0. */
+typedef struct JoinFilter {
+    const char *relation;       /* Negated relation, NULL for a comparison */
+    int slot_a;                 /* Left operand slot */
+    int slot_b;                 /* Right operand slot, -1 for a constant */
+    int value;                  /* Right operand constant */
+    unsigned int mask;          /* JOIN_FILTER_* outcomes that pass */
+    int slot;                   /* Latest-bound slot read, the leapfrog depth */
+    int atom;                   /* Atom binding that slot, the pipeline step */
+} JoinFilter;
+
+/* Slots are numbered in binding order, so slot i is the i-th variable bound
+ * and a frame is var_count values wide */
+typedef struct JoinQuery {
+    JoinAtom *atoms;            /* SCAN atom first, then one per JOIN */
+    int atom_count;
+    int atom_capacity;
+    int *vars;                  /* Variable number ($N) of each slot */
+    int var_count;              /* Number of slots */
+    int var_capacity;
+    JoinFilter *filters;        /* WHERE and NOT filters, ordered by slot */
+    int filter_count;
+    int filter_capacity;
+    bool cyclic;                /* Some JOIN constrains two bound variables */
+    const char *emit_relation;  /* EMIT target (borrowed from the rule AST) */
+    int emit_a;                 /* EMIT column A slot */
+    int emit_b;                 /* EMIT column B slot */
+} JoinQuery;
+
+typedef struct JoinStats {
+    long intermediate;          /* Partial bindings produced before the last atom */
+    long results;               /* Complete bindings produced */
+} JoinStats;
+
+/* Callback for each complete binding frame (indexed by slot); return false
+ * to abort */
+typedef bool (*JoinEmitFn)(const int *frame, void *context);
+
+/* SCAN atom pairs per worker before a pairwise join is split across threads */
+#define JOIN_PARALLEL_MIN_SCAN 4096
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Join Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Check if a rule uses explicit JOIN column B variables, WHERE filters or
+ * negation, and needs compiling */
+bool join_rule_needs_query(const ASTNode *rule);
+
+/* Compile a rule body into a join query (binding rules from bytelog-spec 5.2).
+ * Atom constants in WHERE filters are interned into atoms.  Nothing needs
+ * freeing when compilation fails. */
+bool join_query_compile(JoinQuery *query, const ASTNode *rule, AtomTable *atoms,
+                        char *error_buf, size_t error_buf_size);
+
+/* Free a compiled join query */
+void join_query_free(JoinQuery *query);
+
+/* Evaluate a join query against the fact database */
+bool join_query_run(const JoinQuery *query, FactDatabase *db, JoinStrategy strategy,
+                    JoinEmitFn emit, void *context, JoinStats *stats);
+
+/* Evaluate a join query on up to `threads` workers that split the SCAN
+ * atom's tuples.  Worker w emits with contexts[w], concurrently with the
+ * others, while the database is only read.  Leapfrog plans and small scans
+ * run on one worker with contexts[0]. */
+bool join_query_run_parallel(const JoinQuery *query, FactDatabase *db, JoinStrategy strategy,
+                             int threads, JoinEmitFn emit, void *const *contexts,
+                             JoinStats *stats);
+
+#endif /* BYTELOG_JOIN_H */
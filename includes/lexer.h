@@ -29,11 +29,19 @@ typedef enum {
     TOK_MATCH,
     TOK_SOLVE,
     TOK_QUERY,
+    TOK_WHERE,
+    TOK_NOT,
     
     /* Symbols */
     TOK_COLON,      /* : */
     TOK_COMMA,      /* , */
     TOK_WILDCARD,   /* ? */
+    TOK_LT,         /* < */
+    TOK_LE,         /* <= */
+    TOK_GT,         /* > */
+    TOK_GE,         /* >= */
+    TOK_EQ,         /* = or == */
+    TOK_NE,         /* != or <> */
     
     /* Literals */
     TOK_VARIABLE,   /* $0, $1, $2, ... */
@@ -0,0 +1,89 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * parallel.h - ByteLog Parallel Primitives
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Fork-join helpers on POSIX threads and the data-parallel kernels built on
+ * them (radix sort of packed 64-bit tuple keys), plus the prefetch hint
+ * used to overlap the cache misses of independent index probes.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_PARALLEL_H
+#define BYTELOG_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Configuration
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define PARALLEL_MAX_THREADS 16
+
+/* Inputs smaller than this are processed on the calling thread */
+#define PARALLEL_MIN_ITEMS 65536
+
+/* Independent lookups searched in lockstep by batched probes */
+#define PARALLEL_PROBE_GROUP 16
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fork-Join Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Task body: index in [0, count) of the worker running it */
+typedef void (*ParallelTask)(int index, int count, void *context);
+
+/* Number of worker threads to use (online CPUs, capped) */
+int parallel_thread_count(void);
+
+/* Override the worker thread count (0 restores the default) */
+void parallel_set_thread_count(int threads);
+
+/* Pin spawned workers to CPUs by index so worker i always runs on the
+ * same core, and on that core's NUMA node (off by default).  Worker 0 is
+ * the calling thread and is left as it is. */
+void parallel_set_pinning(bool pin);
+
+/* Run task on `count` workers and wait for all of them */
+void parallel_run(int count, ParallelTask task, void *context);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Sorting Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Pack a tuple into a key whose unsigned order matches (a, b) signed order */
+static inline uint64_t parallel_pack_pair(int a, int b) {
+    return ((uint64_t)((uint32_t)a ^ 0x80000000u) << 32) |
+           (uint64_t)((uint32_t)b ^ 0x80000000u);
+}
+
+static inline int parallel_unpack_a(uint64_t key) {
+    return (int)((uint32_t)(key >> 32) ^ 0x80000000u);
+}
+
+static inline int parallel_unpack_b(uint64_t key) {
+    return (int)((uint32_t)key ^ 0x80000000u);
+}
+
+/* LSD radix sort of 64-bit keys; parallel for large inputs */
+bool parallel_radix_sort(uint64_t *keys, size_t count);
+
+/* The same sort on the calling thread, for callers that are already one
+ * of several workers */
+bool parallel_radix_sort_serial(uint64_t *keys, size_t count);
+
+/* Remove adjacent duplicates from a sorted key array, returns new count */
+size_t parallel_unique(uint64_t *keys, size_t count);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Memory Hints
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Start loading addr into cache for an upcoming read */
+static inline void parallel_prefetch(const void *addr) {
+    __builtin_prefetch(addr, 0, 1);
+}
+
+#endif /* BYTELOG_PARALLEL_H */
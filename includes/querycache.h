@@ -0,0 +1,86 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * querycache.h - ByteLog Query Result Cache
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Remembers the answers engine_query gave, keyed on the relation and the
+ * bound arguments.  Each entry records the relation's version when it was
+ * answered; a lookup that finds the relation changed since drops the entry
+ * instead of returning it, so only queries over modified relations are
+ * recomputed.  Entries past the size limit are evicted oldest first.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_QUERYCACHE_H
+#define BYTELOG_QUERYCACHE_H
+
+#include "engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Query Cache Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Entries an engine caches unless engine_set_query_cache says otherwise */
+#define QUERYCACHE_DEFAULT_ENTRIES 1024
+
+/* Result facts held over all entries before the oldest are evicted */
+#define QUERYCACHE_MAX_FACTS (1L << 20)
+
+typedef struct QueryCacheEntry {
+    char *relation;
+    int arg_a;                  /* Pattern, -1 = wildcard */
+    int arg_b;
+    uint64_t version;           /* Relation version the results belong to */
+    FactPair *results;          /* In engine_query order */
+    int count;
+    unsigned int hash;
+    struct QueryCacheEntry *next;   /* Hash collision chain */
+    struct QueryCacheEntry *older;  /* Insertion order, for eviction */
+    struct QueryCacheEntry *newer;
+} QueryCacheEntry;
+
+typedef struct QueryCacheStats {
+    long hits;                  /* Lookups answered from the cache */
+    long misses;                /* Lookups that ran the query */
+    long invalidations;         /* Entries dropped because their relation changed */
+    long evictions;             /* Entries dropped for space */
+    int entries;                /* Entries held */
+    long facts;                 /* Result facts held */
+} QueryCacheStats;
+
+typedef struct QueryCache {
+    QueryCacheEntry **buckets;
+    int bucket_count;           /* Power of two */
+    int max_entries;
+    QueryCacheEntry *oldest;    /* Next to evict */
+    QueryCacheEntry *newest;
+    QueryCacheStats stats;
+} QueryCache;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Query Cache Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Initialize a cache holding up to max_entries answers */
+bool querycache_init(QueryCache *cache, int max_entries);
+
+/* Free every entry and the table */
+void querycache_free(QueryCache *cache);
+
+/* Drop every entry, keeping the statistics */
+void querycache_clear(QueryCache *cache);
+
+/* Look up the answer to a pattern at the relation's current version.  On
+ * a hit, *results receives a copy for the caller to free (NULL for an
+ * empty answer).  An entry for an older version is dropped and missed. */
+bool querycache_lookup(QueryCache *cache, const char *relation, int arg_a, int arg_b,
+                       uint64_t version, QueryResult **results);
+
+/* Remember the answer to a pattern, replacing any older one.  Returns
+ * false when out of memory, leaving the cache without the entry. */
+bool querycache_store(QueryCache *cache, const char *relation, int arg_a, int arg_b,
+                      uint64_t version, const QueryResult *results);
+
+#endif /* BYTELOG_QUERYCACHE_H */
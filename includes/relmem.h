@@ -0,0 +1,74 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * relmem.h - ByteLog Relation Memory
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Allocator for the large arrays behind relations and join indexes (tuple
+ * columns, pending deltas, trie pairs).  Blocks of at least a huge page
+ * are mapped on their own and backed by 2MB pages, so random probes over
+ * them miss the TLB far less often.  Their pages are first touched by the
+ * parallel workers in contiguous shards, which places each shard on the
+ * NUMA node of the worker that scans it.  Smaller blocks come from the
+ * heap.
+ *
+ * Under a memory budget, large blocks past it are mapped from unlinked
+ * temp files instead.  Their pages are written back and evicted by the
+ * kernel under pressure, so relations larger than RAM spill to disk and
+ * their sorted arrays are read back as sequential runs.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_RELMEM_H
+#define BYTELOG_RELMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Configuration
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define RELMEM_HUGE_PAGE ((size_t)2 << 20)
+
+/* How a block's memory is provided */
+typedef enum {
+    RELMEM_HEAP,                /* malloc, for blocks under a huge page */
+    RELMEM_MAPPED,              /* Anonymous mapping, base pages only */
+    RELMEM_TRANSPARENT,         /* Aligned mapping advised for transparent huge pages */
+    RELMEM_HUGETLB,             /* Mapping from the reserved huge page pool */
+    RELMEM_SPILLED              /* Shared mapping of an unlinked temp file */
+} RelMemBacking;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Relation Memory Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Allocate a block (contents undefined), NULL when out of memory */
+void* relmem_alloc(size_t size);
+
+/* The same, first-touching every page on the calling thread, for callers
+ * that are already one of several parallel workers */
+void* relmem_alloc_local(size_t size);
+
+/* Resize a block as realloc does; NULL ptr allocates */
+void* relmem_realloc(void *ptr, size_t size);
+
+/* Free a block from relmem_alloc (NULL is ignored) */
+void relmem_free(void *ptr);
+
+/* Backing of a live block */
+RelMemBacking relmem_backing(const void *ptr);
+
+/* Keep anonymous mappings within `bytes` (0 = unlimited).  Blocks that
+ * would exceed it spill to temp files in `dir` (NULL for $TMPDIR, else
+ * /tmp), falling back to memory when the file cannot be created. */
+void relmem_set_budget(size_t bytes, const char *dir);
+
+/* Bytes of anonymous mappings currently held */
+size_t relmem_resident(void);
+
+/* Enable or disable huge pages for later blocks (default on).  Disabled
+ * blocks are still mapped and first-touched, on base pages. */
+void relmem_set_huge_pages(bool enabled);
+
+#endif /* BYTELOG_RELMEM_H */
@@ -0,0 +1,128 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * roaring.h - ByteLog Compressed Bitmaps
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Roaring-style bitmaps over 32-bit values, used as posting lists for
+ * high-degree keys.  Values are split into 16-bit chunks; each chunk is an
+ * array container (sparse), a bitmap container (dense) or a run container
+ * (long consecutive ranges).
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_ROARING_H
+#define BYTELOG_ROARING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Configuration
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define ROARING_ARRAY_MAX 4096          /* Array containers convert past this */
+#define ROARING_BITMAP_WORDS 1024       /* 65536 bits per bitmap container */
+
+/* Adjacency lists longer than this are stored as bitmaps */
+#define ROARING_DEGREE_THRESHOLD 1024
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bitmap Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef enum {
+    ROARING_ARRAY,              /* Sorted uint16 values */
+    ROARING_BITMAP,             /* 65536-bit bitmap */
+    ROARING_RUN                 /* Sorted [start, start + length] runs */
+} RoaringContainerType;
+
+typedef struct RoaringRun {
+    uint16_t start;
+    uint16_t length;            /* Run covers start .. start + length */
+} RoaringRun;
+
+typedef struct RoaringContainer {
+    uint16_t key;               /* High 16 bits of the values */
+    RoaringContainerType type;
+    int cardinality;            /* Number of values */
+    int size;                   /* Array values or runs in use */
+    int capacity;               /* Array values or runs allocated */
+    union {
+        uint16_t *array;
+        uint64_t *words;
+        RoaringRun *runs;
+    } data;
+} RoaringContainer;
+
+typedef struct RoaringBitmap {
+    RoaringContainer *containers;   /* Sorted by key */
+    int count;
+    int capacity;
+} RoaringBitmap;
+
+typedef struct RoaringIterator {
+    const RoaringBitmap *bitmap;
+    int container;              /* Current container index */
+    int position;               /* Array index, bit index or run index */
+    int offset;                 /* Offset within the current run */
+} RoaringIterator;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Value Encoding
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Map signed values to unsigned ones with the same order */
+static inline uint32_t roaring_encode(int value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static inline int roaring_decode(uint32_t value) {
+    return (int)(value ^ 0x80000000u);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bitmap Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Initialize an empty bitmap */
+void roaring_init(RoaringBitmap *bitmap);
+
+/* Free bitmap storage */
+void roaring_free(RoaringBitmap *bitmap);
+
+/* Add a value, returns false when out of memory */
+bool roaring_add(RoaringBitmap *bitmap, uint32_t value);
+
+/* Check if a value is present */
+bool roaring_contains(const RoaringBitmap *bitmap, uint32_t value);
+
+/* Number of values */
+long roaring_cardinality(const RoaringBitmap *bitmap);
+
+/* Smallest value (bitmap must be non-empty) */
+uint32_t roaring_minimum(const RoaringBitmap *bitmap);
+
+/* Intersection into out (initialized by the call) */
+bool roaring_and(const RoaringBitmap *x, const RoaringBitmap *y, RoaringBitmap *out);
+
+/* Union into out (initialized by the call) */
+bool roaring_or(const RoaringBitmap *x, const RoaringBitmap *y, RoaringBitmap *out);
+
+/* Convert containers to runs where that is smaller */
+bool roaring_run_optimize(RoaringBitmap *bitmap);
+
+/* Heap bytes used by the bitmap */
+size_t roaring_size_bytes(const RoaringBitmap *bitmap);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Iterator Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Start iterating values in ascending order */
+void roaring_iterator_init(RoaringIterator *it, const RoaringBitmap *bitmap);
+
+/* Get the next value, false when exhausted */
+bool roaring_iterator_next(RoaringIterator *it, uint32_t *value);
+
+#endif /* BYTELOG_ROARING_H */
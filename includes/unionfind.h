@@ -0,0 +1,64 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * unionfind.h - ByteLog Equivalence Classes
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Union-find forest over atom values, used to store equivalence relations
+ * without materializing every pair.  Each class also keeps its members on
+ * a circular list so it can be enumerated in O(size).
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BYTELOG_UNIONFIND_H
+#define BYTELOG_UNIONFIND_H
+
+#include <limits.h>
+#include <stdbool.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Union-Find Structure
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Most values unionfind_reserve takes: its slot table is four times
+ * larger at most, which must fit in an int */
+#define UNIONFIND_MAX_VALUES (INT_MAX / 4)
+
+typedef struct UnionFind {
+    int *values;                /* Node -> atom value */
+    int *parent;                /* Node -> parent node, roots are their own */
+    int *size;                  /* Class size, valid at roots */
+    int *next;                  /* Node -> next member of its class (circular) */
+    int count;                  /* Number of nodes */
+    int capacity;               /* Allocated nodes */
+    int *slots;                 /* Open addressing: value -> node + 1, 0 = empty */
+    int slot_capacity;          /* Power of two */
+    long pairs;                 /* Pairs represented: sum of class sizes squared */
+} UnionFind;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Union-Find Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Initialize an empty forest */
+void unionfind_init(UnionFind *uf);
+
+/* Free forest storage */
+void unionfind_free(UnionFind *uf);
+
+/* Make room for `values` distinct values without growing again */
+bool unionfind_reserve(UnionFind *uf, int values);
+
+/* Node of an atom value, or -1 if the value is in no class */
+int unionfind_node(const UnionFind *uf, int value);
+
+/* Root of a node's class */
+int unionfind_root(const UnionFind *uf, int node);
+
+/* Merge the classes of two values, adding them as needed.
+ * Returns the number of pairs added (0 if already related), -1 on error. */
+long unionfind_union(UnionFind *uf, int a, int b);
+
+/* Check if two values are in the same class */
+bool unionfind_same(UnionFind *uf, int a, int b);
+
+#endif /* BYTELOG_UNIONFIND_H */
@@ -68,6 +68,18 @@ ASTNode* ast_make_rel_decl(const char *name, int line, int column) {
     if (!node) return NULL;
     
     node->data.rel_decl.name = ast_copy_string(name);
+    node->data.rel_decl.attributes = 0;
+    node->data.rel_decl.size_hint = 0;
+    node->data.rel_decl.domain_hint = 0;
+    return node;
+}
+
+ASTNode* ast_make_rel_decl_with_attributes(const char *name, unsigned int attributes,
+                                           int line, int column) {
+    ASTNode *node = ast_make_rel_decl(name, line, column);
+    if (!node) return NULL;
+    
+    node->data.rel_decl.attributes = attributes;
     return node;
 }
 
@@ -123,6 +135,17 @@ ASTNode* ast_make_join(const char *relation, int match_var, int line, int column
     
     node->data.join.relation = ast_copy_string(relation);
     node->data.join.match_var = match_var;
+    node->data.join.has_bind = false;
+    node->data.join.bind_var = -1;
+    return node;
+}
+
+ASTNode* ast_make_join_bind(const char *relation, int match_var, int bind_var, int line, int column) {
+    ASTNode *node = ast_make_join(relation, match_var, line, column);
+    if (!node) return NULL;
+    
+    node->data.join.has_bind = true;
+    node->data.join.bind_var = bind_var;
     return node;
 }
 
@@ -237,6 +260,14 @@ ASTNode* ast_make_where(ASTNode *condition, int line, int column) {
     return node;
 }
 
+ASTNode* ast_make_not(ASTNode *operation, int line, int column) {
+    ASTNode *node = ast_alloc_node(AST_NOT, line, column);
+    if (!node) return NULL;
+    
+    node->data.negation.operation = operation;
+    return node;
+}
+
 ASTNode* ast_make_for_each(int var, ASTNode *query, ASTNode *body, int line, int column) {
     ASTNode *node = ast_alloc_node(AST_FOR_EACH, line, column);
     if (!node) return NULL;
@@ -445,8 +476,16 @@ void ast_free(ASTNode *node) {
             free(node->data.query.atom_a);
             free(node->data.query.atom_b);
             break;
+        case AST_EXPR_STRING:
+            free(node->data.expr.string_val);
+            break;
         case AST_PROGRAM:
         case AST_SOLVE:
+        case AST_WHERE:
+        case AST_NOT:
+        case AST_CONDITION:
+        case AST_EXPR_VAR:
+        case AST_EXPR_INT:
             break;
     }
     
@@ -465,6 +504,16 @@ void ast_free_tree(ASTNode *root) {
             ast_free_tree(root->data.rule.body);
             ast_free_tree(root->data.rule.emit);
             break;
+        case AST_WHERE:
+            ast_free_tree(root->data.where.condition);
+            break;
+        case AST_NOT:
+            ast_free_tree(root->data.negation.operation);
+            break;
+        case AST_CONDITION:
+            ast_free_tree(root->data.condition.left);
+            ast_free_tree(root->data.condition.right);
+            break;
         default:
             break;
     }
@@ -491,6 +540,12 @@ const char* ast_node_type_name(ASTNodeType type) {
         case AST_EMIT: return "EMIT";
         case AST_SOLVE: return "SOLVE";
         case AST_QUERY: return "QUERY";
+        case AST_WHERE: return "WHERE";
+        case AST_NOT: return "NOT";
+        case AST_CONDITION: return "CONDITION";
+        case AST_EXPR_VAR: return "EXPR_VAR";
+        case AST_EXPR_INT: return "EXPR_INT";
+        case AST_EXPR_STRING: return "EXPR_STRING";
         default: return "UNKNOWN";
     }
 }
@@ -501,6 +556,28 @@ static void print_indent(int indent) {
     }
 }
 
+static const char* comparison_symbol(OpType op) {
+    switch (op) {
+        case OP_LT: return "<";
+        case OP_LE: return "<=";
+        case OP_GT: return ">";
+        case OP_GE: return ">=";
+        case OP_EQ: return "=";
+        case OP_NE: return "!=";
+        default: return "?";
+    }
+}
+
+static void print_operand(const ASTNode *expr) {
+    if (!expr) return;
+    switch (expr->type) {
+        case AST_EXPR_VAR: printf("$%d", expr->data.expr.var_num); break;
+        case AST_EXPR_INT: printf("%d", expr->data.expr.int_val); break;
+        case AST_EXPR_STRING: printf("%s", expr->data.expr.string_val); break;
+        default: printf("<%s>", ast_node_type_name(expr->type)); break;
+    }
+}
+
 void ast_print_node(const ASTNode *node, int indent) {
     if (!node) return;
     
@@ -514,7 +591,14 @@ void ast_print_node(const ASTNode *node, int indent) {
             break;
             
         case AST_REL_DECL:
-            printf(" name='%s'\n", node->data.rel_decl.name);
+            printf(" name='%s'", node->data.rel_decl.name);
+            if (node->data.rel_decl.attributes & REL_ATTR_SORTED) printf(" SORTED");
+            if (node->data.rel_decl.attributes & REL_ATTR_HASH) printf(" HASH");
+            if (node->data.rel_decl.attributes & REL_ATTR_EQUIVALENCE) printf(" EQUIVALENCE");
+            if (node->data.rel_decl.attributes & REL_ATTR_SYMMETRIC) printf(" SYMMETRIC");
+            if (node->data.rel_decl.size_hint) printf(" SIZE %d", node->data.rel_decl.size_hint);
+            if (node->data.rel_decl.domain_hint) printf(" DOMAIN %d", node->data.rel_decl.domain_hint);
+            printf("\n");
             break;
             
         case AST_FACT:
@@ -555,9 +639,13 @@ void ast_print_node(const ASTNode *node, int indent) {
             break;
             
         case AST_JOIN:
-            printf(" relation='%s' match=$%d\n", 
+            printf(" relation='%s' match=$%d", 
                    node->data.join.relation, 
                    node->data.join.match_var);
+            if (node->data.join.has_bind) {
+                printf(" bind=$%d", node->data.join.bind_var);
+            }
+            printf("\n");
             break;
             
         case AST_EMIT:
@@ -593,6 +681,32 @@ void ast_print_node(const ASTNode *node, int indent) {
             }
             printf("\n");
             break;
+            
+        case AST_WHERE:
+            printf("\n");
+            ast_print_node(node->data.where.condition, indent + 1);
+            break;
+            
+        case AST_NOT:
+            printf("\n");
+            ast_print_node(node->data.negation.operation, indent + 1);
+            break;
+            
+        case AST_CONDITION:
+            printf(" ");
+            print_operand(node->data.condition.left);
+            printf(" %s ", comparison_symbol(node->data.condition.op));
+            print_operand(node->data.condition.right);
+            printf("\n");
+            break;
+            
+        case AST_EXPR_VAR:
+        case AST_EXPR_INT:
+        case AST_EXPR_STRING:
+            printf(" ");
+            print_operand(node);
+            printf("\n");
+            break;
     }
 }
 
@@ -616,7 +730,13 @@ ASTNode* ast_clone(const ASTNode *node) {
             break;
             
         case AST_REL_DECL:
-            clone = ast_make_rel_decl(node->data.rel_decl.name, node->line, node->column);
+            clone = ast_make_rel_decl_with_attributes(node->data.rel_decl.name,
+                                                      node->data.rel_decl.attributes,
+                                                      node->line, node->column);
+            if (clone) {
+                clone->data.rel_decl.size_hint = node->data.rel_decl.size_hint;
+                clone->data.rel_decl.domain_hint = node->data.rel_decl.domain_hint;
+            }
             break;
             
         case AST_FACT:
@@ -641,9 +761,16 @@ ASTNode* ast_clone(const ASTNode *node) {
             break;
             
         case AST_JOIN:
-            clone = ast_make_join(node->data.join.relation,
-                                 node->data.join.match_var,
-                                 node->line, node->column);
+            if (node->data.join.has_bind) {
+                clone = ast_make_join_bind(node->data.join.relation,
+                                          node->data.join.match_var,
+                                          node->data.join.bind_var,
+                                          node->line, node->column);
+            } else {
+                clone = ast_make_join(node->data.join.relation,
+                                     node->data.join.match_var,
+                                     node->line, node->column);
+            }
             break;
             
         case AST_EMIT:
@@ -663,6 +790,38 @@ ASTNode* ast_clone(const ASTNode *node) {
                                   node->data.query.arg_b,
                                   node->line, node->column);
             break;
+            
+        case AST_WHERE:
+            clone = ast_make_where(ast_clone(node->data.where.condition),
+                                  node->line, node->column);
+            break;
+            
+        case AST_NOT:
+            clone = ast_make_not(ast_clone(node->data.negation.operation),
+                                node->line, node->column);
+            break;
+            
+        case AST_CONDITION:
+            clone = ast_make_condition(node->data.condition.op,
+                                      ast_clone(node->data.condition.left),
+                                      ast_clone(node->data.condition.right),
+                                      node->line, node->column);
+            break;
+            
+        case AST_EXPR_VAR:
+            clone = ast_make_expr_var(node->data.expr.var_num,
+                                     node->line, node->column);
+            break;
+            
+        case AST_EXPR_INT:
+            clone = ast_make_expr_int(node->data.expr.int_val,
+                                     node->line, node->column);
+            break;
+            
+        case AST_EXPR_STRING:
+            clone = ast_make_expr_string(node->data.expr.string_val,
+                                        node->line, node->column);
+            break;
     }
     
     if (clone) {
@@ -719,6 +878,34 @@ void ast_walk(const ASTNode *node, const ASTVisitor *visitor, void *context) {
         case AST_QUERY:
             if (visitor->visit_query) visitor->visit_query(node, context);
             break;
+            
+        case AST_WHERE:
+            if (visitor->visit_where) visitor->visit_where(node, context);
+            ast_walk(node->data.where.condition, visitor, context);
+            break;
+            
+        case AST_NOT:
+            if (visitor->visit_not) visitor->visit_not(node, context);
+            ast_walk(node->data.negation.operation, visitor, context);
+            break;
+            
+        case AST_CONDITION:
+            if (visitor->visit_condition) visitor->visit_condition(node, context);
+            ast_walk(node->data.condition.left, visitor, context);
+            ast_walk(node->data.condition.right, visitor, context);
+            break;
+            
+        case AST_EXPR_VAR:
+            if (visitor->visit_expr_var) visitor->visit_expr_var(node, context);
+            break;
+            
+        case AST_EXPR_INT:
+            if (visitor->visit_expr_int) visitor->visit_expr_int(node, context);
+            break;
+            
+        case AST_EXPR_STRING:
+            if (visitor->visit_expr_string) visitor->visit_expr_string(node, context);
+            break;
     }
     
     /* Visit siblings */
@@ -2,7 +2,9 @@
  * atoms.c - ByteLog Atom Table Implementation
  * ═══════════════════════════════════════════════════════════════════════════
  *
- * Hash table-based string interning for readable atom names.
+ * Hash table-based string interning for readable atom names.  The bucket
+ * array doubles as atoms are added, and an ID-indexed array maps IDs back
+ * to names.
  *
  * ═══════════════════════════════════════════════════════════════════════════
  */
@@ -45,7 +47,7 @@ static unsigned int hash_string(const char *str) {
         hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
     }
     
-    return hash % ATOM_TABLE_SIZE;
+    return hash;
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -55,10 +57,10 @@ static unsigned int hash_string(const char *str) {
 void atom_table_init(AtomTable *table) {
     assert(table);
     
-    for (int i = 0; i < ATOM_TABLE_SIZE; i++) {
-        table->buckets[i] = NULL;
-    }
-    
+    table->buckets = NULL;
+    table->bucket_count = 0;
+    table->by_id = NULL;
+    table->by_id_capacity = 0;
     table->next_id = 0;  /* Start from 0 */
     table->count = 0;
 }
@@ -66,7 +68,7 @@ void atom_table_init(AtomTable *table) {
 void atom_table_free(AtomTable *table) {
     if (!table) return;
     
-    for (int i = 0; i < ATOM_TABLE_SIZE; i++) {
+    for (int i = 0; i < table->bucket_count; i++) {
         AtomEntry *entry = table->buckets[i];
         while (entry) {
             AtomEntry *next = entry->next;
@@ -74,28 +76,53 @@ void atom_table_free(AtomTable *table) {
             free(entry);
             entry = next;
         }
-        table->buckets[i] = NULL;
     }
-    
-    table->next_id = 0;
-    table->count = 0;
+    free(table->buckets);
+    free(table->by_id);
+    atom_table_init(table);
 }
 
-int atom_table_lookup(AtomTable *table, const char *name) {
-    assert(table);
-    assert(name);
+/* Double the bucket array (or create it), relinking the existing chains */
+static bool atom_table_grow(AtomTable *table) {
+    int bucket_count = table->bucket_count ? table->bucket_count * 2 : ATOM_TABLE_SIZE;
+    AtomEntry **buckets = calloc((size_t)bucket_count, sizeof(AtomEntry *));
+    if (!buckets) return false;
     
-    unsigned int bucket = hash_string(name);
-    AtomEntry *entry = table->buckets[bucket];
+    for (int i = 0; i < table->bucket_count; i++) {
+        AtomEntry *entry = table->buckets[i];
+        while (entry) {
+            AtomEntry *next = entry->next;
+            unsigned int bucket = entry->hash & (unsigned int)(bucket_count - 1);
+            entry->next = buckets[bucket];
+            buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = bucket_count;
+    return true;
+}
+
+static AtomEntry* atom_table_find(const AtomTable *table, const char *name, unsigned int hash) {
+    if (!table->buckets) return NULL;
     
+    AtomEntry *entry = table->buckets[hash & (unsigned int)(table->bucket_count - 1)];
     while (entry) {
-        if (strcmp(entry->name, name) == 0) {
-            return entry->id;
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            return entry;
         }
         entry = entry->next;
     }
+    return NULL;
+}
+
+int atom_table_lookup(AtomTable *table, const char *name) {
+    assert(table);
+    assert(name);
     
-    return -1;  /* Not found */
+    AtomEntry *entry = atom_table_find(table, name, hash_string(name));
+    return entry ? entry->id : -1;  /* -1 if not found */
 }
 
 int atom_table_intern(AtomTable *table, const char *name) {
@@ -103,9 +130,22 @@ int atom_table_intern(AtomTable *table, const char *name) {
     assert(name);
     
     /* Check if already exists */
-    int existing_id = atom_table_lookup(table, name);
-    if (existing_id != -1) {
-        return existing_id;
+    unsigned int hash = hash_string(name);
+    AtomEntry *existing = atom_table_find(table, name, hash);
+    if (existing) {
+        return existing->id;
+    }
+    
+    /* Keep chains short and leave room for the new ID */
+    if (table->count >= table->bucket_count && !atom_table_grow(table)) {
+        return -1;
+    }
+    if (table->next_id >= table->by_id_capacity) {
+        int capacity = table->by_id_capacity ? table->by_id_capacity * 2 : ATOM_TABLE_SIZE;
+        AtomEntry **by_id = realloc(table->by_id, (size_t)capacity * sizeof(AtomEntry *));
+        if (!by_id) return -1;
+        table->by_id = by_id;
+        table->by_id_capacity = capacity;
     }
     
     /* Create new entry */
@@ -119,10 +159,12 @@ int atom_table_intern(AtomTable *table, const char *name) {
     }
     
     entry->id = table->next_id++;
+    entry->hash = hash;
+    table->by_id[entry->id] = entry;
     table->count++;
     
     /* Insert into hash table */
-    unsigned int bucket = hash_string(name);
+    unsigned int bucket = hash & (unsigned int)(table->bucket_count - 1);
     entry->next = table->buckets[bucket];
     table->buckets[bucket] = entry;
     
@@ -132,18 +174,10 @@ int atom_table_intern(AtomTable *table, const char *name) {
 const char* atom_table_name(const AtomTable *table, int id) {
     assert(table);
     
-    /* Linear search through all buckets (could be optimized with reverse map) */
-    for (int i = 0; i < ATOM_TABLE_SIZE; i++) {
-        AtomEntry *entry = table->buckets[i];
-        while (entry) {
-            if (entry->id == id) {
-                return entry->name;
-            }
-            entry = entry->next;
-        }
+    if (id < 0 || id >= table->next_id) {
+        return NULL;  /* Not found */
     }
-    
-    return NULL;  /* Not found */
+    return table->by_id[id]->name;
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -229,35 +263,10 @@ void atom_table_print(const AtomTable *table) {
         return;
     }
     
-    /* Collect all entries and sort by ID for readable output */
-    AtomEntry **entries = malloc(table->count * sizeof(AtomEntry*));
-    int count = 0;
-    
-    for (int i = 0; i < ATOM_TABLE_SIZE; i++) {
-        AtomEntry *entry = table->buckets[i];
-        while (entry) {
-            entries[count++] = entry;
-            entry = entry->next;
-        }
-    }
-    
-    /* Simple selection sort by ID */
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = i + 1; j < count; j++) {
-            if (entries[i]->id > entries[j]->id) {
-                AtomEntry *temp = entries[i];
-                entries[i] = entries[j];
-                entries[j] = temp;
-            }
-        }
+    /* IDs are dense, so print them in order */
+    for (int id = 0; id < table->next_id; id++) {
+        printf("%3d: %s\n", id, table->by_id[id]->name);
     }
-    
-    /* Print sorted entries */
-    for (int i = 0; i < count; i++) {
-        printf("%3d: %s\n", entries[i]->id, entries[i]->name);
-    }
-    
-    free(entries);
 }
 
 void atom_table_stats(const AtomTable *table, int *count, int *next_id) {
@@ -0,0 +1,148 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bench_freeze.c - Frozen Relation Benchmark
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Builds the same random relation as sorted storage and as frozen storage
+ * and compares the bytes each holds with the time for one million
+ * membership probes and two thousand column lookups.  Half of the probes
+ * are absent pairs, which the frozen relation's fingerprint filter
+ * rejects without searching its rows.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static bool build_relation(FactDatabase *db, int facts, int nodes) {
+    factdb_init(db);
+    if (!factdb_set_storage(db, "edge", RELATION_STORAGE_SORTED, true)) return false;
+
+    unsigned int seed = 7u;
+    for (int i = 0; i < facts; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        if (factdb_insert(db, "edge", a, b) < 0) return false;
+    }
+    return factdb_merge(db) >= 0;
+}
+
+/* Bytes behind a relation's arrays, as allocated */
+static size_t relation_bytes(const FactDatabase *db) {
+    size_t bytes = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *rel = db->relations[i]; rel; rel = rel->next) {
+            bytes += (size_t)rel->capacity * sizeof(FactPair);
+            bytes += (size_t)rel->delta_capacity * sizeof(uint64_t);
+            bytes += frozen_bytes(&rel->frozen);
+        }
+    }
+    return bytes;
+}
+
+/* Membership probes: even ones replay the built facts, odd ones are
+ * absent; returns ms */
+static double time_probes(FactDatabase *db, int probes, int facts, int nodes, int *hits) {
+    unsigned int stored = 7u;
+    unsigned int seed = 11u;
+    *hits = 0;
+    double start = now_ms();
+    for (int i = 0; i < probes; i++) {
+        int a, b;
+        if (i % 2 == 0) {
+            if ((i / 2) % facts == 0) stored = 7u;
+            a = (int)(next_random(&stored) % (unsigned int)nodes);
+            b = (int)(next_random(&stored) % (unsigned int)nodes);
+        } else {
+            a = (int)(next_random(&seed) % (unsigned int)nodes);
+            b = nodes + (int)(next_random(&seed) % (unsigned int)nodes);
+        }
+        *hits += factdb_contains(db, "edge", a, b);
+    }
+    return now_ms() - start;
+}
+
+/* Lookups of one column value, alternating columns; returns ms */
+static double time_lookups(FactDatabase *db, int lookups, int nodes, long *rows) {
+    unsigned int seed = 13u;
+    *rows = 0;
+    double start = now_ms();
+    for (int i = 0; i < lookups; i++) {
+        int v = (int)(next_random(&seed) % (unsigned int)nodes);
+        QueryResult *results = factdb_query(db, "edge", i % 2 ? v : -1, i % 2 ? -1 : v);
+        *rows += query_result_count(results);
+        query_result_free(results);
+    }
+    return now_ms() - start;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Benchmark
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void bench_freeze(int facts, int probes) {
+    int nodes = facts / 8;
+    FactDatabase db;
+    if (!build_relation(&db, facts, nodes)) {
+        printf("  %10d  out of memory\n", facts);
+        factdb_cleanup(&db);
+        return;
+    }
+
+    const char *layouts[2] = {"sorted", "frozen"};
+    for (int frozen = 0; frozen < 2; frozen++) {
+        double freeze_ms = 0.0;
+        if (frozen) {
+            double start = now_ms();
+            if (!factdb_freeze(&db)) {
+                printf("  %10d  out of memory\n", facts);
+                break;
+            }
+            freeze_ms = now_ms() - start;
+        }
+
+        int hits;
+        long rows;
+        double probe_ms = time_probes(&db, probes, facts, nodes, &hits);
+        double lookup_ms = time_lookups(&db, probes / 500, nodes, &rows);
+        size_t bytes = relation_bytes(&db);
+        printf("  %10ld %7s %9.1f %9.1f %10.1f %9.1f %9d\n",
+               factdb_relation_size(&db, "edge"), layouts[frozen],
+               (double)bytes / (double)factdb_relation_size(&db, "edge"),
+               freeze_ms, probe_ms, lookup_ms, hits);
+    }
+    factdb_cleanup(&db);
+}
+
+int main(int argc, char **argv) {
+    int max_facts = argc > 1 ? atoi(argv[1]) : 8000000;
+    int probes = 1000000;
+
+    printf("ByteLog Freeze Benchmark: sorted vs frozen storage\n");
+    printf("═══════════════════════════════════════════════════════════════════════\n");
+    printf("  %10s %7s %9s %9s %10s %9s %9s\n",
+           "facts", "layout", "bytes/f", "freeze-ms", "probe-ms", "lookup-ms", "hits");
+    printf("  ─────────────────────────────────────────────────────────────────────\n");
+
+    for (int facts = 125000; facts <= max_facts; facts *= 4) {
+        bench_freeze(facts, probes);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bench_import.c - Fact File Import Benchmark
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Writes two temporary edge files, one of integer node IDs and one of atom
+ * names, then times factfile_load on each at increasing thread counts.
+ * Integer columns never touch the atom table, so they show the parser's
+ * throughput; the atom file adds the per-chunk interning step.
+ *
+ * A second table times the FACT statements of a parsed program, loaded one
+ * statement at a time and through engine_execute_program's bulk path.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "factfile.h"
+#include "parallel.h"
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+/* Write `lines` random edges over `nodes` nodes; returns the file size */
+static long write_edges(const char *path, int lines, int nodes, bool atoms) {
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+
+    unsigned int seed = 11u;
+    for (int i = 0; i < lines; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        if (atoms) {
+            fprintf(file, "node_%d\tnode_%d\n", a, b);
+        } else {
+            fprintf(file, "%d\t%d\n", a, b);
+        }
+    }
+    fclose(file);
+
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Benchmark
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void bench_load(const char *label, const char *path, long bytes, int threads) {
+    FactDatabase db;
+    AtomTable atoms;
+    char error[256];
+
+    factdb_init(&db);
+    atom_table_init(&atoms);
+    parallel_set_thread_count(threads);
+
+    double start = now_ms();
+    long facts = factfile_load(&db, &atoms, "edge", path, error, sizeof(error));
+    double elapsed = now_ms() - start;
+
+    if (facts < 0) {
+        printf("  %-6s %7d  failed: %s\n", label, threads, error);
+    } else {
+        printf("  %-6s %7d %10ld %9.1f %9.1f\n", label, threads, facts, elapsed,
+               bytes / (1024.0 * 1024.0) / (elapsed / 1000.0));
+    }
+    factdb_cleanup(&db);
+    atom_table_free(&atoms);
+}
+
+/* Run a program's FACT statements one by one, or through the bulk path */
+static void bench_program(const ASTNode *ast, int lines, bool bulk) {
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    if (!engine) return;
+    engine_init(engine);
+
+    double start = now_ms();
+    bool ok = true;
+    if (bulk) {
+        ok = engine_execute_program(engine, ast);
+    } else {
+        for (const ASTNode *stmt = ast->data.program.statements; stmt && ok; stmt = stmt->next) {
+            ok = engine_execute_statement(engine, stmt);
+        }
+        ok = ok && factdb_merge(&engine->facts) >= 0;
+    }
+    double elapsed = now_ms() - start;
+
+    printf("  %-9s %9d %10ld %9.1f %11.0f\n", bulk ? "bulk" : "per-fact", lines,
+           ok ? factdb_count(&engine->facts) : -1L, elapsed, lines / (elapsed / 1000.0));
+    engine_cleanup(engine);
+    free(engine);
+}
+
+int main(int argc, char **argv) {
+    int lines = argc > 1 ? atoi(argv[1]) : 8000000;
+    int nodes = lines / 4 > 0 ? lines / 4 : 1;
+    int max_threads = parallel_thread_count();
+    const char *dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+    char ints[512], names[512];
+    snprintf(ints, sizeof(ints), "%s/bytelog_import_%d_ints.tsv", dir, (int)getpid());
+    snprintf(names, sizeof(names), "%s/bytelog_import_%d_atoms.tsv", dir, (int)getpid());
+    long int_bytes = write_edges(ints, lines, nodes, false);
+    long name_bytes = write_edges(names, lines, nodes, true);
+    if (int_bytes < 0 || name_bytes < 0) {
+        fprintf(stderr, "Cannot write benchmark files in %s\n", dir);
+        unlink(ints);
+        unlink(names);
+        return 1;
+    }
+
+    printf("ByteLog Import Benchmark: %d edges over %d nodes\n", lines, nodes);
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-6s %7s %10s %9s %9s\n", "column", "threads", "facts", "load-ms", "MB/s");
+    printf("  ─────────────────────────────────────────────────────────────\n");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        bench_load("int", ints, int_bytes, threads);
+        bench_load("atom", names, name_bytes, threads);
+    }
+    if (max_threads & (max_threads - 1)) {
+        bench_load("int", ints, int_bytes, max_threads);
+        bench_load("atom", names, name_bytes, max_threads);
+    }
+
+    parallel_set_thread_count(0);
+    unlink(ints);
+    unlink(names);
+
+    /* Program facts over an undeclared relation */
+    int program_lines = lines / 16 > 0 ? lines / 16 : 1;
+    size_t capacity = (size_t)program_lines * 40 + 64;
+    char *source = malloc(capacity);
+    if (!source) return 1;
+    size_t length = (size_t)snprintf(source, capacity, "REL edge\n");
+    unsigned int seed = 3u;
+    for (int i = 0; i < program_lines; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        length += (size_t)snprintf(source + length, capacity - length, "FACT edge %d %d\n", a, b);
+    }
+
+    char error[512];
+    ASTNode *ast = parse_string(source, error, sizeof(error));
+    free(source);
+    if (!ast) {
+        fprintf(stderr, "Parse failed: %s\n", error);
+        return 1;
+    }
+
+    printf("\nProgram FACT statements\n");
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-9s %9s %10s %9s %11s\n", "path", "facts", "stored", "load-ms", "facts/s");
+    printf("  ─────────────────────────────────────────────────────────────\n");
+    bench_program(ast, program_lines, false);
+    bench_program(ast, program_lines, true);
+    ast_free_tree(ast);
+    return 0;
+}
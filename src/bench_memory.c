@@ -0,0 +1,147 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bench_memory.c - Relation Memory Benchmark
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Builds a large sorted relation twice, once on base pages and once with
+ * huge pages enabled, and runs the same random membership probes against
+ * each.  Every binary search step touches a different page of the tuple
+ * array, so on base pages most steps also miss the TLB.
+ *
+ * dTLB read misses come from perf_event_open; where the kernel does not
+ * allow it (containers, perf_event_paranoid) only times are reported.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "engine.h"
+#include "parallel.h"
+#include "relmem.h"
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+/* Counter of this thread's dTLB read misses, -1 when unavailable */
+static int tlb_counter_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static const char* backing_name(RelMemBacking backing) {
+    switch (backing) {
+        case RELMEM_HEAP: return "heap";
+        case RELMEM_MAPPED: return "4k";
+        case RELMEM_TRANSPARENT: return "thp";
+        case RELMEM_HUGETLB: return "hugetlb";
+        case RELMEM_SPILLED: return "disk";
+    }
+    return "?";
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Benchmark
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void bench_probes(int facts, int probe_count, bool huge) {
+    FactDatabase db;
+    unsigned int seed = 7u;
+    int nodes = facts / 8;
+
+    relmem_set_huge_pages(huge);
+    void *sample = relmem_alloc(RELMEM_HUGE_PAGE);
+    const char *backing = sample ? backing_name(relmem_backing(sample)) : "none";
+    relmem_free(sample);
+
+    factdb_init(&db);
+    bool ok = factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, true);
+    for (int i = 0; ok && i < facts; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        ok = factdb_insert(&db, "edge", a, b) >= 0;
+    }
+    if (!ok || factdb_merge(&db) < 0) {
+        printf("  %10d %8s  out of memory\n", facts, backing);
+        factdb_cleanup(&db);
+        return;
+    }
+
+    int counter = tlb_counter_open();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    int hits = 0;
+    seed = 11u;
+    double start = now_ms();
+    for (int i = 0; i < probe_count; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        hits += factdb_contains(&db, "edge", a, b);
+    }
+    double elapsed = now_ms() - start;
+
+    long long misses = -1;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+        close(counter);
+    }
+
+    if (misses >= 0) {
+        printf("  %10ld %8s %10d %11.1f %14lld\n",
+               factdb_count(&db), backing, hits, elapsed, misses);
+    } else {
+        printf("  %10ld %8s %10d %11.1f %14s\n",
+               factdb_count(&db), backing, hits, elapsed, "n/a");
+    }
+    factdb_cleanup(&db);
+}
+
+int main(int argc, char **argv) {
+    int max_facts = argc > 1 ? atoi(argv[1]) : 16000000;
+    int probe_count = 2000000;
+
+    /* Pinned workers first-touch the same shards on every run */
+    parallel_set_pinning(true);
+
+    printf("ByteLog Memory Benchmark: random probes of a sorted relation\n");
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %10s %8s %10s %11s %14s\n", "facts", "pages", "hits", "probe-ms", "dtlb-misses");
+    printf("  ─────────────────────────────────────────────────────────────\n");
+
+    for (int facts = 1000000; facts <= max_facts; facts *= 4) {
+        bench_probes(facts, probe_count, false);
+        bench_probes(facts, probe_count, true);
+    }
+    relmem_set_huge_pages(true);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bench_probe.c - Batched Index Probe Benchmark
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Inserts derived facts into a large sorted relation, half of them already
+ * present, one lookup at a time and then with factdb_insert_batch:
+ *
+ *   factdb_insert        binary search per fact, each step a dependent miss
+ *   factdb_insert_batch  PARALLEL_PROBE_GROUP searches run in lockstep with
+ *                        every step's loads prefetched together
+ *
+ * Once the tuple array outgrows the last-level cache, the batched probes
+ * overlap their misses and the gap widens.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Helpers
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+/* Sorted relation of `facts` random pairs, merged so probes hit the array */
+static bool build_relation(FactDatabase *db, int facts, unsigned int seed) {
+    factdb_init(db);
+    if (!factdb_set_storage(db, "edge", RELATION_STORAGE_SORTED, true)) return false;
+
+    int nodes = facts / 8;
+    for (int i = 0; i < facts; i++) {
+        int a = (int)(next_random(&seed) % (unsigned int)nodes);
+        int b = (int)(next_random(&seed) % (unsigned int)nodes);
+        if (factdb_insert(db, "edge", a, b) < 0) return false;
+    }
+    return factdb_merge(db) >= 0;
+}
+
+/* Probe pairs: even ones copied from the relation, odd ones random */
+static FactPair* make_probes(FactDatabase *db, int count, unsigned int seed) {
+    FactPair *stored;
+    int stored_count = factdb_export(db, "edge", &stored);
+    FactPair *probes = malloc((size_t)count * sizeof(FactPair));
+    if (stored_count <= 0 || !probes) {
+        free(stored);
+        free(probes);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (i % 2 == 0) {
+            probes[i] = stored[next_random(&seed) % (unsigned int)stored_count];
+        } else {
+            probes[i].arg_a = (int)next_random(&seed);
+            probes[i].arg_b = (int)next_random(&seed);
+        }
+    }
+    free(stored);
+    return probes;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Benchmark
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void bench_inserts(int facts, int probe_count) {
+    FactDatabase single, batched;
+    FactPair *probes = NULL;
+    bool ok = build_relation(&single, facts, 7u) && build_relation(&batched, facts, 7u);
+    if (ok) probes = make_probes(&single, probe_count, 11u);
+    if (!probes) {
+        printf("  %10d  out of memory\n", facts);
+        factdb_cleanup(&single);
+        factdb_cleanup(&batched);
+        return;
+    }
+
+    int single_added = 0;
+    double start = now_ms();
+    for (int i = 0; i < probe_count; i++) {
+        single_added += factdb_insert(&single, "edge", probes[i].arg_a, probes[i].arg_b) > 0;
+    }
+    double single_ms = now_ms() - start;
+
+    start = now_ms();
+    int batched_added = factdb_insert_batch(&batched, "edge", probes, probe_count, NULL);
+    double batched_ms = now_ms() - start;
+
+    printf("  %10ld %10d %10d %11.1f %11.1f %8.1fx%s\n",
+           factdb_count(&single), probe_count, batched_added,
+           single_ms, batched_ms, batched_ms > 0 ? single_ms / batched_ms : 0.0,
+           single_added != batched_added ? "  MISMATCH" : "");
+
+    free(probes);
+    factdb_cleanup(&single);
+    factdb_cleanup(&batched);
+}
+
+int main(int argc, char **argv) {
+    int max_facts = argc > 1 ? atoi(argv[1]) : 8000000;
+    int probe_count = 1000000;
+
+    printf("ByteLog Probe Benchmark: inserts into a sorted relation\n");
+    printf("═══════════════════════════════════════════════════════════════════════\n");
+    printf("  %10s %10s %10s %11s %11s %9s\n",
+           "facts", "probes", "new", "single-ms", "batched-ms", "speedup");
+    printf("  ─────────────────────────────────────────────────────────────────────\n");
+
+    for (int facts = 125000; facts <= max_facts; facts *= 4) {
+        bench_inserts(facts, probe_count);
+    }
+    return 0;
+}
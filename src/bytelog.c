@@ -0,0 +1,218 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * bytelog.c - ByteLog Embedding API
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Wraps an execution engine behind the opaque handle of bytelog.h.  The
+ * engine only sees rules inside the program it solves, so the handle moves
+ * every loaded RULE into a program of its own, ending in SOLVE, and solves
+ * by executing that program.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "bytelog.h"
+#include "atoms.h"
+#include "engine.h"
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Handle Structures
+ * ───────────────────────────────────────────────────────────────────────── */
+
+struct ByteLog {
+    ExecutionEngine engine;
+    ASTNode *rules;             /* SOLVE, then every loaded rule */
+    char error[512];
+};
+
+struct ByteLogResults {
+    QueryResult *results;
+    QueryResult *next;          /* Next fact to return */
+    int count;
+};
+
+static bool bytelog_fail(ByteLog *db, const char *message) {
+    snprintf(db->error, sizeof(db->error), "%s", message);
+    return false;
+}
+
+/* ID of an atom name or integer literal, -1 for an unknown atom */
+static int bytelog_lookup(ByteLog *db, const char *name) {
+    if (is_integer_literal(name)) {
+        bool success;
+        return parse_integer(name, &success);
+    }
+    return atom_table_lookup(&db->engine.atoms, name);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Handles
+ * ───────────────────────────────────────────────────────────────────────── */
+
+ByteLog* bytelog_create(void) {
+    ByteLog *db = calloc(1, sizeof(ByteLog));
+    if (!db) return NULL;
+
+    db->rules = ast_make_program(ast_make_solve(0, 0));
+    if (!db->rules || !db->rules->data.program.statements) {
+        ast_free_tree(db->rules);
+        free(db);
+        return NULL;
+    }
+    engine_init(&db->engine);
+    return db;
+}
+
+void bytelog_free(ByteLog *db) {
+    if (!db) return;
+    engine_cleanup(&db->engine);
+    ast_free_tree(db->rules);
+    free(db);
+}
+
+const char* bytelog_error(const ByteLog *db) {
+    return db->error;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Loading and Solving
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Keep a parsed program's rules, then run the rest of it */
+static bool bytelog_run(ByteLog *db, ASTNode *program) {
+    bool solve = false;
+    ASTNode **link = &program->data.program.statements;
+    while (*link) {
+        ASTNode *stmt = *link;
+        if (stmt->type != AST_RULE && stmt->type != AST_SOLVE) {
+            link = &stmt->next;
+            continue;
+        }
+        *link = stmt->next;
+        stmt->next = NULL;
+        if (stmt->type == AST_RULE) {
+            ast_append(db->rules->data.program.statements, stmt);
+        } else {
+            solve = true;
+            ast_free_tree(stmt);
+        }
+    }
+
+    bool ok = engine_execute_program(&db->engine, program);
+    ast_free_tree(program);
+    if (!ok) return bytelog_fail(db, engine_get_error(&db->engine));
+    return !solve || bytelog_solve(db);
+}
+
+bool bytelog_load_source(ByteLog *db, const char *source) {
+    if (!source) return bytelog_fail(db, "No source");
+
+    ASTNode *program = parse_string(source, db->error, sizeof(db->error));
+    return program && bytelog_run(db, program);
+}
+
+bool bytelog_load_file(ByteLog *db, const char *path) {
+    if (!path) return bytelog_fail(db, "No file");
+
+    ASTNode *program = parse_file(path, db->error, sizeof(db->error));
+    return program && bytelog_run(db, program);
+}
+
+bool bytelog_load_facts(ByteLog *db, const char *relation, const char *path) {
+    if (!engine_load_facts(&db->engine, relation, path)) {
+        return bytelog_fail(db, engine_get_error(&db->engine));
+    }
+    return true;
+}
+
+bool bytelog_insert(ByteLog *db, const char *relation, const char *a, const char *b) {
+    if (!relation || !a || !b) return bytelog_fail(db, "Missing relation or argument");
+    if (db->engine.facts.frozen) return bytelog_fail(db, "Database is frozen");
+
+    if (!factdb_add_fact(&db->engine.facts, relation, bytelog_atom(db, a), bytelog_atom(db, b))) {
+        return bytelog_fail(db, "Out of memory");
+    }
+    return true;
+}
+
+bool bytelog_solve(ByteLog *db) {
+    if (!engine_execute_program(&db->engine, db->rules)) {
+        return bytelog_fail(db, engine_get_error(&db->engine));
+    }
+    return true;
+}
+
+bool bytelog_freeze(ByteLog *db) {
+    if (!engine_freeze(&db->engine)) {
+        return bytelog_fail(db, engine_get_error(&db->engine));
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Atoms
+ * ───────────────────────────────────────────────────────────────────────── */
+
+int bytelog_atom(ByteLog *db, const char *name) {
+    if (is_integer_literal(name)) return bytelog_lookup(db, name);
+    return atom_table_intern(&db->engine.atoms, name);
+}
+
+const char* bytelog_atom_name(const ByteLog *db, int id) {
+    return atom_table_name(&db->engine.atoms, id);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Queries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+ByteLogResults* bytelog_query(ByteLog *db, const char *relation, const char *a, const char *b) {
+    int arg_a = a ? bytelog_lookup(db, a) : BYTELOG_ANY;
+    int arg_b = b ? bytelog_lookup(db, b) : BYTELOG_ANY;
+
+    /* An atom never interned is in no fact */
+    if (relation && ((a && arg_a < 0) || (b && arg_b < 0))) {
+        ByteLogResults *empty = calloc(1, sizeof(ByteLogResults));
+        if (!empty) bytelog_fail(db, "Out of memory");
+        return empty;
+    }
+    return bytelog_query_ids(db, relation, arg_a, arg_b);
+}
+
+ByteLogResults* bytelog_query_ids(ByteLog *db, const char *relation, int a, int b) {
+    if (!relation) {
+        bytelog_fail(db, "No relation");
+        return NULL;
+    }
+
+    ByteLogResults *results = calloc(1, sizeof(ByteLogResults));
+    if (!results) {
+        bytelog_fail(db, "Out of memory");
+        return NULL;
+    }
+    results->results = factdb_query(&db->engine.facts, relation, a, b);
+    results->next = results->results;
+    results->count = query_result_count(results->results);
+    return results;
+}
+
+int bytelog_results_count(const ByteLogResults *results) {
+    return results ? results->count : 0;
+}
+
+bool bytelog_results_next(ByteLogResults *results, int *a, int *b) {
+    if (!results || !results->next) return false;
+
+    *a = results->next->arg_a;
+    *b = results->next->arg_b;
+    results->next = results->next->next;
+    return true;
+}
+
+void bytelog_results_free(ByteLogResults *results) {
+    if (!results) return;
+    query_result_free(results->results);
+    free(results);
+}
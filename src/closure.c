@@ -0,0 +1,502 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * closure.c - ByteLog Dense Transitive Closure
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Atoms are renumbered 0..n-1 and each relation becomes n bit rows of
+ * ceil(n / 64) words.  Reflexive-transitive products G* . S are computed by
+ * row-OR propagation: Tarjan's algorithm condenses G into strongly connected
+ * components, which it emits sinks first, so each component's row is the
+ * OR of its members' rows and its (already final) successors' rows.  That
+ * costs O((n + m) * n / 64) word operations instead of Warshall's O(n^3 / 64).
+ * The OR loops are plain word loops the compiler vectorizes.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "closure.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Plan Recognition
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool plan_add(const char **names, int *count, const char *name) {
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(names[i], name) == 0) return true;
+    }
+    if (*count >= CLOSURE_MAX_INPUTS) return false;
+    names[(*count)++] = name;
+    return true;
+}
+
+/* Classify one rule emitting plan->target, false if it has no closure shape */
+static bool plan_rule(ClosurePlan *plan, const ASTNode *rule) {
+    const ASTNode *scan = rule->data.rule.body;
+    const ASTNode *emit = rule->data.rule.emit;
+    if (!scan || scan->type != AST_SCAN || scan->data.scan.has_match) return false;
+
+    const char *scanned = scan->data.scan.relation;
+    const ASTNode *join = scan->next;
+
+    /* SCAN base, EMIT r $1 $2 */
+    if (!join) {
+        if (emit->data.emit.var_a != 1 || emit->data.emit.var_b != 2) return false;
+        if (strcmp(scanned, plan->target) == 0) return true;
+        return plan_add(plan->bases, &plan->base_count, scanned);
+    }
+
+    /* SCAN x, JOIN y $1 $2, EMIT r $0 $2 */
+    if (join->type != AST_JOIN || join->next || !join->data.join.has_bind) return false;
+    if (join->data.join.match_var != 1 || join->data.join.bind_var != 2) return false;
+    if (emit->data.emit.var_a != 0 || emit->data.emit.var_b != 2) return false;
+
+    const char *joined = join->data.join.relation;
+    bool scans_target = strcmp(scanned, plan->target) == 0;
+    bool joins_target = strcmp(joined, plan->target) == 0;
+
+    if (scans_target && joins_target) {
+        plan->nonlinear = true;
+        return true;
+    }
+    if (scans_target) return plan_add(plan->right, &plan->right_count, joined);
+    if (joins_target) return plan_add(plan->left, &plan->left_count, scanned);
+    return false;
+}
+
+bool closure_plan(ClosurePlan *plan, const char *target,
+                  ASTNode *const *rules, int rule_count) {
+    memset(plan, 0, sizeof(*plan));
+    plan->target = target;
+
+    bool found = false;
+    for (int i = 0; i < rule_count; i++) {
+        const ASTNode *emit = rules[i]->data.rule.emit;
+        if (!emit || emit->type != AST_EMIT) continue;
+        if (strcmp(emit->data.emit.relation, target) != 0) continue;
+
+        if (!plan_rule(plan, rules[i])) return false;
+        found = true;
+    }
+
+    /* Mixing r . r with linear steps has no single-product closed form */
+    bool recursive = plan->nonlinear || plan->left_count > 0 || plan->right_count > 0;
+    if (plan->nonlinear && (plan->left_count > 0 || plan->right_count > 0)) return false;
+    return found && recursive;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bit Rows
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef struct BitMatrix {
+    uint64_t *words;
+    int rows;
+    int stride;                 /* Words per row */
+} BitMatrix;
+
+static bool matrix_init(BitMatrix *m, int n) {
+    m->rows = n;
+    m->stride = (n + 63) / 64;
+    m->words = calloc((size_t)n * (size_t)m->stride, sizeof(uint64_t));
+    return m->words != NULL;
+}
+
+static uint64_t* matrix_row(const BitMatrix *m, int row) {
+    return m->words + (size_t)row * (size_t)m->stride;
+}
+
+static void matrix_set(BitMatrix *m, int row, int col) {
+    matrix_row(m, row)[col / 64] |= (uint64_t)1 << (col % 64);
+}
+
+static void row_or(uint64_t *restrict dst, const uint64_t *restrict src, int words) {
+    for (int i = 0; i < words; i++) {
+        dst[i] |= src[i];
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Graphs and Components
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef enum {
+    CLOSURE_SOURCE_BASE,        /* Target or base relation, part of r0 */
+    CLOSURE_SOURCE_LEFT,
+    CLOSURE_SOURCE_RIGHT
+} ClosureRole;
+
+typedef struct ClosureSource {
+    ClosureRole role;
+    FactPair *tuples;           /* Atom values, then dense indices */
+    int count;
+} ClosureSource;
+
+typedef struct ClosureGraph {
+    int n;
+    int *offsets;               /* n + 1 edge offsets */
+    int *targets;               /* Edge targets grouped by source */
+} ClosureGraph;
+
+static void graph_free(ClosureGraph *g) {
+    free(g->offsets);
+    free(g->targets);
+}
+
+/* Adjacency lists over all sources with the given role */
+static bool graph_build(ClosureGraph *g, int n, const ClosureSource *sources,
+                        int source_count, ClosureRole role) {
+    size_t edges = 0;
+    for (int s = 0; s < source_count; s++) {
+        if (sources[s].role == role) edges += (size_t)sources[s].count;
+    }
+
+    g->n = n;
+    g->offsets = calloc((size_t)n + 1, sizeof(int));
+    g->targets = malloc((edges ? edges : 1) * sizeof(int));
+    if (!g->offsets || !g->targets) {
+        graph_free(g);
+        return false;
+    }
+
+    for (int s = 0; s < source_count; s++) {
+        if (sources[s].role != role) continue;
+        for (int i = 0; i < sources[s].count; i++) {
+            g->offsets[sources[s].tuples[i].arg_a + 1]++;
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        g->offsets[v + 1] += g->offsets[v];
+    }
+
+    /* offsets[v] is advanced while filling, then restored */
+    for (int s = 0; s < source_count; s++) {
+        if (sources[s].role != role) continue;
+        for (int i = 0; i < sources[s].count; i++) {
+            const FactPair *edge = &sources[s].tuples[i];
+            g->targets[g->offsets[edge->arg_a]++] = edge->arg_b;
+        }
+    }
+    for (int v = n; v > 0; v--) {
+        g->offsets[v] = g->offsets[v - 1];
+    }
+    g->offsets[0] = 0;
+    return true;
+}
+
+typedef struct Components {
+    int *component;             /* Component of each node */
+    int *members;               /* Nodes grouped by component, sinks first */
+    int *starts;                /* count + 1 offsets into members */
+    int count;
+} Components;
+
+static void components_free(Components *c) {
+    free(c->component);
+    free(c->members);
+    free(c->starts);
+}
+
+/* Iterative Tarjan; components come out in reverse topological order */
+static bool components_find(Components *c, const ClosureGraph *g) {
+    int n = g->n;
+    int *index = malloc((size_t)n * sizeof(int));
+    int *low = malloc((size_t)n * sizeof(int));
+    int *edge = malloc((size_t)n * sizeof(int));
+    int *stack = malloc((size_t)n * sizeof(int));
+    int *calls = malloc((size_t)n * sizeof(int));
+    bool *on_stack = calloc((size_t)n, sizeof(bool));
+    c->component = malloc((size_t)n * sizeof(int));
+    c->members = malloc((size_t)n * sizeof(int));
+    c->starts = malloc(((size_t)n + 1) * sizeof(int));
+    c->count = 0;
+
+    bool ok = index && low && edge && stack && calls && on_stack &&
+              c->component && c->members && c->starts;
+    if (ok) {
+        int counter = 0, sp = 0, emitted = 0;
+        for (int v = 0; v < n; v++) index[v] = -1;
+
+        for (int root = 0; root < n; root++) {
+            if (index[root] >= 0) continue;
+
+            int depth = 0;
+            calls[depth++] = root;
+            index[root] = low[root] = counter++;
+            edge[root] = g->offsets[root];
+            stack[sp++] = root;
+            on_stack[root] = true;
+
+            while (depth > 0) {
+                int v = calls[depth - 1];
+                if (edge[v] < g->offsets[v + 1]) {
+                    int w = g->targets[edge[v]++];
+                    if (index[w] < 0) {
+                        calls[depth++] = w;
+                        index[w] = low[w] = counter++;
+                        edge[w] = g->offsets[w];
+                        stack[sp++] = w;
+                        on_stack[w] = true;
+                    } else if (on_stack[w] && index[w] < low[v]) {
+                        low[v] = index[w];
+                    }
+                    continue;
+                }
+
+                if (low[v] == index[v]) {
+                    c->starts[c->count] = emitted;
+                    int w;
+                    do {
+                        w = stack[--sp];
+                        on_stack[w] = false;
+                        c->component[w] = c->count;
+                        c->members[emitted++] = w;
+                    } while (w != v);
+                    c->count++;
+                }
+
+                depth--;
+                if (depth > 0 && low[v] < low[calls[depth - 1]]) {
+                    low[calls[depth - 1]] = low[v];
+                }
+            }
+        }
+        c->starts[c->count] = emitted;
+    } else {
+        components_free(c);
+    }
+
+    free(index);
+    free(low);
+    free(edge);
+    free(stack);
+    free(calls);
+    free(on_stack);
+    return ok;
+}
+
+/* Replace every row of s with its row in G* . s */
+static bool closure_propagate(const ClosureGraph *g, BitMatrix *s) {
+    Components c;
+    if (!components_find(&c, g)) return false;
+
+    for (int k = 0; k < c.count; k++) {
+        int first = c.members[c.starts[k]];
+        uint64_t *row = matrix_row(s, first);
+
+        for (int m = c.starts[k]; m < c.starts[k + 1]; m++) {
+            int v = c.members[m];
+            if (v != first) row_or(row, matrix_row(s, v), s->stride);
+            for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+                int w = g->targets[e];
+                if (c.component[w] != k) row_or(row, matrix_row(s, w), s->stride);
+            }
+        }
+
+        /* Members of a component reach each other, so they share a row */
+        for (int m = c.starts[k] + 1; m < c.starts[k + 1]; m++) {
+            memcpy(matrix_row(s, c.members[m]), row, (size_t)s->stride * sizeof(uint64_t));
+        }
+    }
+
+    components_free(&c);
+    return true;
+}
+
+/* r0 . right+ added to r0, one bit of r0 at a time */
+static bool closure_compose_right(BitMatrix *r, const BitMatrix *step) {
+    uint64_t *original = malloc((size_t)r->stride * sizeof(uint64_t));
+    if (!original) return false;
+
+    for (int x = 0; x < r->rows; x++) {
+        uint64_t *row = matrix_row(r, x);
+        memcpy(original, row, (size_t)r->stride * sizeof(uint64_t));
+        for (int w = 0; w < r->stride; w++) {
+            for (uint64_t bits = original[w]; bits; bits &= bits - 1) {
+                int y = w * 64 + __builtin_ctzll(bits);
+                row_or(row, matrix_row(step, y), r->stride);
+            }
+        }
+    }
+
+    free(original);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Domain
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static uint64_t domain_key(int value) {
+    return (uint64_t)((uint32_t)value ^ 0x80000000u);
+}
+
+static int domain_value(uint64_t key) {
+    return (int)((uint32_t)key ^ 0x80000000u);
+}
+
+static int domain_index(const uint64_t *keys, int n, int value) {
+    uint64_t key = domain_key(value);
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Sorted distinct atoms of all sources, NULL when out of memory */
+static uint64_t* domain_build(const ClosureSource *sources, int source_count, int *n) {
+    size_t total = 0;
+    for (int s = 0; s < source_count; s++) {
+        total += 2 * (size_t)sources[s].count;
+    }
+
+    uint64_t *keys = malloc((total ? total : 1) * sizeof(uint64_t));
+    if (!keys) return NULL;
+
+    size_t k = 0;
+    for (int s = 0; s < source_count; s++) {
+        for (int i = 0; i < sources[s].count; i++) {
+            keys[k++] = domain_key(sources[s].tuples[i].arg_a);
+            keys[k++] = domain_key(sources[s].tuples[i].arg_b);
+        }
+    }
+    if (!parallel_radix_sort(keys, total)) {
+        free(keys);
+        return NULL;
+    }
+
+    *n = (int)parallel_unique(keys, total);
+    return keys;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Evaluation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define CLOSURE_MAX_SOURCES (1 + 3 * CLOSURE_MAX_INPUTS)
+
+static bool closure_compute(const ClosurePlan *plan, FactDatabase *db,
+                            ClosureSource *sources, int source_count,
+                            const uint64_t *keys, int n) {
+    BitMatrix r;
+    if (!matrix_init(&r, n)) return false;
+
+    for (int s = 0; s < source_count; s++) {
+        if (sources[s].role != CLOSURE_SOURCE_BASE) continue;
+        for (int i = 0; i < sources[s].count; i++) {
+            matrix_set(&r, sources[s].tuples[i].arg_a, sources[s].tuples[i].arg_b);
+        }
+    }
+
+    bool ok = true;
+    ClosureGraph g;
+
+    /* r0+ = r0* . r0 */
+    if (plan->nonlinear) {
+        ok = graph_build(&g, n, sources, source_count, CLOSURE_SOURCE_BASE);
+        if (ok) {
+            ok = closure_propagate(&g, &r);
+            graph_free(&g);
+        }
+    }
+
+    /* r0 . right* = r0 + r0 . (right* . right) */
+    if (ok && plan->right_count > 0) {
+        BitMatrix step;
+        ok = matrix_init(&step, n);
+        if (ok) {
+            for (int s = 0; s < source_count; s++) {
+                if (sources[s].role != CLOSURE_SOURCE_RIGHT) continue;
+                for (int i = 0; i < sources[s].count; i++) {
+                    matrix_set(&step, sources[s].tuples[i].arg_a, sources[s].tuples[i].arg_b);
+                }
+            }
+            ok = graph_build(&g, n, sources, source_count, CLOSURE_SOURCE_RIGHT);
+            if (ok) {
+                ok = closure_propagate(&g, &step) && closure_compose_right(&r, &step);
+                graph_free(&g);
+            }
+            free(step.words);
+        }
+    }
+
+    /* left* . r */
+    if (ok && plan->left_count > 0) {
+        ok = graph_build(&g, n, sources, source_count, CLOSURE_SOURCE_LEFT);
+        if (ok) {
+            ok = closure_propagate(&g, &r);
+            graph_free(&g);
+        }
+    }
+
+    for (int x = 0; x < n && ok; x++) {
+        const uint64_t *row = matrix_row(&r, x);
+        int a = domain_value(keys[x]);
+        for (int w = 0; w < r.stride && ok; w++) {
+            for (uint64_t bits = row[w]; bits && ok; bits &= bits - 1) {
+                int z = w * 64 + __builtin_ctzll(bits);
+                ok = factdb_insert(db, plan->target, a, domain_value(keys[z])) >= 0;
+            }
+        }
+    }
+
+    free(r.words);
+    return ok;
+}
+
+static bool source_add(ClosureSource *sources, int *count, FactDatabase *db,
+                       const char *relation, ClosureRole role) {
+    ClosureSource *source = &sources[*count];
+    source->role = role;
+    source->count = factdb_export(db, relation, &source->tuples);
+    if (source->count < 0) return false;
+    (*count)++;
+    return true;
+}
+
+bool closure_evaluate(const ClosurePlan *plan, FactDatabase *db,
+                      int max_domain, bool *applied) {
+    ClosureSource sources[CLOSURE_MAX_SOURCES];
+    int source_count = 0;
+    bool ok = source_add(sources, &source_count, db, plan->target, CLOSURE_SOURCE_BASE);
+
+    for (int i = 0; i < plan->base_count && ok; i++) {
+        ok = source_add(sources, &source_count, db, plan->bases[i], CLOSURE_SOURCE_BASE);
+    }
+    for (int i = 0; i < plan->left_count && ok; i++) {
+        ok = source_add(sources, &source_count, db, plan->left[i], CLOSURE_SOURCE_LEFT);
+    }
+    for (int i = 0; i < plan->right_count && ok; i++) {
+        ok = source_add(sources, &source_count, db, plan->right[i], CLOSURE_SOURCE_RIGHT);
+    }
+
+    int n = 0;
+    uint64_t *keys = ok ? domain_build(sources, source_count, &n) : NULL;
+    ok = ok && keys;
+
+    *applied = ok && n <= max_domain;
+    if (*applied && n > 0) {
+        /* Renumber atoms to rows in place */
+        for (int s = 0; s < source_count; s++) {
+            for (int i = 0; i < sources[s].count; i++) {
+                FactPair *tuple = &sources[s].tuples[i];
+                tuple->arg_a = domain_index(keys, n, tuple->arg_a);
+                tuple->arg_b = domain_index(keys, n, tuple->arg_b);
+            }
+        }
+        ok = closure_compute(plan, db, sources, source_count, keys, n);
+    }
+
+    for (int s = 0; s < source_count; s++) {
+        free(sources[s].tuples);
+    }
+    free(keys);
+    return ok;
+}
@@ -10,12 +10,16 @@
 #include "parser.h"
 #include "ast.h"
 #include "engine.h"
+#include "querycache.h"
 #include "wat_gen.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
+/* Files accepted through --input-facts */
+#define MAX_INPUT_FACTS 64
+
 static void print_usage(const char *program_name) {
     printf("Usage: %s [OPTIONS] <file.bl>\n", program_name);
     printf("ByteLog interpreter, analyzer, and compiler\n\n");
@@ -23,6 +27,10 @@ static void print_usage(const char *program_name) {
     printf("  -v, --verbose         Show detailed parsing and execution information\n");
     printf("  -c, --compile=FORMAT  Compile to target format (wat|wasm)\n");
     printf("  -o, --output=FILE     Output file (default: input.{wat|wasm}, use '-' for stdout)\n");
+    printf("  --memory-budget=MB    Spill relations past MB megabytes to temp files\n");
+    printf("  --spill-dir=DIR       Directory for spilled relations (default: $TMPDIR or /tmp)\n");
+    printf("  --input-facts REL=PATH  Load a two-column .tsv or .csv file into REL\n");
+    printf("  --freeze              Freeze the solved database before answering queries\n");
     printf("  -h, --help            Show this help message\n\n");
     printf("Examples:\n");
     printf("  %s program.bl                 # Run program, show results\n", program_name);
@@ -31,6 +39,7 @@ static void print_usage(const char *program_name) {
     printf("  %s --compile=wasm program.bl  # Compile to WASM binary\n", program_name);
     printf("  %s -c wat -o - program.bl     # Output WAT to stdout\n", program_name);
     printf("  %s -c wat -o output.wat prog.bl # Custom output file\n", program_name);
+    printf("  %s --input-facts edge=edges.tsv prog.bl # Import base facts\n", program_name);
 }
 
 static char* get_default_output_filename(const char *input_filename, const char *extension) {
@@ -186,7 +195,12 @@ typedef enum {
 int main(int argc, char **argv) {
     const char *filename = NULL;
     const char *output_file = NULL;
+    const char *spill_dir = NULL;
+    const char *input_facts[MAX_INPUT_FACTS];
+    int input_count = 0;
+    size_t memory_budget = 0;
     bool verbose = false;
+    bool freeze = false;
     ExecutionMode mode = MODE_INTERPRET;
     
     /* Parse command line arguments */
@@ -232,6 +246,38 @@ int main(int argc, char **argv) {
                 }
                 output_file = argv[++i];
             }
+        } else if (strncmp(argv[i], "--memory-budget=", 16) == 0) {
+            char *end;
+            unsigned long long megabytes = strtoull(argv[i] + 16, &end, 10);
+            if (*end != '\0' || megabytes == 0) {
+                fprintf(stderr, "Invalid memory budget: %s\n", argv[i] + 16);
+                return 1;
+            }
+            memory_budget = (size_t)megabytes << 20;
+        } else if (strcmp(argv[i], "--freeze") == 0) {
+            freeze = true;
+        } else if (strncmp(argv[i], "--spill-dir=", 12) == 0) {
+            spill_dir = argv[i] + 12;
+        } else if (strcmp(argv[i], "--input-facts") == 0 ||
+                   strncmp(argv[i], "--input-facts=", 14) == 0) {
+            const char *spec = argv[i][13] == '=' ? argv[i] + 14 : NULL;
+            if (!spec) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "Option --input-facts requires a REL=PATH argument\n");
+                    return 1;
+                }
+                spec = argv[++i];
+            }
+            const char *equals = strchr(spec, '=');
+            if (!equals || equals == spec || equals[1] == '\0') {
+                fprintf(stderr, "Invalid input facts (expected REL=PATH): %s\n", spec);
+                return 1;
+            }
+            if (input_count == MAX_INPUT_FACTS) {
+                fprintf(stderr, "Too many --input-facts files (at most %d)\n", MAX_INPUT_FACTS);
+                return 1;
+            }
+            input_facts[input_count++] = spec;
         } else if (argv[i][0] == '-') {
             fprintf(stderr, "Unknown option: %s\n", argv[i]);
             print_usage(argv[0]);
@@ -409,8 +455,26 @@ int main(int argc, char **argv) {
     
     engine_init(engine);
     engine_set_debug(engine, false);  /* Set to true for detailed execution trace */
+    if (memory_budget) engine_set_memory_budget(engine, memory_budget, spill_dir);
+    
+    /* Import base facts before the program's own facts and rules */
+    for (int i = 0; i < input_count; i++) {
+        const char *equals = strchr(input_facts[i], '=');
+        char relation[256];
+        snprintf(relation, sizeof(relation), "%.*s",
+                 (int)(equals - input_facts[i]), input_facts[i]);
+        
+        if (!engine_load_facts(engine, relation, equals + 1)) {
+            fprintf(stderr, "Import error: %s\n", engine_get_error(engine));
+            engine_cleanup(engine);
+            free(engine);
+            ast_free_tree(ast);
+            return 1;
+        }
+        if (verbose) printf("Imported %s into '%s'\n", equals + 1, relation);
+    }
     
-    if (!engine_execute_program(engine, ast)) {
+    if (!engine_execute_program(engine, ast) || (freeze && !engine_freeze(engine))) {
         if (verbose) {
             printf("❌ Execution failed: %s\n", engine_get_error(engine));
         } else {
@@ -435,8 +499,31 @@ int main(int argc, char **argv) {
         printf("─────────────────────────────────────────\n");
     }
     
+    /* Answer every query in one batch, then print them in program order */
+    int query_total = 0;
+    for (stmt = ast->data.program.statements; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_QUERY) query_total++;
+    }
+    const ASTNode **queries = malloc(((size_t)query_total + 1) * sizeof(ASTNode *));
+    QueryResult **answers = malloc(((size_t)query_total + 1) * sizeof(QueryResult *));
+    if (!queries || !answers) {
+        fprintf(stderr, "Out of memory answering queries\n");
+        free(queries);
+        free(answers);
+        engine_cleanup(engine);
+        free(engine);
+        ast_free_tree(ast);
+        return 1;
+    }
+    query_total = 0;
+    for (stmt = ast->data.program.statements; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_QUERY) queries[query_total++] = stmt;
+    }
+    engine_query_batch(engine, queries, query_total, answers);
+    
     stmt = ast->data.program.statements;
     int query_num = 1;
+    int answered = 0;
     while (stmt) {
         if (stmt->type == AST_QUERY) {
             if (verbose) {
@@ -460,8 +547,7 @@ int main(int argc, char **argv) {
                 }
             }
             
-            /* Execute the query */
-            QueryResult *results = engine_query(engine, stmt);
+            QueryResult *results = answers[answered++];
             if (results) {
                 query_result_print(results, stmt->data.query.relation, &engine->atoms);
                 query_result_free(results);
@@ -472,8 +558,13 @@ int main(int argc, char **argv) {
         }
         stmt = stmt->next;
     }
+    free(queries);
+    free(answers);
     
     if (verbose) {
+        QueryCacheStats stats;
+        engine_query_cache_stats(engine, &stats);
+        printf("Query cache: %ld hits, %ld misses\n\n", stats.hits, stats.misses);
         printf("🎯 ByteLog program executed successfully!\n");
     }
     
@@ -9,8 +9,17 @@
  */
 
 #include "engine.h"
+#include "closure.h"
+#include "epoch.h"
+#include "factfile.h"
+#include "factset.h"
+#include "join.h"
 #include "parser.h"
+#include "parallel.h"
+#include "querycache.h"
+#include "relmem.h"
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
@@ -52,14 +61,778 @@ static unsigned int hash_fact(const char *relation, int arg_a, int arg_b) {
     return hash % FACT_DATABASE_SIZE;
 }
 
+static unsigned int hash_relation(const char *relation) {
+    unsigned int hash = 5381;
+    
+    for (const char *c = relation; *c; c++) {
+        hash = ((hash << 5) + hash) + (unsigned char)*c;
+    }
+    
+    return hash % RELATION_TABLE_SIZE;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Relation Registry
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static Relation* factdb_find_relation(const FactDatabase *db, const char *relation) {
+    for (Relation *rel = db->relations[hash_relation(relation)]; rel; rel = rel->next) {
+        if (strcmp(rel->name, relation) == 0) {
+            return rel;
+        }
+    }
+    return NULL;
+}
+
+/* Find or register a relation (new relations use hash storage) */
+static Relation* factdb_relation(FactDatabase *db, const char *relation) {
+    Relation *rel = factdb_find_relation(db, relation);
+    if (rel) return rel;
+    
+    rel = calloc(1, sizeof(Relation));
+    if (!rel) return NULL;
+    
+    rel->name = strdup(relation);
+    if (!rel->name) {
+        free(rel);
+        return NULL;
+    }
+    rel->storage = RELATION_STORAGE_HASH;
+    unionfind_init(&rel->classes);
+    
+    unsigned int bucket = hash_relation(relation);
+    rel->next = db->relations[bucket];
+    db->relations[bucket] = rel;
+    return rel;
+}
+
+static Relation* factdb_sorted_relation(const FactDatabase *db, const char *relation) {
+    Relation *rel = factdb_find_relation(db, relation);
+    return rel && rel->storage == RELATION_STORAGE_SORTED ? rel : NULL;
+}
+
+static Relation* factdb_equivalence_relation(const FactDatabase *db, const char *relation) {
+    Relation *rel = factdb_find_relation(db, relation);
+    return rel && rel->storage == RELATION_STORAGE_EQUIVALENCE ? rel : NULL;
+}
+
+/* Order a pair the way a symmetric relation stores it */
+static void relation_canonicalize(const Relation *rel, int *arg_a, int *arg_b) {
+    if (rel && rel->symmetric && rel->storage != RELATION_STORAGE_FROZEN && *arg_a > *arg_b) {
+        int swap = *arg_a;
+        *arg_a = *arg_b;
+        *arg_b = swap;
+    }
+}
+
+/* Facts a stored pair stands for: symmetric pairs off the diagonal are two */
+static long relation_weight(const Relation *rel, int arg_a, int arg_b) {
+    return rel && rel->symmetric && rel->storage != RELATION_STORAGE_FROZEN && arg_a != arg_b ? 2 : 1;
+}
+
+static void relation_free_postings(Relation *rel) {
+    for (int i = 0; i < rel->posting_count; i++) {
+        roaring_free(&rel->postings[i].values);
+    }
+    free(rel->postings);
+    rel->postings = NULL;
+    rel->posting_count = 0;
+    rel->posting_capacity = 0;
+    rel->posted = 0;
+}
+
+static void relation_free(Relation *rel) {
+    free(rel->name);
+    relmem_free(rel->tuples);
+    relmem_free(rel->delta);
+    if (rel->pending.table) factset_free(&rel->pending);
+    relation_free_postings(rel);
+    unionfind_free(&rel->classes);
+    frozen_free(&rel->frozen);
+    free(rel);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Sorted Relation Storage
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool tuple_less(const FactPair *tuple, int arg_a, int arg_b) {
+    return tuple->arg_a < arg_a || (tuple->arg_a == arg_a && tuple->arg_b < arg_b);
+}
+
+/* First index in [lo, hi) whose tuple is >= (arg_a, arg_b).  Gallops from
+ * lo so a cursor moving forward pays O(log distance) per probe. */
+static int tuple_gallop(const FactPair *tuples, int lo, int hi, int arg_a, int arg_b) {
+    int step = 1;
+    int bound = lo;
+    
+    while (bound < hi && tuple_less(&tuples[bound], arg_a, arg_b)) {
+        lo = bound + 1;
+        bound += step;
+        step <<= 1;
+    }
+    if (bound > hi) bound = hi;
+    
+    while (lo < bound) {
+        int mid = lo + (bound - lo) / 2;
+        if (tuple_less(&tuples[mid], arg_a, arg_b)) {
+            lo = mid + 1;
+        } else {
+            bound = mid;
+        }
+    }
+    return lo;
+}
+
+/* Posting for a high-degree key, NULL if the key lives in the array */
+static Posting* relation_find_posting(const Relation *rel, int arg_a) {
+    int lo = 0, hi = rel->posting_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (rel->postings[mid].arg_a < arg_a) {
+            lo = mid + 1;
+        } else if (rel->postings[mid].arg_a > arg_a) {
+            hi = mid;
+        } else {
+            return &rel->postings[mid];
+        }
+    }
+    return NULL;
+}
+
+static bool relation_contains(const Relation *rel, int arg_a, int arg_b) {
+    const Posting *posting = relation_find_posting(rel, arg_a);
+    if (posting) {
+        return roaring_contains(&posting->values, roaring_encode(arg_b));
+    }
+    
+    int pos = tuple_gallop(rel->tuples, 0, rel->count, arg_a, arg_b);
+    return pos < rel->count &&
+           rel->tuples[pos].arg_a == arg_a && rel->tuples[pos].arg_b == arg_b;
+}
+
+/* Lower bounds of n (arg_a, arg_b) probes in tuples[0..count), searched
+ * in lockstep.  The searches halve the same length each step, so a step
+ * prefetches all of the next step's loads before comparing any of them
+ * and the cache misses of independent probes overlap. */
+static void tuple_lower_bounds(const FactPair *tuples, int count,
+                               const FactPair *probes, int n, int *at) {
+    for (int k = 0; k < n; k++) at[k] = 0;
+    if (count == 0) return;
+    
+    int len = count;
+    while (len > 1) {
+        int half = len / 2;
+        for (int k = 0; k < n; k++) {
+            at[k] += tuple_less(&tuples[at[k] + half], probes[k].arg_a, probes[k].arg_b) ? half : 0;
+            parallel_prefetch(&tuples[at[k] + (len - half) / 2]);
+        }
+        len -= half;
+    }
+    for (int k = 0; k < n; k++) {
+        at[k] += tuple_less(&tuples[at[k]], probes[k].arg_a, probes[k].arg_b);
+    }
+}
+
+/* relation_contains for a group of at most PARALLEL_PROBE_GROUP pairs */
+static void relation_contains_group(const Relation *rel, const FactPair *pairs, int n,
+                                    bool *found) {
+    int at[PARALLEL_PROBE_GROUP];
+    tuple_lower_bounds(rel->tuples, rel->count, pairs, n, at);
+    
+    for (int k = 0; k < n; k++) {
+        const Posting *posting = rel->posting_count > 0 ?
+            relation_find_posting(rel, pairs[k].arg_a) : NULL;
+        if (posting) {
+            found[k] = roaring_contains(&posting->values, roaring_encode(pairs[k].arg_b));
+        } else {
+            found[k] = at[k] < rel->count &&
+                       rel->tuples[at[k]].arg_a == pairs[k].arg_a &&
+                       rel->tuples[at[k]].arg_b == pairs[k].arg_b;
+        }
+    }
+}
+
+/* Pending inserts a size hint allocates up front: half a huge page, so
+ * the buffer comes from the heap and relmem never faults it in whole */
+#define RELATION_HINT_DELTA ((int)(RELMEM_HUGE_PAGE / 2 / sizeof(uint64_t)))
+
+static bool relation_reserve_delta(Relation *rel, int needed) {
+    if (needed <= rel->delta_capacity) return true;
+    
+    /* The first buffer takes what the size hint still expects, within
+     * bounds; later ones double */
+    int capacity = rel->delta_capacity;
+    if (capacity == 0) {
+        int expected = rel->size_hint - rel->count;
+        capacity = expected < 64 ? 64 :
+                   expected < RELATION_HINT_DELTA ? expected : RELATION_HINT_DELTA;
+    }
+    while (capacity < needed) capacity *= 2;
+    
+    uint64_t *delta = relmem_realloc(rel->delta, (size_t)capacity * sizeof(uint64_t));
+    if (!delta) return false;
+    rel->delta = delta;
+    rel->delta_capacity = capacity;
+    return true;
+}
+
+/* Forget the pending inserts' keys once the buffer is emptied */
+static void relation_clear_pending(Relation *rel) {
+    rel->delta_count = 0;
+    rel->pending_indexed = 0;
+    if (rel->pending.table) factset_clear(&rel->pending);
+}
+
+/* Claim a key not in the tuple array for the pending inserts.  Keys
+ * buffered without a check (bulk loads, conversions) are indexed first.
+ * Returns 1 if the key is new, 0 if it is already pending, -1 on error. */
+static int relation_claim_pending(Relation *rel, uint64_t key) {
+    if (!rel->pending.table && !factset_init(&rel->pending, 0)) return -1;
+    for (; rel->pending_indexed < rel->delta_count; rel->pending_indexed++) {
+        if (factset_insert(&rel->pending, rel->delta[rel->pending_indexed]) < 0) return -1;
+    }
+    return factset_insert(&rel->pending, key);
+}
+
+/* Buffer a pair unless it is already pending.  Returns as
+ * relation_claim_pending. */
+static int relation_push_delta(Relation *rel, int arg_a, int arg_b) {
+    if (!relation_reserve_delta(rel, rel->delta_count + 1)) return -1;
+    
+    uint64_t key = parallel_pack_pair(arg_a, arg_b);
+    int fresh = relation_claim_pending(rel, key);
+    if (fresh <= 0) return fresh;
+    rel->delta[rel->delta_count++] = key;
+    rel->pending_indexed = rel->delta_count;
+    return 1;
+}
+
+/* Fold a sorted run of new values for one key into its posting with
+ * the bitmap OR kernel.  Returns the number of new values or -1. */
+static int posting_merge(Posting *posting, const uint64_t *delta, int n) {
+    RoaringBitmap run, merged;
+    roaring_init(&run);
+    
+    for (int i = 0; i < n; i++) {
+        if (!roaring_add(&run, roaring_encode(parallel_unpack_b(delta[i])))) {
+            roaring_free(&run);
+            return -1;
+        }
+    }
+    
+    long before = roaring_cardinality(&posting->values);
+    bool ok = roaring_or(&posting->values, &run, &merged);
+    roaring_free(&run);
+    if (!ok) return -1;
+    
+    roaring_free(&posting->values);
+    posting->values = merged;
+    return (int)(roaring_cardinality(&merged) - before);
+}
+
+static bool relation_insert_posting(Relation *rel, const Posting *posting) {
+    if (rel->posting_count == rel->posting_capacity) {
+        int capacity = rel->posting_capacity ? rel->posting_capacity * 2 : 4;
+        Posting *postings = realloc(rel->postings, (size_t)capacity * sizeof(Posting));
+        if (!postings) return false;
+        rel->postings = postings;
+        rel->posting_capacity = capacity;
+    }
+    
+    int pos = rel->posting_count;
+    while (pos > 0 && rel->postings[pos - 1].arg_a > posting->arg_a) {
+        rel->postings[pos] = rel->postings[pos - 1];
+        pos--;
+    }
+    rel->postings[pos] = *posting;
+    rel->posting_count++;
+    return true;
+}
+
+/* Drop one value from a posting by rebuilding its bitmap; a posting left
+ * empty is removed */
+static bool relation_posting_remove(Relation *rel, Posting *posting, int arg_b) {
+    RoaringBitmap rest;
+    RoaringIterator it;
+    uint32_t value, removed = roaring_encode(arg_b);
+    
+    roaring_init(&rest);
+    roaring_iterator_init(&it, &posting->values);
+    while (roaring_iterator_next(&it, &value)) {
+        if (value != removed && !roaring_add(&rest, value)) {
+            roaring_free(&rest);
+            return false;
+        }
+    }
+    
+    roaring_free(&posting->values);
+    if (roaring_cardinality(&rest) > 0) {
+        posting->values = rest;
+        return true;
+    }
+    
+    roaring_free(&rest);
+    int index = (int)(posting - rel->postings);
+    memmove(rel->postings + index, rel->postings + index + 1,
+            (size_t)(rel->posting_count - index - 1) * sizeof(Posting));
+    rel->posting_count--;
+    return true;
+}
+
+/* Remove a merged tuple, returns 1 if it was stored, 0 if not, -1 when
+ * out of memory */
+static int relation_retract(Relation *rel, int arg_a, int arg_b) {
+    Posting *posting = relation_find_posting(rel, arg_a);
+    if (posting) {
+        if (!roaring_contains(&posting->values, roaring_encode(arg_b))) return 0;
+        if (!relation_posting_remove(rel, posting, arg_b)) return -1;
+        rel->posted--;
+        return 1;
+    }
+    
+    int pos = tuple_gallop(rel->tuples, 0, rel->count, arg_a, arg_b);
+    if (pos == rel->count || rel->tuples[pos].arg_a != arg_a || rel->tuples[pos].arg_b != arg_b) {
+        return 0;
+    }
+    memmove(rel->tuples + pos, rel->tuples + pos + 1,
+            (size_t)(rel->count - pos - 1) * sizeof(FactPair));
+    rel->count--;
+    return 1;
+}
+
+/* Move adjacency lists longer than ROARING_DEGREE_THRESHOLD out of the
+ * tuple array into bitmap postings.  Lists stay in the array when their
+ * bitmap cannot be allocated. */
+static void relation_promote(Relation *rel) {
+    int write = 0;
+    int i = 0;
+    
+    while (i < rel->count) {
+        int end = i + 1;
+        while (end < rel->count && rel->tuples[end].arg_a == rel->tuples[i].arg_a) end++;
+        
+        bool promoted = false;
+        if (end - i > ROARING_DEGREE_THRESHOLD) {
+            Posting posting;
+            posting.arg_a = rel->tuples[i].arg_a;
+            roaring_init(&posting.values);
+            
+            promoted = true;
+            for (int j = i; j < end && promoted; j++) {
+                promoted = roaring_add(&posting.values, roaring_encode(rel->tuples[j].arg_b));
+            }
+            if (promoted) {
+                roaring_run_optimize(&posting.values);
+                promoted = relation_insert_posting(rel, &posting);
+            }
+            if (promoted) {
+                rel->posted += end - i;
+            } else {
+                roaring_free(&posting.values);
+            }
+        }
+        
+        if (!promoted) {
+            if (write != i) {
+                memmove(rel->tuples + write, rel->tuples + i, (size_t)(end - i) * sizeof(FactPair));
+            }
+            write += end - i;
+        }
+        i = end;
+    }
+    
+    rel->count = write;
+}
+
+/* Keys one owner merges: a range of pending keys and the slice of the
+ * tuple array covering the same range */
+typedef struct MergePartition {
+    uint64_t *keys;             /* Pending keys in the range, unsorted */
+    int key_count;
+    int tuple_lo;               /* Tuples [tuple_lo, tuple_hi) in the range */
+    int tuple_hi;
+    FactPair *merged;           /* Output: the slice with new tuples added */
+    int merged_count;
+    int added;                  /* New facts, symmetric weights included */
+    int posted;                 /* New facts that went to postings */
+} MergePartition;
+
+/* Radix sort one partition's pending keys and merge them into its slice
+ * of the tuple array, or into the postings of posted keys.  Partitions
+ * never share a key, so owners run without synchronization. */
+static bool merge_partition(const Relation *rel, MergePartition *part) {
+    /* Partitions are merged by parallel workers, or alone when the delta
+     * is too small to split, so either way the sort and the first touch
+     * of the merged slice stay on this thread */
+    uint64_t *keys = part->keys;
+    if (!parallel_radix_sort_serial(keys, (size_t)part->key_count)) return false;
+    int pending = (int)parallel_unique(keys, (size_t)part->key_count);
+    
+    /* Route runs for posted keys to their bitmaps, compact the rest */
+    int rest = 0;
+    for (int j = 0; j < pending; ) {
+        int arg_a = parallel_unpack_a(keys[j]);
+        int end = j + 1;
+        while (end < pending && parallel_unpack_a(keys[end]) == arg_a) end++;
+        
+        Posting *posting = relation_find_posting(rel, arg_a);
+        if (posting) {
+            uint32_t diagonal = roaring_encode(arg_a);
+            bool had_diagonal = roaring_contains(&posting->values, diagonal);
+            int posted = posting_merge(posting, keys + j, end - j);
+            if (posted < 0) return false;
+            part->posted += posted;
+            part->added += posted;
+            
+            /* Symmetric pairs count for both orientations, except (a, a) */
+            if (rel->symmetric) {
+                part->added += posted - (!had_diagonal && roaring_contains(&posting->values, diagonal));
+            }
+        } else {
+            memmove(keys + rest, keys + j, (size_t)(end - j) * sizeof(uint64_t));
+            rest += end - j;
+        }
+        j = end;
+    }
+    pending = rest;
+    
+    int slice = part->tuple_hi - part->tuple_lo;
+    FactPair *merged = relmem_alloc_local((size_t)(slice + pending + 1) * sizeof(FactPair));
+    if (!merged) return false;
+    
+    const FactPair *tuples = rel->tuples;
+    int i = part->tuple_lo, j = 0, n = 0;
+    while (j < pending) {
+        int arg_a = parallel_unpack_a(keys[j]);
+        int arg_b = parallel_unpack_b(keys[j]);
+        
+        /* Copy the run of existing tuples that sort before this insert */
+        int run = tuple_gallop(tuples, i, part->tuple_hi, arg_a, arg_b);
+        if (run > i) {
+            memcpy(merged + n, tuples + i, (size_t)(run - i) * sizeof(FactPair));
+            n += run - i;
+            i = run;
+        }
+        
+        if (i < part->tuple_hi && tuples[i].arg_a == arg_a && tuples[i].arg_b == arg_b) {
+            j++;
+            continue;
+        }
+        merged[n].arg_a = arg_a;
+        merged[n].arg_b = arg_b;
+        n++;
+        j++;
+        part->added += (int)relation_weight(rel, arg_a, arg_b) - 1;
+    }
+    if (i < part->tuple_hi) {
+        memcpy(merged + n, tuples + i, (size_t)(part->tuple_hi - i) * sizeof(FactPair));
+        n += part->tuple_hi - i;
+    }
+    
+    part->merged = merged;
+    part->merged_count = n;
+    part->added += n - slice;
+    return true;
+}
+
+/* Install merged partitions (in key order) as the tuple array, then
+ * promote long adjacency lists.  Returns the number of new facts. */
+static int relation_commit_merge(Relation *rel, MergePartition *parts, int count,
+                                 FactPair *tuples) {
+    int added = 0;
+    int total = 0;
+    for (int p = 0; p < count; p++) {
+        added += parts[p].added;
+        rel->posted += parts[p].posted;
+        total += parts[p].merged_count;
+    }
+    
+    relmem_free(rel->tuples);
+    rel->tuples = tuples;
+    rel->count = total;
+    rel->capacity = total;
+    relation_clear_pending(rel);
+    
+    relation_promote(rel);
+    return added;
+}
+
+/* Scatter ranges of a parallel merge: pending keys are routed to this many
+ * key-range owners */
+#define MERGE_PARTITION_BITS 8
+#define MERGE_PARTITIONS (1 << MERGE_PARTITION_BITS)
+
+typedef struct MergeTask {
+    Relation *rel;
+    int workers;
+    uint64_t base;              /* Smallest pending key */
+    int shift;                  /* Partition of a key: (key - base) >> shift */
+    int partitions;             /* Partitions in use */
+    int (*histograms)[MERGE_PARTITIONS];    /* One row per worker */
+    uint64_t *scattered;        /* Pending keys grouped by partition */
+    MergePartition parts[MERGE_PARTITIONS];
+    int offsets[MERGE_PARTITIONS];          /* Output start of each partition */
+    FactPair *tuples;           /* Concatenated output */
+    bool failed[PARALLEL_MAX_THREADS];
+} MergeTask;
+
+static void merge_chunk(int count, int index, int workers, int *begin, int *end) {
+    int chunk = (count + workers - 1) / workers;
+    *begin = chunk * index < count ? chunk * index : count;
+    *end = *begin + chunk < count ? *begin + chunk : count;
+}
+
+static inline int merge_partition_of(const MergeTask *task, uint64_t key) {
+    return (int)((key - task->base) >> task->shift);
+}
+
+static void merge_histogram_task(int index, int workers, void *context) {
+    MergeTask *task = context;
+    int begin, end;
+    int *histogram = task->histograms[index];
+    
+    merge_chunk(task->rel->delta_count, index, workers, &begin, &end);
+    memset(histogram, 0, MERGE_PARTITIONS * sizeof(int));
+    for (int i = begin; i < end; i++) {
+        histogram[merge_partition_of(task, task->rel->delta[i])]++;
+    }
+}
+
+static void merge_scatter_task(int index, int workers, void *context) {
+    MergeTask *task = context;
+    int begin, end;
+    int *offsets = task->histograms[index];
+    
+    merge_chunk(task->rel->delta_count, index, workers, &begin, &end);
+    for (int i = begin; i < end; i++) {
+        uint64_t key = task->rel->delta[i];
+        task->scattered[offsets[merge_partition_of(task, key)]++] = key;
+    }
+}
+
+/* Each owner finds its slice of the tuple array by the range bounds and
+ * merges its partitions, striding so skewed ranges spread out */
+static void merge_owner_task(int index, int workers, void *context) {
+    MergeTask *task = context;
+    const Relation *rel = task->rel;
+    
+    for (int p = index; p < task->partitions && !task->failed[index]; p += workers) {
+        MergePartition *part = &task->parts[p];
+        uint64_t lower = task->base + ((uint64_t)p << task->shift);
+        uint64_t upper = task->base + ((uint64_t)(p + 1) << task->shift);
+        
+        part->tuple_lo = p == 0 ? 0 :
+            tuple_gallop(rel->tuples, 0, rel->count,
+                         parallel_unpack_a(lower), parallel_unpack_b(lower));
+        part->tuple_hi = p == task->partitions - 1 ? rel->count :
+            tuple_gallop(rel->tuples, part->tuple_lo, rel->count,
+                         parallel_unpack_a(upper), parallel_unpack_b(upper));
+        task->failed[index] = !merge_partition(rel, part);
+    }
+}
+
+static void merge_copy_task(int index, int workers, void *context) {
+    MergeTask *task = context;
+    for (int p = index; p < task->partitions; p += workers) {
+        const MergePartition *part = &task->parts[p];
+        memcpy(task->tuples + task->offsets[p], part->merged,
+               (size_t)part->merged_count * sizeof(FactPair));
+    }
+}
+
+/* Radix-partitioned merge: workers histogram and scatter the pending keys
+ * into order-preserving key ranges, then each range's owner sorts its
+ * keys and merges them with its slice of the tuple array on its own */
+static int relation_merge_partitioned(Relation *rel, int workers) {
+    MergeTask *task = calloc(1, sizeof(MergeTask));
+    if (!task) return -1;
+    task->rel = rel;
+    task->workers = workers;
+    
+    /* Partition on the highest bits that vary across the pending keys */
+    uint64_t base = rel->delta[0], top = rel->delta[0];
+    for (int i = 1; i < rel->delta_count; i++) {
+        if (rel->delta[i] < base) base = rel->delta[i];
+        if (rel->delta[i] > top) top = rel->delta[i];
+    }
+    task->base = base;
+    while (((top - base) >> task->shift) >= MERGE_PARTITIONS) task->shift++;
+    task->partitions = (int)((top - base) >> task->shift) + 1;
+    
+    task->histograms = malloc((size_t)workers * sizeof(*task->histograms));
+    task->scattered = malloc((size_t)rel->delta_count * sizeof(uint64_t));
+    bool ok = task->histograms && task->scattered;
+    
+    if (ok) {
+        parallel_run(workers, merge_histogram_task, task);
+        
+        /* Exclusive prefix sum in (partition, worker) order */
+        int offset = 0;
+        for (int p = 0; p < task->partitions; p++) {
+            task->parts[p].keys = task->scattered + offset;
+            for (int w = 0; w < workers; w++) {
+                int n = task->histograms[w][p];
+                task->histograms[w][p] = offset;
+                offset += n;
+            }
+            task->parts[p].key_count = (int)(task->scattered + offset - task->parts[p].keys);
+        }
+        
+        parallel_run(workers, merge_scatter_task, task);
+        parallel_run(workers, merge_owner_task, task);
+        for (int w = 0; w < workers; w++) ok = ok && !task->failed[w];
+    }
+    
+    int total = 0;
+    for (int p = 0; ok && p < task->partitions; p++) {
+        task->offsets[p] = total;
+        total += task->parts[p].merged_count;
+    }
+    if (ok) {
+        task->tuples = relmem_alloc((size_t)(total + 1) * sizeof(FactPair));
+        ok = task->tuples != NULL;
+    }
+    if (ok) parallel_run(workers, merge_copy_task, task);
+    
+    int added = ok ? relation_commit_merge(rel, task->parts, task->partitions, task->tuples) : -1;
+    for (int p = 0; p < task->partitions; p++) relmem_free(task->parts[p].merged);
+    free(task->histograms);
+    free(task->scattered);
+    free(task);
+    return added;
+}
+
+/* Merge pending inserts into the tuple array and postings; large deltas
+ * are merged by partition owners in parallel.  Returns the number of new
+ * facts or -1 when out of memory. */
+static int relation_merge(Relation *rel) {
+    if (rel->delta_count == 0) return 0;
+    
+    int workers = rel->delta_count >= PARALLEL_MIN_ITEMS ? parallel_thread_count() : 1;
+    if (workers > 1) return relation_merge_partitioned(rel, workers);
+    
+    MergePartition part = {rel->delta, rel->delta_count, 0, rel->count, NULL, 0, 0, 0};
+    if (!merge_partition(rel, &part)) return -1;
+    return relation_commit_merge(rel, &part, 1, part.merged);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Sorted Relation Cursor
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Ordered walk over a sorted relation's tuple array and postings */
+typedef struct RelationCursor {
+    const Relation *rel;
+    int tuple;                  /* Next array index */
+    int posting;                /* Next posting index */
+    bool in_posting;            /* Walking the current posting's bitmap */
+    RoaringIterator values;
+} RelationCursor;
+
+static void relation_cursor_init(RelationCursor *cursor, const Relation *rel) {
+    cursor->rel = rel;
+    cursor->tuple = 0;
+    cursor->posting = 0;
+    cursor->in_posting = false;
+}
+
+static bool relation_cursor_next(RelationCursor *cursor, FactPair *out) {
+    const Relation *rel = cursor->rel;
+    
+    for (;;) {
+        if (cursor->in_posting) {
+            uint32_t value;
+            if (roaring_iterator_next(&cursor->values, &value)) {
+                out->arg_a = rel->postings[cursor->posting].arg_a;
+                out->arg_b = roaring_decode(value);
+                return true;
+            }
+            cursor->in_posting = false;
+            cursor->posting++;
+        }
+        
+        /* Array keys and posted keys are disjoint, take the smaller */
+        bool posting_first = cursor->posting < rel->posting_count &&
+            (cursor->tuple == rel->count ||
+             rel->postings[cursor->posting].arg_a < rel->tuples[cursor->tuple].arg_a);
+        
+        if (posting_first) {
+            roaring_iterator_init(&cursor->values, &rel->postings[cursor->posting].values);
+            cursor->in_posting = true;
+        } else if (cursor->tuple < rel->count) {
+            *out = rel->tuples[cursor->tuple++];
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+/* Merge pending inserts before a read unless merging is deferred */
+static void factdb_sync_relation(FactDatabase *db, Relation *rel) {
+    if (db->defer_merge || rel->delta_count == 0) return;
+    
+    int added = relation_merge(rel);
+    if (added > 0) db->count += added;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Equivalence Relation Storage
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Walk over every pair within every class of an equivalence relation */
+typedef struct ClassCursor {
+    const UnionFind *classes;
+    int root;                   /* Current class root */
+    int a;                      /* Column A member */
+    int b;                      /* Next column B member, -1 when the class is done */
+} ClassCursor;
+
+static void class_cursor_init(ClassCursor *cursor, const Relation *rel) {
+    cursor->classes = &rel->classes;
+    cursor->root = -1;
+    cursor->a = -1;
+    cursor->b = -1;
+}
+
+static bool class_cursor_next(ClassCursor *cursor, FactPair *out) {
+    const UnionFind *uf = cursor->classes;
+    
+    while (cursor->b < 0) {
+        do {
+            cursor->root++;
+        } while (cursor->root < uf->count && uf->parent[cursor->root] != cursor->root);
+        if (cursor->root >= uf->count) return false;
+        cursor->a = cursor->root;
+        cursor->b = cursor->root;
+    }
+    
+    out->arg_a = uf->values[cursor->a];
+    out->arg_b = uf->values[cursor->b];
+    
+    /* Members form a circle through the root */
+    cursor->b = uf->next[cursor->b];
+    if (cursor->b == cursor->root) {
+        cursor->a = uf->next[cursor->a];
+        cursor->b = cursor->a == cursor->root ? -1 : cursor->root;
+    }
+    return true;
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Fact Database Implementation
  * ───────────────────────────────────────────────────────────────────────── */
 
 void factdb_init(FactDatabase *db) {
     memset(db->buckets, 0, sizeof(db->buckets));
+    memset(db->relations, 0, sizeof(db->relations));
     db->count = 0;
     db->capacity = FACT_DATABASE_SIZE;
+    db->defer_merge = false;
+    db->memory_budget = 0;
+    db->frozen = false;
+    db->version = 0;
 }
 
 void factdb_cleanup(FactDatabase *db) {
@@ -72,60 +845,503 @@ void factdb_cleanup(FactDatabase *db) {
             fact = next;
         }
     }
-    memset(db->buckets, 0, sizeof(db->buckets));
-    db->count = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        Relation *rel = db->relations[i];
+        while (rel) {
+            Relation *next = rel->next;
+            relation_free(rel);
+            rel = next;
+        }
+    }
+    memset(db->buckets, 0, sizeof(db->buckets));
+    memset(db->relations, 0, sizeof(db->relations));
+    db->count = 0;
+    db->defer_merge = false;
+    db->frozen = false;
+}
+
+static bool fact_chain_contains(const Fact *fact, const char *relation, int arg_a, int arg_b) {
+    while (fact) {
+        if (strcmp(fact->relation, relation) == 0 &&
+            fact->arg_a == arg_a && fact->arg_b == arg_b) {
+            return true;
+        }
+        fact = fact->next;
+    }
+    
+    return false;
+}
+
+static bool factdb_hash_contains(const FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    return fact_chain_contains(db->buckets[hash_fact(relation, arg_a, arg_b)],
+                               relation, arg_a, arg_b);
+}
+
+/* Record a change to a relation's facts */
+static void relation_touch(FactDatabase *db, Relation *rel) {
+    rel->version = ++db->version;
+}
+
+/* Chain a new fact into the hash table; weight is the facts it counts for.
+ * The relation is registered so its version can be tracked. */
+static bool factdb_hash_insert(FactDatabase *db, const char *relation, int arg_a, int arg_b,
+                               long weight) {
+    Relation *rel = factdb_relation(db, relation);
+    if (!rel) return false;
+    
+    Fact *fact = malloc(sizeof(Fact));
+    if (!fact) return false;
+    
+    fact->relation = strdup(relation);
+    if (!fact->relation) {
+        free(fact);
+        return false;
+    }
+    
+    fact->arg_a = arg_a;
+    fact->arg_b = arg_b;
+    
+    /* Add to hash table */
+    unsigned int bucket = hash_fact(relation, arg_a, arg_b);
+    fact->next = db->buckets[bucket];
+    db->buckets[bucket] = fact;
+    db->count += weight;
+    relation_touch(db, rel);
+    
+    return true;
+}
+
+/* Under a memory budget, relations seen for the first time are stored
+ * sorted, whose arrays can spill, instead of as hash chains */
+static Relation* factdb_budget_relation(FactDatabase *db, const char *relation) {
+    Relation *rel = factdb_find_relation(db, relation);
+    if (rel || !db->memory_budget) return rel;
+    
+    if (!factdb_set_storage(db, relation, RELATION_STORAGE_SORTED, false)) return NULL;
+    return factdb_find_relation(db, relation);
+}
+
+int factdb_insert(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    if (!relation || db->frozen) return -1;
+    
+    Relation *rel = factdb_budget_relation(db, relation);
+    if (!rel && db->memory_budget) return -1;
+    relation_canonicalize(rel, &arg_a, &arg_b);
+    long weight = relation_weight(rel, arg_a, arg_b);
+    
+    if (rel && rel->storage == RELATION_STORAGE_SORTED) {
+        if (relation_contains(rel, arg_a, arg_b)) return 0;
+        int fresh = relation_push_delta(rel, arg_a, arg_b);
+        if (fresh > 0) relation_touch(db, rel);
+        return fresh;
+    }
+    
+    if (rel && rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        long added = unionfind_union(&rel->classes, arg_a, arg_b);
+        if (added < 0) return -1;
+        db->count += added;
+        if (added > 0) relation_touch(db, rel);
+        return added > 0 ? 1 : 0;
+    }
+    
+    /* Check if fact already exists */
+    if (factdb_hash_contains(db, relation, arg_a, arg_b)) {
+        return 0;
+    }
+    
+    return factdb_hash_insert(db, relation, arg_a, arg_b, weight) ? 1 : -1;
+}
+
+int factdb_insert_batch(FactDatabase *db, const char *relation, const FactPair *pairs,
+                        int count, int *inserted) {
+    if (!relation || db->frozen) return -1;
+    
+    Relation *rel = factdb_budget_relation(db, relation);
+    if (!rel && db->memory_budget) return -1;
+    bool sorted = rel && rel->storage == RELATION_STORAGE_SORTED;
+    bool hashed = !rel || rel->storage == RELATION_STORAGE_HASH;
+    int added = 0;
+    
+    for (int base = 0; base < count; base += PARALLEL_PROBE_GROUP) {
+        int n = count - base < PARALLEL_PROBE_GROUP ? count - base : PARALLEL_PROBE_GROUP;
+        FactPair group[PARALLEL_PROBE_GROUP];
+        bool found[PARALLEL_PROBE_GROUP];
+        unsigned int buckets[PARALLEL_PROBE_GROUP];
+        
+        for (int k = 0; k < n; k++) {
+            group[k] = pairs[base + k];
+            relation_canonicalize(rel, &group[k].arg_a, &group[k].arg_b);
+        }
+        
+        /* Issue every lookup of the group before resolving any.  Hash
+         * chains are re-read and pending inserts claimed at resolve time,
+         * so a pair repeated within the group sees its earlier insert. */
+        if (sorted) {
+            relation_contains_group(rel, group, n, found);
+            if (!relation_reserve_delta(rel, rel->delta_count + n)) return -1;
+        } else if (hashed) {
+            for (int k = 0; k < n; k++) {
+                buckets[k] = hash_fact(relation, group[k].arg_a, group[k].arg_b);
+                parallel_prefetch(db->buckets[buckets[k]]);
+            }
+        }
+        
+        for (int k = 0; k < n; k++) {
+            int arg_a = group[k].arg_a, arg_b = group[k].arg_b;
+            int result;
+            if (sorted) {
+                result = found[k] ? 0 : relation_push_delta(rel, arg_a, arg_b);
+                if (result > 0) relation_touch(db, rel);
+            } else if (hashed) {
+                result = fact_chain_contains(db->buckets[buckets[k]], relation, arg_a, arg_b) ? 0 :
+                    factdb_hash_insert(db, relation, arg_a, arg_b,
+                                       relation_weight(rel, arg_a, arg_b)) ? 1 : -1;
+            } else {
+                result = factdb_insert(db, relation, arg_a, arg_b);
+            }
+            
+            if (result < 0) return -1;
+            if (inserted) inserted[base + k] = result;
+            added += result;
+        }
+    }
+    return added;
+}
+
+typedef struct BulkTask {
+    const Relation *rel;
+    const FactPair *pairs;
+    uint64_t *keys;             /* Output: packed, canonical pairs */
+    int count;
+} BulkTask;
+
+static void bulk_pack_task(int index, int workers, void *context) {
+    BulkTask *task = context;
+    int begin, end;
+    
+    merge_chunk(task->count, index, workers, &begin, &end);
+    for (int i = begin; i < end; i++) {
+        int arg_a = task->pairs[i].arg_a, arg_b = task->pairs[i].arg_b;
+        relation_canonicalize(task->rel, &arg_a, &arg_b);
+        task->keys[i] = parallel_pack_pair(arg_a, arg_b);
+    }
+}
+
+bool factdb_bulk_load(FactDatabase *db, const char *relation, const FactPair *pairs, int count) {
+    if (!relation || db->frozen) return false;
+    if (count == 0) return true;
+    
+    Relation *rel = factdb_budget_relation(db, relation);
+    if (!rel && db->memory_budget) return false;
+    if ((!rel || (!rel->declared && rel->storage == RELATION_STORAGE_HASH)) &&
+        count >= FACTDB_BULK_SORTED_FACTS) {
+        if (!factdb_set_storage(db, relation, RELATION_STORAGE_SORTED, false)) return false;
+        rel = factdb_find_relation(db, relation);
+    }
+    if (!rel || rel->storage != RELATION_STORAGE_SORTED) {
+        return factdb_insert_batch(db, relation, pairs, count, NULL) >= 0;
+    }
+    
+    /* The merge drops duplicates and facts already stored */
+    if (!relation_reserve_delta(rel, rel->delta_count + count)) return false;
+    BulkTask task = {rel, pairs, rel->delta + rel->delta_count, count};
+    parallel_run(count >= PARALLEL_MIN_ITEMS ? parallel_thread_count() : 1, bulk_pack_task, &task);
+    rel->delta_count += count;
+    relation_touch(db, rel);
+    return true;
+}
+
+/* Allocate for a relation's capacity hints in its current layout.  The
+ * tuple array is rebuilt by every merge and hash chains hang off a fixed
+ * table, so neither is sized here; sorted relations size their first
+ * pending buffer from the hint once an insert needs it. */
+static bool relation_reserve_hints(Relation *rel) {
+    switch (rel->storage) {
+        case RELATION_STORAGE_SORTED: {
+            int postings = rel->size_hint / ROARING_DEGREE_THRESHOLD;
+            if (rel->domain_hint && rel->domain_hint < postings) postings = rel->domain_hint;
+            if (postings > rel->posting_capacity) {
+                Posting *grown = realloc(rel->postings, (size_t)postings * sizeof(Posting));
+                if (!grown) return false;
+                rel->postings = grown;
+                rel->posting_capacity = postings;
+            }
+            return true;
+        }
+        case RELATION_STORAGE_EQUIVALENCE:
+            /* A class of n values holds n * n facts, so only the domain
+             * bounds its nodes */
+            return rel->domain_hint == 0 || unionfind_reserve(&rel->classes, rel->domain_hint);
+        default:
+            return true;
+    }
+}
+
+bool factdb_reserve(FactDatabase *db, const char *relation, int facts, int domain) {
+    if (!relation || db->frozen || facts < 0 || facts > FACTDB_MAX_HINT ||
+        domain < 0 || domain > FACTDB_MAX_HINT) {
+        return false;
+    }
+    
+    Relation *rel = factdb_budget_relation(db, relation);
+    if (!rel && db->memory_budget) return false;
+    if (!rel) rel = factdb_relation(db, relation);
+    if (!rel) return false;
+    
+    if (facts > rel->size_hint) rel->size_hint = facts;
+    if (domain > rel->domain_hint) rel->domain_hint = domain;
+    
+    /* Setting the storage reserves for the hints */
+    if (!rel->declared && rel->storage == RELATION_STORAGE_HASH &&
+        rel->size_hint >= FACTDB_BULK_SORTED_FACTS) {
+        return factdb_set_storage(db, relation, RELATION_STORAGE_SORTED, false);
+    }
+    return relation_reserve_hints(rel);
+}
+
+bool factdb_add_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    return factdb_insert(db, relation, arg_a, arg_b) >= 0;
+}
+
+int factdb_retract(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    if (!relation || db->frozen) return -1;
+    
+    Relation *rel = factdb_find_relation(db, relation);
+    relation_canonicalize(rel, &arg_a, &arg_b);
+    long weight = relation_weight(rel, arg_a, arg_b);
+    
+    if (rel && rel->storage == RELATION_STORAGE_EQUIVALENCE) return -1;
+    
+    if (rel && rel->storage == RELATION_STORAGE_SORTED) {
+        /* The pair may still be pending */
+        int added = relation_merge(rel);
+        if (added < 0) return -1;
+        db->count += added;
+        
+        int removed = relation_retract(rel, arg_a, arg_b);
+        if (removed > 0) {
+            db->count -= weight;
+            relation_touch(db, rel);
+        }
+        return removed;
+    }
+    
+    Fact **link = &db->buckets[hash_fact(relation, arg_a, arg_b)];
+    while (*link) {
+        Fact *fact = *link;
+        if (strcmp(fact->relation, relation) == 0 &&
+            fact->arg_a == arg_a && fact->arg_b == arg_b) {
+            *link = fact->next;
+            free(fact->relation);
+            free(fact);
+            db->count -= weight;
+            if (rel) relation_touch(db, rel);
+            return 1;
+        }
+        link = &fact->next;
+    }
+    return 0;
+}
+
+bool factdb_has_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    if (!relation) return false;
+    
+    Relation *rel = factdb_find_relation(db, relation);
+    relation_canonicalize(rel, &arg_a, &arg_b);
+    
+    if (rel && rel->storage == RELATION_STORAGE_FROZEN) {
+        return frozen_contains(&rel->frozen, arg_a, arg_b);
+    }
+    if (rel && rel->storage == RELATION_STORAGE_SORTED) {
+        factdb_sync_relation(db, rel);
+        return relation_contains(rel, arg_a, arg_b);
+    }
+    if (rel && rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        return unionfind_same(&rel->classes, arg_a, arg_b);
+    }
+    
+    return factdb_hash_contains(db, relation, arg_a, arg_b);
+}
+
+/* Membership test on a resolved relation */
+static bool relation_has_pair(const FactDatabase *db, const Relation *rel, int arg_a, int arg_b) {
+    relation_canonicalize(rel, &arg_a, &arg_b);
+    
+    if (rel->storage == RELATION_STORAGE_FROZEN) {
+        return frozen_contains(&rel->frozen, arg_a, arg_b);
+    }
+    if (rel->storage == RELATION_STORAGE_SORTED) {
+        return relation_contains(rel, arg_a, arg_b);
+    }
+    if (rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        /* Plain root walks: path halving would write to the forest */
+        int node_a = unionfind_node(&rel->classes, arg_a);
+        int node_b = unionfind_node(&rel->classes, arg_b);
+        return node_a >= 0 && node_b >= 0 &&
+               unionfind_root(&rel->classes, node_a) == unionfind_root(&rel->classes, node_b);
+    }
+    
+    return factdb_hash_contains(db, rel->name, arg_a, arg_b);
+}
+
+bool factdb_contains(const FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    if (!relation) return false;
+    
+    /* Every stored fact's relation is registered, so none means no facts */
+    const Relation *rel = factdb_find_relation(db, relation);
+    return rel && relation_has_pair(db, rel, arg_a, arg_b);
+}
+
+static bool query_result_append(QueryResult **results, QueryResult **tail, int arg_a, int arg_b) {
+    QueryResult *result = malloc(sizeof(QueryResult));
+    if (!result) return false;
+    
+    result->arg_a = arg_a;
+    result->arg_b = arg_b;
+    result->next = NULL;
+    
+    if (*tail) {
+        (*tail)->next = result;
+    } else {
+        *results = result;
+    }
+    *tail = result;
+    return true;
+}
+
+/* Range scan over a sorted relation; a bound arg_a seeks to its run */
+static QueryResult* relation_query(const Relation *rel, int arg_a, int arg_b) {
+    QueryResult *results = NULL;
+    QueryResult *tail = NULL;
+    
+    if (arg_a == -1) {
+        RelationCursor cursor;
+        FactPair tuple;
+        relation_cursor_init(&cursor, rel);
+        while (relation_cursor_next(&cursor, &tuple)) {
+            if (arg_b != -1 && tuple.arg_b != arg_b) continue;
+            if (!query_result_append(&results, &tail, tuple.arg_a, tuple.arg_b)) break;
+        }
+        return results;
+    }
+    
+    const Posting *posting = relation_find_posting(rel, arg_a);
+    if (posting) {
+        if (arg_b != -1) {
+            if (roaring_contains(&posting->values, roaring_encode(arg_b))) {
+                query_result_append(&results, &tail, arg_a, arg_b);
+            }
+            return results;
+        }
+        
+        RoaringIterator it;
+        uint32_t value;
+        roaring_iterator_init(&it, &posting->values);
+        while (roaring_iterator_next(&it, &value)) {
+            if (!query_result_append(&results, &tail, arg_a, roaring_decode(value))) break;
+        }
+        return results;
+    }
+    
+    int start = tuple_gallop(rel->tuples, 0, rel->count, arg_a, arg_b == -1 ? INT_MIN : arg_b);
+    for (int i = start; i < rel->count; i++) {
+        const FactPair *tuple = &rel->tuples[i];
+        if (tuple->arg_a != arg_a) break;
+        if (arg_b != -1 && tuple->arg_b != arg_b) break;
+        if (!query_result_append(&results, &tail, tuple->arg_a, tuple->arg_b)) break;
+    }
+    
+    return results;
 }
 
-bool factdb_add_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
-    if (!relation) return false;
+/* Pattern query by class: a bound value enumerates its own class only */
+static QueryResult* equivalence_query(Relation *rel, int arg_a, int arg_b) {
+    QueryResult *results = NULL;
+    QueryResult *tail = NULL;
+    UnionFind *uf = &rel->classes;
     
-    /* Check if fact already exists */
-    if (factdb_has_fact(db, relation, arg_a, arg_b)) {
-        return true;  /* Already exists, no need to add */
+    if (arg_a == -1 && arg_b == -1) {
+        ClassCursor cursor;
+        FactPair tuple;
+        class_cursor_init(&cursor, rel);
+        while (class_cursor_next(&cursor, &tuple)) {
+            if (!query_result_append(&results, &tail, tuple.arg_a, tuple.arg_b)) break;
+        }
+        return results;
     }
     
-    /* Create new fact */
-    Fact *fact = malloc(sizeof(Fact));
-    if (!fact) return false;
-    
-    fact->relation = strdup(relation);
-    if (!fact->relation) {
-        free(fact);
-        return false;
+    if (arg_a != -1 && arg_b != -1) {
+        if (unionfind_same(uf, arg_a, arg_b)) {
+            query_result_append(&results, &tail, arg_a, arg_b);
+        }
+        return results;
     }
     
-    fact->arg_a = arg_a;
-    fact->arg_b = arg_b;
+    int bound = arg_a != -1 ? arg_a : arg_b;
+    int node = unionfind_node(uf, bound);
+    if (node < 0) return NULL;
     
-    /* Add to hash table */
-    unsigned int bucket = hash_fact(relation, arg_a, arg_b);
-    fact->next = db->buckets[bucket];
-    db->buckets[bucket] = fact;
-    db->count++;
+    int member = node;
+    do {
+        int other = uf->values[member];
+        bool ok = arg_a != -1 ? query_result_append(&results, &tail, bound, other)
+                              : query_result_append(&results, &tail, other, bound);
+        if (!ok) break;
+        member = uf->next[member];
+    } while (member != node);
     
-    return true;
+    return results;
 }
 
-bool factdb_has_fact(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
-    if (!relation) return false;
+/* A bound column reads one row */
+QueryResult* factdb_query_frozen(const FrozenRelation *frozen, int arg_a, int arg_b) {
+    QueryResult *results = NULL;
+    QueryResult *tail = NULL;
     
-    unsigned int bucket = hash_fact(relation, arg_a, arg_b);
-    Fact *fact = db->buckets[bucket];
+    if (arg_a != -1 && arg_b != -1) {
+        if (frozen_contains(frozen, arg_a, arg_b)) {
+            query_result_append(&results, &tail, arg_a, arg_b);
+        }
+        return results;
+    }
     
-    while (fact) {
-        if (strcmp(fact->relation, relation) == 0 &&
-            fact->arg_a == arg_a && fact->arg_b == arg_b) {
-            return true;
+    if (arg_a == -1 && arg_b == -1) {
+        const FrozenIndex *index = &frozen->by_a;
+        for (int k = 0; k < index->key_count; k++) {
+            for (int i = index->offsets[k]; i < index->offsets[k + 1]; i++) {
+                if (!query_result_append(&results, &tail, index->keys[k], index->values[i])) {
+                    return results;
+                }
+            }
         }
-        fact = fact->next;
+        return results;
     }
     
-    return false;
+    const int *values;
+    int bound = arg_a != -1 ? arg_a : arg_b;
+    int n = frozen_values(arg_a != -1 ? &frozen->by_a : &frozen->by_b, bound, &values);
+    for (int i = 0; i < n; i++) {
+        bool ok = arg_a != -1 ? query_result_append(&results, &tail, bound, values[i])
+                              : query_result_append(&results, &tail, values[i], bound);
+        if (!ok) break;
+    }
+    return results;
 }
 
-QueryResult* factdb_query(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
-    if (!relation) return NULL;
+/* Pattern query over the stored facts, without symmetric expansion */
+static QueryResult* relation_query_stored(FactDatabase *db, Relation *rel, int arg_a, int arg_b) {
+    if (rel->storage == RELATION_STORAGE_FROZEN) {
+        return factdb_query_frozen(&rel->frozen, arg_a, arg_b);
+    }
+    if (rel->storage == RELATION_STORAGE_SORTED) {
+        factdb_sync_relation(db, rel);
+        return relation_query(rel, arg_a, arg_b);
+    }
+    if (rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        return equivalence_query(rel, arg_a, arg_b);
+    }
     
+    const char *relation = rel->name;
     QueryResult *results = NULL;
     QueryResult *tail = NULL;
     
@@ -138,46 +1354,118 @@ QueryResult* factdb_query(FactDatabase *db, const char *relation, int arg_a, int
                 if (strcmp(fact->relation, relation) == 0 &&
                     (arg_a == -1 || fact->arg_a == arg_a) &&
                     (arg_b == -1 || fact->arg_b == arg_b)) {
-                    
-                    QueryResult *result = malloc(sizeof(QueryResult));
-                    if (!result) break;
-                    
-                    result->arg_a = fact->arg_a;
-                    result->arg_b = fact->arg_b;
-                    result->next = NULL;
-                    
-                    if (tail) {
-                        tail->next = result;
-                    } else {
-                        results = result;
-                    }
-                    tail = result;
+                    if (!query_result_append(&results, &tail, fact->arg_a, fact->arg_b)) break;
                 }
                 fact = fact->next;
             }
         }
     } else {
         /* Exact query */
-        if (factdb_has_fact(db, relation, arg_a, arg_b)) {
-            QueryResult *result = malloc(sizeof(QueryResult));
-            if (result) {
-                result->arg_a = arg_a;
-                result->arg_b = arg_b;
-                result->next = NULL;
-                results = result;
-            }
+        if (factdb_hash_contains(db, relation, arg_a, arg_b)) {
+            query_result_append(&results, &tail, arg_a, arg_b);
+        }
+    }
+    
+    return results;
+}
+
+/* Pattern query over a symmetric relation.  Stored (x, y) answers for
+ * (y, x) too, so a bound value is looked up in both columns. */
+static QueryResult* symmetric_query(FactDatabase *db, Relation *rel, int arg_a, int arg_b) {
+    QueryResult *results = NULL;
+    QueryResult *tail = NULL;
+    
+    if (arg_a != -1 && arg_b != -1) {
+        int a = arg_a, b = arg_b;
+        relation_canonicalize(rel, &a, &b);
+        QueryResult *stored = relation_query_stored(db, rel, a, b);
+        if (stored) {
+            stored->arg_a = arg_a;
+            stored->arg_b = arg_b;
+        }
+        return stored;
+    }
+    
+    if (arg_a == -1 && arg_b == -1) {
+        QueryResult *stored = relation_query_stored(db, rel, -1, -1);
+        for (QueryResult *r = stored; r; r = r->next) {
+            if (!query_result_append(&results, &tail, r->arg_a, r->arg_b)) break;
+            if (r->arg_a != r->arg_b &&
+                !query_result_append(&results, &tail, r->arg_b, r->arg_a)) break;
         }
+        query_result_free(stored);
+        return results;
     }
     
+    /* (bound, x) with bound <= x is stored as is, (x, bound) with x < bound
+     * is stored with bound in column B */
+    int bound = arg_a != -1 ? arg_a : arg_b;
+    QueryResult *upper = relation_query_stored(db, rel, bound, -1);
+    QueryResult *lower = relation_query_stored(db, rel, -1, bound);
+    bool ok = true;
+    
+    for (QueryResult *r = upper; r && ok; r = r->next) {
+        ok = arg_a != -1 ? query_result_append(&results, &tail, bound, r->arg_b)
+                         : query_result_append(&results, &tail, r->arg_b, bound);
+    }
+    for (QueryResult *r = lower; r && ok; r = r->next) {
+        if (r->arg_a == bound) continue;
+        ok = arg_a != -1 ? query_result_append(&results, &tail, bound, r->arg_a)
+                         : query_result_append(&results, &tail, r->arg_a, bound);
+    }
+    
+    query_result_free(upper);
+    query_result_free(lower);
     return results;
 }
 
+/* Pattern query over every fact of a relation */
+static QueryResult* relation_query_pattern(FactDatabase *db, Relation *rel, int arg_a, int arg_b) {
+    if (rel->symmetric && rel->storage != RELATION_STORAGE_EQUIVALENCE &&
+        rel->storage != RELATION_STORAGE_FROZEN) {
+        return symmetric_query(db, rel, arg_a, arg_b);
+    }
+    return relation_query_stored(db, rel, arg_a, arg_b);
+}
+
+QueryResult* factdb_query(FactDatabase *db, const char *relation, int arg_a, int arg_b) {
+    if (!relation) return NULL;
+    
+    /* Every stored fact's relation is registered, so none means no facts */
+    Relation *rel = factdb_find_relation(db, relation);
+    return rel ? relation_query_pattern(db, rel, arg_a, arg_b) : NULL;
+}
+
 QueryResult* factdb_get_all(FactDatabase *db, const char *relation) {
     return factdb_query(db, relation, -1, -1);
 }
 
+static void print_fact(const char *relation, int arg_a, int arg_b, const AtomTable *atoms) {
+    printf("  %s(", relation);
+    
+    /* Try to get atom name for arg_a */
+    const char *name_a = atom_table_name(atoms, arg_a);
+    if (name_a) {
+        printf("%s", name_a);
+    } else {
+        printf("%d", arg_a);
+    }
+    
+    printf(", ");
+    
+    /* Try to get atom name for arg_b */
+    const char *name_b = atom_table_name(atoms, arg_b);
+    if (name_b) {
+        printf("%s", name_b);
+    } else {
+        printf("%d", arg_b);
+    }
+    
+    printf(")\n");
+}
+
 void factdb_print(const FactDatabase *db, const AtomTable *atoms) {
-    printf("Fact Database (%d facts):\n", db->count);
+    printf("Fact Database (%ld facts):\n", db->count);
     printf("─────────────────────────\n");
     
     if (db->count == 0) {
@@ -186,36 +1474,491 @@ void factdb_print(const FactDatabase *db, const AtomTable *atoms) {
     }
     
     for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
-        Fact *fact = db->buckets[i];
-        while (fact) {
-            printf("  %s(", fact->relation);
-            
-            /* Try to get atom name for arg_a */
-            const char *name_a = atom_table_name(atoms, fact->arg_a);
-            if (name_a) {
-                printf("%s", name_a);
+        for (Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            const Relation *rel = factdb_find_relation(db, fact->relation);
+            print_fact(fact->relation, fact->arg_a, fact->arg_b, atoms);
+            if (relation_weight(rel, fact->arg_a, fact->arg_b) == 2) {
+                print_fact(fact->relation, fact->arg_b, fact->arg_a, atoms);
+            }
+        }
+    }
+    
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *rel = db->relations[i]; rel; rel = rel->next) {
+            RelationCursor cursor;
+            ClassCursor classes;
+            FactPair tuple;
+            relation_cursor_init(&cursor, rel);
+            while (relation_cursor_next(&cursor, &tuple)) {
+                print_fact(rel->name, tuple.arg_a, tuple.arg_b, atoms);
+                if (relation_weight(rel, tuple.arg_a, tuple.arg_b) == 2) {
+                    print_fact(rel->name, tuple.arg_b, tuple.arg_a, atoms);
+                }
+            }
+            class_cursor_init(&classes, rel);
+            while (class_cursor_next(&classes, &tuple)) {
+                print_fact(rel->name, tuple.arg_a, tuple.arg_b, atoms);
+            }
+            const FrozenIndex *rows = &rel->frozen.by_a;
+            for (int k = 0; k < rows->key_count; k++) {
+                for (int v = rows->offsets[k]; v < rows->offsets[k + 1]; v++) {
+                    print_fact(rel->name, rows->keys[k], rows->values[v], atoms);
+                }
+            }
+        }
+    }
+}
+
+long factdb_count(const FactDatabase *db) {
+    return db->count;
+}
+
+long factdb_relation_size(const FactDatabase *db, const char *relation) {
+    if (!relation) return 0;
+    
+    const Relation *rel = factdb_find_relation(db, relation);
+    if (rel && rel->storage == RELATION_STORAGE_SORTED) return rel->count + rel->posted;
+    if (rel && rel->storage == RELATION_STORAGE_EQUIVALENCE) return rel->classes.pairs;
+    if (rel && rel->storage == RELATION_STORAGE_FROZEN) return rel->frozen.count;
+    
+    long size = 0;
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (const Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, relation) == 0) size++;
+        }
+    }
+    return size;
+}
+
+/* Move a relation's hash facts into a sorted array */
+static bool factdb_convert_to_sorted(FactDatabase *db, Relation *rel) {
+    int moving = 0;
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, rel->name) == 0) moving++;
+        }
+    }
+    
+    /* Reserve up front so the move cannot fail halfway */
+    if (!relation_reserve_delta(rel, rel->delta_count + moving)) return false;
+    
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        Fact **link = &db->buckets[i];
+        while (*link) {
+            Fact *fact = *link;
+            if (strcmp(fact->relation, rel->name) == 0) {
+                rel->delta[rel->delta_count++] = parallel_pack_pair(fact->arg_a, fact->arg_b);
+                *link = fact->next;
+                db->count -= relation_weight(rel, fact->arg_a, fact->arg_b);
+                free(fact->relation);
+                free(fact);
             } else {
-                printf("%d", fact->arg_a);
+                link = &fact->next;
             }
-            
-            printf(", ");
-            
-            /* Try to get atom name for arg_b */
-            const char *name_b = atom_table_name(atoms, fact->arg_b);
-            if (name_b) {
-                printf("%s", name_b);
+        }
+    }
+    
+    rel->storage = RELATION_STORAGE_SORTED;
+    int added = relation_merge(rel);
+    if (added < 0) return false;
+    db->count += added;
+    return true;
+}
+
+/* Unlink a relation's facts from the hash table */
+static void factdb_hash_remove(FactDatabase *db, const Relation *rel) {
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        Fact **link = &db->buckets[i];
+        while (*link) {
+            Fact *fact = *link;
+            if (strcmp(fact->relation, rel->name) == 0) {
+                *link = fact->next;
+                db->count -= relation_weight(rel, fact->arg_a, fact->arg_b);
+                free(fact->relation);
+                free(fact);
+            } else {
+                link = &fact->next;
+            }
+        }
+    }
+}
+
+/* Union a relation's hash facts into classes.  The facts are only removed
+ * once every union succeeded, so running out of memory loses nothing. */
+static bool factdb_convert_to_equivalence(FactDatabase *db, Relation *rel) {
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, rel->name) != 0) continue;
+            if (unionfind_union(&rel->classes, fact->arg_a, fact->arg_b) < 0) {
+                unionfind_free(&rel->classes);
+                return false;
+            }
+        }
+    }
+    
+    factdb_hash_remove(db, rel);
+    rel->storage = RELATION_STORAGE_EQUIVALENCE;
+    db->count += rel->classes.pairs;
+    
+    /* The classes answer every pair the facts imply */
+    relation_touch(db, rel);
+    return true;
+}
+
+/* Materialize every pair of an equivalence relation into the hash table
+ * (one orientation per pair when the relation is also symmetric) */
+static bool factdb_equivalence_to_hash(FactDatabase *db, Relation *rel) {
+    rel->storage = RELATION_STORAGE_HASH;
+    db->count -= rel->classes.pairs;
+    
+    bool ok = true;
+    ClassCursor cursor;
+    FactPair tuple;
+    class_cursor_init(&cursor, rel);
+    while (ok && class_cursor_next(&cursor, &tuple)) {
+        if (rel->symmetric && tuple.arg_a > tuple.arg_b) continue;
+        ok = factdb_hash_insert(db, rel->name, tuple.arg_a, tuple.arg_b,
+                                relation_weight(rel, tuple.arg_a, tuple.arg_b));
+    }
+    
+    unionfind_free(&rel->classes);
+    return ok;
+}
+
+/* Move a sorted relation's tuples back into the hash table */
+static bool factdb_convert_to_hash(FactDatabase *db, Relation *rel) {
+    if (rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        return factdb_equivalence_to_hash(db, rel);
+    }
+    
+    int added = relation_merge(rel);
+    if (added < 0) return false;
+    db->count += added;
+    
+    rel->storage = RELATION_STORAGE_HASH;
+    
+    bool ok = true;
+    RelationCursor cursor;
+    FactPair tuple;
+    relation_cursor_init(&cursor, rel);
+    while (relation_cursor_next(&cursor, &tuple)) {
+        long weight = relation_weight(rel, tuple.arg_a, tuple.arg_b);
+        db->count -= weight;
+        if (ok) ok = factdb_hash_insert(db, rel->name, tuple.arg_a, tuple.arg_b, weight);
+    }
+    
+    relation_free_postings(rel);
+    relmem_free(rel->tuples);
+    rel->tuples = NULL;
+    rel->count = 0;
+    rel->capacity = 0;
+    return ok;
+}
+
+bool factdb_set_storage(FactDatabase *db, const char *relation,
+                        RelationStorage storage, bool declared) {
+    if (!relation || db->frozen || storage == RELATION_STORAGE_FROZEN) return false;
+    
+    Relation *rel = factdb_relation(db, relation);
+    if (!rel) return false;
+    
+    if (rel->declared && !declared) return true;
+    rel->declared = rel->declared || declared;
+    if (rel->storage == storage) return true;
+    
+    /* Every conversion goes through the hash table */
+    if (rel->storage != RELATION_STORAGE_HASH && !factdb_convert_to_hash(db, rel)) {
+        return false;
+    }
+    
+    bool ok = true;
+    switch (storage) {
+        case RELATION_STORAGE_SORTED:
+            ok = factdb_convert_to_sorted(db, rel);
+            break;
+        case RELATION_STORAGE_EQUIVALENCE:
+            ok = factdb_convert_to_equivalence(db, rel);
+            break;
+        default:
+            break;
+    }
+    return ok && relation_reserve_hints(rel);
+}
+
+bool factdb_set_symmetric(FactDatabase *db, const char *relation) {
+    if (!relation || db->frozen) return false;
+    
+    Relation *rel = factdb_relation(db, relation);
+    if (!rel) return false;
+    if (rel->symmetric) return true;
+    
+    /* Equivalence classes hold both orientations already */
+    if (rel->storage == RELATION_STORAGE_EQUIVALENCE) {
+        rel->symmetric = true;
+        return true;
+    }
+    
+    /* Every fact now answers its reversed pair as well */
+    relation_touch(db, rel);
+    
+    /* Re-insert the facts through the hash table, keeping one per pair */
+    RelationStorage storage = rel->storage;
+    if (storage != RELATION_STORAGE_HASH && !factdb_convert_to_hash(db, rel)) return false;
+    
+    FactPair *tuples;
+    int count = factdb_export(db, relation, &tuples);
+    if (count < 0) return false;
+    
+    factdb_hash_remove(db, rel);
+    rel->symmetric = true;
+    
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) {
+        ok = factdb_insert(db, relation, tuples[i].arg_a, tuples[i].arg_b) >= 0;
+    }
+    free(tuples);
+    
+    if (ok && storage == RELATION_STORAGE_SORTED) ok = factdb_convert_to_sorted(db, rel);
+    return ok;
+}
+
+bool factdb_is_symmetric(const FactDatabase *db, const char *relation) {
+    const Relation *rel = relation ? factdb_find_relation(db, relation) : NULL;
+    return rel && rel->symmetric;
+}
+
+uint64_t factdb_relation_version(const FactDatabase *db, const char *relation) {
+    const Relation *rel = relation ? factdb_find_relation(db, relation) : NULL;
+    return rel ? rel->version : 0;
+}
+
+RelationStorage factdb_get_storage(const FactDatabase *db, const char *relation) {
+    const Relation *rel = relation ? factdb_find_relation(db, relation) : NULL;
+    return rel ? rel->storage : RELATION_STORAGE_HASH;
+}
+
+int factdb_merge(FactDatabase *db) {
+    int total = 0;
+    
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (Relation *rel = db->relations[i]; rel; rel = rel->next) {
+            int added = relation_merge(rel);
+            if (added < 0) return -1;
+            db->count += added;
+            total += added;
+        }
+    }
+    
+    return total;
+}
+
+void factdb_set_memory_budget(FactDatabase *db, size_t bytes, const char *spill_dir) {
+    db->memory_budget = bytes;
+    relmem_set_budget(bytes, spill_dir);
+}
+
+void factdb_defer_merge(FactDatabase *db, bool defer) {
+    db->defer_merge = defer;
+}
+
+/* Copy the stored facts, without symmetric expansion */
+static int factdb_export_stored(FactDatabase *db, const char *relation, FactPair **tuples) {
+    const Relation *frozen = factdb_find_relation(db, relation);
+    if (frozen && frozen->storage == RELATION_STORAGE_FROZEN) {
+        const FrozenIndex *rows = &frozen->frozen.by_a;
+        if (frozen->frozen.count == 0) return 0;
+        
+        *tuples = malloc((size_t)frozen->frozen.count * sizeof(FactPair));
+        if (!*tuples) return -1;
+        
+        for (int k = 0; k < rows->key_count; k++) {
+            for (int i = rows->offsets[k]; i < rows->offsets[k + 1]; i++) {
+                (*tuples)[i].arg_a = rows->keys[k];
+                (*tuples)[i].arg_b = rows->values[i];
+            }
+        }
+        return frozen->frozen.count;
+    }
+    
+    Relation *rel = factdb_sorted_relation(db, relation);
+    if (rel) {
+        factdb_sync_relation(db, rel);
+        int total = rel->count + rel->posted;
+        if (total == 0) return 0;
+        
+        *tuples = malloc((size_t)total * sizeof(FactPair));
+        if (!*tuples) return -1;
+        
+        RelationCursor cursor;
+        int n = 0;
+        relation_cursor_init(&cursor, rel);
+        while (relation_cursor_next(&cursor, &(*tuples)[n])) n++;
+        return n;
+    }
+    
+    rel = factdb_equivalence_relation(db, relation);
+    if (rel) {
+        if (rel->classes.pairs == 0) return 0;
+        
+        *tuples = malloc((size_t)rel->classes.pairs * sizeof(FactPair));
+        if (!*tuples) return -1;
+        
+        ClassCursor cursor;
+        int n = 0;
+        class_cursor_init(&cursor, rel);
+        while (class_cursor_next(&cursor, &(*tuples)[n])) n++;
+        return n;
+    }
+    
+    int total = 0;
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, relation) == 0) total++;
+        }
+    }
+    if (total == 0) return 0;
+    
+    *tuples = malloc((size_t)total * sizeof(FactPair));
+    if (!*tuples) return -1;
+    
+    int n = 0;
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, relation) == 0) {
+                (*tuples)[n].arg_a = fact->arg_a;
+                (*tuples)[n].arg_b = fact->arg_b;
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+/* Add the reverse of every off-diagonal pair and sort, so consumers that
+ * expect sorted input see both orientations in order */
+static int symmetric_expand(FactPair **tuples, int count) {
+    int total = count;
+    for (int i = 0; i < count; i++) {
+        if ((*tuples)[i].arg_a != (*tuples)[i].arg_b) total++;
+    }
+    
+    uint64_t *keys = malloc((size_t)total * sizeof(uint64_t));
+    if (!keys) return -1;
+    
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        const FactPair *tuple = &(*tuples)[i];
+        keys[n++] = parallel_pack_pair(tuple->arg_a, tuple->arg_b);
+        if (tuple->arg_a != tuple->arg_b) {
+            keys[n++] = parallel_pack_pair(tuple->arg_b, tuple->arg_a);
+        }
+    }
+    
+    FactPair *expanded = malloc((size_t)total * sizeof(FactPair));
+    if (!expanded || !parallel_radix_sort(keys, (size_t)total)) {
+        free(keys);
+        free(expanded);
+        return -1;
+    }
+    for (int i = 0; i < total; i++) {
+        expanded[i].arg_a = parallel_unpack_a(keys[i]);
+        expanded[i].arg_b = parallel_unpack_b(keys[i]);
+    }
+    
+    free(keys);
+    free(*tuples);
+    *tuples = expanded;
+    return total;
+}
+
+int factdb_export(FactDatabase *db, const char *relation, FactPair **tuples) {
+    *tuples = NULL;
+    if (!relation) return 0;
+    
+    int count = factdb_export_stored(db, relation, tuples);
+    const Relation *rel = factdb_find_relation(db, relation);
+    if (count <= 0 || !rel || !rel->symmetric || rel->storage == RELATION_STORAGE_EQUIVALENCE ||
+        rel->storage == RELATION_STORAGE_FROZEN) {
+        return count;
+    }
+    
+    int total = symmetric_expand(tuples, count);
+    if (total < 0) {
+        free(*tuples);
+        *tuples = NULL;
+    }
+    return total;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Frozen Storage
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Build a relation's frozen rows from its facts in both orientations */
+static bool relation_freeze(FactDatabase *db, Relation *rel) {
+    FactPair *tuples;
+    int count = factdb_export(db, rel->name, &tuples);
+    if (count < 0) return false;
+    
+    uint64_t *keys = malloc(((size_t)count + 1) * sizeof(uint64_t));
+    if (!keys) {
+        free(tuples);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        keys[i] = parallel_pack_pair(tuples[i].arg_a, tuples[i].arg_b);
+    }
+    free(tuples);
+    
+    bool ok = frozen_build(&rel->frozen, keys, count);
+    free(keys);
+    return ok;
+}
+
+/* Drop a relation's mutable layout once its frozen rows are built */
+static void relation_release(FactDatabase *db, Relation *rel) {
+    if (rel->storage == RELATION_STORAGE_HASH) factdb_hash_remove(db, rel);
+    relmem_free(rel->tuples);
+    relmem_free(rel->delta);
+    rel->tuples = NULL;
+    rel->delta = NULL;
+    rel->count = rel->capacity = 0;
+    relation_clear_pending(rel);
+    rel->delta_capacity = 0;
+    relation_free_postings(rel);
+    unionfind_free(&rel->classes);
+    rel->storage = RELATION_STORAGE_FROZEN;
+}
+
+bool factdb_freeze(FactDatabase *db) {
+    if (db->frozen) return true;
+    if (factdb_merge(db) < 0) return false;
+    
+    /* Build everything before releasing anything, so a failure leaves the
+     * database as it was */
+    bool ok = true;
+    for (int i = 0; i < RELATION_TABLE_SIZE && ok; i++) {
+        for (Relation *rel = db->relations[i]; rel && ok; rel = rel->next) {
+            ok = relation_freeze(db, rel);
+        }
+    }
+    
+    long count = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (Relation *rel = db->relations[i]; rel; rel = rel->next) {
+            if (ok) {
+                relation_release(db, rel);
+                count += rel->frozen.count;
             } else {
-                printf("%d", fact->arg_b);
+                frozen_free(&rel->frozen);
             }
-            
-            printf(")\n");
-            fact = fact->next;
         }
     }
-}
-
-int factdb_count(const FactDatabase *db) {
-    return db->count;
+    if (!ok) return false;
+    
+    db->count = count;
+    db->frozen = true;
+    return true;
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -289,9 +2032,15 @@ void engine_init(ExecutionEngine *engine) {
     memset(engine->error, 0, sizeof(engine->error));
     engine->error_count = 0;
     engine->debug = false;
+    engine->join_strategy = JOIN_STRATEGY_AUTO;
+    engine->closure_max_domain = CLOSURE_DEFAULT_MAX_DOMAIN;
+    engine->epochs = NULL;
+    engine->query_cache = NULL;
+    engine->query_cache_entries = QUERYCACHE_DEFAULT_ENTRIES;
 }
 
 void engine_cleanup(ExecutionEngine *engine) {
+    engine_set_query_cache(engine, 0);
     factdb_cleanup(&engine->facts);
     atom_table_free(&engine->atoms);
     engine->error_count = 0;
@@ -318,116 +2067,861 @@ void engine_set_debug(ExecutionEngine *engine, bool debug) {
     engine->debug = debug;
 }
 
+void engine_set_join_strategy(ExecutionEngine *engine, JoinStrategy strategy) {
+    engine->join_strategy = strategy;
+}
+
+void engine_set_memory_budget(ExecutionEngine *engine, size_t bytes, const char *spill_dir) {
+    factdb_set_memory_budget(&engine->facts, bytes, spill_dir);
+}
+
+void engine_set_closure_domain(ExecutionEngine *engine, int max_atoms) {
+    engine->closure_max_domain = max_atoms > 0 ? max_atoms : 0;
+}
+
+void engine_set_epochs(ExecutionEngine *engine, struct EpochStore *store) {
+    engine->epochs = store;
+}
+
+/* Hand the solved facts to concurrent readers */
+static bool engine_publish(ExecutionEngine *engine) {
+    if (engine->epochs && !epoch_publish(engine->epochs, &engine->facts)) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+bool engine_freeze(ExecutionEngine *engine) {
+    if (!factdb_freeze(&engine->facts)) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+bool engine_reserve(ExecutionEngine *engine, const char *relation, int facts, int domain) {
+    if (engine->facts.frozen) {
+        engine_error(engine, "Database is frozen");
+        return false;
+    }
+    if (!relation) {
+        engine_error(engine, "No relation to reserve");
+        return false;
+    }
+    if (facts < 0 || facts > FACTDB_MAX_HINT || domain < 0 || domain > FACTDB_MAX_HINT) {
+        engine_error(engine, "Capacity hint out of range");
+        return false;
+    }
+    if (!factdb_reserve(&engine->facts, relation, facts, domain)) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+bool engine_load_facts(ExecutionEngine *engine, const char *relation, const char *path) {
+    if (engine->facts.frozen) {
+        engine_error(engine, "Database is frozen");
+        return false;
+    }
+    
+    char message[256];
+    if (factfile_load(&engine->facts, &engine->atoms, relation, path,
+                      message, sizeof(message)) < 0) {
+        engine_error(engine, message);
+        return false;
+    }
+    return true;
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Rule Evaluation (Fixpoint Computation)
  * ───────────────────────────────────────────────────────────────────────── */
 
-static bool engine_evaluate_rule(ExecutionEngine *engine, const ASTNode *rule) {
-    if (!rule || rule->type != AST_RULE) {
-        engine_error(engine, "Invalid rule node");
-        return false;
+/* Rows per column batch in legacy rule evaluation, and derived facts
+ * buffered before insertion */
+#define RULE_BATCH_SIZE 1024
+
+typedef struct JoinEmitContext {
+    ExecutionEngine *engine;
+    const JoinQuery *query;
+    bool new_facts_added;
+    FactPair pending[RULE_BATCH_SIZE];
+    int pending_count;
+} JoinEmitContext;
+
+/* Insert a batch of derived facts, printing the new ones in debug mode */
+static bool engine_insert_derived(ExecutionEngine *engine, const char *relation,
+                                  const FactPair *pairs, int count, bool *new_facts_added) {
+    int inserted[RULE_BATCH_SIZE];
+    int added = factdb_insert_batch(&engine->facts, relation, pairs, count,
+                                    engine->debug ? inserted : NULL);
+    if (added < 0) return false;
+    if (added > 0) *new_facts_added = true;
+    
+    for (int k = 0; engine->debug && k < count; k++) {
+        if (!inserted[k]) continue;
+        const char *name_a = atom_table_name(&engine->atoms, pairs[k].arg_a);
+        const char *name_b = atom_table_name(&engine->atoms, pairs[k].arg_b);
+        printf("  Derived: %s(%s, %s)\n", relation,
+               name_a ? name_a : "?", name_b ? name_b : "?");
+    }
+    return true;
+}
+
+static bool engine_flush_join_emits(JoinEmitContext *ctx) {
+    int count = ctx->pending_count;
+    ctx->pending_count = 0;
+    if (count == 0) return true;
+    
+    return engine_insert_derived(ctx->engine, ctx->query->emit_relation,
+                                 ctx->pending, count, &ctx->new_facts_added);
+}
+
+static bool engine_emit_join_frame(const int *frame, void *context) {
+    JoinEmitContext *ctx = context;
+    const JoinQuery *query = ctx->query;
+    FactPair *pending = &ctx->pending[ctx->pending_count++];
+    pending->arg_a = frame[query->emit_a];
+    pending->arg_b = frame[query->emit_b];
+    
+    return ctx->pending_count < RULE_BATCH_SIZE || engine_flush_join_emits(ctx);
+}
+
+/* Emit state of one worker of a parallel join.  Workers drop facts the
+ * database already holds and claim the rest in a shared concurrent set,
+ * so every new fact is buffered by exactly one of them. */
+typedef struct ParallelEmitContext {
+    const FactDatabase *db;
+    const JoinQuery *query;
+    FactSet *derived;
+    FactPair *facts;
+    int count;
+    int capacity;
+} ParallelEmitContext;
+
+static bool engine_emit_parallel_frame(const int *frame, void *context) {
+    ParallelEmitContext *ctx = context;
+    const JoinQuery *query = ctx->query;
+    int emit_a = frame[query->emit_a];
+    int emit_b = frame[query->emit_b];
+    
+    if (factdb_contains(ctx->db, query->emit_relation, emit_a, emit_b)) return true;
+    int claimed = factset_insert(ctx->derived, parallel_pack_pair(emit_a, emit_b));
+    if (claimed <= 0) return claimed == 0;
+    
+    if (ctx->count == ctx->capacity) {
+        int capacity = ctx->capacity ? ctx->capacity * 2 : RULE_BATCH_SIZE;
+        FactPair *facts = realloc(ctx->facts, (size_t)capacity * sizeof(FactPair));
+        if (!facts) return false;
+        ctx->facts = facts;
+        ctx->capacity = capacity;
+    }
+    ctx->facts[ctx->count].arg_a = emit_a;
+    ctx->facts[ctx->count].arg_b = emit_b;
+    ctx->count++;
+    return true;
+}
+
+/* Check if a compiled rule is worth splitting across threads: a pairwise
+ * plan over a large SCAN relation.  Debug runs stay serial so derivations
+ * print in order. */
+static int engine_join_threads(ExecutionEngine *engine, const JoinQuery *query) {
+    int threads = parallel_thread_count();
+    bool leapfrog = engine->join_strategy == JOIN_STRATEGY_LEAPFROG ||
+                    (engine->join_strategy == JOIN_STRATEGY_AUTO && query->cyclic);
+    if (threads < 2 || leapfrog || engine->debug) return 1;
+    
+    long scan = factdb_relation_size(&engine->facts, query->atoms[0].relation);
+    return scan >= 2L * JOIN_PARALLEL_MIN_SCAN ? threads : 1;
+}
+
+/* Run a join query on every worker, then insert what each worker claimed */
+static bool engine_run_parallel_join(ExecutionEngine *engine, const JoinQuery *query,
+                                     int threads, JoinStats *stats, bool *new_facts_added) {
+    /* Size the claim table for the facts the EMIT relation still expects */
+    const Relation *emit = factdb_find_relation(&engine->facts, query->emit_relation);
+    long expected = emit ? emit->size_hint - factdb_relation_size(&engine->facts, emit->name) : 0;
+    
+    FactSet derived;
+    if (!factset_init(&derived, expected > 0 ? (size_t)expected : 0)) return false;
+    
+    ParallelEmitContext workers[PARALLEL_MAX_THREADS];
+    void *contexts[PARALLEL_MAX_THREADS];
+    for (int w = 0; w < PARALLEL_MAX_THREADS; w++) {
+        workers[w] = (ParallelEmitContext){&engine->facts, query, &derived, NULL, 0, 0};
+        contexts[w] = &workers[w];
+    }
+    
+    bool ok = join_query_run_parallel(query, &engine->facts, engine->join_strategy, threads,
+                                      engine_emit_parallel_frame, contexts, stats);
+    
+    for (int w = 0; w < PARALLEL_MAX_THREADS; w++) {
+        for (int base = 0; ok && base < workers[w].count; base += RULE_BATCH_SIZE) {
+            int n = workers[w].count - base < RULE_BATCH_SIZE ?
+                    workers[w].count - base : RULE_BATCH_SIZE;
+            ok = engine_insert_derived(engine, query->emit_relation, &workers[w].facts[base],
+                                       n, new_facts_added);
+        }
+        free(workers[w].facts);
+    }
+    factset_free(&derived);
+    return ok;
+}
+
+/* Run a join query on the calling thread, inserting derived facts a
+ * batch at a time */
+static bool engine_run_join(ExecutionEngine *engine, const JoinQuery *query,
+                            JoinStats *stats, bool *new_facts_added) {
+    JoinEmitContext *ctx = malloc(sizeof(JoinEmitContext));
+    if (!ctx) return false;
+    ctx->engine = engine;
+    ctx->query = query;
+    ctx->new_facts_added = false;
+    ctx->pending_count = 0;
+    
+    bool ok = join_query_run(query, &engine->facts, engine->join_strategy,
+                             engine_emit_join_frame, ctx, stats) &&
+              engine_flush_join_emits(ctx);
+    *new_facts_added = ctx->new_facts_added;
+    free(ctx);
+    return ok;
+}
+
+/* Evaluate a rule compiled into a join query (its JOINs name their column
+ * B variables explicitly) */
+static bool engine_evaluate_join_query(ExecutionEngine *engine, const JoinQuery *query) {
+    JoinStats stats = {0, 0};
+    bool new_facts_added = false;
+    int threads = engine_join_threads(engine, query);
+    bool ok = threads > 1 ?
+        engine_run_parallel_join(engine, query, threads, &stats, &new_facts_added) :
+        engine_run_join(engine, query, &stats, &new_facts_added);
+    if (!ok) {
+        engine_error(engine, "Out of memory during join evaluation");
+        return false;
+    }
+    
+    if (engine->debug) {
+        printf("  Join: %ld intermediate, %ld results (%s)\n",
+               stats.intermediate, stats.results, query->cyclic ? "cyclic" : "acyclic");
+    }
+    return new_facts_added;
+}
+
+/* Probe state for one legacy JOIN.  Sorted relations are probed in place
+ * through a forward cursor, so ascending probe keys walk the tuple array
+ * once like a merge join.  Hash and symmetric relations are probed through
+ * a sorted copy (symmetric copies hold both orientations), made once per
+ * rule evaluation. */
+typedef struct JoinProbe {
+    Relation *sorted;           /* Probed in place, or NULL */
+    Relation *classes;          /* Equivalence relation, or NULL */
+    FactPair *copy;             /* Sorted copy of a hash or symmetric relation */
+    int copy_count;
+    int cursor;
+} JoinProbe;
+
+/* Sort pairs by (arg_a, arg_b) in place */
+static bool factpairs_sort(FactPair *tuples, int count) {
+    uint64_t *keys = malloc((size_t)count * sizeof(uint64_t));
+    if (!keys) return false;
+    
+    for (int i = 0; i < count; i++) {
+        keys[i] = parallel_pack_pair(tuples[i].arg_a, tuples[i].arg_b);
+    }
+    if (!parallel_radix_sort(keys, (size_t)count)) {
+        free(keys);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        tuples[i].arg_a = parallel_unpack_a(keys[i]);
+        tuples[i].arg_b = parallel_unpack_b(keys[i]);
+    }
+    
+    free(keys);
+    return true;
+}
+
+static bool join_probe_init(JoinProbe *probe, FactDatabase *db, const char *relation) {
+    probe->sorted = factdb_sorted_relation(db, relation);
+    probe->classes = factdb_equivalence_relation(db, relation);
+    probe->copy = NULL;
+    probe->copy_count = 0;
+    probe->cursor = 0;
+    
+    if (probe->classes) return true;
+    if (probe->sorted && !factdb_is_symmetric(db, relation)) {
+        factdb_sync_relation(db, probe->sorted);
+        return true;
+    }
+    
+    /* Symmetric exports arrive sorted, hash exports in bucket order */
+    probe->sorted = NULL;
+    probe->copy_count = factdb_export(db, relation, &probe->copy);
+    if (probe->copy_count < 0) return false;
+    return factdb_is_symmetric(db, relation) || factpairs_sort(probe->copy, probe->copy_count);
+}
+
+static void join_probe_free(JoinProbe *probe) {
+    free(probe->copy);
+    probe->copy = NULL;
+}
+
+/* Find the first column B value joined to key, false if there is none */
+static bool join_probe_first(JoinProbe *probe, int key, int *arg_b) {
+    /* A value in any class is related to itself first */
+    if (probe->classes) {
+        if (unionfind_node(&probe->classes->classes, key) < 0) return false;
+        *arg_b = key;
+        return true;
+    }
+    
+    const FactPair *tuples = probe->copy;
+    int count = probe->copy_count;
+    
+    const Relation *rel = probe->sorted;
+    if (rel) {
+        const Posting *posting = relation_find_posting(rel, key);
+        if (posting) {
+            *arg_b = roaring_decode(roaring_minimum(&posting->values));
+            return true;
+        }
+        tuples = rel->tuples;
+        count = rel->count;
+    }
+    
+    /* A key that goes backwards restarts the walk */
+    if (probe->cursor > 0 && tuples[probe->cursor - 1].arg_a >= key) {
+        probe->cursor = 0;
+    }
+    probe->cursor = tuple_gallop(tuples, probe->cursor, count, key, INT_MIN);
+    if (probe->cursor == count || tuples[probe->cursor].arg_a != key) {
+        return false;
+    }
+    *arg_b = tuples[probe->cursor].arg_b;
+    return true;
+}
+
+/* Value of legacy variable $var for a scanned tuple (-1 if unbound) */
+static int scan_binding(const ASTNode *scan, const FactPair *tuple, int var) {
+    switch (var) {
+        case 0:
+            if (!scan->data.scan.has_match) return -1;
+            if (scan->data.scan.match_var == 0) return tuple->arg_a;
+            if (scan->data.scan.match_var == 1) return tuple->arg_b;
+            return -1;
+        case 1: return tuple->arg_a;
+        case 2: return tuple->arg_b;
+        default: return -1;
+    }
+}
+
+/* Sort the outer tuples by a JOIN key so probes into a sorted relation
+ * arrive in ascending order (the sort half of sort-merge join) */
+static bool engine_order_by_key(FactPair **tuples, int count, const ASTNode *scan, int key_var) {
+    bool ascending = true;
+    for (int i = 1; i < count && ascending; i++) {
+        ascending = scan_binding(scan, &(*tuples)[i - 1], key_var) <=
+                    scan_binding(scan, &(*tuples)[i], key_var);
+    }
+    if (ascending) return true;
+    
+    uint64_t *keys = malloc((size_t)count * sizeof(uint64_t));
+    FactPair *ordered = malloc((size_t)count * sizeof(FactPair));
+    if (!keys || !ordered) {
+        free(keys);
+        free(ordered);
+        return false;
+    }
+    
+    /* Pack (key, index) so the radix sort carries the permutation */
+    for (int i = 0; i < count; i++) {
+        keys[i] = parallel_pack_pair(scan_binding(scan, &(*tuples)[i], key_var), i);
+    }
+    if (!parallel_radix_sort(keys, (size_t)count)) {
+        free(keys);
+        free(ordered);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        ordered[i] = (*tuples)[parallel_unpack_b(keys[i])];
+    }
+    
+    free(keys);
+    free(*tuples);
+    *tuples = ordered;
+    return true;
+}
+
+/* Legacy bindings for a batch of scanned tuples, one column per variable.
+ * sel lists the rows still satisfying the body; operators narrow it
+ * instead of moving rows. */
+typedef struct RuleBatch {
+    int vars[3][RULE_BATCH_SIZE];   /* $0 = match_var, $1 = arg_a, $2 = arg_b */
+    int sel[RULE_BATCH_SIZE];
+    int count;                      /* Live rows in sel */
+    FactPair emit[RULE_BATCH_SIZE]; /* Derived facts of the live rows */
+} RuleBatch;
+
+/* Load scanned tuples into the batch columns, every row selected */
+static void rule_batch_scan(RuleBatch *batch, const ASTNode *scan,
+                            const FactPair *tuples, int n) {
+    for (int k = 0; k < n; k++) {
+        batch->vars[1][k] = tuples[k].arg_a;
+        batch->vars[2][k] = tuples[k].arg_b;
+        batch->sel[k] = k;
+    }
+    
+    int match = scan->data.scan.has_match ? scan->data.scan.match_var : -1;
+    if (match == 0 || match == 1) {
+        memcpy(batch->vars[0], batch->vars[match + 1], (size_t)n * sizeof(int));
+    } else {
+        for (int k = 0; k < n; k++) batch->vars[0][k] = -1;
+    }
+    batch->count = n;
+}
+
+/* Keep the rows whose key_var has a partner in the probed relation and
+ * bind it to $2.  Every row is written and the count advances by the
+ * probe result, as in the compiled pipeline's filters. */
+static void rule_batch_join(RuleBatch *batch, JoinProbe *probe, int key_var) {
+    if (key_var < 0 || key_var > 2) {
+        batch->count = 0;
+        return;
+    }
+    
+    const int *keys = batch->vars[key_var];
+    int *joined = batch->vars[2];
+    int kept = 0;
+    for (int k = 0; k < batch->count; k++) {
+        int j = batch->sel[k];
+        int value = -1;
+        bool found = keys[j] != -1 && join_probe_first(probe, keys[j], &value);
+        batch->sel[kept] = j;
+        joined[j] = found ? value : joined[j];
+        kept += (int)found;
+    }
+    batch->count = kept;
+}
+
+/* Insert the EMIT fact of every selected row, false on error */
+static bool rule_batch_emit(ExecutionEngine *engine, RuleBatch *batch,
+                            const ASTNode *emit, bool *new_facts_added) {
+    int var_a = emit->data.emit.var_a;
+    int var_b = emit->data.emit.var_b;
+    if (var_a < 0 || var_a > 2 || var_b < 0 || var_b > 2) return true;
+    
+    const int *column_a = batch->vars[var_a];
+    const int *column_b = batch->vars[var_b];
+    int n = 0;
+    for (int k = 0; k < batch->count; k++) {
+        FactPair *fact = &batch->emit[n];
+        fact->arg_a = column_a[batch->sel[k]];
+        fact->arg_b = column_b[batch->sel[k]];
+        n += fact->arg_a != -1 && fact->arg_b != -1;
+    }
+    
+    return engine_insert_derived(engine, emit->data.emit.relation, batch->emit, n,
+                                 new_facts_added);
+}
+
+/* Evaluate one rule; plan is its compiled join query, or NULL for the
+ * legacy SCAN/JOIN form */
+static bool engine_evaluate_rule(ExecutionEngine *engine, const ASTNode *rule,
+                                 const JoinQuery *plan) {
+    if (!rule || rule->type != AST_RULE) {
+        engine_error(engine, "Invalid rule node");
+        return false;
+    }
+    
+    if (plan) {
+        return engine_evaluate_join_query(engine, plan);
+    }
+    
+    bool new_facts_added = false;
+    const char *target = rule->data.rule.target;
+    
+    if (engine->debug) {
+        printf("Evaluating rule for '%s'\n", target);
+    }
+    
+    /* For each combination of facts that matches the rule body */
+    ASTNode *body = rule->data.rule.body;
+    ASTNode *emit = rule->data.rule.emit;
+    
+    if (!body || !emit || emit->type != AST_EMIT) {
+        engine_error(engine, "Invalid rule structure");
+        return false;
+    }
+    
+    /* Simple case: SCAN + optional JOIN + EMIT */
+    if (body->type == AST_SCAN) {
+        /* Get all facts for the scanned relation */
+        FactPair *scan_tuples;
+        int scan_count = factdb_export(&engine->facts, body->data.scan.relation, &scan_tuples);
+        bool ok = scan_count >= 0;
+        
+        int join_count = 0;
+        for (ASTNode *op = body->next; op; op = op->next) {
+            if (op->type == AST_JOIN) join_count++;
+        }
+        JoinProbe *probes = join_count > 0 ? malloc(join_count * sizeof(JoinProbe)) : NULL;
+        RuleBatch *batch = scan_count > 0 ? malloc(sizeof(RuleBatch)) : NULL;
+        if (!ok || (join_count > 0 && !probes) || (scan_count > 0 && !batch)) {
+            free(scan_tuples);
+            free(probes);
+            free(batch);
+            engine_error(engine, "Out of memory");
+            return false;
+        }
+        
+        int ready = 0;
+        for (ASTNode *op = body->next; op && ok; op = op->next) {
+            if (op->type == AST_JOIN) {
+                ok = join_probe_init(&probes[ready++], &engine->facts, op->data.join.relation);
+            }
+        }
+        
+        /* Merge-join the first JOIN when it probes a sorted array */
+        if (ok && join_count > 0 && !probes[0].classes) {
+            ASTNode *first = body->next;
+            while (first->type != AST_JOIN) first = first->next;
+            ok = engine_order_by_key(&scan_tuples, scan_count, body, first->data.join.match_var);
+        }
+        
+        /* Scan, each JOIN and EMIT in turn consume a whole column batch */
+        bool failed = false;
+        for (int base = 0; ok && !failed && base < scan_count; base += RULE_BATCH_SIZE) {
+            int n = scan_count - base < RULE_BATCH_SIZE ? scan_count - base : RULE_BATCH_SIZE;
+            rule_batch_scan(batch, body, &scan_tuples[base], n);
+            
+            int p = 0;
+            for (ASTNode *op = body->next; op && batch->count > 0; op = op->next) {
+                if (op->type == AST_JOIN) {
+                    rule_batch_join(batch, &probes[p++], op->data.join.match_var);
+                }
+            }
+            
+            failed = !rule_batch_emit(engine, batch, emit, &new_facts_added);
+        }
+        
+        for (int q = 0; q < ready; q++) join_probe_free(&probes[q]);
+        free(scan_tuples);
+        free(probes);
+        free(batch);
+        if (!ok || failed) {
+            engine_error(engine, "Out of memory");
+            return false;
+        }
+    }
+    
+    return new_facts_added;
+}
+
+static const char* rule_head(const ASTNode *rule) {
+    const ASTNode *emit = rule->data.rule.emit;
+    return emit && emit->type == AST_EMIT ? emit->data.emit.relation : NULL;
+}
+
+/* Check if a rule reads only relation and emits into it */
+static bool rule_is_internal(const ASTNode *rule, const char *relation) {
+    const char *head = rule_head(rule);
+    if (!head || strcmp(head, relation) != 0 || !rule->data.rule.body) return false;
+    
+    for (const ASTNode *op = rule->data.rule.body; op; op = op->next) {
+        const char *read = op->type == AST_SCAN ? op->data.scan.relation :
+                           op->type == AST_JOIN ? op->data.join.relation : NULL;
+        if (!read || strcmp(read, relation) != 0) return false;
+    }
+    return true;
+}
+
+/* SCAN r, EMIT r $2 $1 */
+static bool rule_is_symmetric(const ASTNode *rule) {
+    const ASTNode *scan = rule->data.rule.body;
+    const ASTNode *emit = rule->data.rule.emit;
+    return scan->type == AST_SCAN && !scan->data.scan.has_match && !scan->next &&
+           emit->data.emit.var_a == 2 && emit->data.emit.var_b == 1;
+}
+
+/* SCAN r, JOIN r $1 $2, EMIT r $0 $2 */
+static bool rule_is_transitive(const ASTNode *rule) {
+    const ASTNode *scan = rule->data.rule.body;
+    const ASTNode *join = scan->next;
+    const ASTNode *emit = rule->data.rule.emit;
+    return scan->type == AST_SCAN && !scan->data.scan.has_match &&
+           join && join->type == AST_JOIN && !join->next && join->data.join.has_bind &&
+           join->data.join.match_var == 1 && join->data.join.bind_var == 2 &&
+           emit->data.emit.var_a == 0 && emit->data.emit.var_b == 2;
+}
+
+/* A relation with a symmetric and a transitive rule is an equivalence
+ * relation; store it as union-find classes unless declared otherwise */
+static bool engine_detect_equivalence(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                                      const char *relation) {
+    bool symmetric = false;
+    bool transitive = false;
+    for (int i = 0; i < rule_count; i++) {
+        if (!rule_is_internal(rules[i], relation)) continue;
+        symmetric = symmetric || rule_is_symmetric(rules[i]);
+        transitive = transitive || rule_is_transitive(rules[i]);
+    }
+    if (!symmetric || !transitive) return true;
+    
+    if (!factdb_set_storage(&engine->facts, relation, RELATION_STORAGE_EQUIVALENCE, false)) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+/* A relation with a rule swapping it into itself is closed under swapping
+ * its columns, whatever facts it later gets; store it symmetrically.
+ * Copies between relations imply symmetry only for the facts they copy,
+ * so they are left to run. */
+static bool engine_detect_symmetric(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                                    const char *relation) {
+    if (factdb_get_storage(&engine->facts, relation) == RELATION_STORAGE_EQUIVALENCE ||
+        factdb_is_symmetric(&engine->facts, relation)) {
+        return true;
+    }
+    
+    bool swaps = false;
+    for (int i = 0; i < rule_count; i++) {
+        swaps = swaps || (rule_is_internal(rules[i], relation) && rule_is_symmetric(rules[i]));
+    }
+    if (!swaps) return true;
+    
+    if (!factdb_set_symmetric(&engine->facts, relation)) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+/* Check if symmetric storage makes a rule redundant: a swap of the
+ * relation into itself */
+static bool rule_is_implied_symmetric(const ASTNode *rule) {
+    const char *head = rule_head(rule);
+    return rule_is_internal(rule, head) && rule_is_symmetric(rule);
+}
+
+/* Equivalence relations are detected first, then symmetric ones; the
+ * remaining relations probed by JOIN are stored sorted unless a REL
+ * attribute says otherwise: column A lookups become merge walks and join
+ * tries need no sort.  Rules implied by equivalence or symmetric storage
+ * are marked to be skipped. */
+static bool engine_choose_storage(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                                  bool *skip) {
+    for (int i = 0; i < rule_count; i++) {
+        const char *head = rule_head(rules[i]);
+        if (head && !engine_detect_equivalence(engine, rules, rule_count, head)) return false;
+    }
+    for (int i = 0; i < rule_count; i++) {
+        const char *head = rule_head(rules[i]);
+        if (head && !engine_detect_symmetric(engine, rules, rule_count, head)) return false;
+    }
+    
+    for (int i = 0; i < rule_count; i++) {
+        const char *head = rule_head(rules[i]);
+        if (head && factdb_get_storage(&engine->facts, head) == RELATION_STORAGE_EQUIVALENCE &&
+            rule_is_internal(rules[i], head)) {
+            skip[i] = true;
+        } else if (head && factdb_is_symmetric(&engine->facts, head) &&
+                   rule_is_implied_symmetric(rules[i])) {
+            skip[i] = true;
+        }
+        
+        for (ASTNode *op = rules[i]->data.rule.body; op; op = op->next) {
+            if (op->type != AST_JOIN) continue;
+            if (factdb_get_storage(&engine->facts, op->data.join.relation) ==
+                RELATION_STORAGE_EQUIVALENCE) {
+                continue;
+            }
+            if (!factdb_set_storage(&engine->facts, op->data.join.relation,
+                                    RELATION_STORAGE_SORTED, false)) {
+                engine_error(engine, "Out of memory");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Relation read by a body operation, looking through NOT */
+static const char* operation_relation(const ASTNode *op, bool *negated) {
+    *negated = op->type == AST_NOT;
+    if (*negated) op = op->data.negation.operation;
+    if (!op) return NULL;
+    return op->type == AST_SCAN ? op->data.scan.relation :
+           op->type == AST_JOIN ? op->data.join.relation : NULL;
+}
+
+static int relation_index(const char **names, int *count, const char *name) {
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    names[*count] = name;
+    return (*count)++;
+}
+
+/* Give every rule the stratum of its head: a relation sits at least as high
+ * as each relation its rules read and strictly above each one they negate.
+ * Levels only rise, so when one passes the number of relations the
+ * negation is recursive and the program has no stratification. */
+static bool engine_stratify(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                            int *strata, int *stratum_count) {
+    int capacity = 0;
+    for (int i = 0; i < rule_count; i++) {
+        capacity++;
+        for (const ASTNode *op = rules[i]->data.rule.body; op; op = op->next) capacity++;
     }
     
-    bool new_facts_added = false;
-    const char *target = rule->data.rule.target;
-    
-    if (engine->debug) {
-        printf("Evaluating rule for '%s'\n", target);
+    const char **names = malloc((size_t)capacity * sizeof(char *));
+    int *levels = calloc((size_t)capacity, sizeof(int));
+    if (!names || !levels) {
+        free(names);
+        free(levels);
+        engine_error(engine, "Out of memory");
+        return false;
     }
     
-    /* For each combination of facts that matches the rule body */
-    ASTNode *body = rule->data.rule.body;
-    ASTNode *emit = rule->data.rule.emit;
+    int count = 0;
+    bool ok = true;
+    bool changed = true;
+    while (ok && changed) {
+        changed = false;
+        for (int i = 0; i < rule_count && ok; i++) {
+            const char *head_name = rule_head(rules[i]);
+            if (!head_name) continue;
+            int head = relation_index(names, &count, head_name);
+            
+            for (const ASTNode *op = rules[i]->data.rule.body; op; op = op->next) {
+                bool negated;
+                const char *read = operation_relation(op, &negated);
+                if (!read) continue;
+                
+                int need = levels[relation_index(names, &count, read)] + (negated ? 1 : 0);
+                if (levels[head] >= need) continue;
+                levels[head] = need;
+                changed = true;
+                
+                if (need >= count) {
+                    char message[256];
+                    snprintf(message, sizeof(message),
+                             "Negation is not stratified: '%s' depends on its own negation",
+                             head_name);
+                    engine_error(engine, message);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
     
-    if (!body || !emit || emit->type != AST_EMIT) {
-        engine_error(engine, "Invalid rule structure");
-        return false;
+    *stratum_count = 1;
+    for (int i = 0; ok && i < rule_count; i++) {
+        const char *head_name = rule_head(rules[i]);
+        strata[i] = head_name ? levels[relation_index(names, &count, head_name)] : 0;
+        if (strata[i] >= *stratum_count) *stratum_count = strata[i] + 1;
     }
     
-    /* Simple case: SCAN + optional JOIN + EMIT */
-    if (body->type == AST_SCAN) {
-        /* Get all facts for the scanned relation */
-        QueryResult *scan_results = factdb_get_all(&engine->facts, body->data.scan.relation);
-        QueryResult *scan_iter = scan_results;
+    free(names);
+    free(levels);
+    return ok;
+}
+
+/* A closure can run once no rule still pending derives one of its inputs */
+static bool engine_closure_ready(const ClosurePlan *plan, ASTNode **rules, int rule_count,
+                                 const bool *skip) {
+    const char *const *lists[] = {plan->bases, plan->left, plan->right};
+    int counts[] = {plan->base_count, plan->left_count, plan->right_count};
+
+    for (int i = 0; i < rule_count; i++) {
+        const char *head = rule_head(rules[i]);
+        if (skip[i] || !head || strcmp(head, plan->target) == 0) continue;
+
+        for (int l = 0; l < 3; l++) {
+            for (int j = 0; j < counts[l]; j++) {
+                if (strcmp(lists[l][j], head) == 0) return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Evaluate closure-shaped recursive relations over small atom domains as
+ * bit matrices before the fixpoint loop, marking their rules so the loop
+ * skips them.  Closures feeding other closures run in dependency order. */
+static bool engine_evaluate_closures(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                                     bool *skip) {
+    if (engine->closure_max_domain <= 0) return true;
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
         
-        while (scan_iter) {
-            /* Variable bindings: $0 = match_var, $1 = scan_iter->arg_a, $2 = scan_iter->arg_b */
-            int var_bindings[3] = {-1, scan_iter->arg_a, scan_iter->arg_b};
+        for (int i = 0; i < rule_count; i++) {
+            const char *target = rule_head(rules[i]);
+            if (skip[i] || !target) continue;
             
-            /* Set match variable if specified */
-            if (body->data.scan.has_match) {
-                if (body->data.scan.match_var == 0) {
-                    var_bindings[0] = scan_iter->arg_a;
-                } else if (body->data.scan.match_var == 1) {
-                    var_bindings[0] = scan_iter->arg_b;
-                }
+            /* Plan each relation once per pass, at its first rule */
+            bool seen = false;
+            for (int j = 0; j < i && !seen; j++) {
+                seen = rule_head(rules[j]) && strcmp(rule_head(rules[j]), target) == 0;
             }
+            if (seen) continue;
             
-            /* Check for JOIN operations */
-            ASTNode *next_op = body->next;
-            bool join_satisfied = true;
+            if (factdb_get_storage(&engine->facts, target) == RELATION_STORAGE_EQUIVALENCE) {
+                continue;
+            }
             
-            while (next_op && join_satisfied) {
-                if (next_op->type == AST_JOIN) {
-                    /* Find facts that join on the specified variable */
-                    int join_var = next_op->data.join.match_var;
-                    if (join_var < 0 || join_var > 2 || var_bindings[join_var] == -1) {
-                        join_satisfied = false;
-                        break;
-                    }
-                    
-                    /* Look for facts where first argument matches the join variable */
-                    QueryResult *join_results = factdb_query(&engine->facts, 
-                                                            next_op->data.join.relation,
-                                                            var_bindings[join_var], -1);
-                    
-                    if (!join_results) {
-                        join_satisfied = false;
-                    } else {
-                        /* Update variable bindings with join result */
-                        /* For simplicity, take first result - more complex rules would iterate */
-                        var_bindings[2] = join_results->arg_b;  /* $2 gets second arg of join */
-                        query_result_free(join_results);
-                    }
-                }
-                next_op = next_op->next;
+            ClosurePlan plan;
+            if (!closure_plan(&plan, target, rules, rule_count)) continue;
+            if (!engine_closure_ready(&plan, rules, rule_count, skip)) continue;
+            
+            bool applied;
+            if (!closure_evaluate(&plan, &engine->facts, engine->closure_max_domain, &applied)) {
+                engine_error(engine, "Out of memory evaluating dense closure");
+                return false;
             }
+            if (!applied) continue;
             
-            /* If all joins satisfied, emit the fact */
-            if (join_satisfied) {
-                int emit_a = -1, emit_b = -1;
-                
-                /* Resolve emit variables */
-                if (emit->data.emit.var_a >= 0 && emit->data.emit.var_a < 3) {
-                    emit_a = var_bindings[emit->data.emit.var_a];
-                }
-                if (emit->data.emit.var_b >= 0 && emit->data.emit.var_b < 3) {
-                    emit_b = var_bindings[emit->data.emit.var_b];
-                }
-                
-                /* Add the derived fact if variables are bound */
-                if (emit_a != -1 && emit_b != -1) {
-                    if (!factdb_has_fact(&engine->facts, emit->data.emit.relation, emit_a, emit_b)) {
-                        factdb_add_fact(&engine->facts, emit->data.emit.relation, emit_a, emit_b);
-                        new_facts_added = true;
-                        
-                        if (engine->debug) {
-                            const char *name_a = atom_table_name(&engine->atoms, emit_a);
-                            const char *name_b = atom_table_name(&engine->atoms, emit_b);
-                            printf("  Derived: %s(%s, %s)\n", emit->data.emit.relation,
-                                   name_a ? name_a : "?", name_b ? name_b : "?");
-                        }
-                    }
+            if (engine->debug) {
+                printf("Dense closure for '%s'\n", target);
+            }
+            for (int j = i; j < rule_count; j++) {
+                if (rule_head(rules[j]) && strcmp(rule_head(rules[j]), target) == 0) {
+                    skip[j] = true;
                 }
             }
-            
-            scan_iter = scan_iter->next;
+            progress = true;
         }
-        
-        query_result_free(scan_results);
     }
     
-    return new_facts_added;
+    if (factdb_merge(&engine->facts) < 0) {
+        engine_error(engine, "Out of memory merging derived facts");
+        return false;
+    }
+    return true;
+}
+
+/* Compile the rules that use explicit JOIN bindings or WHERE filters once
+ * per SOLVE, so slot allocation is not repeated every iteration.  A rule
+ * that fails to compile is reported and skipped. */
+static void engine_compile_rules(ExecutionEngine *engine, ASTNode **rules, int rule_count,
+                                 bool *skip, JoinQuery *plans) {
+    char error_buf[256];
+    
+    for (int i = 0; i < rule_count; i++) {
+        if (skip[i] || !join_rule_needs_query(rules[i])) continue;
+        if (!join_query_compile(&plans[i], rules[i], &engine->atoms, error_buf, sizeof(error_buf))) {
+            engine_error(engine, error_buf);
+            skip[i] = true;
+        }
+    }
 }
 
 static bool engine_solve(ExecutionEngine *engine, const ASTNode *program) {
@@ -463,60 +2957,233 @@ static bool engine_solve(ExecutionEngine *engine, const ASTNode *program) {
         stmt = stmt->next;
     }
     
-    /* Fixpoint iteration */
-    bool changed = true;
-    int iteration = 0;
+    /* Rules evaluated as dense closures or implied by equivalence or
+     * symmetric storage */
+    bool *skip = calloc(rule_count, sizeof(bool));
+    int *strata = calloc(rule_count, sizeof(int));
+    JoinQuery *plans = calloc(rule_count, sizeof(JoinQuery));
+    int stratum_count = 1;
+    if (!skip || !strata || !plans) {
+        free(skip);
+        free(strata);
+        free(plans);
+        free(rules);
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    
+    if (!engine_stratify(engine, rules, rule_count, strata, &stratum_count) ||
+        !engine_choose_storage(engine, rules, rule_count, skip) ||
+        !engine_evaluate_closures(engine, rules, rule_count, skip)) {
+        free(skip);
+        free(strata);
+        free(plans);
+        free(rules);
+        return false;
+    }
+    engine_compile_rules(engine, rules, rule_count, skip, plans);
     
     if (engine->debug) {
         printf("Starting fixpoint computation...\n");
     }
     
-    while (changed && iteration < 100) {  /* Prevent infinite loops */
-        changed = false;
-        iteration++;
-        
-        if (engine->debug) {
-            printf("\nIteration %d:\n", iteration);
-        }
+    /* Facts derived into sorted relations are buffered and merged at the
+     * end of each iteration, so the arrays rules read stay stable */
+    factdb_defer_merge(&engine->facts, true);
+    bool ok = true;
+    
+    /* Each stratum reaches its fixpoint before the next one starts, so a
+     * negated relation is complete by the time a rule probes it */
+    for (int stratum = 0; ok && stratum < stratum_count; stratum++) {
+        bool changed = true;
+        int iteration = 0;
         
-        /* Apply all rules */
-        for (i = 0; i < rule_count; i++) {
-            if (engine_evaluate_rule(engine, rules[i])) {
-                changed = true;
+        while (changed && iteration < 100) {  /* Prevent infinite loops */
+            long facts_before = factdb_count(&engine->facts);
+            iteration++;
+            
+            if (engine->debug) {
+                printf("\nStratum %d, iteration %d:\n", stratum, iteration);
+            }
+            
+            /* Apply the stratum's rules not skipped above */
+            for (i = 0; i < rule_count; i++) {
+                if (!skip[i] && strata[i] == stratum) {
+                    engine_evaluate_rule(engine, rules[i], plans[i].atoms ? &plans[i] : NULL);
+                }
+            }
+            
+            if (factdb_merge(&engine->facts) < 0) {
+                engine_error(engine, "Out of memory merging derived facts");
+                ok = false;
+                break;
+            }
+            changed = factdb_count(&engine->facts) > facts_before;
+            
+            if (engine->debug) {
+                printf("Facts after iteration %d: %ld\n", iteration, factdb_count(&engine->facts));
             }
         }
         
         if (engine->debug) {
-            printf("Facts after iteration %d: %d\n", iteration, factdb_count(&engine->facts));
+            printf("Stratum %d reached its fixpoint after %d iterations.\n", stratum, iteration);
         }
     }
     
-    if (engine->debug) {
-        printf("Fixpoint reached after %d iterations.\n", iteration);
-    }
+    factdb_defer_merge(&engine->facts, false);
     
+    for (i = 0; i < rule_count; i++) {
+        join_query_free(&plans[i]);
+    }
+    free(plans);
+    free(strata);
+    free(skip);
     free(rules);
-    return true;
+    return ok;
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Statement Execution
  * ───────────────────────────────────────────────────────────────────────── */
 
+static bool engine_declare_relation(ExecutionEngine *engine, const ASTNode *decl) {
+    unsigned int attributes = decl->data.rel_decl.attributes;
+    bool ok = true;
+    
+    if (attributes & REL_ATTR_SORTED) {
+        ok = factdb_set_storage(&engine->facts, decl->data.rel_decl.name,
+                                RELATION_STORAGE_SORTED, true);
+    } else if (attributes & REL_ATTR_HASH) {
+        ok = factdb_set_storage(&engine->facts, decl->data.rel_decl.name,
+                                RELATION_STORAGE_HASH, true);
+    } else if (attributes & REL_ATTR_EQUIVALENCE) {
+        ok = factdb_set_storage(&engine->facts, decl->data.rel_decl.name,
+                                RELATION_STORAGE_EQUIVALENCE, true);
+    }
+    if (ok && (attributes & REL_ATTR_SYMMETRIC)) {
+        ok = factdb_set_symmetric(&engine->facts, decl->data.rel_decl.name);
+    }
+    if (!ok) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    
+    if (decl->data.rel_decl.size_hint || decl->data.rel_decl.domain_hint) {
+        return engine_reserve(engine, decl->data.rel_decl.name, decl->data.rel_decl.size_hint,
+                              decl->data.rel_decl.domain_hint);
+    }
+    return true;
+}
+
+/* Resolve a FACT's atoms against the engine's table, which may already
+ * hold imported or logged atoms the parser never saw */
+static bool engine_fact_pair(ExecutionEngine *engine, const ASTNode *stmt, FactPair *pair) {
+    pair->arg_a = stmt->data.fact.a;
+    pair->arg_b = stmt->data.fact.b;
+    if (stmt->data.fact.atom_a) {
+        pair->arg_a = atom_table_intern(&engine->atoms, stmt->data.fact.atom_a);
+    }
+    if (stmt->data.fact.atom_b) {
+        pair->arg_b = atom_table_intern(&engine->atoms, stmt->data.fact.atom_b);
+    }
+    if (pair->arg_a < 0 || pair->arg_b < 0) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bulk Loading of Program Facts
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* A program's FACT statements for one relation, gathered into a column */
+typedef struct FactColumn {
+    const char *relation;
+    FactPair *pairs;
+    int count;
+    int capacity;
+} FactColumn;
+
+typedef struct FactColumns {
+    FactColumn *columns;
+    int count;
+    int capacity;
+    int last;                   /* Column of the previous fact */
+} FactColumns;
+
+static bool fact_columns_add(FactColumns *cols, const char *relation, FactPair pair) {
+    FactColumn *column = cols->last < cols->count ? &cols->columns[cols->last] : NULL;
+    if (!column || strcmp(column->relation, relation) != 0) {
+        column = NULL;
+        for (int i = 0; i < cols->count && !column; i++) {
+            if (strcmp(cols->columns[i].relation, relation) == 0) {
+                column = &cols->columns[i];
+                cols->last = i;
+            }
+        }
+    }
+    if (!column) {
+        if (cols->count == cols->capacity) {
+            int capacity = cols->capacity ? cols->capacity * 2 : 8;
+            FactColumn *columns = realloc(cols->columns, (size_t)capacity * sizeof(FactColumn));
+            if (!columns) return false;
+            cols->columns = columns;
+            cols->capacity = capacity;
+        }
+        cols->last = cols->count++;
+        column = &cols->columns[cols->last];
+        *column = (FactColumn){relation, NULL, 0, 0};
+    }
+    
+    if (column->count == column->capacity) {
+        int capacity = column->capacity ? column->capacity * 2 : 64;
+        FactPair *pairs = realloc(column->pairs, (size_t)capacity * sizeof(FactPair));
+        if (!pairs) return false;
+        column->pairs = pairs;
+        column->capacity = capacity;
+    }
+    column->pairs[column->count++] = pair;
+    return true;
+}
+
+/* Bulk load and empty every column */
+static bool fact_columns_flush(ExecutionEngine *engine, FactColumns *cols) {
+    bool ok = true;
+    for (int i = 0; i < cols->count; i++) {
+        FactColumn *column = &cols->columns[i];
+        ok = ok && factdb_bulk_load(&engine->facts, column->relation, column->pairs, column->count);
+        free(column->pairs);
+    }
+    cols->count = 0;
+    cols->last = 0;
+    if (!ok) engine_error(engine, "Out of memory");
+    return ok;
+}
+
+static void fact_columns_free(FactColumns *cols) {
+    for (int i = 0; i < cols->count; i++) free(cols->columns[i].pairs);
+    free(cols->columns);
+}
+
 bool engine_execute_statement(ExecutionEngine *engine, const ASTNode *stmt) {
     if (!stmt) return false;
+    if (engine->facts.frozen && stmt->type != AST_QUERY) {
+        engine_error(engine, "Database is frozen");
+        return false;
+    }
     
     switch (stmt->type) {
         case AST_REL_DECL:
-            /* Relation declarations don't need runtime processing */
-            return true;
+            /* Apply storage attributes */
+            return engine_declare_relation(engine, stmt);
             
-        case AST_FACT:
-            /* Add fact to database */
-            return factdb_add_fact(&engine->facts, 
-                                   stmt->data.fact.relation,
-                                   stmt->data.fact.a,
-                                   stmt->data.fact.b);
+        case AST_FACT: {
+            FactPair pair;
+            return engine_fact_pair(engine, stmt, &pair) &&
+                   factdb_add_fact(&engine->facts, stmt->data.fact.relation,
+                                   pair.arg_a, pair.arg_b);
+        }
             
         case AST_RULE:
             /* Rules are processed during SOLVE */
@@ -524,7 +3191,7 @@ bool engine_execute_statement(ExecutionEngine *engine, const ASTNode *stmt) {
             
         case AST_SOLVE:
             /* Compute fixpoint */
-            return engine_solve(engine, stmt->next ? stmt : NULL);
+            return engine_solve(engine, stmt->next ? stmt : NULL) && engine_publish(engine);
             
         case AST_QUERY:
             /* Queries are handled separately by engine_query */
@@ -541,25 +3208,38 @@ bool engine_execute_program(ExecutionEngine *engine, const ASTNode *program) {
         engine_error(engine, "Invalid program node");
         return false;
     }
+    if (engine->facts.frozen) {
+        engine_error(engine, "Database is frozen");
+        return false;
+    }
     
-    /* First pass: Add all facts and copy atom table */
+    /* First pass: Declare relations and gather facts into per-relation
+     * columns, bulk loaded whenever a declaration may change a layout */
+    FactColumns cols = {NULL, 0, 0, 0};
+    bool ok = true;
     ASTNode *stmt = program->data.program.statements;
-    while (stmt) {
-        if (stmt->type == AST_FACT) {
-            /* Copy atoms from fact to engine's atom table */
-            if (stmt->data.fact.atom_a) {
-                atom_table_intern(&engine->atoms, stmt->data.fact.atom_a);
-            }
-            if (stmt->data.fact.atom_b) {
-                atom_table_intern(&engine->atoms, stmt->data.fact.atom_b);
-            }
-            
-            if (!engine_execute_statement(engine, stmt)) {
-                return false;
+    while (stmt && ok) {
+        if (stmt->type == AST_REL_DECL) {
+            ok = fact_columns_flush(engine, &cols) && engine_execute_statement(engine, stmt);
+        } else if (stmt->type == AST_FACT) {
+            FactPair pair;
+            ok = engine_fact_pair(engine, stmt, &pair);
+            if (ok && !fact_columns_add(&cols, stmt->data.fact.relation, pair)) {
+                engine_error(engine, "Out of memory");
+                ok = false;
             }
         }
         stmt = stmt->next;
     }
+    ok = ok && fact_columns_flush(engine, &cols);
+    fact_columns_free(&cols);
+    if (!ok) return false;
+    
+    /* Sort, deduplicate and index the loaded facts */
+    if (factdb_merge(&engine->facts) < 0) {
+        engine_error(engine, "Out of memory");
+        return false;
+    }
     
     /* Second pass: Process SOLVE (which handles rules) */
     stmt = program->data.program.statements;
@@ -573,7 +3253,25 @@ bool engine_execute_program(ExecutionEngine *engine, const ASTNode *program) {
         stmt = stmt->next;
     }
     
-    return true;
+    return engine_publish(engine);
+}
+
+/* The engine's query cache, created on first use (NULL when off) */
+/* The cache in use, or NULL when answers must not be cached: unmerged
+ * inserts change answers without a new version, and a frozen database
+ * may be read by several threads while the cache is written on lookup */
+static QueryCache* engine_query_cache(ExecutionEngine *engine) {
+    if (engine->facts.defer_merge || engine->facts.frozen) return NULL;
+    if (engine->query_cache || engine->query_cache_entries == 0) return engine->query_cache;
+    
+    QueryCache *cache = malloc(sizeof(QueryCache));
+    if (!cache) return NULL;
+    if (!querycache_init(cache, engine->query_cache_entries)) {
+        free(cache);
+        return NULL;
+    }
+    engine->query_cache = cache;
+    return cache;
 }
 
 QueryResult* engine_query(ExecutionEngine *engine, const ASTNode *query) {
@@ -593,7 +3291,339 @@ QueryResult* engine_query(ExecutionEngine *engine, const ASTNode *query) {
         arg_b = atom_table_intern(&engine->atoms, query->data.query.atom_b);
     }
     
-    return factdb_query(&engine->facts, query->data.query.relation, arg_a, arg_b);
+    const char *relation = query->data.query.relation;
+    if (!relation) return NULL;
+    
+    QueryCache *cache = engine_query_cache(engine);
+    if (!cache) {
+        return factdb_query(&engine->facts, relation, arg_a, arg_b);
+    }
+    
+    uint64_t version = factdb_relation_version(&engine->facts, relation);
+    QueryResult *results;
+    if (querycache_lookup(cache, relation, arg_a, arg_b, version, &results)) return results;
+    
+    results = factdb_query(&engine->facts, relation, arg_a, arg_b);
+    querycache_store(cache, relation, arg_a, arg_b, version, results);
+    return results;
+}
+
+void engine_set_query_cache(ExecutionEngine *engine, int max_entries) {
+    if (engine->query_cache) {
+        querycache_free(engine->query_cache);
+        free(engine->query_cache);
+        engine->query_cache = NULL;
+    }
+    engine->query_cache_entries = max_entries > 0 ? max_entries : 0;
+}
+
+void engine_query_cache_stats(const ExecutionEngine *engine, QueryCacheStats *stats) {
+    if (engine->query_cache) {
+        *stats = engine->query_cache->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Prepared Queries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+PreparedQuery* engine_prepare_query(ExecutionEngine *engine, const char *relation,
+                                    QueryBinding binding_a, QueryBinding binding_b) {
+    if (!relation) {
+        engine_error(engine, "Invalid query relation");
+        return NULL;
+    }
+    
+    PreparedQuery *prepared = calloc(1, sizeof(PreparedQuery));
+    if (prepared) prepared->relation = strdup(relation);
+    if (!prepared || !prepared->relation) {
+        free(prepared);
+        engine_error(engine, "Out of memory preparing query");
+        return NULL;
+    }
+    
+    prepared->engine = engine;
+    prepared->binding_a = binding_a;
+    prepared->binding_b = binding_b;
+    if (binding_a == QUERY_BOUND && binding_b == QUERY_BOUND) {
+        prepared->plan = QUERY_PLAN_PROBE;
+    } else if (binding_a == QUERY_BOUND || binding_b == QUERY_BOUND) {
+        prepared->plan = QUERY_PLAN_SEEK;
+    } else {
+        prepared->plan = QUERY_PLAN_SCAN;
+    }
+    prepared->rel = factdb_find_relation(&engine->facts, relation);
+    return prepared;
+}
+
+QueryResult* prepared_query_execute(PreparedQuery *prepared, int arg_a, int arg_b) {
+    /* Relations live until cleanup, so one found stays valid */
+    FactDatabase *db = &prepared->engine->facts;
+    if (!prepared->rel) {
+        prepared->rel = factdb_find_relation(db, prepared->relation);
+        if (!prepared->rel) return NULL;
+    }
+    
+    if (prepared->plan == QUERY_PLAN_PROBE) {
+        factdb_sync_relation(db, prepared->rel);
+        if (!relation_has_pair(db, prepared->rel, arg_a, arg_b)) return NULL;
+        QueryResult *result = NULL;
+        QueryResult *tail = NULL;
+        query_result_append(&result, &tail, arg_a, arg_b);
+        return result;
+    }
+    
+    if (prepared->binding_a == QUERY_FREE) arg_a = -1;
+    if (prepared->binding_b == QUERY_FREE) arg_b = -1;
+    return relation_query_pattern(db, prepared->rel, arg_a, arg_b);
+}
+
+void prepared_query_free(PreparedQuery *prepared) {
+    if (!prepared) return;
+    free(prepared->relation);
+    free(prepared);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Batched Queries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* One query of a batch, resolved to its relation and atom IDs */
+typedef struct BatchQuery {
+    Relation *rel;
+    int arg_a;                  /* -1 = wildcard */
+    int arg_b;
+    int shape;                  /* Bit 0: arg_a bound, bit 1: arg_b bound */
+    int index;                  /* Position in the caller's batch */
+} BatchQuery;
+
+#define BATCH_BOUND_A 1
+#define BATCH_BOUND_B 2
+
+/* By relation and shape, so each group is a run; then by key */
+static int batch_query_compare(const void *left, const void *right) {
+    const BatchQuery *x = left;
+    const BatchQuery *y = right;
+    if (x->rel != y->rel) return (uintptr_t)x->rel < (uintptr_t)y->rel ? -1 : 1;
+    if (x->shape != y->shape) return x->shape < y->shape ? -1 : 1;
+    if (x->arg_a != y->arg_a) return x->arg_a < y->arg_a ? -1 : 1;
+    if (x->arg_b != y->arg_b) return x->arg_b < y->arg_b ? -1 : 1;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+static QueryResult* query_result_copy(const QueryResult *results) {
+    QueryResult *copy = NULL;
+    QueryResult *tail = NULL;
+    for (const QueryResult *r = results; r; r = r->next) {
+        if (!query_result_append(&copy, &tail, r->arg_a, r->arg_b)) break;
+    }
+    return copy;
+}
+
+/* Fully bound queries: membership tests issued a group at a time so
+ * their cache misses overlap */
+static void batch_probe(FactDatabase *db, Relation *rel, const BatchQuery *group, int n,
+                        QueryResult **results) {
+    bool sorted = rel->storage == RELATION_STORAGE_SORTED;
+    if (sorted) factdb_sync_relation(db, rel);
+    
+    for (int base = 0; base < n; base += PARALLEL_PROBE_GROUP) {
+        int m = n - base < PARALLEL_PROBE_GROUP ? n - base : PARALLEL_PROBE_GROUP;
+        FactPair pairs[PARALLEL_PROBE_GROUP];
+        bool found[PARALLEL_PROBE_GROUP];
+        
+        for (int k = 0; k < m; k++) {
+            pairs[k].arg_a = group[base + k].arg_a;
+            pairs[k].arg_b = group[base + k].arg_b;
+            relation_canonicalize(rel, &pairs[k].arg_a, &pairs[k].arg_b);
+        }
+        if (sorted) {
+            relation_contains_group(rel, pairs, m, found);
+        } else {
+            for (int k = 0; rel->storage == RELATION_STORAGE_HASH && k < m; k++) {
+                parallel_prefetch(db->buckets[hash_fact(rel->name, pairs[k].arg_a, pairs[k].arg_b)]);
+            }
+            for (int k = 0; k < m; k++) {
+                found[k] = relation_has_pair(db, rel, group[base + k].arg_a, group[base + k].arg_b);
+            }
+        }
+        
+        for (int k = 0; k < m; k++) {
+            QueryResult *tail = NULL;
+            if (found[k]) {
+                query_result_append(&results[group[base + k].index], &tail,
+                                    group[base + k].arg_a, group[base + k].arg_b);
+            }
+        }
+    }
+}
+
+static int batch_key_find(const int *keys, int n, int key) {
+    int lo = 0;
+    int hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < n && keys[lo] == key ? lo : -1;
+}
+
+/* Queries binding the same unindexed column share one pass over the
+ * relation, each fact going to the query whose key it carries.  Facts
+ * are met in the order a lone query meets them, so answers match. */
+static bool batch_scan(FactDatabase *db, Relation *rel, const BatchQuery *group, int n,
+                       QueryResult **results) {
+    bool by_a = group[0].shape == BATCH_BOUND_A;
+    int *keys = malloc((size_t)n * sizeof(int));
+    QueryResult **tails = calloc((size_t)n, sizeof(QueryResult *));
+    if (!keys || !tails) {
+        free(keys);
+        free(tails);
+        return false;
+    }
+    for (int k = 0; k < n; k++) {
+        keys[k] = by_a ? group[k].arg_a : group[k].arg_b;
+    }
+    
+    if (rel->storage == RELATION_STORAGE_SORTED) {
+        factdb_sync_relation(db, rel);
+        RelationCursor cursor;
+        FactPair tuple;
+        relation_cursor_init(&cursor, rel);
+        while (relation_cursor_next(&cursor, &tuple)) {
+            int k = batch_key_find(keys, n, by_a ? tuple.arg_a : tuple.arg_b);
+            if (k >= 0) {
+                query_result_append(&results[group[k].index], &tails[k], tuple.arg_a, tuple.arg_b);
+            }
+        }
+    } else {
+        for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+            for (const Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+                if (strcmp(fact->relation, rel->name) != 0) continue;
+                int k = batch_key_find(keys, n, by_a ? fact->arg_a : fact->arg_b);
+                if (k >= 0) {
+                    query_result_append(&results[group[k].index], &tails[k],
+                                        fact->arg_a, fact->arg_b);
+                }
+            }
+        }
+    }
+    
+    free(keys);
+    free(tails);
+    return true;
+}
+
+/* Answer one group of distinct queries sharing a relation and shape */
+static void batch_answer(FactDatabase *db, const BatchQuery *group, int n, QueryResult **results) {
+    Relation *rel = group[0].rel;
+    if (group[0].shape == (BATCH_BOUND_A | BATCH_BOUND_B)) {
+        batch_probe(db, rel, group, n, results);
+        return;
+    }
+    
+    /* Symmetric relations answer from both columns, so share nothing */
+    bool plain = !rel->symmetric || rel->storage == RELATION_STORAGE_EQUIVALENCE ||
+                 rel->storage == RELATION_STORAGE_FROZEN;
+    bool unindexed = rel->storage == RELATION_STORAGE_HASH ||
+                     (rel->storage == RELATION_STORAGE_SORTED && group[0].shape == BATCH_BOUND_B);
+    if (plain && unindexed && n > 1 && batch_scan(db, rel, group, n, results)) return;
+    
+    for (int k = 0; k < n; k++) {
+        results[group[k].index] = relation_query_pattern(db, rel, group[k].arg_a, group[k].arg_b);
+    }
+}
+
+bool engine_query_batch(ExecutionEngine *engine, const ASTNode *const *queries, int count,
+                        QueryResult **results) {
+    for (int i = 0; i < count; i++) results[i] = NULL;
+    
+    BatchQuery *batch = malloc(((size_t)count + 1) * sizeof(BatchQuery));
+    int *source = malloc(((size_t)count + 1) * sizeof(int));
+    if (!batch || !source) {
+        free(batch);
+        free(source);
+        engine_error(engine, "Out of memory answering queries");
+        return false;
+    }
+    
+    bool ok = true;
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        const ASTNode *query = queries[i];
+        source[i] = -1;
+        if (!query || query->type != AST_QUERY) {
+            engine_error(engine, "Invalid query node");
+            ok = false;
+            continue;
+        }
+        
+        int arg_a = query->data.query.arg_a;
+        int arg_b = query->data.query.arg_b;
+        if (query->data.query.atom_a) {
+            arg_a = atom_table_intern(&engine->atoms, query->data.query.atom_a);
+        }
+        if (query->data.query.atom_b) {
+            arg_b = atom_table_intern(&engine->atoms, query->data.query.atom_b);
+        }
+        
+        /* Every stored fact's relation is registered, so none means no facts */
+        Relation *rel = query->data.query.relation ?
+            factdb_find_relation(&engine->facts, query->data.query.relation) : NULL;
+        if (!rel) continue;
+        
+        batch[n].rel = rel;
+        batch[n].arg_a = arg_a;
+        batch[n].arg_b = arg_b;
+        batch[n].shape = (arg_a != -1 ? BATCH_BOUND_A : 0) | (arg_b != -1 ? BATCH_BOUND_B : 0);
+        batch[n].index = i;
+        n++;
+    }
+    qsort(batch, (size_t)n, sizeof(BatchQuery), batch_query_compare);
+    
+    /* Identical queries share the first one's answer, and cached answers
+     * leave the batch; the rest stay in order at the front */
+    QueryCache *cache = engine_query_cache(engine);
+    int pending = 0;
+    for (int i = 0; i < n; i++) {
+        const BatchQuery *query = &batch[i];
+        if (i > 0 && query->rel == batch[i - 1].rel && query->arg_a == batch[i - 1].arg_a &&
+            query->arg_b == batch[i - 1].arg_b) {
+            int first = batch[i - 1].index;
+            source[query->index] = source[first] >= 0 ? source[first] : first;
+            continue;
+        }
+        if (cache && querycache_lookup(cache, query->rel->name, query->arg_a, query->arg_b,
+                                       query->rel->version, &results[query->index])) {
+            continue;
+        }
+        batch[pending++] = *query;
+    }
+    
+    for (int g = 0; g < pending; ) {
+        int h = g + 1;
+        while (h < pending && batch[h].rel == batch[g].rel && batch[h].shape == batch[g].shape) h++;
+        batch_answer(&engine->facts, batch + g, h - g, results);
+        g = h;
+    }
+    
+    for (int k = 0; cache && k < pending; k++) {
+        querycache_store(cache, batch[k].rel->name, batch[k].arg_a, batch[k].arg_b,
+                         batch[k].rel->version, results[batch[k].index]);
+    }
+    for (int i = 0; i < count; i++) {
+        if (source[i] >= 0) results[i] = query_result_copy(results[source[i]]);
+    }
+    
+    free(batch);
+    free(source);
+    return ok;
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -0,0 +1,210 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * epoch.c - ByteLog Epoch Snapshots
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * A reader announces the global epoch in its slot and then loads the
+ * current snapshot; the writer swaps the snapshot, advances the epoch and
+ * then scans the slots, all with sequentially consistent atomics.  A
+ * snapshot retired at epoch E can only be held by a reader announcing an
+ * epoch below E.  A reader whose announcement the writer missed stored it
+ * after the scan, so it loads the newer snapshot instead.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "epoch.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Snapshots
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void relation_release(EpochRelation *rel) {
+    if (--rel->refs > 0) return;
+    free(rel->name);
+    frozen_free(&rel->frozen);
+    free(rel);
+}
+
+static void snapshot_release(EpochSnapshot *snapshot) {
+    for (int i = 0; i < snapshot->relation_count; i++) {
+        relation_release(snapshot->relations[i]);
+    }
+    free(snapshot->relations);
+    free(snapshot);
+}
+
+static int relation_compare(const void *left, const void *right) {
+    const EpochRelation *a = *(EpochRelation * const *)left;
+    const EpochRelation *b = *(EpochRelation * const *)right;
+    return strcmp(a->name, b->name);
+}
+
+static EpochRelation* snapshot_find(const EpochSnapshot *snapshot, const char *relation) {
+    int lo = 0;
+    int hi = snapshot->relation_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int order = strcmp(snapshot->relations[mid]->name, relation);
+        if (order == 0) return snapshot->relations[mid];
+        if (order < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+/* Freeze one of the writer's relations */
+static EpochRelation* relation_build(FactDatabase *db, const Relation *source) {
+    EpochRelation *rel = calloc(1, sizeof(EpochRelation));
+    if (!rel) return NULL;
+    rel->name = strdup(source->name);
+    rel->version = source->version;
+    rel->refs = 1;
+
+    FactPair *pairs;
+    int count = rel->name ? factdb_export(db, source->name, &pairs) : -1;
+    uint64_t *keys = count >= 0 ? malloc(((size_t)count + 1) * sizeof(uint64_t)) : NULL;
+    bool ok = keys != NULL;
+    if (ok) {
+        for (int i = 0; i < count; i++) {
+            keys[i] = parallel_pack_pair(pairs[i].arg_a, pairs[i].arg_b);
+        }
+        ok = frozen_build(&rel->frozen, keys, count);
+    }
+    if (count >= 0) free(pairs);
+    free(keys);
+
+    if (!ok) {
+        free(rel->name);
+        free(rel);
+        return NULL;
+    }
+    return rel;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Writer Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool epoch_init(EpochStore *store) {
+    memset(store, 0, sizeof(*store));
+    store->current = calloc(1, sizeof(EpochSnapshot));
+    if (!store->current) return false;
+    store->current->epoch = 1;
+    store->epoch = 1;
+    return true;
+}
+
+void epoch_free(EpochStore *store) {
+    while (store->retired) {
+        EpochSnapshot *next = store->retired->next;
+        snapshot_release(store->retired);
+        store->retired = next;
+    }
+    if (store->current) snapshot_release(store->current);
+    store->current = NULL;
+}
+
+bool epoch_publish(EpochStore *store, FactDatabase *db) {
+    if (factdb_merge(db) < 0) return false;
+
+    int total = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *rel = db->relations[i]; rel; rel = rel->next) total++;
+    }
+
+    EpochSnapshot *snapshot = calloc(1, sizeof(EpochSnapshot));
+    if (!snapshot) return false;
+    snapshot->relations = malloc(((size_t)total + 1) * sizeof(EpochRelation *));
+    if (!snapshot->relations) {
+        free(snapshot);
+        return false;
+    }
+
+    /* Share what did not change since the current snapshot */
+    EpochSnapshot *previous = store->current;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *source = db->relations[i]; source; source = source->next) {
+            EpochRelation *rel = snapshot_find(previous, source->name);
+            if (rel && rel->version == source->version) {
+                rel->refs++;
+            } else {
+                rel = relation_build(db, source);
+            }
+            if (!rel) {
+                snapshot_release(snapshot);
+                return false;
+            }
+            snapshot->relations[snapshot->relation_count++] = rel;
+            snapshot->count += rel->frozen.count;
+        }
+    }
+    qsort(snapshot->relations, (size_t)snapshot->relation_count, sizeof(EpochRelation *),
+          relation_compare);
+
+    snapshot->epoch = previous->epoch + 1;
+    __atomic_store_n(&store->current, snapshot, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&store->epoch, snapshot->epoch, __ATOMIC_SEQ_CST);
+
+    previous->retired = snapshot->epoch;
+    previous->next = store->retired;
+    store->retired = previous;
+    epoch_reclaim(store);
+    return true;
+}
+
+int epoch_reclaim(EpochStore *store) {
+    uint64_t oldest = UINT64_MAX;
+    for (int r = 0; r < EPOCH_MAX_READERS; r++) {
+        uint64_t pinned = __atomic_load_n(&store->readers[r].pinned, __ATOMIC_SEQ_CST);
+        if (pinned && pinned < oldest) oldest = pinned;
+    }
+
+    int waiting = 0;
+    EpochSnapshot **link = &store->retired;
+    while (*link) {
+        EpochSnapshot *snapshot = *link;
+        if (snapshot->retired <= oldest) {
+            *link = snapshot->next;
+            snapshot_release(snapshot);
+        } else {
+            link = &snapshot->next;
+            waiting++;
+        }
+    }
+    return waiting;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Reader Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+const EpochSnapshot* epoch_pin(EpochStore *store, int reader) {
+    uint64_t epoch = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&store->readers[reader].pinned, epoch, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+}
+
+void epoch_unpin(EpochStore *store, int reader) {
+    __atomic_store_n(&store->readers[reader].pinned, 0, __ATOMIC_SEQ_CST);
+}
+
+const FrozenRelation* epoch_relation(const EpochSnapshot *snapshot, const char *relation) {
+    const EpochRelation *rel = relation ? snapshot_find(snapshot, relation) : NULL;
+    return rel ? &rel->frozen : NULL;
+}
+
+bool epoch_contains(const EpochSnapshot *snapshot, const char *relation, int arg_a, int arg_b) {
+    const FrozenRelation *frozen = epoch_relation(snapshot, relation);
+    return frozen && frozen_contains(frozen, arg_a, arg_b);
+}
+
+QueryResult* epoch_query(const EpochSnapshot *snapshot, const char *relation, int arg_a, int arg_b) {
+    const FrozenRelation *frozen = epoch_relation(snapshot, relation);
+    return frozen ? factdb_query_frozen(frozen, arg_a, arg_b) : NULL;
+}
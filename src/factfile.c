@@ -0,0 +1,368 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factfile.c - ByteLog Delimited Fact Import
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * The mapped file is cut into one run of whole lines per worker.  A worker
+ * scans its lines with memchr and parses both fields in place.  Integers
+ * are stored as they are.  Atom names are stored as an index into a
+ * chunk-local dictionary of (pointer, length) views into the mapping.
+ * Only that dictionary goes through the shared atom table, on the calling
+ * thread, so each distinct name is interned once per chunk.  The workers
+ * then rewrite their local indexes to atom IDs.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "factfile.h"
+#include "parallel.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Chunk State
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define FIELD_ATOM_A 1u         /* arg_a holds a chunk-local name index */
+#define FIELD_ATOM_B 2u         /* arg_b holds a chunk-local name index */
+
+typedef struct ImportName {
+    const char *text;           /* Points into the mapped file */
+    int length;
+    uint32_t hash;
+} ImportName;
+
+typedef struct ImportSlot {
+    uint32_t hash;
+    int index;                  /* Name index + 1, 0 when empty */
+} ImportSlot;
+
+typedef struct ImportChunk {
+    const char *begin;          /* Whole lines [begin, end) */
+    const char *end;
+    char delimiter;
+    FactPair *pairs;
+    unsigned char *kinds;       /* FIELD_ATOM_A | FIELD_ATOM_B per pair */
+    int count;
+    int capacity;
+    ImportName *names;          /* Distinct atom names by local index */
+    int name_count;
+    int name_capacity;
+    ImportSlot *slots;          /* Open addressing over names */
+    int slot_capacity;          /* Power of two */
+    int *remap;                 /* Local index to atom ID */
+    const char *error_at;       /* Start of the first bad line, or NULL */
+    const char *error;
+} ImportChunk;
+
+static uint32_t name_hash(const char *text, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool chunk_grow_slots(ImportChunk *chunk) {
+    int capacity = chunk->slot_capacity ? chunk->slot_capacity * 2 : 1024;
+    ImportSlot *slots = calloc((size_t)capacity, sizeof(ImportSlot));
+    if (!slots) return false;
+
+    for (int k = 0; k < chunk->name_count; k++) {
+        int s = (int)(chunk->names[k].hash & (uint32_t)(capacity - 1));
+        while (slots[s].index) s = (s + 1) & (capacity - 1);
+        slots[s] = (ImportSlot){chunk->names[k].hash, k + 1};
+    }
+    free(chunk->slots);
+    chunk->slots = slots;
+    chunk->slot_capacity = capacity;
+    return true;
+}
+
+/* Local index of an atom name, added on first sight; -1 when out of memory */
+static int chunk_name(ImportChunk *chunk, const char *text, int length) {
+    if ((chunk->name_count + 1) * 2 > chunk->slot_capacity && !chunk_grow_slots(chunk)) {
+        return -1;
+    }
+
+    uint32_t hash = name_hash(text, length);
+    int mask = chunk->slot_capacity - 1;
+    int s = (int)(hash & (uint32_t)mask);
+    while (chunk->slots[s].index) {
+        /* The hash in the slot rules out most mismatches without
+         * touching the name or the file */
+        if (chunk->slots[s].hash == hash) {
+            const ImportName *name = &chunk->names[chunk->slots[s].index - 1];
+            if (name->length == length && memcmp(name->text, text, (size_t)length) == 0) {
+                return chunk->slots[s].index - 1;
+            }
+        }
+        s = (s + 1) & mask;
+    }
+
+    if (chunk->name_count == chunk->name_capacity) {
+        int capacity = chunk->name_capacity ? chunk->name_capacity * 2 : 256;
+        ImportName *names = realloc(chunk->names, (size_t)capacity * sizeof(ImportName));
+        if (!names) return -1;
+        chunk->names = names;
+        chunk->name_capacity = capacity;
+    }
+    chunk->names[chunk->name_count] = (ImportName){text, length, hash};
+    chunk->slots[s] = (ImportSlot){hash, ++chunk->name_count};
+    return chunk->name_count - 1;
+}
+
+static bool chunk_push(ImportChunk *chunk, int arg_a, int arg_b, unsigned int kinds) {
+    if (chunk->count == chunk->capacity) {
+        int capacity = chunk->capacity ? chunk->capacity * 2 : 4096;
+        FactPair *pairs = realloc(chunk->pairs, (size_t)capacity * sizeof(FactPair));
+        if (!pairs) return false;
+        chunk->pairs = pairs;
+        unsigned char *kinds_grown = realloc(chunk->kinds, (size_t)capacity);
+        if (!kinds_grown) return false;
+        chunk->kinds = kinds_grown;
+        chunk->capacity = capacity;
+    }
+    chunk->pairs[chunk->count] = (FactPair){arg_a, arg_b};
+    chunk->kinds[chunk->count] = (unsigned char)kinds;
+    chunk->count++;
+    return true;
+}
+
+static void chunk_free(ImportChunk *chunk) {
+    free(chunk->pairs);
+    free(chunk->kinds);
+    free(chunk->names);
+    free(chunk->slots);
+    free(chunk->remap);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Parsing
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static inline bool is_name_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool is_name_char(char c) {
+    return is_name_start(c) || (c >= '0' && c <= '9');
+}
+
+/* Parse one field into *value, an integer or a local name index (then
+ * *atom is set).  Returns NULL or the reason the field is invalid. */
+static const char* parse_field(ImportChunk *chunk, const char *start, const char *end,
+                               int *value, bool *atom) {
+    while (start < end && *start == ' ') start++;
+    while (end > start && end[-1] == ' ') end--;
+    if (end - start >= 2 && *start == '"' && end[-1] == '"') {
+        start++;
+        end--;
+    }
+    if (start == end) return "empty field";
+
+    const char *p = start;
+    bool negative = *p == '-';
+    if (negative) p++;
+    if (p < end && *p >= '0' && *p <= '9') {
+        long long number = 0;
+        for (; p < end; p++) {
+            if (*p < '0' || *p > '9') return "invalid integer";
+            number = number * 10 + (*p - '0');
+            if (number > (long long)INT_MAX + 1) return "integer out of range";
+        }
+        if (negative) number = -number;
+        if (number > INT_MAX) return "integer out of range";
+        *value = (int)number;
+        *atom = false;
+        return NULL;
+    }
+
+    if (!is_name_start(*start)) return "expected an integer or atom name";
+    for (p = start + 1; p < end; p++) {
+        if (!is_name_char(*p)) return "expected an integer or atom name";
+    }
+    *value = chunk_name(chunk, start, (int)(end - start));
+    *atom = true;
+    return *value < 0 ? "out of memory" : NULL;
+}
+
+static void chunk_parse(ImportChunk *chunk) {
+    const char *line = chunk->begin;
+
+    while (line < chunk->end) {
+        const char *eol = memchr(line, '\n', (size_t)(chunk->end - line));
+        if (!eol) eol = chunk->end;
+        const char *stop = eol > line && eol[-1] == '\r' ? eol - 1 : eol;
+
+        const char *first = line;
+        while (first < stop && *first == ' ') first++;
+        if (first == stop || *first == '#') {
+            line = eol + 1;
+            continue;
+        }
+
+        const char *split = memchr(line, chunk->delimiter, (size_t)(stop - line));
+        const char *reason = NULL;
+        int arg_a = 0, arg_b = 0;
+        bool atom_a = false, atom_b = false;
+        if (!split || memchr(split + 1, chunk->delimiter, (size_t)(stop - split - 1))) {
+            reason = "expected two fields";
+        } else {
+            reason = parse_field(chunk, line, split, &arg_a, &atom_a);
+            if (!reason) reason = parse_field(chunk, split + 1, stop, &arg_b, &atom_b);
+        }
+        if (!reason && !chunk_push(chunk, arg_a, arg_b,
+                                   (atom_a ? FIELD_ATOM_A : 0u) | (atom_b ? FIELD_ATOM_B : 0u))) {
+            reason = "out of memory";
+        }
+        if (reason) {
+            chunk->error_at = line;
+            chunk->error = reason;
+            return;
+        }
+        line = eol + 1;
+    }
+}
+
+static void parse_task(int index, int workers, void *context) {
+    (void)workers;
+    chunk_parse(&((ImportChunk *)context)[index]);
+}
+
+static void remap_task(int index, int workers, void *context) {
+    (void)workers;
+    ImportChunk *chunk = &((ImportChunk *)context)[index];
+    for (int i = 0; i < chunk->count; i++) {
+        unsigned char kinds = chunk->kinds[i];
+        if (kinds & FIELD_ATOM_A) chunk->pairs[i].arg_a = chunk->remap[chunk->pairs[i].arg_a];
+        if (kinds & FIELD_ATOM_B) chunk->pairs[i].arg_b = chunk->remap[chunk->pairs[i].arg_b];
+    }
+}
+
+/* Intern a chunk's distinct names, the only step touching the atom table */
+static bool chunk_intern(ImportChunk *chunk, AtomTable *atoms) {
+    chunk->remap = malloc((size_t)(chunk->name_count + 1) * sizeof(int));
+    if (!chunk->remap) return false;
+
+    char buffer[256];
+    for (int k = 0; k < chunk->name_count; k++) {
+        const ImportName *name = &chunk->names[k];
+        char *text = name->length < (int)sizeof(buffer) ? buffer : malloc((size_t)name->length + 1);
+        if (!text) return false;
+        memcpy(text, name->text, (size_t)name->length);
+        text[name->length] = '\0';
+
+        chunk->remap[k] = atom_table_intern(atoms, text);
+        if (text != buffer) free(text);
+        if (chunk->remap[k] < 0) return false;
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Import Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+long factfile_load(FactDatabase *db, AtomTable *atoms, const char *relation,
+                   const char *path, char *error, size_t error_size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+
+    size_t path_length = strlen(path);
+    char delimiter = path_length >= 4 && strcmp(path + path_length - 4, ".csv") == 0 ? ',' : '\t';
+    int workers = size >= (size_t)FACTFILE_PARALLEL_BYTES ? parallel_thread_count() : 1;
+    ImportChunk *chunks = calloc((size_t)workers, sizeof(ImportChunk));
+    if (!chunks) {
+        munmap((void *)data, size);
+        snprintf(error, error_size, "%s: out of memory", path);
+        return -1;
+    }
+
+    /* Cut after the first newline past each even share */
+    const char *end = data + size;
+    const char *begin = data;
+    for (int i = 0; i < workers; i++) {
+        const char *cut = i == workers - 1 ? end : data + size / (size_t)workers * (size_t)(i + 1);
+        if (cut < begin) cut = begin;
+        if (cut < end) {
+            const char *newline = memchr(cut, '\n', (size_t)(end - cut));
+            cut = newline ? newline + 1 : end;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = cut;
+        chunks[i].delimiter = delimiter;
+        begin = cut;
+    }
+
+    parallel_run(workers, parse_task, chunks);
+
+    long added = 0;
+    for (int i = 0; i < workers && added >= 0; i++) {
+        if (!chunks[i].error_at) continue;
+
+        long line = 1;
+        for (const char *p = data; (p = memchr(p, '\n', (size_t)(chunks[i].error_at - p))); p++) {
+            line++;
+        }
+        snprintf(error, error_size, "%s:%ld: %s", path, line, chunks[i].error);
+        added = -1;
+    }
+
+    for (int i = 0; i < workers && added >= 0; i++) {
+        if (!chunk_intern(&chunks[i], atoms)) {
+            snprintf(error, error_size, "%s: out of memory", path);
+            added = -1;
+        }
+    }
+    if (added >= 0) parallel_run(workers, remap_task, chunks);
+
+    /* The hash table has a fixed bucket count, so bulk loads go to the
+     * sorted layout unless the relation was declared otherwise.  Pending
+     * inserts are merged first, so the size difference after the final
+     * merge counts this file's new facts once each. */
+    if (added >= 0) {
+        bool ok = (factdb_get_storage(db, relation) == RELATION_STORAGE_EQUIVALENCE ||
+                   factdb_set_storage(db, relation, RELATION_STORAGE_SORTED, false)) &&
+                  factdb_merge(db) >= 0;
+        long before = factdb_relation_size(db, relation);
+        for (int i = 0; ok && i < workers; i++) {
+            ok = factdb_bulk_load(db, relation, chunks[i].pairs, chunks[i].count);
+        }
+        if (ok && factdb_merge(db) >= 0) {
+            added = factdb_relation_size(db, relation) - before;
+        } else {
+            snprintf(error, error_size, "%s: out of memory", path);
+            added = -1;
+        }
+    }
+
+    for (int i = 0; i < workers; i++) chunk_free(&chunks[i]);
+    free(chunks);
+    munmap((void *)data, size);
+    return added;
+}
@@ -0,0 +1,593 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factlog.c - ByteLog Durable Fact Log
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Log records are framed as
+ *
+ *     u32 payload length, u32 CRC-32 of the payload,
+ *     payload: u8 type, u64 sequence number, i32 x, i32 y, name bytes
+ *
+ * where an atom record carries (id, 0, atom name) and an insert or
+ * retract record (arg_a, arg_b, relation name).  Integers are little
+ * endian.  Replay stops at the first record that is short or fails its
+ * checksum, which is where a crash mid-write leaves the log, and the file
+ * is cut back to the last whole record.
+ *
+ * The snapshot holds the sequence number it covers, the atoms in ID order
+ * and each relation's pairs, followed by a CRC-32 of all of it.  It is
+ * written to a temp file, synced and renamed into place before the log
+ * is emptied, so a crash at any point leaves a snapshot plus a log whose
+ * records it already covers are skipped by sequence number.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "factlog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Encoding
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define RECORD_HEADER 8         /* Payload length and checksum */
+#define RECORD_FIXED 17         /* Type, sequence number, x and y */
+
+static const unsigned char SNAPSHOT_MAGIC[8] = {'B', 'L', 'S', 'N', 'A', 'P', '0', '1'};
+
+typedef enum {
+    RECORD_ATOM = 1,
+    RECORD_INSERT = 2,
+    RECORD_RETRACT = 3
+} RecordType;
+
+static uint32_t crc_table[256];
+static bool crc_ready = false;
+
+/* CRC-32 (IEEE), continuing from a previous result */
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t size) {
+    if (!crc_ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[i] = c;
+        }
+        crc_ready = true;
+    }
+
+    const unsigned char *bytes = data;
+    crc = ~crc;
+    while (size--) crc = crc_table[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_u64(unsigned char *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)in[i] << (8 * i);
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+/* Bounds-checked reader over a mapped file */
+typedef struct Reader {
+    const unsigned char *at;
+    const unsigned char *end;
+    bool ok;
+} Reader;
+
+static const unsigned char* reader_take(Reader *reader, size_t size) {
+    if (!reader->ok || (size_t)(reader->end - reader->at) < size) {
+        reader->ok = false;
+        return NULL;
+    }
+    const unsigned char *at = reader->at;
+    reader->at += size;
+    return at;
+}
+
+static uint32_t reader_u32(Reader *reader) {
+    const unsigned char *at = reader_take(reader, 4);
+    return at ? get_u32(at) : 0;
+}
+
+/* Length-prefixed string, copied and NUL-terminated */
+static char* reader_string(Reader *reader) {
+    uint32_t length = reader_u32(reader);
+    const unsigned char *at = reader_take(reader, length);
+    if (!at) return NULL;
+
+    char *copy = malloc((size_t)length + 1);
+    if (!copy) {
+        reader->ok = false;
+        return NULL;
+    }
+    memcpy(copy, at, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/* Map a whole file read-only; *size is 0 (and NULL returned) when empty */
+static const unsigned char* map_file(int fd, size_t *size) {
+    struct stat st;
+    *size = 0;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) return NULL;
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return data;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Applying Records
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool apply_atom(FactLog *log, ExecutionEngine *engine, int id, const char *name) {
+    if (atom_table_intern(&log->atoms, name) != id ||
+        atom_table_intern(&engine->atoms, name) != id) {
+        log->error = "Engine atoms do not match the logged atoms";
+        return false;
+    }
+    return true;
+}
+
+/* Base relations are kept sorted: hash chains hang off a fixed table and
+ * would make logging and recovery quadratic in the number of facts */
+static bool base_relation(FactLog *log, const char *relation) {
+    if (factdb_set_storage(&log->base, relation, RELATION_STORAGE_SORTED, true)) return true;
+    log->error = "Out of memory";
+    return false;
+}
+
+static bool apply_fact(FactLog *log, ExecutionEngine *engine, RecordType type,
+                       const char *relation, int arg_a, int arg_b) {
+    if (!base_relation(log, relation)) return false;
+
+    bool ok;
+    if (type == RECORD_INSERT) {
+        ok = factdb_insert(&log->base, relation, arg_a, arg_b) >= 0 &&
+             factdb_insert(&engine->facts, relation, arg_a, arg_b) >= 0;
+    } else {
+        ok = factdb_retract(&log->base, relation, arg_a, arg_b) >= 0 &&
+             factdb_retract(&engine->facts, relation, arg_a, arg_b) >= 0;
+    }
+    if (!ok) log->error = "Cannot apply a logged fact";
+    return ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Snapshot
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool snapshot_load(FactLog *log, ExecutionEngine *engine) {
+    int fd = open(log->snapshot_path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT;
+
+    size_t size;
+    const unsigned char *data = map_file(fd, &size);
+    close(fd);
+    if (!data || size < sizeof(SNAPSHOT_MAGIC) + 8 + 4 ||
+        memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        crc32_update(0, data, size - 4) != get_u32(data + size - 4)) {
+        if (data) munmap((void *)data, size);
+        log->error = "Snapshot is damaged";
+        return false;
+    }
+
+    Reader reader = {data + sizeof(SNAPSHOT_MAGIC), data + size - 4, true};
+    log->lsn = get_u64(reader_take(&reader, 8));
+
+    uint32_t atom_count = reader_u32(&reader);
+    bool ok = reader.ok;
+    for (uint32_t id = 0; ok && id < atom_count; id++) {
+        char *name = reader_string(&reader);
+        ok = name && apply_atom(log, engine, (int)id, name);
+        free(name);
+    }
+
+    /* Each relation is loaded in one piece, so the engine lays out large
+     * ones as a bulk import would */
+    uint32_t relation_count = reader_u32(&reader);
+    for (uint32_t r = 0; ok && r < relation_count && reader.ok; r++) {
+        char *relation = reader_string(&reader);
+        uint32_t count = reader_u32(&reader);
+        ok = relation != NULL && reader.ok && count <= (size_t)(reader.end - reader.at) / 8;
+
+        FactPair *pairs = ok ? malloc(((size_t)count + 1) * sizeof(FactPair)) : NULL;
+        ok = ok && pairs != NULL;
+        for (uint32_t i = 0; ok && i < count; i++) {
+            pairs[i].arg_a = (int)reader_u32(&reader);
+            pairs[i].arg_b = (int)reader_u32(&reader);
+        }
+        ok = ok && reader.ok && base_relation(log, relation) &&
+             factdb_bulk_load(&log->base, relation, pairs, (int)count) &&
+             factdb_bulk_load(&engine->facts, relation, pairs, (int)count);
+        free(pairs);
+        free(relation);
+    }
+
+    munmap((void *)data, size);
+    if (!ok || !reader.ok) {
+        if (!log->error) log->error = "Cannot load the snapshot";
+        return false;
+    }
+    return true;
+}
+
+typedef struct SnapshotWriter {
+    FILE *file;
+    uint32_t crc;
+    bool ok;
+} SnapshotWriter;
+
+static void snapshot_write(SnapshotWriter *writer, const void *data, size_t size) {
+    if (writer->ok && fwrite(data, 1, size, writer->file) != size) writer->ok = false;
+    writer->crc = crc32_update(writer->crc, data, size);
+}
+
+static void snapshot_u32(SnapshotWriter *writer, uint32_t value) {
+    unsigned char bytes[4];
+    put_u32(bytes, value);
+    snapshot_write(writer, bytes, 4);
+}
+
+static void snapshot_string(SnapshotWriter *writer, const char *text) {
+    size_t length = strlen(text);
+    snapshot_u32(writer, (uint32_t)length);
+    snapshot_write(writer, text, length);
+}
+
+/* Atom names indexed by ID */
+static const char** atom_names(const AtomTable *atoms) {
+    const char **names = calloc((size_t)atoms->next_id + 1, sizeof(char *));
+    if (!names) return NULL;
+
+    for (int id = 0; id < atoms->next_id; id++) {
+        names[id] = atom_table_name(atoms, id);
+    }
+    return names;
+}
+
+/* Names of every base relation */
+static const char** base_relations(const FactDatabase *base, int *count) {
+    *count = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *rel = base->relations[i]; rel; rel = rel->next) (*count)++;
+    }
+
+    const char **names = malloc(((size_t)*count + 1) * sizeof(char *));
+    if (!names) return NULL;
+
+    int n = 0;
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (const Relation *rel = base->relations[i]; rel; rel = rel->next) names[n++] = rel->name;
+    }
+    return names;
+}
+
+static bool snapshot_save(FactLog *log) {
+    size_t length = strlen(log->snapshot_path) + 5;
+    char *temp = malloc(length);
+    if (!temp) return false;
+    snprintf(temp, length, "%s.tmp", log->snapshot_path);
+
+    SnapshotWriter writer = {fopen(temp, "wb"), 0, true};
+    const char **atoms = atom_names(&log->atoms);
+    int relation_count = 0;
+    const char **relations = base_relations(&log->base, &relation_count);
+    writer.ok = writer.file && atoms && relations;
+
+    unsigned char lsn[8];
+    put_u64(lsn, log->lsn);
+    snapshot_write(&writer, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    snapshot_write(&writer, lsn, 8);
+
+    snapshot_u32(&writer, writer.ok ? (uint32_t)log->atoms.next_id : 0);
+    for (int id = 0; writer.ok && id < log->atoms.next_id; id++) {
+        snapshot_string(&writer, atoms[id] ? atoms[id] : "");
+    }
+
+    snapshot_u32(&writer, (uint32_t)relation_count);
+    for (int r = 0; writer.ok && r < relation_count; r++) {
+        FactPair *pairs;
+        int count = factdb_export(&log->base, relations[r], &pairs);
+        if (count < 0) {
+            writer.ok = false;
+            break;
+        }
+        snapshot_string(&writer, relations[r]);
+        snapshot_u32(&writer, (uint32_t)count);
+        for (int i = 0; i < count; i++) {
+            snapshot_u32(&writer, (uint32_t)pairs[i].arg_a);
+            snapshot_u32(&writer, (uint32_t)pairs[i].arg_b);
+        }
+        free(pairs);
+    }
+
+    unsigned char crc[4];
+    put_u32(crc, writer.crc);
+    if (writer.ok) writer.ok = fwrite(crc, 1, 4, writer.file) == 4;
+    if (writer.ok) writer.ok = fflush(writer.file) == 0 && fsync(fileno(writer.file)) == 0;
+    if (writer.file && fclose(writer.file) != 0) writer.ok = false;
+    free(atoms);
+    free(relations);
+
+    /* Publish atomically, then make the rename itself durable */
+    if (writer.ok) writer.ok = rename(temp, log->snapshot_path) == 0;
+    if (writer.ok) {
+        int dir = open(log->dir, O_RDONLY);
+        if (dir >= 0) {
+            fsync(dir);
+            close(dir);
+        }
+    } else {
+        unlink(temp);
+    }
+    free(temp);
+    return writer.ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Write-Ahead Log
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Apply the records after the snapshot and cut off a torn tail */
+static bool wal_replay(FactLog *log, ExecutionEngine *engine) {
+    size_t size;
+    const unsigned char *data = map_file(log->fd, &size);
+    size_t valid = 0;
+    bool ok = true;
+
+    while (ok && size - valid >= RECORD_HEADER) {
+        const unsigned char *record = data + valid;
+        uint32_t length = get_u32(record);
+        if (length < RECORD_FIXED || length > size - valid - RECORD_HEADER ||
+            crc32_update(0, record + RECORD_HEADER, length) != get_u32(record + 4)) {
+            break;
+        }
+
+        const unsigned char *payload = record + RECORD_HEADER;
+        RecordType type = (RecordType)payload[0];
+        uint64_t lsn = get_u64(payload + 1);
+        int x = (int)get_u32(payload + 9);
+        int y = (int)get_u32(payload + 13);
+        char *name = malloc(length - RECORD_FIXED + 1);
+        if (!name) {
+            log->error = "Out of memory";
+            ok = false;
+            break;
+        }
+        memcpy(name, payload + RECORD_FIXED, length - RECORD_FIXED);
+        name[length - RECORD_FIXED] = '\0';
+
+        /* Records up to the snapshot's sequence number are already in it */
+        if (lsn > log->lsn) {
+            ok = type == RECORD_ATOM ? apply_atom(log, engine, x, name) :
+                 type == RECORD_INSERT || type == RECORD_RETRACT ?
+                     apply_fact(log, engine, type, name, x, y) : false;
+            if (!ok && !log->error) log->error = "Unknown log record";
+            log->lsn = lsn;
+        }
+        free(name);
+        valid += RECORD_HEADER + length;
+    }
+
+    if (data) munmap((void *)data, size);
+    if (ok && valid < size) {
+        ok = ftruncate(log->fd, (off_t)valid) == 0 && fsync(log->fd) == 0;
+        if (!ok) log->error = "Cannot truncate the log";
+    }
+    log->wal_bytes = (long)valid;
+    return ok;
+}
+
+static bool wal_append(FactLog *log, RecordType type, int x, int y, const char *name) {
+    size_t name_length = strlen(name);
+    size_t length = RECORD_FIXED + name_length;
+
+    if (log->used + RECORD_HEADER + length > log->capacity) {
+        size_t capacity = log->capacity ? log->capacity : 4096;
+        while (capacity < log->used + RECORD_HEADER + length) capacity *= 2;
+        unsigned char *buffer = realloc(log->buffer, capacity);
+        if (!buffer) {
+            log->error = "Out of memory";
+            return false;
+        }
+        log->buffer = buffer;
+        log->capacity = capacity;
+    }
+
+    unsigned char *record = log->buffer + log->used;
+    unsigned char *payload = record + RECORD_HEADER;
+    payload[0] = (unsigned char)type;
+    put_u64(payload + 1, log->lsn + 1);
+    put_u32(payload + 9, (uint32_t)x);
+    put_u32(payload + 13, (uint32_t)y);
+    memcpy(payload + RECORD_FIXED, name, name_length);
+    put_u32(record, (uint32_t)length);
+    put_u32(record + 4, crc32_update(0, payload, length));
+
+    log->used += RECORD_HEADER + length;
+    log->lsn++;
+    log->pending++;
+    return true;
+}
+
+/* Log the engine atoms interned since the last record */
+static bool wal_append_atoms(FactLog *log, const ExecutionEngine *engine) {
+    int first = log->atoms.next_id;
+    if (engine->atoms.next_id <= first) return true;
+
+    const char **names = atom_names(&engine->atoms);
+    bool ok = names != NULL;
+    for (int id = first; ok && id < engine->atoms.next_id; id++) {
+        ok = names[id] && wal_append(log, RECORD_ATOM, id, 0, names[id]) &&
+             atom_table_intern(&log->atoms, names[id]) == id;
+    }
+    free(names);
+    if (!ok && !log->error) log->error = "Cannot log atoms";
+    return ok;
+}
+
+/* Write the buffered records and sync them with one fsync */
+static bool wal_flush(FactLog *log) {
+    if (log->used == 0) return true;
+
+    size_t written = 0;
+    while (written < log->used) {
+        ssize_t n = write(log->fd, log->buffer + written, log->used - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+
+    if (written < log->used || fdatasync(log->fd) != 0) {
+        /* Cut a partial group off so later commits stay replayable */
+        if (ftruncate(log->fd, (off_t)log->wal_bytes) != 0) log->error = "Log is damaged";
+        else log->error = "Cannot write the log";
+        return false;
+    }
+
+    log->wal_bytes += (long)log->used;
+    log->used = 0;
+    log->pending = 0;
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Log Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static char* path_join(const char *dir, const char *file) {
+    size_t length = strlen(dir) + strlen(file) + 2;
+    char *path = malloc(length);
+    if (path) snprintf(path, length, "%s/%s", dir, file);
+    return path;
+}
+
+static void factlog_release(FactLog *log) {
+    if (log->fd >= 0) close(log->fd);
+    log->fd = -1;
+    free(log->dir);
+    free(log->wal_path);
+    free(log->snapshot_path);
+    free(log->buffer);
+    log->dir = log->wal_path = log->snapshot_path = NULL;
+    log->buffer = NULL;
+    log->used = log->capacity = 0;
+    factdb_cleanup(&log->base);
+    atom_table_free(&log->atoms);
+}
+
+bool factlog_open(FactLog *log, const char *dir, ExecutionEngine *engine) {
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    log->group_records = FACTLOG_GROUP_RECORDS;
+    log->checkpoint_bytes = FACTLOG_CHECKPOINT_BYTES;
+    factdb_init(&log->base);
+    atom_table_init(&log->atoms);
+
+    log->dir = strdup(dir);
+    log->wal_path = path_join(dir, "facts.wal");
+    log->snapshot_path = path_join(dir, "facts.snapshot");
+    if (!log->dir || !log->wal_path || !log->snapshot_path) {
+        log->error = "Out of memory";
+    } else if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        log->error = "Cannot create the log directory";
+    } else if (snapshot_load(log, engine)) {
+        log->fd = open(log->wal_path, O_RDWR | O_CREAT | O_APPEND, 0666);
+        if (log->fd < 0) {
+            log->error = "Cannot open the log";
+        } else if (wal_replay(log, engine)) {
+            if (factdb_merge(&engine->facts) >= 0) return true;
+            log->error = "Out of memory";
+        }
+    }
+
+    factlog_release(log);
+    return false;
+}
+
+int factlog_insert(FactLog *log, ExecutionEngine *engine, const char *relation,
+                   int arg_a, int arg_b) {
+    if (!relation) return -1;
+
+    int result = factdb_insert(&engine->facts, relation, arg_a, arg_b);
+    if (result < 0 || !base_relation(log, relation)) return -1;
+
+    int logged = factdb_insert(&log->base, relation, arg_a, arg_b);
+    if (logged <= 0) return logged < 0 ? -1 : result;
+    if (!wal_append_atoms(log, engine) || !wal_append(log, RECORD_INSERT, arg_a, arg_b, relation)) {
+        /* Keep the base to what was logged */
+        factdb_retract(&log->base, relation, arg_a, arg_b);
+        return -1;
+    }
+    if (log->pending >= log->group_records && !factlog_commit(log)) return -1;
+    return result;
+}
+
+int factlog_retract(FactLog *log, ExecutionEngine *engine, const char *relation,
+                    int arg_a, int arg_b) {
+    if (!relation) return -1;
+
+    int result = factdb_retract(&engine->facts, relation, arg_a, arg_b);
+    if (result < 0) return -1;
+    if (!factdb_has_fact(&log->base, relation, arg_a, arg_b)) return result;
+
+    if (!wal_append(log, RECORD_RETRACT, arg_a, arg_b, relation) ||
+        factdb_retract(&log->base, relation, arg_a, arg_b) < 0) {
+        return -1;
+    }
+    if (log->pending >= log->group_records && !factlog_commit(log)) return -1;
+    return result;
+}
+
+bool factlog_commit(FactLog *log) {
+    if (!wal_flush(log)) return false;
+    if (log->checkpoint_bytes > 0 && log->wal_bytes >= log->checkpoint_bytes) {
+        return factlog_checkpoint(log);
+    }
+    return true;
+}
+
+bool factlog_checkpoint(FactLog *log) {
+    if (!wal_flush(log)) return false;
+    if (!snapshot_save(log)) {
+        log->error = "Cannot write the snapshot";
+        return false;
+    }
+
+    /* The snapshot covers every record; a crash before the truncate only
+     * leaves records that replay skips */
+    if (ftruncate(log->fd, 0) != 0 || fsync(log->fd) != 0) {
+        log->error = "Cannot truncate the log";
+        return false;
+    }
+    log->wal_bytes = 0;
+    return true;
+}
+
+bool factlog_close(FactLog *log) {
+    bool ok = wal_flush(log);
+    factlog_release(log);
+    return ok;
+}
@@ -0,0 +1,270 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * factset.c - ByteLog Concurrent Fact Set
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Linear probing over 64-bit slots.  A slot only ever changes once, from
+ * empty to a key or from empty to "moved", so a reader that finds a key
+ * can trust it and two threads racing for the same key meet at the same
+ * slot.  Keys 0 and 1 would collide with those sentinels and are tracked
+ * as bits instead.
+ *
+ * Growing publishes a table twice the size as the old table's successor.
+ * Every thread that notices it claims chunks of old slots, seals empty
+ * ones as moved and copies keys across; the last chunk to finish lets any
+ * thread swing the set to the new table.  An insert that races with the
+ * migration either lands before its slot is sealed, and is copied, or
+ * finds the seal and retries in the new table.  Outgrown tables stay
+ * allocated until factset_free, since late readers may still probe them.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "factset.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Slots
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define SLOT_EMPTY 0ull
+#define SLOT_MOVED 1ull
+
+#define FACTSET_MIN_CAPACITY 1024
+
+typedef enum {
+    PROBE_ADDED,                /* Key claimed a slot */
+    PROBE_PRESENT,              /* Key was already there */
+    PROBE_MOVED,                /* Table is being migrated, retry in the next */
+    PROBE_FULL                  /* No empty slot left */
+} ProbeResult;
+
+static inline uint64_t slot_load(const uint64_t *slot) {
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+/* Replace an empty slot; on failure *current holds what is there now */
+static inline bool slot_claim(uint64_t *slot, uint64_t *current, uint64_t value) {
+    return __atomic_compare_exchange_n(slot, current, value, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* splitmix64 finalizer: packed tuples differ mostly in their low bits */
+static inline size_t key_hash(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return (size_t)key;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Tables
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static FactSetTable* table_create(size_t capacity) {
+    FactSetTable *table = malloc(sizeof(FactSetTable));
+    if (!table) return NULL;
+
+    table->slots = calloc(capacity, sizeof(uint64_t));
+    if (!table->slots) {
+        free(table);
+        return NULL;
+    }
+    table->capacity = capacity;
+    table->next = NULL;
+    table->claimed = 0;
+    table->migrated = 0;
+    table->older = NULL;
+    return table;
+}
+
+static void table_free(FactSetTable *table) {
+    free(table->slots);
+    free(table);
+}
+
+static ProbeResult table_insert(FactSetTable *table, uint64_t key) {
+    size_t mask = table->capacity - 1;
+    size_t i = key_hash(key) & mask;
+
+    for (size_t probes = 0; probes < table->capacity; probes++) {
+        uint64_t current = slot_load(&table->slots[i]);
+        if (current == SLOT_EMPTY && slot_claim(&table->slots[i], &current, key)) {
+            return PROBE_ADDED;
+        }
+        if (current == key) return PROBE_PRESENT;
+        if (current == SLOT_MOVED) return PROBE_MOVED;
+        i = (i + 1) & mask;
+    }
+    return PROBE_FULL;
+}
+
+/* Seal an empty slot as moved, or copy its key into the next table */
+static void table_migrate_slot(FactSetTable *table, FactSetTable *next, size_t i) {
+    uint64_t current = SLOT_EMPTY;
+    if (slot_claim(&table->slots[i], &current, SLOT_MOVED)) return;
+
+    /* Keys are unique and the next table is twice as large, so the copy
+     * always finds a slot */
+    table_insert(next, current);
+}
+
+/* Migrate chunks until none are left, wait for the other helpers, then
+ * make the next table current */
+static void table_help_migrate(FactSet *set, FactSetTable *table) {
+    FactSetTable *next = __atomic_load_n(&table->next, __ATOMIC_ACQUIRE);
+    size_t chunks = (table->capacity + FACTSET_MIGRATE_CHUNK - 1) / FACTSET_MIGRATE_CHUNK;
+    size_t chunk;
+
+    while ((chunk = __atomic_fetch_add(&table->claimed, 1, __ATOMIC_ACQ_REL)) < chunks) {
+        size_t begin = chunk * FACTSET_MIGRATE_CHUNK;
+        size_t end = begin + FACTSET_MIGRATE_CHUNK < table->capacity ?
+                     begin + FACTSET_MIGRATE_CHUNK : table->capacity;
+        for (size_t i = begin; i < end; i++) {
+            table_migrate_slot(table, next, i);
+        }
+        __atomic_fetch_add(&table->migrated, 1, __ATOMIC_ACQ_REL);
+    }
+
+    while (__atomic_load_n(&table->migrated, __ATOMIC_ACQUIRE) < chunks) {
+        sched_yield();
+    }
+
+    FactSetTable *expected = table;
+    __atomic_compare_exchange_n(&set->table, &expected, next, false,
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* Publish a successor twice the size (unless another thread already
+ * did) and help migrate into it */
+static bool table_grow(FactSet *set, FactSetTable *table) {
+    if (!__atomic_load_n(&table->next, __ATOMIC_ACQUIRE)) {
+        FactSetTable *bigger = table_create(table->capacity * 2);
+        if (!bigger) return false;
+
+        FactSetTable *expected = NULL;
+        if (__atomic_compare_exchange_n(&table->next, &expected, bigger, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            bigger->older = __atomic_load_n(&set->tables, __ATOMIC_ACQUIRE);
+            while (!__atomic_compare_exchange_n(&set->tables, &bigger->older, bigger, false,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            }
+        } else {
+            table_free(bigger);
+        }
+    }
+
+    table_help_migrate(set, table);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Set Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool factset_init(FactSet *set, size_t expected) {
+    size_t capacity = FACTSET_MIN_CAPACITY;
+    while (capacity < expected * 2) capacity *= 2;
+
+    set->table = table_create(capacity);
+    set->tables = set->table;
+    set->count = 0;
+    set->reserved = 0;
+    return set->table != NULL;
+}
+
+void factset_free(FactSet *set) {
+    FactSetTable *table = set->tables;
+    while (table) {
+        FactSetTable *older = table->older;
+        table_free(table);
+        table = older;
+    }
+    set->table = NULL;
+    set->tables = NULL;
+    set->count = 0;
+    set->reserved = 0;
+}
+
+void factset_clear(FactSet *set) {
+    FactSetTable *table = set->table;
+    FactSetTable *older = set->tables;
+    while (older) {
+        FactSetTable *next = older->older;
+        if (older != table) table_free(older);
+        older = next;
+    }
+
+    memset(table->slots, 0, table->capacity * sizeof(uint64_t));
+    table->next = NULL;
+    table->claimed = 0;
+    table->migrated = 0;
+    table->older = NULL;
+    set->tables = table;
+    set->count = 0;
+    set->reserved = 0;
+}
+
+int factset_insert(FactSet *set, uint64_t key) {
+    if (key <= SLOT_MOVED) {
+        unsigned int bit = 1u << key;
+        if (__atomic_fetch_or(&set->reserved, bit, __ATOMIC_ACQ_REL) & bit) return 0;
+        __atomic_fetch_add(&set->count, 1, __ATOMIC_ACQ_REL);
+        return 1;
+    }
+
+    for (;;) {
+        FactSetTable *table = __atomic_load_n(&set->table, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&table->next, __ATOMIC_ACQUIRE)) {
+            table_help_migrate(set, table);
+            continue;
+        }
+
+        switch (table_insert(table, key)) {
+            case PROBE_ADDED: {
+                /* Keep the table at most half full; the key is in either way */
+                long count = __atomic_add_fetch(&set->count, 1, __ATOMIC_ACQ_REL);
+                if ((size_t)count * 2 > table->capacity) table_grow(set, table);
+                return 1;
+            }
+            case PROBE_PRESENT:
+                return 0;
+            case PROBE_MOVED:
+                table_help_migrate(set, table);
+                break;
+            case PROBE_FULL:
+                if (!table_grow(set, table)) return -1;
+                break;
+        }
+    }
+}
+
+bool factset_contains(FactSet *set, uint64_t key) {
+    if (key <= SLOT_MOVED) {
+        return (__atomic_load_n(&set->reserved, __ATOMIC_ACQUIRE) >> key) & 1u;
+    }
+
+    FactSetTable *table = __atomic_load_n(&set->table, __ATOMIC_ACQUIRE);
+    while (table) {
+        size_t mask = table->capacity - 1;
+        size_t i = key_hash(key) & mask;
+        for (size_t probes = 0; probes < table->capacity; probes++) {
+            uint64_t current = slot_load(&table->slots[i]);
+            if (current == key) return true;
+            if (current == SLOT_EMPTY) return false;
+            if (current == SLOT_MOVED) break;
+            i = (i + 1) & mask;
+        }
+
+        /* Sealed slot or a full sweep: the key can only be further on */
+        table = __atomic_load_n(&table->next, __ATOMIC_ACQUIRE);
+    }
+    return false;
+}
+
+long factset_count(FactSet *set) {
+    return __atomic_load_n(&set->count, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,294 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * frozen.c - ByteLog Frozen Relations
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * The facts are sorted once by (a, b) and once by (b, a), and each order
+ * is cut into compressed sparse rows.  The membership filter is a
+ * hash-and-displace perfect hash: facts hash into buckets of about
+ * FROZEN_BUCKET_KEYS, and buckets are placed largest first, each trying
+ * displacements until all of its facts land on free slots.  A seed that
+ * cannot place some bucket is replaced by the next one.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "frozen.h"
+#include "parallel.h"
+#include "relmem.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Displacements tried for one bucket before the seed is abandoned */
+#define FROZEN_MAX_DISPLACEMENT (1u << 20)
+
+/* Seeds tried before the build gives up */
+#define FROZEN_MAX_SEEDS 32
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Hashing
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* SplitMix64 finalizer: a bijection, so distinct facts never share a hash */
+static inline uint64_t frozen_mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* Map the hash's high half onto [0, n) without a division */
+static inline uint32_t frozen_reduce(uint64_t hash, int n) {
+    return (uint32_t)(((hash >> 32) * (uint64_t)(uint32_t)n) >> 32);
+}
+
+static inline uint16_t frozen_fingerprint(uint64_t hash) {
+    return (uint16_t)hash;
+}
+
+static inline uint32_t frozen_slot(uint64_t hash, uint32_t displacement, int slot_count) {
+    return frozen_reduce(frozen_mix(hash + displacement * 0x9e3779b97f4a7c15ULL), slot_count);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Compressed Sparse Rows
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void index_free(FrozenIndex *index) {
+    relmem_free(index->keys);
+    relmem_free(index->offsets);
+    relmem_free(index->values);
+    memset(index, 0, sizeof(*index));
+}
+
+/* Cut sorted, duplicate-free packed pairs into rows keyed by their high half */
+static bool index_build(FrozenIndex *index, const uint64_t *keys, int count) {
+    int key_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || (keys[i] >> 32) != (keys[i - 1] >> 32)) key_count++;
+    }
+
+    index->keys = relmem_alloc((size_t)key_count * sizeof(int));
+    index->offsets = relmem_alloc(((size_t)key_count + 1) * sizeof(int));
+    index->values = relmem_alloc((size_t)count * sizeof(int));
+    if (!index->keys || !index->offsets || !index->values) {
+        index_free(index);
+        return false;
+    }
+
+    int k = 0;
+    for (int i = 0; i < count; i++) {
+        int key = parallel_unpack_a(keys[i]);
+        if (k == 0 || index->keys[k - 1] != key) {
+            index->keys[k] = key;
+            index->offsets[k] = i;
+            k++;
+        }
+        index->values[i] = parallel_unpack_b(keys[i]);
+    }
+    index->offsets[key_count] = count;
+    index->key_count = key_count;
+    return true;
+}
+
+int frozen_values(const FrozenIndex *index, int key, const int **values) {
+    int lo = 0;
+    int hi = index->key_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (index->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == index->key_count || index->keys[lo] != key) return 0;
+
+    *values = index->values + index->offsets[lo];
+    return index->offsets[lo + 1] - index->offsets[lo];
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Perfect Hash
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Scratch arrays for placing buckets */
+typedef struct HashBuild {
+    uint64_t *hashes;           /* Fact -> seeded hash */
+    int *start;                 /* Bucket -> first member, bucket_count + 1 */
+    int *members;               /* Facts grouped by bucket */
+    int *order;                 /* Buckets, largest first */
+    uint32_t *slots;            /* Slots of the bucket being placed */
+    unsigned char *taken;       /* Slot -> occupied */
+} HashBuild;
+
+/* Try to place every fact with one seed */
+static bool hash_place(FrozenRelation *frozen, HashBuild *build, const uint64_t *keys,
+                       int count, uint64_t seed) {
+    int buckets = frozen->bucket_count;
+
+    memset(build->start, 0, ((size_t)buckets + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        build->hashes[i] = frozen_mix(keys[i] ^ seed);
+        build->start[frozen_reduce(build->hashes[i], buckets) + 1]++;
+    }
+
+    int largest = 0;
+    for (int b = 0; b < buckets; b++) {
+        if (build->start[b + 1] > largest) largest = build->start[b + 1];
+        build->start[b + 1] += build->start[b];
+    }
+
+    /* Group facts by bucket, using start as a cursor and shifting it back */
+    for (int i = 0; i < count; i++) {
+        build->members[build->start[frozen_reduce(build->hashes[i], buckets)]++] = i;
+    }
+    for (int b = buckets; b > 0; b--) build->start[b] = build->start[b - 1];
+    build->start[0] = 0;
+
+    /* Counting sort of the buckets by size, largest first */
+    int *by_size = calloc((size_t)largest + 2, sizeof(int));
+    if (!by_size) return false;
+    for (int b = 0; b < buckets; b++) {
+        by_size[largest - (build->start[b + 1] - build->start[b]) + 1]++;
+    }
+    for (int s = 0; s <= largest; s++) by_size[s + 1] += by_size[s];
+    for (int b = 0; b < buckets; b++) {
+        build->order[by_size[largest - (build->start[b + 1] - build->start[b])]++] = b;
+    }
+    free(by_size);
+
+    memset(build->taken, 0, (size_t)frozen->slot_count);
+    memset(frozen->fingerprints, 0, (size_t)frozen->slot_count * sizeof(uint16_t));
+    memset(frozen->displacements, 0, (size_t)buckets * sizeof(uint32_t));
+
+    for (int o = 0; o < buckets; o++) {
+        int bucket = build->order[o];
+        const int *members = build->members + build->start[bucket];
+        int size = build->start[bucket + 1] - build->start[bucket];
+        if (size == 0) break;
+
+        uint32_t displacement = 0;
+        for (;; displacement++) {
+            if (displacement == FROZEN_MAX_DISPLACEMENT) return false;
+
+            bool placed = true;
+            for (int j = 0; j < size && placed; j++) {
+                uint32_t slot = frozen_slot(build->hashes[members[j]], displacement, frozen->slot_count);
+                placed = !build->taken[slot];
+                for (int k = 0; k < j && placed; k++) placed = build->slots[k] != slot;
+                build->slots[j] = slot;
+            }
+            if (placed) break;
+        }
+
+        frozen->displacements[bucket] = displacement;
+        for (int j = 0; j < size; j++) {
+            build->taken[build->slots[j]] = 1;
+            frozen->fingerprints[build->slots[j]] = frozen_fingerprint(build->hashes[members[j]]);
+        }
+    }
+    return true;
+}
+
+static bool hash_build(FrozenRelation *frozen, const uint64_t *keys, int count) {
+    frozen->bucket_count = count / FROZEN_BUCKET_KEYS + 1;
+    frozen->slot_count = count + count / 4 + 1;
+    frozen->displacements = relmem_alloc((size_t)frozen->bucket_count * sizeof(uint32_t));
+    frozen->fingerprints = relmem_alloc((size_t)frozen->slot_count * sizeof(uint16_t));
+
+    HashBuild build;
+    build.hashes = malloc(((size_t)count + 1) * sizeof(uint64_t));
+    build.start = malloc(((size_t)frozen->bucket_count + 1) * sizeof(int));
+    build.members = malloc(((size_t)count + 1) * sizeof(int));
+    build.order = malloc((size_t)frozen->bucket_count * sizeof(int));
+    build.slots = malloc(((size_t)count + 1) * sizeof(uint32_t));
+    build.taken = malloc((size_t)frozen->slot_count);
+
+    bool ok = frozen->displacements && frozen->fingerprints && build.hashes && build.start &&
+              build.members && build.order && build.slots && build.taken;
+    bool placed = false;
+    for (int attempt = 0; ok && !placed && attempt < FROZEN_MAX_SEEDS; attempt++) {
+        frozen->seed = frozen_mix(0x6a09e667f3bcc909ULL + (uint64_t)attempt);
+        placed = hash_place(frozen, &build, keys, count, frozen->seed);
+    }
+
+    free(build.hashes);
+    free(build.start);
+    free(build.members);
+    free(build.order);
+    free(build.slots);
+    free(build.taken);
+    return ok && placed;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Frozen Relation Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool frozen_build(FrozenRelation *frozen, uint64_t *keys, int count) {
+    memset(frozen, 0, sizeof(*frozen));
+    if (!parallel_radix_sort(keys, (size_t)count)) return false;
+    count = (int)parallel_unique(keys, (size_t)count);
+    frozen->count = count;
+
+    uint64_t *reversed = malloc(((size_t)count + 1) * sizeof(uint64_t));
+    bool ok = reversed != NULL;
+    if (ok) {
+        /* Both halves carry the same bias, so swapping them packs (b, a) */
+        for (int i = 0; i < count; i++) reversed[i] = keys[i] << 32 | keys[i] >> 32;
+        ok = parallel_radix_sort(reversed, (size_t)count) &&
+             index_build(&frozen->by_a, keys, count) &&
+             index_build(&frozen->by_b, reversed, count) &&
+             hash_build(frozen, keys, count);
+    }
+    free(reversed);
+
+    if (!ok) frozen_free(frozen);
+    return ok;
+}
+
+void frozen_free(FrozenRelation *frozen) {
+    index_free(&frozen->by_a);
+    index_free(&frozen->by_b);
+    relmem_free(frozen->fingerprints);
+    relmem_free(frozen->displacements);
+    memset(frozen, 0, sizeof(*frozen));
+}
+
+bool frozen_contains(const FrozenRelation *frozen, int arg_a, int arg_b) {
+    if (frozen->count == 0) return false;
+
+    uint64_t hash = frozen_mix(parallel_pack_pair(arg_a, arg_b) ^ frozen->seed);
+    uint32_t bucket = frozen_reduce(hash, frozen->bucket_count);
+    uint32_t slot = frozen_slot(hash, frozen->displacements[bucket], frozen->slot_count);
+    if (frozen->fingerprints[slot] != frozen_fingerprint(hash)) return false;
+
+    /* Fingerprints agree: confirm in the sorted row */
+    const int *values;
+    int n = frozen_values(&frozen->by_a, arg_a, &values);
+    int lo = 0;
+    int hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (values[mid] < arg_b) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < n && values[lo] == arg_b;
+}
+
+size_t frozen_bytes(const FrozenRelation *frozen) {
+    const FrozenIndex *indexes[2] = { &frozen->by_a, &frozen->by_b };
+    size_t bytes = 0;
+    for (int i = 0; i < 2; i++) {
+        if (!indexes[i]->values) continue;
+        bytes += ((size_t)indexes[i]->key_count * 2 + 1 + (size_t)frozen->count) * sizeof(int);
+    }
+    if (frozen->fingerprints) bytes += (size_t)frozen->slot_count * sizeof(uint16_t);
+    if (frozen->displacements) bytes += (size_t)frozen->bucket_count * sizeof(uint32_t);
+    return bytes;
+}
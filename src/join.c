@@ -0,0 +1,1235 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * join.c - ByteLog Multi-way Join Evaluation
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Leapfrog triejoin (Veldhuizen) over sorted per-relation tries, plus the
+ * classic left-to-right pairwise plan it replaces for cyclic rule bodies.
+ *
+ * A binary relation is a two-level trie: a sorted, duplicate-free array of
+ * (key, val) pairs where level 0 walks the distinct keys and level 1 walks
+ * the vals of one key.  Each atom picks the column order that matches the
+ * global variable order, so every variable is bound by intersecting the
+ * sorted key lists of all atoms that mention it.
+ *
+ * Variables live in frame slots numbered in binding order, which is also
+ * the leapfrog variable order: depth d binds slot d.
+ *
+ * WHERE filters run as soon as their last variable is bound.  The pipeline
+ * evaluates them over batches of candidate tuples, narrowing a selection
+ * vector without branching on the outcome; leapfrog checks each key it
+ * binds.  Negated atoms are filters too: an anti-join that probes the
+ * relation's trie and keeps the bindings it does not find.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "join.h"
+#include "parallel.h"
+#include "relmem.h"
+#include "roaring.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Sorted Relation Tries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef struct JoinPair {
+    int key;                    /* Level 0 value */
+    int val;                    /* Level 1 value */
+} JoinPair;
+
+typedef struct JoinPosting {
+    int key;                    /* Level 0 value */
+    RoaringBitmap values;       /* Level 1 values, roaring_encode()d */
+} JoinPosting;
+
+typedef struct JoinTrie {
+    const char *relation;       /* Source relation */
+    bool swapped;               /* Keys come from column B */
+    bool diagonal;              /* Only tuples with a == b, single level */
+    JoinPair *pairs;            /* Sorted, duplicate-free */
+    int count;                  /* Number of pairs */
+    JoinPosting *postings;      /* Bitmaps for keys above the degree threshold */
+    int posting_count;          /* Number of postings */
+} JoinTrie;
+
+/* Tries of one evaluation, at most one per atom */
+typedef struct JoinTrieSet {
+    JoinTrie *tries;
+    int count;
+} JoinTrieSet;
+
+/* First index in [lo, hi) whose key (or val) is >= target, or > target if
+ * strict.  Gallops from lo so forward seeks cost O(log distance). */
+static int gallop(const JoinPair *pairs, int lo, int hi, int target, bool strict, bool on_val) {
+#define GALLOP_BEFORE(i) (on_val ? \
+        (strict ? pairs[i].val <= target : pairs[i].val < target) : \
+        (strict ? pairs[i].key <= target : pairs[i].key < target))
+
+    if (lo >= hi || !GALLOP_BEFORE(lo)) return lo;
+
+    /* Exponential probe: pairs[lo + step / 2] is known to be before target */
+    int step = 1;
+    while (lo + step < hi && GALLOP_BEFORE(lo + step)) {
+        step <<= 1;
+    }
+
+    int left = lo + step / 2 + 1;
+    int right = lo + step < hi ? lo + step : hi;
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (GALLOP_BEFORE(mid)) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return left;
+#undef GALLOP_BEFORE
+}
+
+/* Sort and deduplicate pairs so level 1 values are strictly increasing */
+static bool trie_sort(JoinTrie *trie) {
+    if (trie->count < 2) return true;
+
+    uint64_t *keys = malloc((size_t)trie->count * sizeof(uint64_t));
+    if (!keys) return false;
+
+    for (int i = 0; i < trie->count; i++) {
+        keys[i] = parallel_pack_pair(trie->pairs[i].key, trie->pairs[i].val);
+    }
+    if (!parallel_radix_sort(keys, (size_t)trie->count)) {
+        free(keys);
+        return false;
+    }
+    trie->count = (int)parallel_unique(keys, (size_t)trie->count);
+    for (int i = 0; i < trie->count; i++) {
+        trie->pairs[i].key = parallel_unpack_a(keys[i]);
+        trie->pairs[i].val = parallel_unpack_b(keys[i]);
+    }
+
+    free(keys);
+    return true;
+}
+
+/* Index level 1 lists longer than ROARING_DEGREE_THRESHOLD as bitmaps so
+ * leaf intersections can use the AND kernel.  Lists whose bitmap cannot be
+ * allocated are simply left to the leapfrog path. */
+static void trie_index_postings(JoinTrie *trie) {
+    int capacity = 0;
+
+    for (int i = 0; i < trie->count; ) {
+        int end = gallop(trie->pairs, i, trie->count, trie->pairs[i].key, true, false);
+        if (end - i > ROARING_DEGREE_THRESHOLD) {
+            if (trie->posting_count == capacity) {
+                int grown = capacity ? capacity * 2 : 4;
+                JoinPosting *postings = realloc(trie->postings, (size_t)grown * sizeof(JoinPosting));
+                if (!postings) return;
+                trie->postings = postings;
+                capacity = grown;
+            }
+
+            JoinPosting *posting = &trie->postings[trie->posting_count];
+            posting->key = trie->pairs[i].key;
+            roaring_init(&posting->values);
+
+            bool ok = true;
+            for (int j = i; j < end && ok; j++) {
+                ok = roaring_add(&posting->values, roaring_encode(trie->pairs[j].val));
+            }
+            if (ok) {
+                trie->posting_count++;
+            } else {
+                roaring_free(&posting->values);
+            }
+        }
+        i = end;
+    }
+}
+
+/* Index probe: does the trie hold (key, val), or any pair keyed key */
+static bool trie_contains(const JoinTrie *trie, int key, int val, bool any_val) {
+    int lo = gallop(trie->pairs, 0, trie->count, key, false, false);
+    if (lo >= trie->count || trie->pairs[lo].key != key) return false;
+    if (any_val) return true;
+
+    int hi = gallop(trie->pairs, lo, trie->count, key, true, false);
+    int at = gallop(trie->pairs, lo, hi, val, false, true);
+    return at < hi && trie->pairs[at].val == val;
+}
+
+static bool pair_less(const JoinPair *pair, int key, int val) {
+    return pair->key < key || (pair->key == key && pair->val < val);
+}
+
+/* Lower bounds of n (key, val) probes in pairs[0..count), searched in
+ * lockstep.  Each step prefetches the next step's loads of every probe
+ * before comparing any, so their cache misses overlap. */
+static void pair_lower_bounds(const JoinPair *pairs, int count, const int *keys,
+                              const int *vals, int n, int *at) {
+    for (int k = 0; k < n; k++) at[k] = 0;
+    if (count == 0) return;
+
+    int len = count;
+    while (len > 1) {
+        int half = len / 2;
+        for (int k = 0; k < n; k++) {
+            at[k] += pair_less(&pairs[at[k] + half], keys[k], vals[k]) ? half : 0;
+            parallel_prefetch(&pairs[at[k] + (len - half) / 2]);
+        }
+        len -= half;
+    }
+    for (int k = 0; k < n; k++) {
+        at[k] += pair_less(&pairs[at[k]], keys[k], vals[k]);
+    }
+}
+
+static const RoaringBitmap* trie_posting(const JoinTrie *trie, int key) {
+    int lo = 0, hi = trie->posting_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (trie->postings[mid].key < key) {
+            lo = mid + 1;
+        } else if (trie->postings[mid].key > key) {
+            hi = mid;
+        } else {
+            return &trie->postings[mid].values;
+        }
+    }
+    return NULL;
+}
+
+static bool trie_build(JoinTrie *trie, FactDatabase *db) {
+    FactPair *tuples;
+    int total = factdb_export(db, trie->relation, &tuples);
+
+    trie->pairs = NULL;
+    trie->count = 0;
+    trie->postings = NULL;
+    trie->posting_count = 0;
+    if (total <= 0) return total == 0;
+
+    trie->pairs = relmem_alloc((size_t)total * sizeof(JoinPair));
+    if (!trie->pairs) {
+        free(tuples);
+        return false;
+    }
+
+    for (int i = 0; i < total; i++) {
+        if (trie->diagonal && tuples[i].arg_a != tuples[i].arg_b) continue;
+        JoinPair *pair = &trie->pairs[trie->count++];
+        pair->key = trie->swapped ? tuples[i].arg_b : tuples[i].arg_a;
+        pair->val = trie->swapped ? tuples[i].arg_a : tuples[i].arg_b;
+    }
+    free(tuples);
+
+    /* Sorted relations export in (a, b) order; only swapping reorders */
+    bool presorted = !trie->swapped &&
+        factdb_get_storage(db, trie->relation) == RELATION_STORAGE_SORTED;
+    if (!presorted && !trie_sort(trie)) return false;
+
+    if (!trie->diagonal) trie_index_postings(trie);
+    return true;
+}
+
+static void trie_free(JoinTrie *trie) {
+    for (int i = 0; i < trie->posting_count; i++) {
+        roaring_free(&trie->postings[i].values);
+    }
+    free(trie->postings);
+    relmem_free(trie->pairs);
+}
+
+/* Get the trie for (relation, orientation), building it on first use */
+static JoinTrie* trie_set_get(JoinTrieSet *set, FactDatabase *db, const char *relation,
+                              bool swapped, bool diagonal) {
+    for (int i = 0; i < set->count; i++) {
+        JoinTrie *trie = &set->tries[i];
+        if (trie->swapped == swapped && trie->diagonal == diagonal &&
+            strcmp(trie->relation, relation) == 0) {
+            return trie;
+        }
+    }
+
+    JoinTrie *trie = &set->tries[set->count];
+    trie->relation = relation;
+    trie->swapped = swapped;
+    trie->diagonal = diagonal;
+    if (!trie_build(trie, db)) {
+        trie_free(trie);
+        return NULL;
+    }
+    set->count++;
+    return trie;
+}
+
+static bool trie_set_init(JoinTrieSet *set, int atom_count) {
+    set->tries = malloc((size_t)atom_count * sizeof(JoinTrie));
+    set->count = 0;
+    return set->tries != NULL;
+}
+
+/* Tries probed by a query's anti-join filters, indexed like its filters */
+static bool trie_set_get_negated(JoinTrieSet *set, FactDatabase *db, const JoinQuery *query,
+                                 const JoinTrie **filter_tries) {
+    for (int f = 0; f < query->filter_count; f++) {
+        if (!query->filters[f].relation) continue;
+        filter_tries[f] = trie_set_get(set, db, query->filters[f].relation, false, false);
+        if (!filter_tries[f]) return false;
+    }
+    return true;
+}
+
+static void trie_set_free(JoinTrieSet *set) {
+    for (int i = 0; i < set->count; i++) {
+        trie_free(&set->tries[i]);
+    }
+    free(set->tries);
+    set->tries = NULL;
+    set->count = 0;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Trie Iterators
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef struct TrieIterator {
+    const JoinTrie *trie;
+    int depth;                  /* -1 = root, 0 = keys, 1 = vals of one key */
+    int pos;                    /* Current pair index */
+    int end;                    /* Exclusive end of the current level */
+    int saved_pos;              /* Level 0 position while at level 1 */
+    int saved_end;              /* Level 0 end while at level 1 */
+} TrieIterator;
+
+static void trie_iter_init(TrieIterator *it, const JoinTrie *trie) {
+    it->trie = trie;
+    it->depth = -1;
+    it->pos = 0;
+    it->end = 0;
+    it->saved_pos = 0;
+    it->saved_end = 0;
+}
+
+static int trie_iter_key(const TrieIterator *it) {
+    const JoinPair *pair = &it->trie->pairs[it->pos];
+    return it->depth == 0 ? pair->key : pair->val;
+}
+
+static bool trie_iter_at_end(const TrieIterator *it) {
+    return it->pos >= it->end;
+}
+
+static void trie_iter_open(TrieIterator *it) {
+    if (it->depth < 0) {
+        it->depth = 0;
+        it->pos = 0;
+        it->end = it->trie->count;
+    } else {
+        int key = it->trie->pairs[it->pos].key;
+        it->saved_pos = it->pos;
+        it->saved_end = it->end;
+        it->depth = 1;
+        it->end = gallop(it->trie->pairs, it->pos, it->saved_end, key, true, false);
+    }
+}
+
+static void trie_iter_up(TrieIterator *it) {
+    if (it->depth == 1) {
+        it->pos = it->saved_pos;
+        it->end = it->saved_end;
+    }
+    it->depth--;
+}
+
+static void trie_iter_next(TrieIterator *it) {
+    if (it->depth == 0) {
+        it->pos = gallop(it->trie->pairs, it->pos, it->end, trie_iter_key(it), true, false);
+    } else {
+        it->pos++;
+    }
+}
+
+static void trie_iter_seek(TrieIterator *it, int target) {
+    it->pos = gallop(it->trie->pairs, it->pos, it->end, target, false, it->depth == 1);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Query Compilation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool join_rule_needs_query(const ASTNode *rule) {
+    if (!rule || rule->type != AST_RULE) return false;
+
+    for (const ASTNode *op = rule->data.rule.body; op; op = op->next) {
+        if ((op->type == AST_JOIN && op->data.join.has_bind) ||
+            op->type == AST_WHERE || op->type == AST_NOT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool compile_error(char *error_buf, size_t error_buf_size, const ASTNode *node,
+                          const char *message, int var) {
+    if (error_buf && error_buf_size > 0) {
+        if (var >= 0) {
+            snprintf(error_buf, error_buf_size, "Line %d:%d: %s: $%d",
+                     node->line, node->column, message, var);
+        } else {
+            snprintf(error_buf, error_buf_size, "Line %d:%d: %s",
+                     node->line, node->column, message);
+        }
+    }
+    return false;
+}
+
+/* Slot of a bound variable, or -1 */
+static int query_slot(const JoinQuery *query, int var) {
+    for (int slot = 0; slot < query->var_count; slot++) {
+        if (query->vars[slot] == var) return slot;
+    }
+    return -1;
+}
+
+/* Give a variable the next slot, returns it or -1 when out of memory */
+static int query_bind(JoinQuery *query, int var) {
+    if (query->var_count == query->var_capacity) {
+        int capacity = query->var_capacity ? query->var_capacity * 2 : 8;
+        int *vars = realloc(query->vars, (size_t)capacity * sizeof(int));
+        if (!vars) return -1;
+        query->vars = vars;
+        query->var_capacity = capacity;
+    }
+    query->vars[query->var_count] = var;
+    return query->var_count++;
+}
+
+static JoinAtom* query_add_atom(JoinQuery *query, const char *relation) {
+    if (query->atom_count == query->atom_capacity) {
+        int capacity = query->atom_capacity ? query->atom_capacity * 2 : 4;
+        JoinAtom *atoms = realloc(query->atoms, (size_t)capacity * sizeof(JoinAtom));
+        if (!atoms) return NULL;
+        query->atoms = atoms;
+        query->atom_capacity = capacity;
+    }
+    JoinAtom *atom = &query->atoms[query->atom_count++];
+    atom->relation = relation;
+    atom->closes = false;
+    return atom;
+}
+
+/* Atom whose step binds a slot: the SCAN binds slots 0 and 1, every JOIN
+ * that does not close a cycle binds one more */
+static int query_binding_atom(const JoinQuery *query, int slot) {
+    for (int i = 1; i < query->atom_count; i++) {
+        if (!query->atoms[i].closes && query->atoms[i].slot_b == slot) return i;
+    }
+    return 0;
+}
+
+/* Resolve a WHERE operand to a slot, or to a constant with *slot = -1 */
+static bool filter_operand(const JoinQuery *query, const ASTNode *expr, AtomTable *atoms,
+                           int *slot, int *value, char *error_buf, size_t error_buf_size) {
+    *slot = -1;
+    *value = 0;
+
+    switch (expr->type) {
+        case AST_EXPR_VAR:
+            *slot = query_slot(query, expr->data.expr.var_num);
+            if (*slot < 0) {
+                return compile_error(error_buf, error_buf_size, expr,
+                                     "unbound where variable", expr->data.expr.var_num);
+            }
+            return true;
+        case AST_EXPR_INT:
+            *value = expr->data.expr.int_val;
+            return true;
+        case AST_EXPR_STRING:
+            *value = atom_table_intern(atoms, expr->data.expr.string_val);
+            if (*value < 0) {
+                return compile_error(error_buf, error_buf_size, expr, "Out of memory", -1);
+            }
+            return true;
+        default:
+            return compile_error(error_buf, error_buf_size, expr,
+                                 "Unsupported WHERE operand", -1);
+    }
+}
+
+static unsigned int filter_mask(OpType op) {
+    switch (op) {
+        case OP_LT: return JOIN_FILTER_LT;
+        case OP_LE: return JOIN_FILTER_LT | JOIN_FILTER_EQ;
+        case OP_GT: return JOIN_FILTER_GT;
+        case OP_GE: return JOIN_FILTER_GT | JOIN_FILTER_EQ;
+        case OP_EQ: return JOIN_FILTER_EQ;
+        case OP_NE: return JOIN_FILTER_LT | JOIN_FILTER_GT;
+        default: return 0;
+    }
+}
+
+/* Mask bit of the outcome of comparing a with b, selected without a branch */
+static inline unsigned int filter_pass(unsigned int mask, int a, int b) {
+    return (mask >> ((a > b) - (a < b) + 1)) & 1u;
+}
+
+/* Insert a filter, keeping the list ordered by slot */
+static bool query_add_filter(JoinQuery *query, const JoinFilter *filter) {
+    if (query->filter_count == query->filter_capacity) {
+        int capacity = query->filter_capacity ? query->filter_capacity * 2 : 4;
+        JoinFilter *filters = realloc(query->filters, (size_t)capacity * sizeof(JoinFilter));
+        if (!filters) return false;
+        query->filters = filters;
+        query->filter_capacity = capacity;
+    }
+
+    int at = query->filter_count++;
+    while (at > 0 && query->filters[at - 1].slot > filter->slot) {
+        query->filters[at] = query->filters[at - 1];
+        at--;
+    }
+    query->filters[at] = *filter;
+    return true;
+}
+
+/* WHERE a op b: pushed down to the step that binds the later of its slots.
+ * A constant on the left is mirrored to the right; a comparison of two
+ * constants is folded, and one that never holds becomes an empty mask. */
+static bool query_compile_where(JoinQuery *query, const ASTNode *where, AtomTable *atoms,
+                                char *error_buf, size_t error_buf_size) {
+    const ASTNode *condition = where->data.where.condition;
+    if (!condition || condition->type != AST_CONDITION ||
+        !condition->data.condition.left || !condition->data.condition.right) {
+        return compile_error(error_buf, error_buf_size, where, "Malformed WHERE condition", -1);
+    }
+
+    JoinFilter filter;
+    int left_slot, left_value, right_slot, right_value;
+    filter.relation = NULL;
+    if (!filter_operand(query, condition->data.condition.left, atoms, &left_slot, &left_value,
+                        error_buf, error_buf_size) ||
+        !filter_operand(query, condition->data.condition.right, atoms, &right_slot, &right_value,
+                        error_buf, error_buf_size)) {
+        return false;
+    }
+    filter.mask = filter_mask(condition->data.condition.op);
+
+    if (left_slot < 0 && right_slot < 0) {
+        if (filter_pass(filter.mask, left_value, right_value)) return true;
+        filter.slot_a = 0;
+        filter.slot_b = 0;
+        filter.value = 0;
+        filter.mask = 0;
+    } else if (left_slot < 0) {
+        filter.slot_a = right_slot;
+        filter.slot_b = -1;
+        filter.value = left_value;
+        filter.mask = (filter.mask & JOIN_FILTER_EQ) |
+                      ((filter.mask & JOIN_FILTER_LT) << 2) |
+                      ((filter.mask & JOIN_FILTER_GT) >> 2);
+    } else {
+        filter.slot_a = left_slot;
+        filter.slot_b = right_slot;
+        filter.value = right_value;
+    }
+
+    filter.slot = filter.slot_a > filter.slot_b ? filter.slot_a : filter.slot_b;
+    filter.atom = query_binding_atom(query, filter.slot);
+    if (!query_add_filter(query, &filter)) {
+        return compile_error(error_buf, error_buf_size, where, "Out of memory", -1);
+    }
+    return true;
+}
+
+/* NOT SCAN rel excludes the scanned tuple ($0, $1); NOT JOIN rel $N [$M]
+ * excludes bindings where rel has a tuple keyed $N (valued $M).  Negation
+ * binds nothing, so its variables must be bound by the rest of the body. */
+static bool query_compile_not(JoinQuery *query, const ASTNode *negation,
+                              char *error_buf, size_t error_buf_size) {
+    const ASTNode *op = negation->data.negation.operation;
+    JoinFilter filter;
+    filter.value = 0;
+    filter.mask = 0;
+
+    if (op && op->type == AST_SCAN) {
+        if (op->data.scan.has_match) {
+            return compile_error(error_buf, error_buf_size, op, "NOT SCAN takes no MATCH", -1);
+        }
+        filter.relation = op->data.scan.relation;
+        filter.slot_a = query_slot(query, 0);
+        filter.slot_b = query_slot(query, 1);
+    } else if (op && op->type == AST_JOIN) {
+        filter.relation = op->data.join.relation;
+        filter.slot_a = query_slot(query, op->data.join.match_var);
+        if (filter.slot_a < 0) {
+            return compile_error(error_buf, error_buf_size, op,
+                                 "unbound negated variable", op->data.join.match_var);
+        }
+        filter.slot_b = -1;
+        if (op->data.join.has_bind) {
+            filter.slot_b = query_slot(query, op->data.join.bind_var);
+            if (filter.slot_b < 0) {
+                return compile_error(error_buf, error_buf_size, op,
+                                     "unbound negated variable", op->data.join.bind_var);
+            }
+        }
+    } else {
+        return compile_error(error_buf, error_buf_size, negation,
+                             "NOT must negate a SCAN or JOIN", -1);
+    }
+
+    filter.slot = filter.slot_a > filter.slot_b ? filter.slot_a : filter.slot_b;
+    filter.atom = query_binding_atom(query, filter.slot);
+    if (!query_add_filter(query, &filter)) {
+        return compile_error(error_buf, error_buf_size, negation, "Out of memory", -1);
+    }
+    return true;
+}
+
+static bool query_compile(JoinQuery *query, const ASTNode *rule, AtomTable *atoms,
+                          char *error_buf, size_t error_buf_size) {
+    const ASTNode *body = rule->data.rule.body;
+    const ASTNode *emit = rule->data.rule.emit;
+    if (!body || body->type != AST_SCAN || !emit || emit->type != AST_EMIT) {
+        return compile_error(error_buf, error_buf_size, rule,
+                             "Rule body must start with SCAN and end with EMIT", -1);
+    }
+
+    int next_var = 2;
+
+    /* SCAN rel binds $0 (column A) and $1 (column B) */
+    if (body->data.scan.has_match) {
+        return compile_error(error_buf, error_buf_size, body,
+                             "unbound match variable", body->data.scan.match_var);
+    }
+    JoinAtom *scan = query_add_atom(query, body->data.scan.relation);
+    if (!scan || (scan->slot_a = query_bind(query, 0)) < 0 ||
+        (scan->slot_b = query_bind(query, 1)) < 0) {
+        return compile_error(error_buf, error_buf_size, body, "Out of memory", -1);
+    }
+
+    /* JOIN rel $N [$M] requires $N, binds column B to $M or the next variable */
+    for (const ASTNode *op = body->next; op; op = op->next) {
+        if (op->type == AST_WHERE || op->type == AST_NOT) continue;
+        if (op->type != AST_JOIN) {
+            return compile_error(error_buf, error_buf_size, op,
+                                 "Only the first body operation may be a SCAN", -1);
+        }
+
+        int match = op->data.join.match_var;
+        int bind = op->data.join.has_bind ? op->data.join.bind_var : next_var;
+        int match_slot = query_slot(query, match);
+        if (match_slot < 0) {
+            return compile_error(error_buf, error_buf_size, op, "unbound join variable", match);
+        }
+        if (bind < 0) {
+            return compile_error(error_buf, error_buf_size, op, "variable out of range", bind);
+        }
+
+        JoinAtom *atom = query_add_atom(query, op->data.join.relation);
+        if (!atom) return compile_error(error_buf, error_buf_size, op, "Out of memory", -1);
+        atom->slot_a = match_slot;
+        atom->slot_b = query_slot(query, bind);
+        atom->closes = atom->slot_b >= 0;
+
+        if (atom->closes) {
+            query->cyclic = true;
+        } else {
+            atom->slot_b = query_bind(query, bind);
+            if (atom->slot_b < 0) {
+                return compile_error(error_buf, error_buf_size, op, "Out of memory", -1);
+            }
+            if (bind >= next_var) next_var = bind + 1;
+        }
+    }
+
+    /* Filters may read variables bound after them in the body */
+    for (const ASTNode *op = body->next; op; op = op->next) {
+        if (op->type == AST_WHERE &&
+            !query_compile_where(query, op, atoms, error_buf, error_buf_size)) {
+            return false;
+        }
+        if (op->type == AST_NOT &&
+            !query_compile_not(query, op, error_buf, error_buf_size)) {
+            return false;
+        }
+    }
+
+    int emit_vars[2] = {emit->data.emit.var_a, emit->data.emit.var_b};
+    int emit_slots[2];
+    for (int i = 0; i < 2; i++) {
+        emit_slots[i] = query_slot(query, emit_vars[i]);
+        if (emit_slots[i] < 0) {
+            return compile_error(error_buf, error_buf_size, emit,
+                                 "unbound emit variable", emit_vars[i]);
+        }
+    }
+    query->emit_relation = emit->data.emit.relation;
+    query->emit_a = emit_slots[0];
+    query->emit_b = emit_slots[1];
+
+    return true;
+}
+
+bool join_query_compile(JoinQuery *query, const ASTNode *rule, AtomTable *atoms,
+                        char *error_buf, size_t error_buf_size) {
+    memset(query, 0, sizeof(*query));
+    if (query_compile(query, rule, atoms, error_buf, error_buf_size)) return true;
+
+    join_query_free(query);
+    return false;
+}
+
+void join_query_free(JoinQuery *query) {
+    free(query->atoms);
+    free(query->vars);
+    free(query->filters);
+    query->atoms = NULL;
+    query->vars = NULL;
+    query->filters = NULL;
+    query->atom_count = 0;
+    query->atom_capacity = 0;
+    query->var_count = 0;
+    query->var_capacity = 0;
+    query->filter_count = 0;
+    query->filter_capacity = 0;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Leapfrog Triejoin
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Per-depth lists are atom_count entries apart: depth d's participants
+ * start at participants[d * atom_count] */
+typedef struct LeapfrogState {
+    const JoinQuery *query;
+    TrieIterator *iters;                /* One per atom */
+    int *participants;                  /* Atoms mentioning each depth's slot */
+    int *participant_count;             /* Per depth */
+    TrieIterator **scratch;             /* Per-depth iterator lists */
+    const RoaringBitmap **bitmaps;      /* Per-depth posting lists */
+    int *filter_start;                  /* First filter of each depth, var_count + 1 */
+    const JoinTrie **filter_tries;      /* Trie of each anti-join filter */
+    int *frame;                         /* One value per slot */
+    JoinEmitFn emit;
+    void *context;
+    JoinStats *stats;
+} LeapfrogState;
+
+/* Filters are ordered by slot, and so by binding atom: the filters of step
+ * s (a depth, or an atom when by_atom) are start[s] up to start[s + 1] */
+static void filter_ranges(const JoinQuery *query, int *start, int steps, bool by_atom) {
+    int f = 0;
+    for (int s = 0; s <= steps; s++) {
+        while (f < query->filter_count &&
+               (by_atom ? query->filters[f].atom : query->filters[f].slot) < s) {
+            f++;
+        }
+        start[s] = f;
+    }
+}
+
+static bool leapfrog_state_init(LeapfrogState *state, const JoinQuery *query) {
+    size_t lists = (size_t)query->var_count * (size_t)query->atom_count;
+
+    state->query = query;
+    state->iters = malloc((size_t)query->atom_count * sizeof(TrieIterator));
+    state->participants = malloc(lists * sizeof(int));
+    state->participant_count = calloc((size_t)query->var_count, sizeof(int));
+    state->scratch = malloc(lists * sizeof(TrieIterator *));
+    state->bitmaps = malloc(lists * sizeof(RoaringBitmap *));
+    state->filter_start = malloc((size_t)(query->var_count + 1) * sizeof(int));
+    state->filter_tries = calloc((size_t)query->filter_count + 1, sizeof(JoinTrie *));
+    state->frame = malloc((size_t)query->var_count * sizeof(int));
+    if (state->filter_start) {
+        filter_ranges(query, state->filter_start, query->var_count, false);
+    }
+    return state->iters && state->participants && state->participant_count &&
+           state->scratch && state->bitmaps && state->filter_start &&
+           state->filter_tries && state->frame;
+}
+
+static void leapfrog_state_free(LeapfrogState *state) {
+    free(state->iters);
+    free(state->participants);
+    free(state->participant_count);
+    free(state->scratch);
+    free(state->bitmaps);
+    free(state->filter_start);
+    free(state->filter_tries);
+    free(state->frame);
+}
+
+/* Check the filters pushed down to a depth once its key is in the frame */
+static bool leapfrog_filters_pass(const LeapfrogState *state, int depth) {
+    const JoinQuery *query = state->query;
+    const int *frame = state->frame;
+    unsigned int pass = 1;
+
+    for (int f = state->filter_start[depth]; f < state->filter_start[depth + 1]; f++) {
+        const JoinFilter *filter = &query->filters[f];
+        int b = filter->slot_b < 0 ? filter->value : frame[filter->slot_b];
+        if (filter->relation) {
+            pass &= !trie_contains(state->filter_tries[f], frame[filter->slot_a], b,
+                                   filter->slot_b < 0);
+        } else {
+            pass &= filter_pass(filter->mask, frame[filter->slot_a], b);
+        }
+    }
+    return pass != 0;
+}
+
+static bool leapfrog_depth(LeapfrogState *state, int depth);
+
+/* Leaf variable where at least two participants have bitmap postings:
+ * intersect them with the AND kernel and check any remaining participants
+ * by seeking their sorted lists.  Returns false when it does not apply. */
+static bool leapfrog_bitmap_depth(LeapfrogState *state, int depth, bool *ok) {
+    const JoinQuery *query = state->query;
+    int k = state->participant_count[depth];
+    const int *participants = &state->participants[depth * query->atom_count];
+    const RoaringBitmap **bitmaps = &state->bitmaps[depth * query->atom_count];
+    TrieIterator **others = &state->scratch[depth * query->atom_count];
+    int bitmap_count = 0;
+    int other_count = 0;
+
+    for (int i = 0; i < k; i++) {
+        TrieIterator *it = &state->iters[participants[i]];
+        if (it->depth != 0) return false;
+
+        const RoaringBitmap *values = trie_posting(it->trie, trie_iter_key(it));
+        if (values) {
+            bitmaps[bitmap_count++] = values;
+        } else {
+            others[other_count++] = it;
+        }
+    }
+    if (bitmap_count < 2) return false;
+
+    RoaringBitmap result;
+    if (!roaring_and(bitmaps[0], bitmaps[1], &result)) {
+        *ok = false;
+        return true;
+    }
+    for (int i = 2; i < bitmap_count; i++) {
+        RoaringBitmap narrowed;
+        bool and_ok = roaring_and(&result, bitmaps[i], &narrowed);
+        roaring_free(&result);
+        if (!and_ok) {
+            *ok = false;
+            return true;
+        }
+        result = narrowed;
+    }
+
+    for (int i = 0; i < other_count; i++) {
+        trie_iter_open(others[i]);
+    }
+
+    RoaringIterator values;
+    uint32_t value;
+    bool exhausted = false;
+
+    *ok = true;
+    roaring_iterator_init(&values, &result);
+    while (*ok && !exhausted && roaring_iterator_next(&values, &value)) {
+        int key = roaring_decode(value);
+        bool matched = true;
+        for (int i = 0; i < other_count && matched; i++) {
+            trie_iter_seek(others[i], key);
+            exhausted = trie_iter_at_end(others[i]);
+            matched = !exhausted && trie_iter_key(others[i]) == key;
+        }
+        if (!matched) continue;
+
+        state->frame[depth] = key;
+        if (!leapfrog_filters_pass(state, depth)) continue;
+        if (depth < query->var_count - 1) {
+            state->stats->intermediate++;
+        }
+        *ok = leapfrog_depth(state, depth + 1);
+    }
+
+    for (int i = 0; i < other_count; i++) {
+        trie_iter_up(others[i]);
+    }
+    roaring_free(&result);
+    return true;
+}
+
+static bool leapfrog_depth(LeapfrogState *state, int depth) {
+    const JoinQuery *query = state->query;
+    if (depth == query->var_count) {
+        state->stats->results++;
+        return state->emit(state->frame, state->context);
+    }
+
+    bool bitmap_ok;
+    if (leapfrog_bitmap_depth(state, depth, &bitmap_ok)) {
+        return bitmap_ok;
+    }
+
+    int k = state->participant_count[depth];
+    const int *participants = &state->participants[depth * query->atom_count];
+    TrieIterator **iters = &state->scratch[depth * query->atom_count];
+    bool exhausted = false;
+
+    for (int i = 0; i < k; i++) {
+        iters[i] = &state->iters[participants[i]];
+        trie_iter_open(iters[i]);
+        if (trie_iter_at_end(iters[i])) exhausted = true;
+    }
+
+    bool ok = true;
+    if (!exhausted) {
+        /* Order iterators by current key (k is tiny, insertion sort) */
+        for (int i = 1; i < k; i++) {
+            TrieIterator *it = iters[i];
+            int j = i - 1;
+            while (j >= 0 && trie_iter_key(iters[j]) > trie_iter_key(it)) {
+                iters[j + 1] = iters[j];
+                j--;
+            }
+            iters[j + 1] = it;
+        }
+
+        int p = 0;
+        while (ok) {
+            int max_key = trie_iter_key(iters[(p + k - 1) % k]);
+            int key = trie_iter_key(iters[p]);
+
+            if (key == max_key) {
+                state->frame[depth] = key;
+                if (leapfrog_filters_pass(state, depth)) {
+                    if (depth < query->var_count - 1) {
+                        state->stats->intermediate++;
+                    }
+                    ok = leapfrog_depth(state, depth + 1);
+                }
+                trie_iter_next(iters[p]);
+            } else {
+                trie_iter_seek(iters[p], max_key);
+            }
+
+            if (trie_iter_at_end(iters[p])) break;
+            p = (p + 1) % k;
+        }
+    }
+
+    for (int i = 0; i < k; i++) {
+        trie_iter_up(iters[i]);
+    }
+    return ok;
+}
+
+static bool run_leapfrog(const JoinQuery *query, FactDatabase *db, JoinEmitFn emit,
+                         void *context, JoinStats *stats) {
+    LeapfrogState state;
+    JoinTrieSet tries = {NULL, 0};
+
+    bool ok = leapfrog_state_init(&state, query) &&
+              trie_set_init(&tries, query->atom_count + query->filter_count);
+    state.emit = emit;
+    state.context = context;
+    state.stats = stats;
+
+    for (int i = 0; i < query->atom_count && ok; i++) {
+        const JoinAtom *atom = &query->atoms[i];
+        bool diagonal = atom->slot_a == atom->slot_b;
+        bool swapped = !diagonal && atom->slot_b < atom->slot_a;
+
+        JoinTrie *trie = trie_set_get(&tries, db, atom->relation, swapped, diagonal);
+        if (!trie) {
+            ok = false;
+            break;
+        }
+        trie_iter_init(&state.iters[i], trie);
+
+        /* Level 0 participates in the earlier slot, level 1 in the later */
+        int d0 = swapped ? atom->slot_b : atom->slot_a;
+        int d1 = swapped ? atom->slot_a : atom->slot_b;
+        state.participants[d0 * query->atom_count + state.participant_count[d0]++] = i;
+        if (!diagonal) {
+            state.participants[d1 * query->atom_count + state.participant_count[d1]++] = i;
+        }
+    }
+
+    if (ok) {
+        ok = trie_set_get_negated(&tries, db, query, state.filter_tries) &&
+             leapfrog_depth(&state, 0);
+    }
+
+    trie_set_free(&tries);
+    leapfrog_state_free(&state);
+    return ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Pipelined Left-to-Right Joins
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Index nested loops over the atoms in body order.  Each binding flows
+ * depth-first through the remaining atoms in one frame, so no intermediate
+ * results are materialized. */
+typedef struct PipelineState {
+    const JoinQuery *query;
+    JoinTrie **tries;           /* One per atom, keyed by column A */
+    int *filter_start;          /* First filter of each atom, atom_count + 1 */
+    const JoinTrie **filter_tries; /* Trie of each anti-join filter */
+    int scan_lo;                /* SCAN atom pairs [scan_lo, scan_hi) */
+    int scan_hi;
+    int *frame;                 /* One value per slot */
+    JoinEmitFn emit;
+    void *context;
+    JoinStats *stats;
+} PipelineState;
+
+/* Candidate tuples filtered per batch */
+#define JOIN_FILTER_BATCH 256
+
+/* Values a filter operand takes across a batch: the atom's own columns
+ * advance with the candidate, earlier slots and constants stay put */
+static const int* batch_operand(const PipelineState *state, const JoinAtom *atom, int i,
+                                int slot, const int *keys, const int *vals, int *stride) {
+    *stride = 1;
+    if (slot == atom->slot_b) return vals;
+    if (i == 0 && slot == atom->slot_a) return keys;
+    *stride = 0;
+    return &state->frame[slot];
+}
+
+/* Narrow the selection vector sel[0..n) to candidates passing a filter.
+ * Every candidate is written and the count advances by the predicate, so
+ * the loop has no data-dependent branch. */
+static int batch_filter(const JoinFilter *filter, const int *a, int stride_a,
+                        const int *b, int stride_b, int *sel, int n) {
+    int kept = 0;
+    for (int k = 0; k < n; k++) {
+        int j = sel[k];
+        sel[kept] = j;
+        kept += (int)filter_pass(filter->mask, a[j * stride_a], b[j * stride_b]);
+    }
+    return kept;
+}
+
+/* Anti-join over a batch: keep the candidates whose (a, b) tuple, or any
+ * tuple keyed a, is absent from the trie.  Probes go out in groups whose
+ * searches run in lockstep. */
+static int batch_anti_join(const JoinTrie *trie, const int *a, int stride_a,
+                           const int *b, int stride_b, bool any_val, int *sel, int n) {
+    int kept = 0;
+    for (int base = 0; base < n; base += PARALLEL_PROBE_GROUP) {
+        int g = n - base < PARALLEL_PROBE_GROUP ? n - base : PARALLEL_PROBE_GROUP;
+        int rows[PARALLEL_PROBE_GROUP], keys[PARALLEL_PROBE_GROUP];
+        int vals[PARALLEL_PROBE_GROUP], at[PARALLEL_PROBE_GROUP];
+
+        for (int k = 0; k < g; k++) {
+            rows[k] = sel[base + k];
+            keys[k] = a[rows[k] * stride_a];
+            vals[k] = any_val ? INT_MIN : b[rows[k] * stride_b];
+        }
+        pair_lower_bounds(trie->pairs, trie->count, keys, vals, g, at);
+
+        for (int k = 0; k < g; k++) {
+            bool found = at[k] < trie->count && trie->pairs[at[k]].key == keys[k] &&
+                         (any_val || trie->pairs[at[k]].val == vals[k]);
+            sel[kept] = rows[k];
+            kept += !found;
+        }
+    }
+    return kept;
+}
+
+static bool pipeline_atom(PipelineState *state, int i);
+
+/* Pairs [lo, hi) of atom i that pass its filters, a batch at a time */
+static bool pipeline_filtered(PipelineState *state, int i, int lo, int hi) {
+    const JoinQuery *query = state->query;
+    const JoinAtom *atom = &query->atoms[i];
+    const JoinPair *pairs = state->tries[i]->pairs;
+    int first = state->filter_start[i];
+    int last = state->filter_start[i + 1];
+    int keys[JOIN_FILTER_BATCH], vals[JOIN_FILTER_BATCH], sel[JOIN_FILTER_BATCH];
+    bool ok = true;
+
+    for (int base = lo; ok && base < hi; base += JOIN_FILTER_BATCH) {
+        int n = hi - base < JOIN_FILTER_BATCH ? hi - base : JOIN_FILTER_BATCH;
+        for (int k = 0; k < n; k++) {
+            keys[k] = pairs[base + k].key;
+            vals[k] = pairs[base + k].val;
+            sel[k] = k;
+        }
+
+        for (int f = first; f < last && n > 0; f++) {
+            const JoinFilter *filter = &query->filters[f];
+            int stride_a, stride_b = 0;
+            const int *a = batch_operand(state, atom, i, filter->slot_a, keys, vals, &stride_a);
+            const int *b = filter->slot_b < 0 ? &filter->value :
+                batch_operand(state, atom, i, filter->slot_b, keys, vals, &stride_b);
+            if (filter->relation) {
+                n = batch_anti_join(state->filter_tries[f], a, stride_a, b, stride_b,
+                                    filter->slot_b < 0, sel, n);
+            } else {
+                n = batch_filter(filter, a, stride_a, b, stride_b, sel, n);
+            }
+        }
+
+        for (int k = 0; ok && k < n; k++) {
+            if (i == 0) state->frame[atom->slot_a] = keys[sel[k]];
+            state->frame[atom->slot_b] = vals[sel[k]];
+            if (i < query->atom_count - 1) {
+                state->stats->intermediate++;
+            }
+            ok = pipeline_atom(state, i + 1);
+        }
+    }
+    return ok;
+}
+
+static bool pipeline_atom(PipelineState *state, int i) {
+    const JoinQuery *query = state->query;
+    if (i == query->atom_count) {
+        state->stats->results++;
+        return state->emit(state->frame, state->context);
+    }
+
+    const JoinAtom *atom = &query->atoms[i];
+    const JoinTrie *trie = state->tries[i];
+    int *frame = state->frame;
+    int lo = state->scan_lo, hi = state->scan_hi;
+
+    /* The SCAN atom walks its share of pairs, JOIN atoms the run of their key */
+    if (i > 0) {
+        int key = frame[atom->slot_a];
+        lo = gallop(trie->pairs, 0, trie->count, key, false, false);
+        hi = gallop(trie->pairs, lo, trie->count, key, true, false);
+    }
+
+    if (atom->closes) {
+        /* Both columns bound: membership check */
+        int at = gallop(trie->pairs, lo, hi, frame[atom->slot_b], false, true);
+        if (at >= hi || trie->pairs[at].val != frame[atom->slot_b]) return true;
+        lo = at;
+        hi = at + 1;
+    }
+
+    if (state->filter_start[i] < state->filter_start[i + 1]) {
+        return pipeline_filtered(state, i, lo, hi);
+    }
+
+    bool ok = true;
+    for (int j = lo; ok && j < hi; j++) {
+        if (i == 0) frame[atom->slot_a] = trie->pairs[j].key;
+        frame[atom->slot_b] = trie->pairs[j].val;
+        if (i < query->atom_count - 1) {
+            state->stats->intermediate++;
+        }
+        ok = pipeline_atom(state, i + 1);
+    }
+    return ok;
+}
+
+/* Workers split the SCAN atom's pairs and share every trie read-only */
+typedef struct PipelineTask {
+    const PipelineState *shared;
+    void *const *contexts;      /* One per worker */
+    JoinStats *stats;           /* One per worker */
+    bool *ok;                   /* One per worker */
+} PipelineTask;
+
+static void pipeline_worker(int index, int workers, void *context) {
+    PipelineTask *task = context;
+    PipelineState state = *task->shared;
+    int count = state.tries[0]->count;
+    int chunk = (count + workers - 1) / workers;
+
+    state.scan_lo = chunk * index < count ? chunk * index : count;
+    state.scan_hi = state.scan_lo + chunk < count ? state.scan_lo + chunk : count;
+    state.frame = malloc((size_t)state.query->var_count * sizeof(int));
+    state.context = task->contexts[index];
+    state.stats = &task->stats[index];
+    task->ok[index] = state.frame && pipeline_atom(&state, 0);
+    free(state.frame);
+}
+
+static bool run_pairwise(const JoinQuery *query, FactDatabase *db, int threads,
+                         JoinEmitFn emit, void *const *contexts, JoinStats *stats) {
+    JoinTrieSet tries = {NULL, 0};
+    PipelineState state = {query, NULL, NULL, NULL, 0, 0, NULL, emit, NULL, NULL};
+
+    state.tries = malloc((size_t)query->atom_count * sizeof(JoinTrie *));
+    state.filter_start = malloc((size_t)(query->atom_count + 1) * sizeof(int));
+    state.filter_tries = calloc((size_t)query->filter_count + 1, sizeof(JoinTrie *));
+    bool ok = state.tries && state.filter_start && state.filter_tries &&
+              trie_set_init(&tries, query->atom_count + query->filter_count);
+    if (state.filter_start) {
+        filter_ranges(query, state.filter_start, query->atom_count, true);
+    }
+
+    for (int i = 0; ok && i < query->atom_count; i++) {
+        const JoinAtom *atom = &query->atoms[i];
+        state.tries[i] = trie_set_get(&tries, db, atom->relation, false,
+                                      atom->slot_a == atom->slot_b);
+        ok = state.tries[i] != NULL;
+    }
+    ok = ok && trie_set_get_negated(&tries, db, query, state.filter_tries);
+
+    /* Small scans are not worth a thread each */
+    int workers = 1;
+    if (ok) {
+        int shares = state.tries[0]->count / JOIN_PARALLEL_MIN_SCAN;
+        workers = threads < shares ? threads : shares;
+        if (workers > PARALLEL_MAX_THREADS) workers = PARALLEL_MAX_THREADS;
+        if (workers < 1) workers = 1;
+    }
+
+    JoinStats worker_stats[PARALLEL_MAX_THREADS];
+    bool worker_ok[PARALLEL_MAX_THREADS];
+    if (ok) {
+        PipelineTask task = {&state, contexts, worker_stats, worker_ok};
+        for (int w = 0; w < workers; w++) {
+            worker_stats[w] = (JoinStats){0, 0};
+        }
+        parallel_run(workers, pipeline_worker, &task);
+
+        for (int w = 0; w < workers; w++) {
+            stats->intermediate += worker_stats[w].intermediate;
+            stats->results += worker_stats[w].results;
+            ok = ok && worker_ok[w];
+        }
+    }
+
+    trie_set_free(&tries);
+    free(state.tries);
+    free(state.filter_start);
+    free(state.filter_tries);
+    return ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Evaluation Entry Point
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool join_query_run(const JoinQuery *query, FactDatabase *db, JoinStrategy strategy,
+                    JoinEmitFn emit, void *context, JoinStats *stats) {
+    return join_query_run_parallel(query, db, strategy, 1, emit, &context, stats);
+}
+
+bool join_query_run_parallel(const JoinQuery *query, FactDatabase *db, JoinStrategy strategy,
+                             int threads, JoinEmitFn emit, void *const *contexts,
+                             JoinStats *stats) {
+    JoinStats local = {0, 0};
+    if (!stats) stats = &local;
+
+    bool leapfrog = strategy == JOIN_STRATEGY_LEAPFROG ||
+                    (strategy == JOIN_STRATEGY_AUTO && query->cyclic);
+
+    if (leapfrog) {
+        return run_leapfrog(query, db, emit, contexts[0], stats);
+    }
+    return run_pairwise(query, db, threads, emit, contexts, stats);
+}
@@ -69,6 +69,8 @@ static const Keyword KEYWORDS[] = {
     {"MATCH", TOK_MATCH},
     {"SOLVE", TOK_SOLVE},
     {"QUERY", TOK_QUERY},
+    {"WHERE", TOK_WHERE},
+    {"NOT", TOK_NOT},
     {NULL, TOK_ERROR}  /* Sentinel */
 };
 
@@ -202,9 +204,17 @@ const char* token_type_name(TokenType type) {
         case TOK_MATCH: return "MATCH";
         case TOK_SOLVE: return "SOLVE";
         case TOK_QUERY: return "QUERY";
+        case TOK_WHERE: return "WHERE";
+        case TOK_NOT: return "NOT";
         case TOK_COLON: return "COLON";
         case TOK_COMMA: return "COMMA";
         case TOK_WILDCARD: return "WILDCARD";
+        case TOK_LT: return "LT";
+        case TOK_LE: return "LE";
+        case TOK_GT: return "GT";
+        case TOK_GE: return "GE";
+        case TOK_EQ: return "EQ";
+        case TOK_NE: return "NE";
         case TOK_VARIABLE: return "VARIABLE";
         case TOK_INTEGER: return "INTEGER";
         case TOK_IDENTIFIER: return "IDENTIFIER";
@@ -327,6 +337,41 @@ static Token scan_identifier(Lexer *lex) {
     }
 }
 
+static Token scan_comparison(Lexer *lex) {
+    int start_line = lex->line;
+    int start_column = lex->column;
+    
+    char ch = current_char(lex);
+    char next = peek_char(lex, 1);
+    TokenType type;
+    int length = 1;
+    
+    switch (ch) {
+        case '<':
+            if (next == '=') { type = TOK_LE; length = 2; }
+            else if (next == '>') { type = TOK_NE; length = 2; }
+            else type = TOK_LT;
+            break;
+        case '>':
+            if (next == '=') { type = TOK_GE; length = 2; }
+            else type = TOK_GT;
+            break;
+        case '=':
+            type = TOK_EQ;
+            if (next == '=') length = 2;
+            break;
+        default: /* "!=" */
+            type = TOK_NE;
+            length = 2;
+            break;
+    }
+    
+    for (int i = 0; i < length; i++) {
+        advance_char(lex);
+    }
+    return token_make_simple(type, start_line, start_column);
+}
+
 Token lexer_next_token(Lexer *lex) {
     assert(lex);
     
@@ -369,6 +414,12 @@ Token lexer_next_token(Lexer *lex) {
             return token_make_simple(TOK_WILDCARD, line, column);
         }
         
+        /* Comparison operators: < <= <> > >= = == != */
+        if (ch == '<' || ch == '>' || ch == '=' ||
+            (ch == '!' && peek_char(lex, 1) == '=')) {
+            return scan_comparison(lex);
+        }
+        
         /* Variables: $0, $1, $2, ... */
         if (ch == '$') {
             return scan_variable(lex);
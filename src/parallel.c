@@ -0,0 +1,232 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * parallel.c - ByteLog Parallel Primitives
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Fork-join on POSIX threads and a parallel LSD radix sort.
+ *
+ * The radix sort runs 8 passes of 8 bits.  Each worker histograms its own
+ * contiguous chunk, an exclusive prefix sum over (digit, worker) gives every
+ * worker a private output range per digit, and workers scatter their chunk
+ * without synchronization.  Passes whose digit is constant across all keys
+ * (the high bytes of small atom IDs) are skipped.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fork-Join
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static int configured_threads = 0;
+
+int parallel_thread_count(void) {
+    if (configured_threads > 0) return configured_threads;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    if (online > PARALLEL_MAX_THREADS) online = PARALLEL_MAX_THREADS;
+    return (int)online;
+}
+
+void parallel_set_thread_count(int threads) {
+    if (threads > PARALLEL_MAX_THREADS) threads = PARALLEL_MAX_THREADS;
+    configured_threads = threads > 0 ? threads : 0;
+}
+
+static bool pin_workers = false;
+
+void parallel_set_pinning(bool pin) {
+    pin_workers = pin;
+}
+
+/* Thread attributes binding worker `index` to the index-th CPU this
+ * process may run on */
+static bool parallel_pin_attr(pthread_attr_t *attr, int index) {
+    cpu_set_t allowed, cpu;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+
+    int cpus = CPU_COUNT(&allowed);
+    if (cpus == 0) return false;
+    int target = index % cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &allowed)) continue;
+        if (target-- > 0) continue;
+
+        CPU_ZERO(&cpu);
+        CPU_SET(c, &cpu);
+        if (pthread_attr_init(attr) != 0) return false;
+        if (pthread_attr_setaffinity_np(attr, sizeof(cpu), &cpu) == 0) return true;
+        pthread_attr_destroy(attr);
+        return false;
+    }
+    return false;
+}
+
+typedef struct ParallelWorker {
+    ParallelTask task;
+    void *context;
+    int index;
+    int count;
+} ParallelWorker;
+
+static void* parallel_worker_main(void *arg) {
+    ParallelWorker *worker = arg;
+    worker->task(worker->index, worker->count, worker->context);
+    return NULL;
+}
+
+void parallel_run(int count, ParallelTask task, void *context) {
+    if (count > PARALLEL_MAX_THREADS) count = PARALLEL_MAX_THREADS;
+    if (count <= 1) {
+        task(0, 1, context);
+        return;
+    }
+
+    pthread_t threads[PARALLEL_MAX_THREADS];
+    ParallelWorker workers[PARALLEL_MAX_THREADS];
+    bool started[PARALLEL_MAX_THREADS] = {false};
+
+    /* Worker 0 runs on the calling thread */
+    for (int i = 1; i < count; i++) {
+        pthread_attr_t attr;
+        bool pinned = pin_workers && parallel_pin_attr(&attr, i);
+        workers[i] = (ParallelWorker){task, context, i, count};
+        started[i] = pthread_create(&threads[i], pinned ? &attr : NULL,
+                                    parallel_worker_main, &workers[i]) == 0;
+        if (pinned) pthread_attr_destroy(&attr);
+    }
+
+    task(0, count, context);
+
+    /* Run any worker that failed to spawn inline */
+    for (int i = 1; i < count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            task(i, count, context);
+        }
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Radix Sort
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+typedef struct RadixPass {
+    const uint64_t *src;
+    uint64_t *dst;
+    size_t count;
+    int shift;
+    size_t (*histograms)[RADIX_BUCKETS];    /* One row per worker */
+} RadixPass;
+
+static void radix_chunk(size_t count, int index, int workers, size_t *begin, size_t *end) {
+    size_t chunk = (count + workers - 1) / workers;
+    *begin = chunk * index < count ? chunk * index : count;
+    *end = *begin + chunk < count ? *begin + chunk : count;
+}
+
+static void radix_histogram_task(int index, int workers, void *context) {
+    RadixPass *pass = context;
+    size_t begin, end;
+    size_t *histogram = pass->histograms[index];
+
+    radix_chunk(pass->count, index, workers, &begin, &end);
+    memset(histogram, 0, RADIX_BUCKETS * sizeof(size_t));
+    for (size_t i = begin; i < end; i++) {
+        histogram[(pass->src[i] >> pass->shift) & (RADIX_BUCKETS - 1)]++;
+    }
+}
+
+static void radix_scatter_task(int index, int workers, void *context) {
+    RadixPass *pass = context;
+    size_t begin, end;
+    size_t *offsets = pass->histograms[index];
+
+    radix_chunk(pass->count, index, workers, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        uint64_t key = pass->src[i];
+        pass->dst[offsets[(key >> pass->shift) & (RADIX_BUCKETS - 1)]++] = key;
+    }
+}
+
+static bool radix_sort(uint64_t *keys, size_t count, int workers) {
+    if (count < 2) return true;
+
+    uint64_t *scratch = malloc(count * sizeof(uint64_t));
+    size_t (*histograms)[RADIX_BUCKETS] = malloc(workers * sizeof(*histograms));
+    if (!scratch || !histograms) {
+        free(scratch);
+        free(histograms);
+        return false;
+    }
+
+    /* Bits that differ between keys; constant digits need no pass */
+    uint64_t varying = 0;
+    for (size_t i = 1; i < count; i++) {
+        varying |= keys[i] ^ keys[0];
+    }
+
+    RadixPass pass = {keys, scratch, count, 0, histograms};
+    for (int p = 0; p < RADIX_PASSES; p++) {
+        pass.shift = p * RADIX_BITS;
+        if (((varying >> pass.shift) & (RADIX_BUCKETS - 1)) == 0) continue;
+
+        parallel_run(workers, radix_histogram_task, &pass);
+
+        /* Exclusive prefix sum in (digit, worker) order */
+        size_t offset = 0;
+        for (int digit = 0; digit < RADIX_BUCKETS; digit++) {
+            for (int w = 0; w < workers; w++) {
+                size_t n = histograms[w][digit];
+                histograms[w][digit] = offset;
+                offset += n;
+            }
+        }
+
+        parallel_run(workers, radix_scatter_task, &pass);
+
+        const uint64_t *sorted = pass.dst;
+        pass.dst = (uint64_t *)pass.src;
+        pass.src = sorted;
+    }
+
+    if (pass.src != keys) {
+        memcpy(keys, pass.src, count * sizeof(uint64_t));
+    }
+
+    free(scratch);
+    free(histograms);
+    return true;
+}
+
+bool parallel_radix_sort(uint64_t *keys, size_t count) {
+    return radix_sort(keys, count, count >= PARALLEL_MIN_ITEMS ? parallel_thread_count() : 1);
+}
+
+bool parallel_radix_sort_serial(uint64_t *keys, size_t count) {
+    return radix_sort(keys, count, 1);
+}
+
+size_t parallel_unique(uint64_t *keys, size_t count) {
+    if (count == 0) return 0;
+
+    size_t unique = 1;
+    for (size_t i = 1; i < count; i++) {
+        if (keys[i] != keys[unique - 1]) {
+            keys[unique++] = keys[i];
+        }
+    }
+    return unique;
+}
@@ -12,6 +12,7 @@
 #include "atoms.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <assert.h>
 
@@ -54,6 +55,9 @@ static ASTNode* parse_body(Parser *parser);
 static ASTNode* parse_operation(Parser *parser);
 static ASTNode* parse_scan(Parser *parser);
 static ASTNode* parse_join(Parser *parser);
+static ASTNode* parse_where(Parser *parser);
+static ASTNode* parse_not(Parser *parser);
+static ASTNode* parse_operand(Parser *parser);
 static ASTNode* parse_emit(Parser *parser);
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -218,11 +222,14 @@ static bool parse_argument(Parser *parser, int *value, char **atom_name) {
 
 ASTNode* parser_parse_program(Parser *parser) {
     ASTNode *statements = NULL;
+    ASTNode *tail = NULL;       /* Last statement, so appending stays O(1) */
     
     while (parser->current_token.type != TOK_EOF && !parser->panic_mode) {
         ASTNode *stmt = parse_statement(parser);
         if (stmt) {
-            statements = ast_append(statements, stmt);
+            tail = ast_append(tail, stmt);
+            if (!statements) statements = tail;
+            while (tail->next) tail = tail->next;
         }
         
         /* Skip to next statement on error */
@@ -253,6 +260,19 @@ static ASTNode* parse_statement(Parser *parser) {
     }
 }
 
+/* Attributes accepted after REL name (case-insensitive) */
+static const struct {
+    const char *name;
+    unsigned int flag;
+} REL_ATTRIBUTES[] = {
+    {"SORTED", REL_ATTR_SORTED},
+    {"HASH", REL_ATTR_HASH},
+    {"EQUIVALENCE", REL_ATTR_EQUIVALENCE},
+    {"SYMMETRIC", REL_ATTR_SYMMETRIC},
+};
+
+#define REL_ATTRIBUTE_COUNT (sizeof(REL_ATTRIBUTES) / sizeof(REL_ATTRIBUTES[0]))
+
 static ASTNode* parse_rel_decl(Parser *parser) {
     int line = parser->current_token.line;
     int column = parser->current_token.column;
@@ -268,8 +288,59 @@ static ASTNode* parse_rel_decl(Parser *parser) {
     char *name = strdup(parser->current_token.value);
     advance_token(parser);
     
-    ASTNode *node = ast_make_rel_decl(name, line, column);
+    /* Optional attributes and capacity hints; statements start with
+     * keywords, so any identifier here belongs to the declaration */
+    unsigned int attributes = 0;
+    int hints[2] = {0, 0};      /* SIZE, DOMAIN */
+    while (parser->current_token.type == TOK_IDENTIFIER) {
+        int hint = strcasecmp(parser->current_token.value, "SIZE") == 0 ? 0 :
+                   strcasecmp(parser->current_token.value, "DOMAIN") == 0 ? 1 : -1;
+        if (hint >= 0) {
+            advance_token(parser);
+            if (parser->current_token.type != TOK_INTEGER ||
+                parser->current_token.int_value <= 0) {
+                parser_error_at_token(parser, &parser->current_token,
+                                     "Expected positive count after SIZE or DOMAIN");
+                free(name);
+                return NULL;
+            }
+            hints[hint] = parser->current_token.int_value;
+            advance_token(parser);
+            continue;
+        }
+        
+        unsigned int flag = 0;
+        for (size_t i = 0; i < REL_ATTRIBUTE_COUNT; i++) {
+            if (strcasecmp(parser->current_token.value, REL_ATTRIBUTES[i].name) == 0) {
+                flag = REL_ATTRIBUTES[i].flag;
+                break;
+            }
+        }
+        if (flag == 0) {
+            parser_error_at_token(parser, &parser->current_token,
+                                 "Unknown relation attribute");
+            free(name);
+            return NULL;
+        }
+        attributes |= flag;
+        advance_token(parser);
+    }
+    
+    /* At most one storage attribute: clearing the lowest set bit leaves none */
+    unsigned int storage = attributes & REL_ATTR_STORAGE;
+    if (storage & (storage - 1)) {
+        parser_error_at_token(parser, &parser->current_token,
+                             "Relation can have only one storage attribute");
+        free(name);
+        return NULL;
+    }
+    
+    ASTNode *node = ast_make_rel_decl_with_attributes(name, attributes, line, column);
     free(name);
+    if (node) {
+        node->data.rel_decl.size_hint = hints[0];
+        node->data.rel_decl.domain_hint = hints[1];
+    }
     return node;
 }
 
@@ -401,9 +472,13 @@ static ASTNode* parse_operation(Parser *parser) {
             return parse_scan(parser);
         case TOK_JOIN:
             return parse_join(parser);
+        case TOK_WHERE:
+            return parse_where(parser);
+        case TOK_NOT:
+            return parse_not(parser);
         default:
             parser_error_at_token(parser, &parser->current_token, 
-                                 "Expected SCAN or JOIN operation");
+                                 "Expected SCAN, JOIN, NOT, or WHERE operation");
             return NULL;
     }
 }
@@ -471,11 +546,110 @@ static ASTNode* parse_join(Parser *parser) {
     int match_var = parser->current_token.int_value;
     advance_token(parser);
     
-    ASTNode *node = ast_make_join(relation, match_var, line, column);
+    /* Optional column B variable; naming an already-bound variable closes a cycle */
+    ASTNode *node;
+    if (parser->current_token.type == TOK_VARIABLE) {
+        int bind_var = parser->current_token.int_value;
+        advance_token(parser);
+        node = ast_make_join_bind(relation, match_var, bind_var, line, column);
+    } else {
+        node = ast_make_join(relation, match_var, line, column);
+    }
     free(relation);
     return node;
 }
 
+static ASTNode* parse_not(Parser *parser) {
+    int line = parser->current_token.line;
+    int column = parser->current_token.column;
+    
+    if (!expect_token(parser, TOK_NOT)) return NULL;
+    
+    ASTNode *operation;
+    switch (parser->current_token.type) {
+        case TOK_SCAN:
+            operation = parse_scan(parser);
+            break;
+        case TOK_JOIN:
+            operation = parse_join(parser);
+            break;
+        default:
+            parser_error_at_token(parser, &parser->current_token, 
+                                 "Expected SCAN or JOIN after NOT");
+            return NULL;
+    }
+    if (!operation) return NULL;
+    
+    return ast_make_not(operation, line, column);
+}
+
+static ASTNode* parse_where(Parser *parser) {
+    int line = parser->current_token.line;
+    int column = parser->current_token.column;
+    
+    if (!expect_token(parser, TOK_WHERE)) return NULL;
+    
+    ASTNode *left = parse_operand(parser);
+    if (!left) return NULL;
+    
+    /* Comparison operator */
+    OpType op;
+    switch (parser->current_token.type) {
+        case TOK_LT: op = OP_LT; break;
+        case TOK_LE: op = OP_LE; break;
+        case TOK_GT: op = OP_GT; break;
+        case TOK_GE: op = OP_GE; break;
+        case TOK_EQ: op = OP_EQ; break;
+        case TOK_NE: op = OP_NE; break;
+        default:
+            parser_error_at_token(parser, &parser->current_token, 
+                                 "Expected comparison operator in WHERE");
+            ast_free_tree(left);
+            return NULL;
+    }
+    advance_token(parser);
+    
+    ASTNode *right = parse_operand(parser);
+    if (!right) {
+        ast_free_tree(left);
+        return NULL;
+    }
+    
+    return ast_make_where(ast_make_condition(op, left, right, line, column),
+                          line, column);
+}
+
+/* WHERE operand: a variable, an integer, or an atom */
+static ASTNode* parse_operand(Parser *parser) {
+    int line = parser->current_token.line;
+    int column = parser->current_token.column;
+    ASTNode *node;
+    
+    switch (parser->current_token.type) {
+        case TOK_VARIABLE:
+            node = ast_make_expr_var(parser->current_token.int_value, line, column);
+            break;
+        case TOK_INTEGER:
+            node = ast_make_expr_int(parser->current_token.int_value, line, column);
+            break;
+        case TOK_IDENTIFIER:
+            if (atom_table_intern(&parser->atoms, parser->current_token.value) == -1) {
+                parser_error_at_token(parser, &parser->current_token, 
+                                     "Failed to intern atom");
+                return NULL;
+            }
+            node = ast_make_expr_string(parser->current_token.value, line, column);
+            break;
+        default:
+            parser_error_at_token(parser, &parser->current_token, 
+                                 "Expected variable, integer, or atom in WHERE");
+            return NULL;
+    }
+    
+    advance_token(parser);
+    return node;
+}
+
 static ASTNode* parse_emit(Parser *parser) {
     int line = parser->current_token.line;
     int column = parser->current_token.column;
@@ -0,0 +1,194 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * querycache.c - ByteLog Query Result Cache
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Chained hash table over (relation, arg_a, arg_b) with twice as many
+ * buckets as entries.  Every entry is also on a doubly linked list in
+ * insertion order, so the oldest is evicted in O(1) and a stale entry is
+ * unlinked wherever it sits.  Answers are kept as flat pair arrays and
+ * copied into a fresh result list on every hit.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "querycache.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Entries
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static unsigned int pattern_hash(const char *relation, int arg_a, int arg_b) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)relation; *c; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    hash = (hash ^ (unsigned int)arg_a) * 16777619u;
+    hash = (hash ^ (unsigned int)arg_b) * 16777619u;
+    return hash ^ (hash >> 15);
+}
+
+static QueryCacheEntry** entry_link(QueryCache *cache, const char *relation, int arg_a, int arg_b,
+                                    unsigned int hash) {
+    QueryCacheEntry **link = &cache->buckets[hash & (unsigned int)(cache->bucket_count - 1)];
+    while (*link) {
+        const QueryCacheEntry *entry = *link;
+        if (entry->hash == hash && entry->arg_a == arg_a && entry->arg_b == arg_b &&
+            strcmp(entry->relation, relation) == 0) {
+            break;
+        }
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/* Unlink the entry at *link from its chain and the insertion order */
+static void entry_remove(QueryCache *cache, QueryCacheEntry **link) {
+    QueryCacheEntry *entry = *link;
+    *link = entry->next;
+
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+
+    cache->stats.entries--;
+    cache->stats.facts -= entry->count;
+    free(entry->relation);
+    free(entry->results);
+    free(entry);
+}
+
+static void evict_oldest(QueryCache *cache) {
+    QueryCacheEntry *oldest = cache->oldest;
+    QueryCacheEntry **link = entry_link(cache, oldest->relation, oldest->arg_a, oldest->arg_b,
+                                        oldest->hash);
+    entry_remove(cache, link);
+    cache->stats.evictions++;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Query Cache Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+bool querycache_init(QueryCache *cache, int max_entries) {
+    memset(cache, 0, sizeof(*cache));
+    cache->max_entries = max_entries > 0 ? max_entries : 1;
+
+    cache->bucket_count = 16;
+    while (cache->bucket_count < cache->max_entries * 2) cache->bucket_count *= 2;
+    cache->buckets = calloc((size_t)cache->bucket_count, sizeof(QueryCacheEntry *));
+    return cache->buckets != NULL;
+}
+
+void querycache_clear(QueryCache *cache) {
+    while (cache->oldest) {
+        QueryCacheEntry *oldest = cache->oldest;
+        entry_remove(cache, entry_link(cache, oldest->relation, oldest->arg_a, oldest->arg_b,
+                                       oldest->hash));
+    }
+}
+
+void querycache_free(QueryCache *cache) {
+    if (cache->buckets) querycache_clear(cache);
+    free(cache->buckets);
+    cache->buckets = NULL;
+}
+
+bool querycache_lookup(QueryCache *cache, const char *relation, int arg_a, int arg_b,
+                       uint64_t version, QueryResult **results) {
+    unsigned int hash = pattern_hash(relation, arg_a, arg_b);
+    QueryCacheEntry **link = entry_link(cache, relation, arg_a, arg_b, hash);
+    QueryCacheEntry *entry = *link;
+
+    if (entry && entry->version != version) {
+        entry_remove(cache, link);
+        cache->stats.invalidations++;
+        entry = NULL;
+    }
+    if (!entry) {
+        cache->stats.misses++;
+        return false;
+    }
+
+    /* Copy back to front so the list comes out in order */
+    QueryResult *copy = NULL;
+    for (int i = entry->count - 1; i >= 0; i--) {
+        QueryResult *result = malloc(sizeof(QueryResult));
+        if (!result) {
+            query_result_free(copy);
+            cache->stats.misses++;
+            return false;
+        }
+        result->arg_a = entry->results[i].arg_a;
+        result->arg_b = entry->results[i].arg_b;
+        result->next = copy;
+        copy = result;
+    }
+
+    cache->stats.hits++;
+    *results = copy;
+    return true;
+}
+
+bool querycache_store(QueryCache *cache, const char *relation, int arg_a, int arg_b,
+                      uint64_t version, const QueryResult *results) {
+    int count = query_result_count((QueryResult *)results);
+    if (count > QUERYCACHE_MAX_FACTS) return true;
+
+    unsigned int hash = pattern_hash(relation, arg_a, arg_b);
+    QueryCacheEntry **link = entry_link(cache, relation, arg_a, arg_b, hash);
+    if (*link) entry_remove(cache, link);
+
+    while (cache->oldest && (cache->stats.entries >= cache->max_entries ||
+                             cache->stats.facts + count > QUERYCACHE_MAX_FACTS)) {
+        evict_oldest(cache);
+    }
+
+    QueryCacheEntry *entry = calloc(1, sizeof(QueryCacheEntry));
+    if (!entry) return false;
+    entry->relation = strdup(relation);
+    entry->results = malloc(((size_t)count + 1) * sizeof(FactPair));
+    if (!entry->relation || !entry->results) {
+        free(entry->relation);
+        free(entry->results);
+        free(entry);
+        return false;
+    }
+
+    int n = 0;
+    for (const QueryResult *r = results; r; r = r->next) {
+        entry->results[n].arg_a = r->arg_a;
+        entry->results[n].arg_b = r->arg_b;
+        n++;
+    }
+    entry->arg_a = arg_a;
+    entry->arg_b = arg_b;
+    entry->version = version;
+    entry->count = count;
+    entry->hash = hash;
+
+    /* Eviction may have emptied the chain the link pointed into */
+    link = &cache->buckets[hash & (unsigned int)(cache->bucket_count - 1)];
+    entry->next = *link;
+    *link = entry;
+
+    entry->older = cache->newest;
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+
+    cache->stats.entries++;
+    cache->stats.facts += count;
+    return true;
+}
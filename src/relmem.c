@@ -0,0 +1,268 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * relmem.c - ByteLog Relation Memory
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Every block starts with a cache-line header recording its backing and
+ * mapped length, so relmem_free and relmem_realloc need only the pointer.
+ *
+ * Large blocks try MAP_HUGETLB first.  Without reserved huge pages that
+ * fails, is remembered, and later blocks map an over-sized region trimmed
+ * to 2MB alignment and madvise it MADV_HUGEPAGE, which lets the kernel
+ * back it with transparent huge pages where enabled.  A kernel without
+ * either still returns a working mapping.
+ *
+ * Linux places a page on the node of the thread that first writes it.
+ * New mappings are touched by parallel_thread_count() workers, worker i
+ * taking the i-th contiguous run of huge pages, the same split the
+ * parallel scans use, so each shard is local to the worker that reads
+ * it when workers are pinned (parallel_set_pinning).  Blocks a worker
+ * allocates for itself (relmem_alloc_local) are touched on that worker's
+ * thread instead: spawning a pool from inside a pool would oversubscribe
+ * the CPUs, and helpers would place the pages away from their owner.
+ *
+ * Past the memory budget a block is a MAP_SHARED view of a temp file that
+ * is unlinked at once, so it disappears with the mapping.  Its disk space
+ * is reserved with posix_fallocate up front: a full disk then fails the
+ * allocation instead of raising SIGBUS on a later write.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "relmem.h"
+#include "parallel.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Block Header
+ * ───────────────────────────────────────────────────────────────────────── */
+
+#define RELMEM_HEADER 64
+
+typedef struct RelMemHeader {
+    RelMemBacking backing;
+    size_t size;                /* Usable bytes */
+    size_t mapped;              /* Mapping length, 0 for heap blocks */
+} RelMemHeader;
+
+static bool huge_pages = true;
+static bool hugetlb_failed = false;
+static size_t budget = 0;
+static size_t resident = 0;     /* Anonymous mapped bytes, updated atomically */
+static char spill_dir[PATH_MAX] = "";
+
+static inline RelMemHeader* block_header(const void *ptr) {
+    return (RelMemHeader *)((char *)ptr - RELMEM_HEADER);
+}
+
+static inline void* block_data(RelMemHeader *header) {
+    return (char *)header + RELMEM_HEADER;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Mappings
+ * ───────────────────────────────────────────────────────────────────────── */
+
+typedef struct TouchTask {
+    char *base;
+    size_t length;
+} TouchTask;
+
+/* Write one byte per base page of this worker's run of huge pages */
+static void touch_task(int index, int workers, void *context) {
+    TouchTask *task = context;
+    size_t pages = task->length / RELMEM_HUGE_PAGE;
+    size_t chunk = (pages + workers - 1) / workers;
+    size_t begin = chunk * index < pages ? chunk * index : pages;
+    size_t end = begin + chunk < pages ? begin + chunk : pages;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    for (size_t at = begin * RELMEM_HUGE_PAGE; at < end * RELMEM_HUGE_PAGE; at += page) {
+        task->base[at] = 0;
+    }
+}
+
+/* Anonymous mapping aligned to a huge page, advised for or against
+ * transparent huge pages */
+static void* map_aligned(size_t length, bool advise) {
+    char *raw = mmap(NULL, length + RELMEM_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    char *base = (char *)(((uintptr_t)raw + RELMEM_HUGE_PAGE - 1) & ~(uintptr_t)(RELMEM_HUGE_PAGE - 1));
+    if (base > raw) munmap(raw, (size_t)(base - raw));
+    size_t tail = (size_t)(raw + length + RELMEM_HUGE_PAGE - (base + length));
+    if (tail > 0) munmap(base + length, tail);
+
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    madvise(base, length, advise ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#else
+    (void)advise;
+#endif
+    return base;
+}
+
+/* Mapping of a fresh, already unlinked temp file with its space reserved */
+static void* map_spill(size_t length) {
+    const char *dir = spill_dir[0] ? spill_dir : getenv("TMPDIR");
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/bytelog-spill-XXXXXX",
+                 dir && dir[0] ? dir : "/tmp") >= (int)sizeof(path)) {
+        return NULL;
+    }
+
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    unlink(path);
+
+    void *base = NULL;
+    if (posix_fallocate(fd, 0, (off_t)length) == 0) {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) base = NULL;
+    }
+    close(fd);
+    return base;
+}
+
+/* Map a block of at least a huge page; local blocks are touched on the
+ * calling thread alone */
+static RelMemHeader* block_map(size_t size, bool local) {
+    size_t length = (size + RELMEM_HEADER + RELMEM_HUGE_PAGE - 1) & ~(RELMEM_HUGE_PAGE - 1);
+    RelMemBacking backing = RELMEM_MAPPED;
+    void *base = NULL;
+
+    if (budget && __atomic_load_n(&resident, __ATOMIC_RELAXED) + length > budget) {
+        base = map_spill(length);
+        if (base) {
+            RelMemHeader *header = base;
+            header->backing = RELMEM_SPILLED;
+            header->size = size;
+            header->mapped = length;
+            return header;
+        }
+    }
+
+#ifdef MAP_HUGETLB
+    if (huge_pages && !__atomic_load_n(&hugetlb_failed, __ATOMIC_RELAXED)) {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+            __atomic_store_n(&hugetlb_failed, true, __ATOMIC_RELAXED);
+        } else {
+            backing = RELMEM_HUGETLB;
+        }
+    }
+#endif
+    if (!base) {
+        base = map_aligned(length, huge_pages);
+        if (!base) return NULL;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+        if (huge_pages) backing = RELMEM_TRANSPARENT;
+#endif
+    }
+
+    __atomic_add_fetch(&resident, length, __ATOMIC_RELAXED);
+
+    TouchTask task = {base, length};
+    int workers = local ? 1 : parallel_thread_count();
+    if ((size_t)workers > length / RELMEM_HUGE_PAGE) workers = (int)(length / RELMEM_HUGE_PAGE);
+    parallel_run(workers, touch_task, &task);
+
+    RelMemHeader *header = base;
+    header->backing = backing;
+    header->size = size;
+    header->mapped = length;
+    return header;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Relation Memory Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static void* block_alloc(size_t size, bool local) {
+    RelMemHeader *header;
+    if (size >= RELMEM_HUGE_PAGE) {
+        header = block_map(size, local);
+    } else {
+        header = malloc(size + RELMEM_HEADER);
+        if (header) {
+            header->backing = RELMEM_HEAP;
+            header->mapped = 0;
+        }
+    }
+    if (!header) return NULL;
+
+    header->size = size;
+    return block_data(header);
+}
+
+void* relmem_alloc(size_t size) {
+    return block_alloc(size, false);
+}
+
+void* relmem_alloc_local(size_t size) {
+    return block_alloc(size, true);
+}
+
+void* relmem_realloc(void *ptr, size_t size) {
+    if (!ptr) return relmem_alloc(size);
+
+    RelMemHeader *header = block_header(ptr);
+    if (header->backing == RELMEM_HEAP && size < RELMEM_HUGE_PAGE) {
+        header = realloc(header, size + RELMEM_HEADER);
+        if (!header) return NULL;
+        header->size = size;
+        return block_data(header);
+    }
+
+    /* Still fits the mapping: nothing moves */
+    if (header->mapped && size + RELMEM_HEADER <= header->mapped && size >= RELMEM_HUGE_PAGE) {
+        header->size = size;
+        return ptr;
+    }
+
+    void *grown = relmem_alloc(size);
+    if (!grown) return NULL;
+    memcpy(grown, ptr, header->size < size ? header->size : size);
+    relmem_free(ptr);
+    return grown;
+}
+
+void relmem_free(void *ptr) {
+    if (!ptr) return;
+
+    RelMemHeader *header = block_header(ptr);
+    if (header->mapped) {
+        if (header->backing != RELMEM_SPILLED) {
+            __atomic_sub_fetch(&resident, header->mapped, __ATOMIC_RELAXED);
+        }
+        munmap(header, header->mapped);
+    } else {
+        free(header);
+    }
+}
+
+RelMemBacking relmem_backing(const void *ptr) {
+    return block_header(ptr)->backing;
+}
+
+void relmem_set_budget(size_t bytes, const char *dir) {
+    budget = bytes;
+    spill_dir[0] = '\0';
+    if (dir && strlen(dir) < sizeof(spill_dir)) strcpy(spill_dir, dir);
+}
+
+size_t relmem_resident(void) {
+    return __atomic_load_n(&resident, __ATOMIC_RELAXED);
+}
+
+void relmem_set_huge_pages(bool enabled) {
+    huge_pages = enabled;
+}
@@ -0,0 +1,652 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * roaring.c - ByteLog Compressed Bitmaps
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Roaring bitmap containers and the container-level AND/OR kernels.
+ *
+ * Array and bitmap containers have dedicated kernels for every pairing.
+ * Run containers are compact at rest; set operations expand them into an
+ * array or bitmap container first.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "roaring.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Container Helpers
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool container_init_array(RoaringContainer *c, uint16_t key, int capacity) {
+    c->key = key;
+    c->type = ROARING_ARRAY;
+    c->cardinality = 0;
+    c->size = 0;
+    c->capacity = capacity > 0 ? capacity : 4;
+    c->data.array = malloc((size_t)c->capacity * sizeof(uint16_t));
+    return c->data.array != NULL;
+}
+
+static bool container_init_bitmap(RoaringContainer *c, uint16_t key) {
+    c->key = key;
+    c->type = ROARING_BITMAP;
+    c->cardinality = 0;
+    c->size = 0;
+    c->capacity = 0;
+    c->data.words = calloc(ROARING_BITMAP_WORDS, sizeof(uint64_t));
+    return c->data.words != NULL;
+}
+
+static void container_free(RoaringContainer *c) {
+    /* All union members share one heap pointer */
+    free(c->data.array);
+    c->data.array = NULL;
+}
+
+static bool bitmap_test(const uint64_t *words, uint16_t low) {
+    return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+static void bitmap_set(uint64_t *words, uint16_t low) {
+    words[low >> 6] |= (uint64_t)1 << (low & 63);
+}
+
+/* First array index whose value is >= low */
+static int array_lower_bound(const uint16_t *array, int size, uint16_t low) {
+    int lo = 0, hi = size;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (array[mid] < low) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool container_contains(const RoaringContainer *c, uint16_t low) {
+    switch (c->type) {
+        case ROARING_ARRAY: {
+            int pos = array_lower_bound(c->data.array, c->size, low);
+            return pos < c->size && c->data.array[pos] == low;
+        }
+        case ROARING_BITMAP:
+            return bitmap_test(c->data.words, low);
+        case ROARING_RUN: {
+            int lo = 0, hi = c->size;
+            while (lo < hi) {
+                int mid = lo + (hi - lo) / 2;
+                const RoaringRun *run = &c->data.runs[mid];
+                if (low < run->start) {
+                    hi = mid;
+                } else if (low > run->start + run->length) {
+                    lo = mid + 1;
+                } else {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+/* Replace an array or run container with its bitmap form */
+static bool container_to_bitmap(RoaringContainer *c) {
+    uint64_t *words = calloc(ROARING_BITMAP_WORDS, sizeof(uint64_t));
+    if (!words) return false;
+
+    if (c->type == ROARING_ARRAY) {
+        for (int i = 0; i < c->size; i++) {
+            bitmap_set(words, c->data.array[i]);
+        }
+    } else if (c->type == ROARING_RUN) {
+        for (int i = 0; i < c->size; i++) {
+            const RoaringRun *run = &c->data.runs[i];
+            for (uint32_t v = run->start; v <= (uint32_t)run->start + run->length; v++) {
+                bitmap_set(words, (uint16_t)v);
+            }
+        }
+    }
+
+    container_free(c);
+    c->type = ROARING_BITMAP;
+    c->size = 0;
+    c->capacity = 0;
+    c->data.words = words;
+    return true;
+}
+
+/* Replace a bitmap container holding few values with an array */
+static bool container_bitmap_to_array(RoaringContainer *c) {
+    uint16_t *array = malloc((size_t)(c->cardinality > 0 ? c->cardinality : 1) * sizeof(uint16_t));
+    if (!array) return false;
+
+    int n = 0;
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        uint64_t word = c->data.words[w];
+        while (word) {
+            array[n++] = (uint16_t)(w * 64 + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+
+    container_free(c);
+    c->type = ROARING_ARRAY;
+    c->size = n;
+    c->capacity = c->cardinality > 0 ? c->cardinality : 1;
+    c->data.array = array;
+    return true;
+}
+
+/* Expand a run container into an array or bitmap container */
+static bool container_expand_runs(RoaringContainer *c) {
+    if (c->type != ROARING_RUN) return true;
+    if (c->cardinality > ROARING_ARRAY_MAX) return container_to_bitmap(c);
+
+    uint16_t *array = malloc((size_t)(c->cardinality > 0 ? c->cardinality : 1) * sizeof(uint16_t));
+    if (!array) return false;
+
+    int n = 0;
+    for (int i = 0; i < c->size; i++) {
+        const RoaringRun *run = &c->data.runs[i];
+        for (uint32_t v = run->start; v <= (uint32_t)run->start + run->length; v++) {
+            array[n++] = (uint16_t)v;
+        }
+    }
+
+    container_free(c);
+    c->type = ROARING_ARRAY;
+    c->size = n;
+    c->capacity = c->cardinality > 0 ? c->cardinality : 1;
+    c->data.array = array;
+    return true;
+}
+
+static bool container_clone(const RoaringContainer *src, RoaringContainer *dst) {
+    *dst = *src;
+    size_t allocated, used;
+    switch (src->type) {
+        case ROARING_ARRAY:
+            allocated = (size_t)src->capacity * sizeof(uint16_t);
+            used = (size_t)src->size * sizeof(uint16_t);
+            break;
+        case ROARING_BITMAP:
+            allocated = used = ROARING_BITMAP_WORDS * sizeof(uint64_t);
+            break;
+        default:
+            allocated = (size_t)src->capacity * sizeof(RoaringRun);
+            used = (size_t)src->size * sizeof(RoaringRun);
+            break;
+    }
+
+    dst->data.array = malloc(allocated > 0 ? allocated : 1);
+    if (!dst->data.array) return false;
+    memcpy(dst->data.array, src->data.array, used);
+    return true;
+}
+
+static bool container_add(RoaringContainer *c, uint16_t low) {
+    if (c->type == ROARING_RUN) {
+        if (container_contains(c, low)) return true;
+        if (!container_expand_runs(c)) return false;
+    }
+
+    if (c->type == ROARING_BITMAP) {
+        if (!bitmap_test(c->data.words, low)) {
+            bitmap_set(c->data.words, low);
+            c->cardinality++;
+        }
+        return true;
+    }
+
+    int pos = array_lower_bound(c->data.array, c->size, low);
+    if (pos < c->size && c->data.array[pos] == low) return true;
+
+    if (c->size >= ROARING_ARRAY_MAX) {
+        if (!container_to_bitmap(c)) return false;
+        bitmap_set(c->data.words, low);
+        c->cardinality++;
+        return true;
+    }
+
+    if (c->size == c->capacity) {
+        int capacity = c->capacity * 2;
+        if (capacity > ROARING_ARRAY_MAX) capacity = ROARING_ARRAY_MAX;
+        uint16_t *array = realloc(c->data.array, (size_t)capacity * sizeof(uint16_t));
+        if (!array) return false;
+        c->data.array = array;
+        c->capacity = capacity;
+    }
+
+    memmove(c->data.array + pos + 1, c->data.array + pos,
+            (size_t)(c->size - pos) * sizeof(uint16_t));
+    c->data.array[pos] = low;
+    c->size++;
+    c->cardinality++;
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Container Kernels
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool container_and(const RoaringContainer *x, const RoaringContainer *y,
+                          RoaringContainer *out) {
+    /* Array results first: an array operand bounds the result size */
+    if (x->type == ROARING_BITMAP && y->type == ROARING_ARRAY) {
+        const RoaringContainer *t = x;
+        x = y;
+        y = t;
+    }
+
+    if (x->type == ROARING_ARRAY && y->type == ROARING_ARRAY) {
+        if (!container_init_array(out, x->key, x->size < y->size ? x->size : y->size)) return false;
+        int i = 0, j = 0;
+        while (i < x->size && j < y->size) {
+            uint16_t a = x->data.array[i], b = y->data.array[j];
+            if (a < b) {
+                i++;
+            } else if (a > b) {
+                j++;
+            } else {
+                out->data.array[out->size++] = a;
+                i++;
+                j++;
+            }
+        }
+        out->cardinality = out->size;
+        return true;
+    }
+
+    if (x->type == ROARING_ARRAY && y->type == ROARING_BITMAP) {
+        if (!container_init_array(out, x->key, x->size)) return false;
+        for (int i = 0; i < x->size; i++) {
+            if (bitmap_test(y->data.words, x->data.array[i])) {
+                out->data.array[out->size++] = x->data.array[i];
+            }
+        }
+        out->cardinality = out->size;
+        return true;
+    }
+
+    /* Bitmap AND bitmap */
+    if (!container_init_bitmap(out, x->key)) return false;
+    int cardinality = 0;
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        out->data.words[w] = x->data.words[w] & y->data.words[w];
+        cardinality += __builtin_popcountll(out->data.words[w]);
+    }
+    out->cardinality = cardinality;
+    return cardinality > ROARING_ARRAY_MAX || container_bitmap_to_array(out);
+}
+
+static bool container_or(const RoaringContainer *x, const RoaringContainer *y,
+                         RoaringContainer *out) {
+    if (x->type == ROARING_ARRAY && y->type == ROARING_ARRAY) {
+        if (!container_init_array(out, x->key, x->size + y->size)) return false;
+        int i = 0, j = 0;
+        while (i < x->size || j < y->size) {
+            uint16_t v;
+            if (j == y->size || (i < x->size && x->data.array[i] < y->data.array[j])) {
+                v = x->data.array[i++];
+            } else if (i == x->size || y->data.array[j] < x->data.array[i]) {
+                v = y->data.array[j++];
+            } else {
+                v = x->data.array[i++];
+                j++;
+            }
+            out->data.array[out->size++] = v;
+        }
+        out->cardinality = out->size;
+        return out->size <= ROARING_ARRAY_MAX || container_to_bitmap(out);
+    }
+
+    /* At least one bitmap: start from it and set the other's bits */
+    if (x->type == ROARING_ARRAY) {
+        const RoaringContainer *t = x;
+        x = y;
+        y = t;
+    }
+    if (!container_clone(x, out)) return false;
+
+    if (y->type == ROARING_ARRAY) {
+        for (int i = 0; i < y->size; i++) {
+            if (!bitmap_test(out->data.words, y->data.array[i])) {
+                bitmap_set(out->data.words, y->data.array[i]);
+                out->cardinality++;
+            }
+        }
+        return true;
+    }
+
+    int cardinality = 0;
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        out->data.words[w] |= y->data.words[w];
+        cardinality += __builtin_popcountll(out->data.words[w]);
+    }
+    out->cardinality = cardinality;
+    return true;
+}
+
+/* Run a binary kernel, expanding run containers into temporaries */
+static bool container_apply(const RoaringContainer *x, const RoaringContainer *y,
+                            RoaringContainer *out,
+                            bool (*kernel)(const RoaringContainer *, const RoaringContainer *,
+                                           RoaringContainer *)) {
+    RoaringContainer tx, ty;
+    bool own_x = false, own_y = false;
+    bool ok = true;
+
+    if (x->type == ROARING_RUN) {
+        ok = container_clone(x, &tx) && container_expand_runs(&tx);
+        own_x = true;
+        x = &tx;
+    }
+    if (ok && y->type == ROARING_RUN) {
+        ok = container_clone(y, &ty) && container_expand_runs(&ty);
+        own_y = true;
+        y = &ty;
+    }
+    if (ok) ok = kernel(x, y, out);
+
+    if (own_x) container_free(&tx);
+    if (own_y) container_free(&ty);
+    return ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bitmap Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+void roaring_init(RoaringBitmap *bitmap) {
+    bitmap->containers = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+}
+
+void roaring_free(RoaringBitmap *bitmap) {
+    for (int i = 0; i < bitmap->count; i++) {
+        container_free(&bitmap->containers[i]);
+    }
+    free(bitmap->containers);
+    roaring_init(bitmap);
+}
+
+/* Index of the container for key, or -(insertion point) - 1 */
+static int roaring_find(const RoaringBitmap *bitmap, uint16_t key) {
+    int lo = 0, hi = bitmap->count;
+
+    /* Ascending inserts hit the last container */
+    if (hi > 0 && bitmap->containers[hi - 1].key == key) return hi - 1;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        uint16_t k = bitmap->containers[mid].key;
+        if (k < key) {
+            lo = mid + 1;
+        } else if (k > key) {
+            hi = mid;
+        } else {
+            return mid;
+        }
+    }
+    return -lo - 1;
+}
+
+/* Append a finished container (keys must arrive in order) */
+static bool roaring_push(RoaringBitmap *bitmap, RoaringContainer *c) {
+    if (bitmap->count == bitmap->capacity) {
+        int capacity = bitmap->capacity ? bitmap->capacity * 2 : 4;
+        RoaringContainer *containers = realloc(bitmap->containers,
+                                               (size_t)capacity * sizeof(RoaringContainer));
+        if (!containers) return false;
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+    bitmap->containers[bitmap->count++] = *c;
+    return true;
+}
+
+bool roaring_add(RoaringBitmap *bitmap, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    int index = roaring_find(bitmap, key);
+
+    if (index < 0) {
+        RoaringContainer c;
+        if (!container_init_array(&c, key, 4)) return false;
+        if (!roaring_push(bitmap, &c)) {
+            container_free(&c);
+            return false;
+        }
+
+        /* Rotate the new container into its sorted slot */
+        index = -index - 1;
+        RoaringContainer added = bitmap->containers[bitmap->count - 1];
+        memmove(bitmap->containers + index + 1, bitmap->containers + index,
+                (size_t)(bitmap->count - 1 - index) * sizeof(RoaringContainer));
+        bitmap->containers[index] = added;
+    }
+
+    return container_add(&bitmap->containers[index], (uint16_t)value);
+}
+
+bool roaring_contains(const RoaringBitmap *bitmap, uint32_t value) {
+    int index = roaring_find(bitmap, (uint16_t)(value >> 16));
+    return index >= 0 && container_contains(&bitmap->containers[index], (uint16_t)value);
+}
+
+long roaring_cardinality(const RoaringBitmap *bitmap) {
+    long total = 0;
+    for (int i = 0; i < bitmap->count; i++) {
+        total += bitmap->containers[i].cardinality;
+    }
+    return total;
+}
+
+uint32_t roaring_minimum(const RoaringBitmap *bitmap) {
+    const RoaringContainer *c = &bitmap->containers[0];
+    uint32_t high = (uint32_t)c->key << 16;
+
+    switch (c->type) {
+        case ROARING_ARRAY:
+            return high | c->data.array[0];
+        case ROARING_RUN:
+            return high | c->data.runs[0].start;
+        case ROARING_BITMAP:
+            for (int w = 0; w < ROARING_BITMAP_WORDS; w++) {
+                if (c->data.words[w]) {
+                    return high | (uint32_t)(w * 64 + __builtin_ctzll(c->data.words[w]));
+                }
+            }
+    }
+    return high;
+}
+
+bool roaring_and(const RoaringBitmap *x, const RoaringBitmap *y, RoaringBitmap *out) {
+    roaring_init(out);
+
+    int i = 0, j = 0;
+    while (i < x->count && j < y->count) {
+        const RoaringContainer *a = &x->containers[i];
+        const RoaringContainer *b = &y->containers[j];
+        if (a->key < b->key) {
+            i++;
+        } else if (a->key > b->key) {
+            j++;
+        } else {
+            RoaringContainer c;
+            if (!container_apply(a, b, &c, container_and)) {
+                roaring_free(out);
+                return false;
+            }
+            if (c.cardinality == 0) {
+                container_free(&c);
+            } else if (!roaring_push(out, &c)) {
+                container_free(&c);
+                roaring_free(out);
+                return false;
+            }
+            i++;
+            j++;
+        }
+    }
+    return true;
+}
+
+bool roaring_or(const RoaringBitmap *x, const RoaringBitmap *y, RoaringBitmap *out) {
+    roaring_init(out);
+
+    int i = 0, j = 0;
+    while (i < x->count || j < y->count) {
+        RoaringContainer c;
+        bool ok;
+        if (j == y->count || (i < x->count && x->containers[i].key < y->containers[j].key)) {
+            ok = container_clone(&x->containers[i++], &c);
+        } else if (i == x->count || y->containers[j].key < x->containers[i].key) {
+            ok = container_clone(&y->containers[j++], &c);
+        } else {
+            ok = container_apply(&x->containers[i++], &y->containers[j++], &c, container_or);
+        }
+
+        if (!ok || !roaring_push(out, &c)) {
+            if (ok) container_free(&c);
+            roaring_free(out);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int container_count_runs(const RoaringContainer *c) {
+    int runs = 0;
+    if (c->type == ROARING_ARRAY) {
+        for (int i = 0; i < c->size; i++) {
+            if (i == 0 || c->data.array[i] != c->data.array[i - 1] + 1) runs++;
+        }
+    } else if (c->type == ROARING_BITMAP) {
+        for (int w = 0; w < ROARING_BITMAP_WORDS; w++) {
+            uint64_t word = c->data.words[w];
+            uint64_t carry = w > 0 ? c->data.words[w - 1] >> 63 : 0;
+            /* A run starts at each set bit whose predecessor is clear */
+            runs += __builtin_popcountll(word & ~((word << 1) | carry));
+        }
+    } else {
+        runs = c->size;
+    }
+    return runs;
+}
+
+bool roaring_run_optimize(RoaringBitmap *bitmap) {
+    for (int i = 0; i < bitmap->count; i++) {
+        RoaringContainer *c = &bitmap->containers[i];
+        if (c->type == ROARING_RUN) continue;
+
+        int runs = container_count_runs(c);
+        size_t run_bytes = (size_t)runs * sizeof(RoaringRun);
+        size_t current = c->type == ROARING_ARRAY
+            ? (size_t)c->cardinality * sizeof(uint16_t)
+            : ROARING_BITMAP_WORDS * sizeof(uint64_t);
+        if (run_bytes >= current) continue;
+
+        RoaringRun *out = malloc((size_t)runs * sizeof(RoaringRun));
+        if (!out) return false;
+
+        int n = -1;
+        uint32_t prev = 0;
+        RoaringIterator it;
+        RoaringBitmap single = {c, 1, 1};
+        uint32_t value;
+        roaring_iterator_init(&it, &single);
+        while (roaring_iterator_next(&it, &value)) {
+            uint16_t low = (uint16_t)value;
+            if (n >= 0 && low == prev + 1) {
+                out[n].length++;
+            } else {
+                out[++n].start = low;
+                out[n].length = 0;
+            }
+            prev = low;
+        }
+
+        container_free(c);
+        c->type = ROARING_RUN;
+        c->size = runs;
+        c->capacity = runs;
+        c->data.runs = out;
+    }
+    return true;
+}
+
+size_t roaring_size_bytes(const RoaringBitmap *bitmap) {
+    size_t bytes = (size_t)bitmap->capacity * sizeof(RoaringContainer);
+    for (int i = 0; i < bitmap->count; i++) {
+        const RoaringContainer *c = &bitmap->containers[i];
+        switch (c->type) {
+            case ROARING_ARRAY: bytes += (size_t)c->capacity * sizeof(uint16_t); break;
+            case ROARING_BITMAP: bytes += ROARING_BITMAP_WORDS * sizeof(uint64_t); break;
+            case ROARING_RUN: bytes += (size_t)c->capacity * sizeof(RoaringRun); break;
+        }
+    }
+    return bytes;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Iterator Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+void roaring_iterator_init(RoaringIterator *it, const RoaringBitmap *bitmap) {
+    it->bitmap = bitmap;
+    it->container = 0;
+    it->position = 0;
+    it->offset = 0;
+}
+
+bool roaring_iterator_next(RoaringIterator *it, uint32_t *value) {
+    while (it->container < it->bitmap->count) {
+        const RoaringContainer *c = &it->bitmap->containers[it->container];
+        uint32_t high = (uint32_t)c->key << 16;
+
+        switch (c->type) {
+            case ROARING_ARRAY:
+                if (it->position < c->size) {
+                    *value = high | c->data.array[it->position++];
+                    return true;
+                }
+                break;
+
+            case ROARING_BITMAP:
+                while (it->position < ROARING_BITMAP_WORDS * 64) {
+                    int w = it->position >> 6;
+                    uint64_t word = c->data.words[w] >> (it->position & 63);
+                    if (word) {
+                        it->position += __builtin_ctzll(word);
+                        *value = high | (uint32_t)it->position++;
+                        return true;
+                    }
+                    it->position = (w + 1) * 64;
+                }
+                break;
+
+            case ROARING_RUN:
+                if (it->position < c->size) {
+                    const RoaringRun *run = &c->data.runs[it->position];
+                    *value = high | (uint32_t)(run->start + it->offset);
+                    if (it->offset++ == run->length) {
+                        it->position++;
+                        it->offset = 0;
+                    }
+                    return true;
+                }
+                break;
+        }
+
+        it->container++;
+        it->position = 0;
+        it->offset = 0;
+    }
+    return false;
+}
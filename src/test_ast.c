@@ -459,6 +459,30 @@ static bool test_ast_clone_rule() {
     return true;
 }
 
+static bool test_ast_clone_where() {
+    ASTNode *cond = ast_make_condition(OP_NE, ast_make_expr_var(2, 1, 8),
+                                       ast_make_expr_string("alice", 1, 14), 1, 1);
+    ASTNode *where = ast_make_where(cond, 1, 1);
+    
+    ASTNode *clone = ast_clone(where);
+    
+    ASSERT_NOT_NULL(clone);
+    ASSERT_EQ(clone->type, AST_WHERE);
+    ASSERT_STR_EQ(ast_node_type_name(clone->type), "WHERE");
+    
+    ASTNode *clone_cond = clone->data.where.condition;
+    ASSERT(clone_cond != cond);
+    ASSERT_EQ(clone_cond->data.condition.op, OP_NE);
+    ASSERT_EQ(clone_cond->data.condition.left->data.expr.var_num, 2);
+    ASSERT(clone_cond->data.condition.right->data.expr.string_val !=
+           cond->data.condition.right->data.expr.string_val);
+    ASSERT_STR_EQ(clone_cond->data.condition.right->data.expr.string_val, "alice");
+    
+    ast_free_tree(where);
+    ast_free_tree(clone);
+    return true;
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * AST Visitor Tests
  * ───────────────────────────────────────────────────────────────────────── */
@@ -684,6 +708,7 @@ int main() {
     TEST(ast_clone);
     TEST(ast_clone_list);
     TEST(ast_clone_rule);
+    TEST(ast_clone_where);
     printf("\n");
     
     /* Visitor pattern tests */
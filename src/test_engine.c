@@ -0,0 +1,3121 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * test_engine.c - Unit Tests for ByteLog Execution Engine
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Tests for fixpoint evaluation, join strategies and query answering.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "engine.h"
+#include "join.h"
+#include "closure.h"
+#include "epoch.h"
+#include "factfile.h"
+#include "factlog.h"
+#include "factset.h"
+#include "parallel.h"
+#include "relmem.h"
+#include "roaring.h"
+#include "unionfind.h"
+#include "parser.h"
+#include "querycache.h"
+#include "ast.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Test Framework
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static int test_count = 0;
+static int test_passed = 0;
+
+#define TEST(name) \
+    do { \
+        test_count++; \
+        printf("Test %d: %s ... ", test_count, #name); \
+        if (test_##name()) { \
+            test_passed++; \
+            printf("PASS\n"); \
+        } else { \
+            printf("FAIL\n"); \
+        } \
+    } while(0)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("ASSERTION FAILED: %s\n", #condition); \
+            return false; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(actual, expected) \
+    do { \
+        if ((actual) != (expected)) { \
+            printf("ASSERTION FAILED: %s != %s (got %d, expected %d)\n", \
+                   #actual, #expected, (int)(actual), (int)(expected)); \
+            return false; \
+        } \
+    } while(0)
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Helper Functions
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Count facts of a relation matching a pattern (wildcards = -1) */
+static int count_facts(ExecutionEngine *engine, const char *relation, int a, int b) {
+    QueryResult *results = factdb_query(&engine->facts, relation, a, b);
+    int count = query_result_count(results);
+    query_result_free(results);
+    return count;
+}
+
+/* Parse and run a program with the given join strategy */
+static ExecutionEngine* run_program(const char *source, JoinStrategy strategy) {
+    char error_buf[512];
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    if (!ast) {
+        printf("Parse failed: %s\n", error_buf);
+        return NULL;
+    }
+
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    engine_set_join_strategy(engine, strategy);
+    if (!engine_execute_program(engine, ast) || engine_has_errors(engine)) {
+        printf("Execution failed: %s\n", engine_get_error(engine));
+    }
+
+    ast_free_tree(ast);
+    return engine;
+}
+
+static int count_facts_db(FactDatabase *db, const char *relation, int a, int b) {
+    QueryResult *results = factdb_query(db, relation, a, b);
+    int count = query_result_count(results);
+    query_result_free(results);
+    return count;
+}
+
+static void free_engine(ExecutionEngine *engine) {
+    engine_cleanup(engine);
+    free(engine);
+}
+
+/* Build a FACT program for a pseudo-random directed graph */
+static char* random_graph_program(int nodes, int edges, unsigned int seed, const char *rules) {
+    size_t capacity = (size_t)edges * 32 + strlen(rules) + 64;
+    char *source = malloc(capacity);
+    size_t len = 0;
+
+    len += snprintf(source + len, capacity - len, "REL edge\n");
+    for (int i = 0; i < edges; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int a = (int)((seed >> 8) % (unsigned int)nodes);
+        seed = seed * 1103515245u + 12345u;
+        int b = (int)((seed >> 8) % (unsigned int)nodes);
+        len += snprintf(source + len, capacity - len, "FACT edge %d %d\n", a, b);
+    }
+    snprintf(source + len, capacity - len, "%s\nSOLVE\n", rules);
+    return source;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Basic Evaluation Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_facts_loaded() {
+    ExecutionEngine *engine = run_program(
+        "REL parent\n"
+        "FACT parent alice bob\n"
+        "FACT parent alice charlie\n"
+        "FACT parent alice bob\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+
+    ASSERT_EQ(factdb_count(&engine->facts), 2);
+    ASSERT_EQ(count_facts(engine, "parent", -1, -1), 2);
+
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Multi-way Join Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_join_query_compile_cyclic() {
+    char error_buf[256];
+    ASTNode *ast = parse_string(
+        "RULE tri: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $0, EMIT tri $0 $1",
+        error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    JoinQuery query;
+    AtomTable atoms;
+    atom_table_init(&atoms);
+    ASSERT(join_rule_needs_query(ast->data.program.statements));
+    ASSERT(join_query_compile(&query, ast->data.program.statements, &atoms,
+                              error_buf, sizeof(error_buf)));
+    ASSERT_EQ(query.atom_count, 3);
+    ASSERT_EQ(query.var_count, 3);
+    ASSERT(query.cyclic);
+    ASSERT(!query.atoms[1].closes);
+    ASSERT(query.atoms[2].closes);
+
+    join_query_free(&query);
+    atom_table_free(&atoms);
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_join_query_compile_unbound() {
+    char error_buf[256];
+    ASTNode *ast = parse_string(
+        "RULE bad: SCAN edge, JOIN edge $5 $2, EMIT bad $0 $2",
+        error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    JoinQuery query;
+    AtomTable atoms;
+    atom_table_init(&atoms);
+    ASSERT(!join_query_compile(&query, ast->data.program.statements, &atoms,
+                               error_buf, sizeof(error_buf)));
+    ASSERT(strstr(error_buf, "unbound join variable") != NULL);
+
+    atom_table_free(&atoms);
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_join_query_slots() {
+    char error_buf[256];
+    ASTNode *ast = parse_string(
+        "RULE far: SCAN edge, JOIN edge $1 $40, JOIN edge $40 $7, EMIT far $0 $7",
+        error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    /* Slots are dense and follow binding order, whatever the numbers */
+    JoinQuery query;
+    AtomTable atoms;
+    atom_table_init(&atoms);
+    ASSERT(join_query_compile(&query, ast->data.program.statements, &atoms,
+                              error_buf, sizeof(error_buf)));
+    ASSERT_EQ(query.var_count, 4);
+    ASSERT_EQ(query.vars[2], 40);
+    ASSERT_EQ(query.vars[3], 7);
+    ASSERT_EQ(query.atoms[1].slot_a, 1);
+    ASSERT_EQ(query.atoms[1].slot_b, 2);
+    ASSERT_EQ(query.atoms[2].slot_a, 2);
+    ASSERT_EQ(query.atoms[2].slot_b, 3);
+    ASSERT_EQ(query.emit_a, 0);
+    ASSERT_EQ(query.emit_b, 3);
+
+    join_query_free(&query);
+    atom_table_free(&atoms);
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_long_chain_rule() {
+    /* Chain 0 -> 1 -> ... -> 30, one rule walking 20 edges */
+    char source[4096];
+    size_t len = 0;
+    len += snprintf(source + len, sizeof(source) - len, "REL edge\n");
+    for (int i = 0; i < 30; i++) {
+        len += snprintf(source + len, sizeof(source) - len, "FACT edge %d %d\n", i, i + 1);
+    }
+    len += snprintf(source + len, sizeof(source) - len, "RULE p20: SCAN edge");
+    for (int v = 1; v < 20; v++) {
+        len += snprintf(source + len, sizeof(source) - len, ", JOIN edge $%d $%d", v, v + 1);
+    }
+    snprintf(source + len, sizeof(source) - len, ", EMIT p20 $0 $20\nSOLVE\n");
+
+    ExecutionEngine *leapfrog = run_program(source, JOIN_STRATEGY_LEAPFROG);
+    ExecutionEngine *pipelined = run_program(source, JOIN_STRATEGY_PAIRWISE);
+    ASSERT(leapfrog != NULL && pipelined != NULL);
+    ASSERT(!engine_has_errors(leapfrog) && !engine_has_errors(pipelined));
+
+    ASSERT_EQ(count_facts(pipelined, "p20", -1, -1), 11);
+    ASSERT_EQ(count_facts(pipelined, "p20", 10, 30), 1);
+    ASSERT_EQ(count_facts(leapfrog, "p20", -1, -1), 11);
+
+    free_engine(leapfrog);
+    free_engine(pipelined);
+    return true;
+}
+
+static bool test_triangle_rule() {
+    /* Triangle 0-1-2 plus a dangling path 2-3-4 */
+    ExecutionEngine *engine = run_program(
+        "REL edge\n"
+        "FACT edge 0 1\n"
+        "FACT edge 1 2\n"
+        "FACT edge 2 0\n"
+        "FACT edge 2 3\n"
+        "FACT edge 3 4\n"
+        "RULE tri: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $0, EMIT tri $0 $1\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+    ASSERT(!engine_has_errors(engine));
+
+    /* Each rotation of the triangle is found once */
+    ASSERT_EQ(count_facts(engine, "tri", -1, -1), 3);
+    ASSERT_EQ(count_facts(engine, "tri", 0, 1), 1);
+    ASSERT_EQ(count_facts(engine, "tri", 2, 3), 0);
+
+    free_engine(engine);
+    return true;
+}
+
+static bool test_explicit_bind_chain() {
+    ExecutionEngine *engine = run_program(
+        "REL edge\n"
+        "FACT edge 0 1\n"
+        "FACT edge 1 2\n"
+        "FACT edge 2 3\n"
+        "FACT edge 1 5\n"
+        "RULE path3: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $3, EMIT path3 $0 $3\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+
+    ASSERT_EQ(count_facts(engine, "path3", -1, -1), 1);
+    ASSERT_EQ(count_facts(engine, "path3", 0, 3), 1);
+
+    free_engine(engine);
+    return true;
+}
+
+static bool test_strategies_agree() {
+    const char *rules =
+        "RULE tri: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $0, EMIT tri $0 $1\n"
+        "RULE sq: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $3, JOIN edge $3 $0, EMIT sq $0 $2\n";
+    char *source = random_graph_program(40, 300, 7, rules);
+
+    ExecutionEngine *leapfrog = run_program(source, JOIN_STRATEGY_LEAPFROG);
+    ExecutionEngine *pairwise = run_program(source, JOIN_STRATEGY_PAIRWISE);
+    free(source);
+    ASSERT(leapfrog != NULL && pairwise != NULL);
+
+    int tri = count_facts(leapfrog, "tri", -1, -1);
+    ASSERT(tri > 0);
+    ASSERT_EQ(count_facts(pairwise, "tri", -1, -1), tri);
+    ASSERT_EQ(count_facts(pairwise, "sq", -1, -1), count_facts(leapfrog, "sq", -1, -1));
+    ASSERT_EQ(factdb_count(&pairwise->facts), factdb_count(&leapfrog->facts));
+
+    free_engine(leapfrog);
+    free_engine(pairwise);
+    return true;
+}
+
+static bool count_frame(const int *frame, void *context) {
+    (void)frame;
+    (*(long *)context)++;
+    return true;
+}
+
+static bool test_leapfrog_fewer_intermediates() {
+    char error_buf[256];
+    char *source = random_graph_program(30, 400, 11,
+        "RULE tri: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $0, EMIT tri $0 $1\n");
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    free(source);
+    ASSERT(ast != NULL);
+
+    ExecutionEngine engine;
+    engine_init(&engine);
+    const ASTNode *rule = NULL;
+    for (ASTNode *stmt = ast->data.program.statements; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_FACT) engine_execute_statement(&engine, stmt);
+        if (stmt->type == AST_RULE) rule = stmt;
+    }
+
+    JoinQuery query;
+    ASSERT(rule != NULL);
+    ASSERT(join_query_compile(&query, rule, &engine.atoms, error_buf, sizeof(error_buf)));
+
+    JoinStats leapfrog = {0, 0};
+    JoinStats pairwise = {0, 0};
+    long leapfrog_frames = 0;
+    long pairwise_frames = 0;
+    ASSERT(join_query_run(&query, &engine.facts, JOIN_STRATEGY_LEAPFROG,
+                          count_frame, &leapfrog_frames, &leapfrog));
+    ASSERT(join_query_run(&query, &engine.facts, JOIN_STRATEGY_PAIRWISE,
+                          count_frame, &pairwise_frames, &pairwise));
+
+    ASSERT(leapfrog_frames > 0);
+    ASSERT_EQ(leapfrog_frames, pairwise_frames);
+    ASSERT_EQ(leapfrog.results, pairwise.results);
+    ASSERT(leapfrog.intermediate < pairwise.intermediate);
+
+    join_query_free(&query);
+    engine_cleanup(&engine);
+    ast_free_tree(ast);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Relation Storage Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Chain 0 -> 1 -> ... -> 20 and its transitive closure (legacy rules) */
+#define CHAIN_CLOSURE_RULES \
+    "RULE reach: SCAN edge, EMIT reach $1 $2\n" \
+    "RULE reach: SCAN reach, JOIN edge $2, EMIT reach $1 $2\n" \
+    "SOLVE\n"
+
+static char* chain_program(const char *declaration) {
+    char *source = malloc(4096);
+    size_t len = snprintf(source, 4096, "%s\n", declaration);
+    for (int i = 0; i < 20; i++) {
+        len += snprintf(source + len, 4096 - len, "FACT edge %d %d\n", i, i + 1);
+    }
+    snprintf(source + len, 4096 - len, "%s", CHAIN_CLOSURE_RULES);
+    return source;
+}
+
+static bool test_sorted_relation_queries() {
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, true));
+
+    int facts[][2] = {{3, 1}, {1, 2}, {1, 9}, {-4, 7}, {3, 1}, {2, 2}, {1, 5}};
+    for (size_t i = 0; i < sizeof(facts) / sizeof(facts[0]); i++) {
+        ASSERT(factdb_add_fact(&db, "edge", facts[i][0], facts[i][1]));
+    }
+
+    /* Pending inserts become visible once merged */
+    ASSERT_EQ(factdb_merge(&db), 6);
+    ASSERT_EQ(factdb_count(&db), 6);
+    ASSERT(factdb_has_fact(&db, "edge", -4, 7));
+    ASSERT(!factdb_has_fact(&db, "edge", 1, 3));
+
+    QueryResult *results = factdb_query(&db, "edge", 1, -1);
+    ASSERT_EQ(query_result_count(results), 3);
+    ASSERT_EQ(results->arg_b, 2);
+    ASSERT_EQ(results->next->arg_b, 5);
+    ASSERT_EQ(results->next->next->arg_b, 9);
+    query_result_free(results);
+
+    results = factdb_query(&db, "edge", -1, 2);
+    ASSERT_EQ(query_result_count(results), 2);
+    query_result_free(results);
+
+    /* Scans come back in (arg_a, arg_b) order */
+    FactPair *tuples = NULL;
+    int count = factdb_export(&db, "edge", &tuples);
+    ASSERT(tuples != NULL);
+    ASSERT_EQ(count, 6);
+    ASSERT_EQ(tuples[0].arg_a, -4);
+    for (int i = 1; i < count; i++) {
+        ASSERT(tuples[i - 1].arg_a < tuples[i].arg_a ||
+               (tuples[i - 1].arg_a == tuples[i].arg_a && tuples[i - 1].arg_b < tuples[i].arg_b));
+    }
+    free(tuples);
+
+    /* Duplicates of merged tuples are rejected up front */
+    ASSERT_EQ(factdb_insert(&db, "edge", 1, 5), 0);
+    ASSERT_EQ(factdb_insert(&db, "edge", 8, 8), 1);
+    ASSERT_EQ(factdb_count(&db), 6);
+    ASSERT_EQ(count_facts_db(&db, "edge", 8, 8), 1);
+    ASSERT_EQ(factdb_count(&db), 7);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_sorted_pending_duplicates() {
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, true));
+
+    /* A pair still pending is already present */
+    ASSERT_EQ(factdb_insert(&db, "edge", 5, 6), 1);
+    uint64_t version = factdb_relation_version(&db, "edge");
+    ASSERT_EQ(factdb_insert(&db, "edge", 5, 6), 0);
+    ASSERT(factdb_relation_version(&db, "edge") == version);
+
+    FactPair pairs[] = {{5, 6}, {7, 8}, {7, 8}, {9, 9}};
+    int inserted[4];
+    ASSERT_EQ(factdb_insert_batch(&db, "edge", pairs, 4, inserted), 2);
+    ASSERT_EQ(inserted[0], 0);
+    ASSERT_EQ(inserted[1], 1);
+    ASSERT_EQ(inserted[2], 0);
+    ASSERT_EQ(inserted[3], 1);
+
+    /* Bulk loaded pairs are checked once a single insert needs them */
+    FactPair bulk[] = {{1, 1}, {1, 2}, {1, 1}};
+    ASSERT(factdb_bulk_load(&db, "edge", bulk, 3));
+    ASSERT_EQ(factdb_insert(&db, "edge", 1, 2), 0);
+    ASSERT_EQ(factdb_insert(&db, "edge", 1, 3), 1);
+
+    /* Merging empties the pending set */
+    ASSERT_EQ(factdb_merge(&db), 6);
+    ASSERT_EQ(factdb_insert(&db, "edge", 5, 6), 0);
+    ASSERT_EQ(factdb_insert(&db, "edge", 6, 5), 1);
+    ASSERT_EQ(factdb_merge(&db), 1);
+    ASSERT_EQ(factdb_count(&db), 7);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_storage_conversion() {
+    FactDatabase db;
+    factdb_init(&db);
+    for (int i = 0; i < 50; i++) {
+        ASSERT(factdb_add_fact(&db, "edge", i % 7, i));
+        ASSERT(factdb_add_fact(&db, "other", i, i));
+    }
+    ASSERT_EQ(factdb_count(&db), 100);
+
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, false));
+    ASSERT_EQ(factdb_get_storage(&db, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_count(&db), 100);
+    ASSERT_EQ(count_facts_db(&db, "edge", 3, -1), 7);
+    ASSERT_EQ(count_facts_db(&db, "other", -1, -1), 50);
+
+    /* Declared layouts win over adaptive requests */
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_HASH, true));
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, false));
+    ASSERT_EQ(factdb_get_storage(&db, "edge"), RELATION_STORAGE_HASH);
+    ASSERT_EQ(factdb_count(&db), 100);
+    ASSERT_EQ(count_facts_db(&db, "edge", 3, -1), 7);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_adaptive_storage() {
+    char *source = chain_program("REL edge");
+    ExecutionEngine *engine = run_program(source, JOIN_STRATEGY_AUTO);
+    free(source);
+    ASSERT(engine != NULL);
+
+    /* edge is probed by JOIN, reach is only scanned */
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "reach"), RELATION_STORAGE_HASH);
+    ASSERT_EQ(count_facts(engine, "reach", -1, -1), 210);
+    ASSERT_EQ(count_facts(engine, "reach", 0, 20), 1);
+
+    free_engine(engine);
+    return true;
+}
+
+static bool test_storage_modes_agree() {
+    const char *declarations[] = {"REL edge HASH", "REL edge SORTED\nREL reach sorted"};
+
+    for (int i = 0; i < 2; i++) {
+        char *source = chain_program(declarations[i]);
+        ExecutionEngine *engine = run_program(source, JOIN_STRATEGY_AUTO);
+        free(source);
+        ASSERT(engine != NULL);
+        ASSERT(!engine_has_errors(engine));
+
+        ASSERT_EQ(factdb_get_storage(&engine->facts, "edge"),
+                  i == 0 ? RELATION_STORAGE_HASH : RELATION_STORAGE_SORTED);
+        ASSERT_EQ(count_facts(engine, "reach", -1, -1), 210);
+        ASSERT_EQ(factdb_count(&engine->facts), 230);
+        free_engine(engine);
+    }
+
+    /* Recursive explicit-bind rule reading and writing a sorted relation */
+    ExecutionEngine *engine = run_program(
+        "REL edge SORTED\n"
+        "REL tc SORTED\n"
+        "FACT edge 0 1\n"
+        "FACT edge 1 2\n"
+        "FACT edge 2 3\n"
+        "FACT edge 3 1\n"
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN edge $1 $2, EMIT tc $0 $2\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+    ASSERT_EQ(count_facts(engine, "tc", -1, -1), 12);
+    ASSERT_EQ(count_facts(engine, "tc", 0, -1), 3);
+
+    free_engine(engine);
+    return true;
+}
+
+static bool test_parallel_radix_sort() {
+    size_t count = PARALLEL_MIN_ITEMS * 3 + 17;
+    uint64_t *keys = malloc(count * sizeof(uint64_t));
+    ASSERT(keys != NULL);
+
+    unsigned int seed = 99;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int a = (int)(seed >> 4) - (1 << 26);
+        seed = seed * 1103515245u + 12345u;
+        keys[i] = parallel_pack_pair(a % 1000, (int)(seed >> 20) - 2048);
+    }
+
+    /* The serial sort agrees with the parallel one */
+    uint64_t *serial = malloc(count * sizeof(uint64_t));
+    ASSERT(serial != NULL);
+    memcpy(serial, keys, count * sizeof(uint64_t));
+
+    parallel_set_thread_count(4);
+    bool ok = parallel_radix_sort(keys, count);
+    parallel_set_thread_count(0);
+    ASSERT(ok);
+    ASSERT(parallel_radix_sort_serial(serial, count));
+    ASSERT(memcmp(serial, keys, count * sizeof(uint64_t)) == 0);
+    free(serial);
+
+    for (size_t i = 1; i < count; i++) {
+        int a0 = parallel_unpack_a(keys[i - 1]), a1 = parallel_unpack_a(keys[i]);
+        int b0 = parallel_unpack_b(keys[i - 1]), b1 = parallel_unpack_b(keys[i]);
+        ASSERT(a0 < a1 || (a0 == a1 && b0 <= b1));
+    }
+
+    size_t unique = parallel_unique(keys, count);
+    ASSERT(unique <= count);
+    for (size_t i = 1; i < unique; i++) {
+        ASSERT(keys[i - 1] < keys[i]);
+    }
+
+    free(keys);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Posting List Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_roaring_bitmap() {
+    RoaringBitmap evens, threes;
+    roaring_init(&evens);
+    roaring_init(&threes);
+
+    /* 5000 values in one chunk forces an array -> bitmap conversion */
+    for (int i = -10000; i < 10000; i += 2) {
+        ASSERT(roaring_add(&evens, roaring_encode(i)));
+    }
+    for (int i = -9999; i < 10000; i += 3) {
+        ASSERT(roaring_add(&threes, roaring_encode(i)));
+    }
+    ASSERT(roaring_add(&evens, roaring_encode(0)));
+    ASSERT_EQ(roaring_cardinality(&evens), 10000);
+    ASSERT(roaring_contains(&evens, roaring_encode(-10000)));
+    ASSERT(!roaring_contains(&evens, roaring_encode(3)));
+    ASSERT_EQ(roaring_decode(roaring_minimum(&evens)), -10000);
+
+    RoaringBitmap both, either;
+    ASSERT(roaring_and(&evens, &threes, &both));
+    ASSERT(roaring_or(&evens, &threes, &either));
+    ASSERT_EQ(roaring_cardinality(&both), 3333);
+    ASSERT_EQ(roaring_cardinality(&either), 10000 + 6667 - 3333);
+
+    /* Iteration is ascending in decoded order */
+    RoaringIterator it;
+    uint32_t value;
+    int previous = INT32_MIN;
+    long seen = 0;
+    roaring_iterator_init(&it, &both);
+    while (roaring_iterator_next(&it, &value)) {
+        int decoded = roaring_decode(value);
+        ASSERT(decoded > previous);
+        ASSERT(decoded % 6 == 0);
+        previous = decoded;
+        seen++;
+    }
+    ASSERT_EQ(seen, 3333);
+
+    /* Consecutive ranges shrink to runs and stay queryable */
+    RoaringBitmap range;
+    roaring_init(&range);
+    for (int i = 100; i < 30000; i++) {
+        ASSERT(roaring_add(&range, roaring_encode(i)));
+    }
+    size_t before = roaring_size_bytes(&range);
+    ASSERT(roaring_run_optimize(&range));
+    ASSERT(roaring_size_bytes(&range) < before / 10);
+    ASSERT_EQ(roaring_cardinality(&range), 29900);
+    ASSERT(roaring_contains(&range, roaring_encode(29999)));
+    ASSERT(!roaring_contains(&range, roaring_encode(30000)));
+
+    RoaringBitmap clipped;
+    ASSERT(roaring_and(&range, &evens, &clipped));
+    ASSERT_EQ(roaring_cardinality(&clipped), 4950);
+
+    roaring_free(&evens);
+    roaring_free(&threes);
+    roaring_free(&both);
+    roaring_free(&either);
+    roaring_free(&range);
+    roaring_free(&clipped);
+    return true;
+}
+
+static Relation* find_relation(FactDatabase *db, const char *name) {
+    for (int i = 0; i < RELATION_TABLE_SIZE; i++) {
+        for (Relation *rel = db->relations[i]; rel; rel = rel->next) {
+            if (strcmp(rel->name, name) == 0) return rel;
+        }
+    }
+    return NULL;
+}
+
+static bool test_posting_promotion() {
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_set_storage(&db, "edge", RELATION_STORAGE_SORTED, true));
+
+    /* Key 7 is a hub well above the degree threshold */
+    int hub_degree = ROARING_DEGREE_THRESHOLD * 3;
+    for (int b = 0; b < hub_degree; b++) {
+        ASSERT(factdb_add_fact(&db, "edge", 7, b));
+    }
+    ASSERT(factdb_add_fact(&db, "edge", 3, 5));
+    ASSERT(factdb_add_fact(&db, "edge", 9, 5));
+    ASSERT_EQ(factdb_merge(&db), hub_degree + 2);
+
+    Relation *rel = find_relation(&db, "edge");
+    ASSERT(rel != NULL);
+    ASSERT_EQ(rel->posting_count, 1);
+    ASSERT_EQ(rel->count, 2);
+    ASSERT_EQ(rel->posted, hub_degree);
+    ASSERT(roaring_size_bytes(&rel->postings[0].values) <
+           (size_t)hub_degree * sizeof(FactPair) / 10);
+
+    ASSERT_EQ(factdb_count(&db), hub_degree + 2);
+    ASSERT(factdb_has_fact(&db, "edge", 7, 0));
+    ASSERT(factdb_has_fact(&db, "edge", 7, hub_degree - 1));
+    ASSERT(!factdb_has_fact(&db, "edge", 7, hub_degree));
+    ASSERT_EQ(count_facts_db(&db, "edge", 7, -1), hub_degree);
+    ASSERT_EQ(count_facts_db(&db, "edge", -1, 5), 3);
+    ASSERT_EQ(count_facts_db(&db, "edge", -1, -1), hub_degree + 2);
+
+    /* Later inserts for the hub go through the OR kernel */
+    ASSERT_EQ(factdb_insert(&db, "edge", 7, 12), 0);
+    ASSERT_EQ(factdb_insert(&db, "edge", 7, -1), 1);
+    ASSERT_EQ(factdb_insert(&db, "edge", 8, 1), 1);
+    ASSERT_EQ(factdb_merge(&db), 2);
+    ASSERT_EQ(rel->posting_count, 1);
+    ASSERT_EQ(count_facts_db(&db, "edge", 7, -1), hub_degree + 1);
+
+    /* Exports interleave array and posting tuples in order */
+    FactPair *tuples = NULL;
+    int count = factdb_export(&db, "edge", &tuples);
+    ASSERT_EQ(count, hub_degree + 4);
+    for (int i = 1; i < count; i++) {
+        ASSERT(tuples[i - 1].arg_a < tuples[i].arg_a ||
+               (tuples[i - 1].arg_a == tuples[i].arg_a && tuples[i - 1].arg_b < tuples[i].arg_b));
+    }
+    ASSERT_EQ(tuples[1].arg_a, 7);
+    ASSERT_EQ(tuples[1].arg_b, -1);
+    free(tuples);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+/* Two hubs sharing most neighbours: the leaf intersection runs on bitmaps */
+static bool test_leapfrog_bitmap_intersection() {
+    size_t capacity = 256 * 1024;
+    char *source = malloc(capacity);
+    size_t len = snprintf(source, capacity, "REL edge\n");
+    for (int b = 0; b < 3000; b++) {
+        if (b % 5 != 0) len += snprintf(source + len, capacity - len, "FACT edge 1 %d\n", b);
+        if (b % 3 != 0) len += snprintf(source + len, capacity - len, "FACT edge 2 %d\n", b);
+    }
+    snprintf(source + len, capacity - len,
+        "FACT edge 1 2\n"
+        "RULE common: SCAN edge, JOIN edge $0 $2, JOIN edge $1 $2, EMIT common $0 $1\n"
+        "SOLVE\n");
+
+    ExecutionEngine *leapfrog = run_program(source, JOIN_STRATEGY_LEAPFROG);
+    ExecutionEngine *pairwise = run_program(source, JOIN_STRATEGY_PAIRWISE);
+    free(source);
+    ASSERT(leapfrog != NULL && pairwise != NULL);
+
+    ASSERT(count_facts(leapfrog, "common", 1, 2) == 1);
+    ASSERT_EQ(count_facts(pairwise, "common", -1, -1), count_facts(leapfrog, "common", -1, -1));
+    ASSERT_EQ(factdb_count(&pairwise->facts), factdb_count(&leapfrog->facts));
+
+    free_engine(leapfrog);
+    free_engine(pairwise);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Dense Closure Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool plan_program(ClosurePlan *plan, const char *target, const char *source) {
+    char error_buf[256];
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    if (!ast) return false;
+
+    ASTNode *rules[16];
+    int rule_count = 0;
+    for (ASTNode *stmt = ast->data.program.statements; stmt && rule_count < 16; stmt = stmt->next) {
+        if (stmt->type == AST_RULE) rules[rule_count++] = stmt;
+    }
+
+    bool planned = closure_plan(plan, target, rules, rule_count);
+    ast_free_tree(ast);
+    return planned;
+}
+
+static bool test_closure_plan_shapes() {
+    ClosurePlan plan;
+    ASSERT(plan_program(&plan, "tc",
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN edge $1 $2, EMIT tc $0 $2\n"));
+    ASSERT_EQ(plan.base_count, 1);
+    ASSERT_EQ(plan.right_count, 1);
+    ASSERT_EQ(plan.left_count, 0);
+
+    ASSERT(plan_program(&plan, "tc",
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN edge, JOIN tc $1 $2, EMIT tc $0 $2\n"));
+    ASSERT_EQ(plan.left_count, 1);
+
+    ASSERT(plan_program(&plan, "tc",
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN tc $1 $2, EMIT tc $0 $2\n"));
+    ASSERT(plan.nonlinear);
+
+    /* Legacy first-match joins and non-recursive rules are left alone */
+    ASSERT(!plan_program(&plan, "reach",
+        "RULE reach: SCAN edge, EMIT reach $1 $2\n"
+        "RULE reach: SCAN reach, JOIN edge $2, EMIT reach $1 $2\n"));
+    ASSERT(!plan_program(&plan, "copy", "RULE copy: SCAN edge, EMIT copy $1 $2\n"));
+    ASSERT(!plan_program(&plan, "tc",
+        "RULE tc: SCAN tc, JOIN tc $1 $2, EMIT tc $0 $2\n"
+        "RULE tc: SCAN tc, JOIN edge $1 $2, EMIT tc $0 $2\n"));
+    return true;
+}
+
+static ExecutionEngine* run_closure_program(const char *source, int max_domain) {
+    char error_buf[512];
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    if (!ast) {
+        printf("Parse failed: %s\n", error_buf);
+        return NULL;
+    }
+
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    engine_set_closure_domain(engine, max_domain);
+    if (!engine_execute_program(engine, ast) || engine_has_errors(engine)) {
+        printf("Execution failed: %s\n", engine_get_error(engine));
+        engine_cleanup(engine);
+        free(engine);
+        engine = NULL;
+    }
+    ast_free_tree(ast);
+    return engine;
+}
+
+static bool test_dense_closure_agrees() {
+    const char *shapes[] = {
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN edge $1 $2, EMIT tc $0 $2\n",
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN edge, JOIN tc $1 $2, EMIT tc $0 $2\n",
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN tc $1 $2, EMIT tc $0 $2\n",
+    };
+
+    for (int i = 0; i < 3; i++) {
+        char rules[512];
+        snprintf(rules, sizeof(rules), "%s"
+                 "RULE hop2: SCAN tc, JOIN edge $1 $2, EMIT hop2 $0 $2\n", shapes[i]);
+        char *source = random_graph_program(60, 90, 3 + i, rules);
+
+        ExecutionEngine *dense = run_closure_program(source, CLOSURE_DEFAULT_MAX_DOMAIN);
+        ExecutionEngine *iterative = run_closure_program(source, 0);
+        ExecutionEngine *over_budget = run_closure_program(source, 8);
+        free(source);
+        ASSERT(dense != NULL && iterative != NULL && over_budget != NULL);
+
+        int closure = count_facts(iterative, "tc", -1, -1);
+        ASSERT(closure > 90);
+        ASSERT_EQ(count_facts(dense, "tc", -1, -1), closure);
+        ASSERT_EQ(count_facts(over_budget, "tc", -1, -1), closure);
+        ASSERT_EQ(count_facts(dense, "hop2", -1, -1), count_facts(iterative, "hop2", -1, -1));
+        ASSERT_EQ(factdb_count(&dense->facts), factdb_count(&iterative->facts));
+
+        free_engine(dense);
+        free_engine(iterative);
+        free_engine(over_budget);
+    }
+    return true;
+}
+
+static bool test_dense_closure_long_chain() {
+    /* Deeper than the fixpoint loop's iteration cap, plus a cycle 150 -> 100 */
+    size_t capacity = 16 * 1024;
+    char *source = malloc(capacity);
+    size_t len = snprintf(source, capacity, "REL edge\n");
+    for (int i = 0; i < 150; i++) {
+        len += snprintf(source + len, capacity - len, "FACT edge %d %d\n", i, i + 1);
+    }
+    snprintf(source + len, capacity - len,
+        "FACT edge 150 100\n"
+        "RULE tc: SCAN edge, EMIT tc $1 $2\n"
+        "RULE tc: SCAN tc, JOIN edge $1 $2, EMIT tc $0 $2\n"
+        "SOLVE\n");
+
+    ExecutionEngine *engine = run_closure_program(source, CLOSURE_DEFAULT_MAX_DOMAIN);
+    free(source);
+    ASSERT(engine != NULL);
+
+    /* 0..99 reach everything after them; 100..150 reach the whole cycle */
+    ASSERT(factdb_has_fact(&engine->facts, "tc", 0, 150));
+    ASSERT(factdb_has_fact(&engine->facts, "tc", 120, 110));
+    ASSERT(factdb_has_fact(&engine->facts, "tc", 150, 150));
+    ASSERT(!factdb_has_fact(&engine->facts, "tc", 0, 0));
+    ASSERT_EQ(count_facts(engine, "tc", -1, -1), 100 * 150 - 4950 + 51 * 51);
+
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Equivalence Storage Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_unionfind_classes() {
+    UnionFind uf;
+    unionfind_init(&uf);
+
+    ASSERT_EQ(unionfind_union(&uf, 7, 7), 1);
+    ASSERT_EQ(unionfind_union(&uf, 1, 2), 4);
+    ASSERT_EQ(unionfind_union(&uf, 2, 1), 0);
+    ASSERT_EQ(unionfind_union(&uf, 2, 3), 5);
+    ASSERT(unionfind_same(&uf, 1, 3));
+    ASSERT(!unionfind_same(&uf, 1, 7));
+    ASSERT(!unionfind_same(&uf, 1, 99));
+    ASSERT_EQ(unionfind_node(&uf, 99), -1);
+
+    /* A long chain stays one class of n^2 pairs */
+    for (int i = 100; i < 3100; i++) {
+        ASSERT(unionfind_union(&uf, i, i + 1) > 0);
+    }
+    ASSERT(unionfind_same(&uf, 100, 3100));
+    ASSERT(uf.pairs == 1 + 9 + 3001L * 3001L);
+
+    /* Merging classes adds 2 * |A| * |B| pairs */
+    ASSERT(unionfind_union(&uf, -5, 3100) == 2L * 3001L + 1);
+    ASSERT(unionfind_union(&uf, 1, 7) == 2L * 3 * 1);
+
+    unionfind_free(&uf);
+    return true;
+}
+
+static bool test_equivalence_storage() {
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_add_fact(&db, "same", 1, 2));
+    ASSERT(factdb_add_fact(&db, "same", 3, 4));
+    ASSERT_EQ(factdb_count(&db), 2);
+
+    /* Converting closes the existing facts */
+    ASSERT(factdb_set_storage(&db, "same", RELATION_STORAGE_EQUIVALENCE, true));
+    ASSERT_EQ(factdb_get_storage(&db, "same"), RELATION_STORAGE_EQUIVALENCE);
+    ASSERT_EQ(factdb_count(&db), 8);
+    ASSERT(factdb_has_fact(&db, "same", 2, 1));
+    ASSERT(factdb_has_fact(&db, "same", 4, 4));
+    ASSERT(!factdb_has_fact(&db, "same", 1, 3));
+
+    ASSERT_EQ(factdb_insert(&db, "same", 2, 3), 1);
+    ASSERT_EQ(factdb_insert(&db, "same", 4, 1), 0);
+    ASSERT_EQ(factdb_count(&db), 16);
+    ASSERT(factdb_has_fact(&db, "same", 1, 4));
+
+    ASSERT_EQ(count_facts_db(&db, "same", 3, -1), 4);
+    ASSERT_EQ(count_facts_db(&db, "same", -1, 1), 4);
+    ASSERT_EQ(count_facts_db(&db, "same", 1, 4), 1);
+    ASSERT_EQ(count_facts_db(&db, "same", 9, -1), 0);
+    ASSERT_EQ(count_facts_db(&db, "same", -1, -1), 16);
+
+    FactPair *tuples = NULL;
+    ASSERT_EQ(factdb_export(&db, "same", &tuples), 16);
+    free(tuples);
+
+    /* Back to the hash table, every pair is materialized */
+    ASSERT(factdb_set_storage(&db, "same", RELATION_STORAGE_HASH, true));
+    ASSERT_EQ(factdb_count(&db), 16);
+    ASSERT(factdb_has_fact(&db, "same", 4, 2));
+    ASSERT_EQ(count_facts_db(&db, "same", -1, -1), 16);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_equivalence_detection() {
+    const char *rules =
+        "RULE knows: SCAN edge, EMIT knows $1 $2\n"
+        "RULE knows: SCAN knows, EMIT knows $2 $1\n"
+        "RULE knows: SCAN knows, JOIN knows $1 $2, EMIT knows $0 $2\n"
+        "RULE bridge: SCAN knows, JOIN edge $1 $2, EMIT bridge $0 $2\n";
+    char *source = random_graph_program(80, 50, 17, rules);
+    size_t length = strlen(source) + 32;
+    char *declared = malloc(length);
+    snprintf(declared, length, "REL knows HASH\n%s", source);
+
+    ExecutionEngine *classes = run_program(source, JOIN_STRATEGY_AUTO);
+    ExecutionEngine *pairs = run_program(declared, JOIN_STRATEGY_AUTO);
+    free(source);
+    free(declared);
+    ASSERT(classes != NULL && pairs != NULL);
+
+    ASSERT_EQ(factdb_get_storage(&classes->facts, "knows"), RELATION_STORAGE_EQUIVALENCE);
+    ASSERT_EQ(factdb_get_storage(&pairs->facts, "knows"), RELATION_STORAGE_HASH);
+
+    int knows = count_facts(pairs, "knows", -1, -1);
+    ASSERT(knows > 100);
+    ASSERT_EQ(count_facts(classes, "knows", -1, -1), knows);
+    ASSERT_EQ(count_facts(classes, "bridge", -1, -1), count_facts(pairs, "bridge", -1, -1));
+    ASSERT_EQ(factdb_count(&classes->facts), factdb_count(&pairs->facts));
+
+    free_engine(classes);
+    free_engine(pairs);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Symmetric Storage Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Facts physically chained in the hash table for a relation */
+static int stored_facts(const FactDatabase *db, const char *relation) {
+    int count = 0;
+    for (int i = 0; i < FACT_DATABASE_SIZE; i++) {
+        for (const Fact *fact = db->buckets[i]; fact; fact = fact->next) {
+            if (strcmp(fact->relation, relation) == 0) count++;
+        }
+    }
+    return count;
+}
+
+static bool test_symmetric_storage() {
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_add_fact(&db, "road", 5, 2));
+    ASSERT(factdb_add_fact(&db, "road", 2, 5));
+    ASSERT(factdb_add_fact(&db, "road", 3, 3));
+    ASSERT_EQ(factdb_count(&db), 3);
+
+    /* Converting folds (5, 2) and (2, 5) into one stored pair */
+    ASSERT(factdb_set_symmetric(&db, "road"));
+    ASSERT(factdb_is_symmetric(&db, "road"));
+    ASSERT_EQ(stored_facts(&db, "road"), 2);
+    ASSERT_EQ(factdb_count(&db), 3);
+
+    ASSERT_EQ(factdb_insert(&db, "road", 7, 2), 1);
+    ASSERT_EQ(factdb_insert(&db, "road", 2, 7), 0);
+    ASSERT_EQ(stored_facts(&db, "road"), 3);
+    ASSERT_EQ(factdb_count(&db), 5);
+    ASSERT(factdb_has_fact(&db, "road", 2, 7));
+    ASSERT(!factdb_has_fact(&db, "road", 5, 7));
+
+    ASSERT_EQ(count_facts_db(&db, "road", 2, -1), 2);
+    ASSERT_EQ(count_facts_db(&db, "road", -1, 2), 2);
+    ASSERT_EQ(count_facts_db(&db, "road", 3, -1), 1);
+    ASSERT_EQ(count_facts_db(&db, "road", 7, 2), 1);
+    ASSERT_EQ(count_facts_db(&db, "road", -1, -1), 5);
+
+    /* Exports hold both orientations in order */
+    FactPair *tuples = NULL;
+    ASSERT_EQ(factdb_export(&db, "road", &tuples), 5);
+    ASSERT(tuples[0].arg_a == 2 && tuples[0].arg_b == 5);
+    ASSERT(tuples[1].arg_a == 2 && tuples[1].arg_b == 7);
+    ASSERT(tuples[4].arg_a == 7 && tuples[4].arg_b == 2);
+    free(tuples);
+
+    /* Sorted layout, including a key large enough for a posting */
+    ASSERT(factdb_set_storage(&db, "road", RELATION_STORAGE_SORTED, true));
+    ASSERT_EQ(factdb_count(&db), 5);
+    for (int i = 0; i < 2000; i++) {
+        ASSERT(factdb_insert(&db, "road", 1000 + i, 1000) >= 0);
+    }
+    ASSERT(factdb_merge(&db) >= 0);
+    ASSERT_EQ(factdb_count(&db), 5 + 3999);
+    ASSERT_EQ(count_facts_db(&db, "road", -1, 1000), 2000);
+    ASSERT_EQ(count_facts_db(&db, "road", 1500, -1), 1);
+    ASSERT(factdb_has_fact(&db, "road", 1000, 2999));
+
+    ASSERT(factdb_set_storage(&db, "road", RELATION_STORAGE_HASH, true));
+    ASSERT_EQ(factdb_count(&db), 5 + 3999);
+    ASSERT_EQ(stored_facts(&db, "road"), 3 + 2000);
+
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_symmetric_detection() {
+    const char *body =
+        "RULE hop: SCAN edge, JOIN knows $2, EMIT hop $1 $2\n"
+        "RULE bridge: SCAN knows, JOIN edge $1 $2, EMIT bridge $0 $2\n";
+    char rules[512];
+    snprintf(rules, sizeof(rules),
+             "RULE knows: SCAN edge, EMIT knows $1 $2\n"
+             "RULE knows: SCAN knows, EMIT knows $2 $1\n%s", body);
+    char *source = random_graph_program(60, 150, 23, rules);
+
+    /* The same relation built from an explicit reversed copy */
+    snprintf(rules, sizeof(rules),
+             "RULE rev: SCAN edge, EMIT rev $2 $1\n"
+             "RULE knows: SCAN edge, EMIT knows $1 $2\n"
+             "RULE knows: SCAN rev, EMIT knows $1 $2\n%s", body);
+    char *reference = random_graph_program(60, 150, 23, rules);
+
+    ExecutionEngine *symmetric = run_program(source, JOIN_STRATEGY_AUTO);
+    ExecutionEngine *pairs = run_program(reference, JOIN_STRATEGY_AUTO);
+    free(source);
+    free(reference);
+    ASSERT(symmetric != NULL && pairs != NULL);
+
+    ASSERT(factdb_is_symmetric(&symmetric->facts, "knows"));
+    ASSERT(!factdb_is_symmetric(&pairs->facts, "knows"));
+
+    int knows = count_facts(pairs, "knows", -1, -1);
+    ASSERT(knows > 200);
+    ASSERT_EQ(count_facts(symmetric, "knows", -1, -1), knows);
+    ASSERT_EQ(count_facts(symmetric, "hop", -1, -1), count_facts(pairs, "hop", -1, -1));
+    ASSERT_EQ(count_facts(symmetric, "bridge", -1, -1), count_facts(pairs, "bridge", -1, -1));
+
+    /* Each unordered pair is stored once */
+    FactPair *tuples = NULL;
+    int stored = 0;
+    int count = factdb_export(&pairs->facts, "knows", &tuples);
+    for (int i = 0; i < count; i++) {
+        if (tuples[i].arg_a <= tuples[i].arg_b) stored++;
+    }
+    free(tuples);
+    ASSERT_EQ(factdb_get_storage(&symmetric->facts, "knows"), RELATION_STORAGE_SORTED);
+    ASSERT(factdb_set_storage(&symmetric->facts, "knows", RELATION_STORAGE_HASH, true));
+    ASSERT_EQ(stored_facts(&symmetric->facts, "knows"), stored);
+
+    free_engine(symmetric);
+    free_engine(pairs);
+
+    /* Copying a relation in both orientations only makes the copied facts
+     * symmetric, so those rules keep running */
+    ExecutionEngine *mirrored = run_program(
+        "FACT edge 1 2\nFACT edge 3 1\n"
+        "RULE link: SCAN edge, EMIT link $1 $2\n"
+        "RULE link: SCAN edge, EMIT link $2 $1\n"
+        "RULE r: SCAN s, EMIT r $2 $1\n"
+        "RULE s: SCAN r, EMIT s $2 $1\n"
+        "FACT s 1 2\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(mirrored != NULL);
+    ASSERT(!factdb_is_symmetric(&mirrored->facts, "link"));
+    ASSERT(!factdb_is_symmetric(&mirrored->facts, "r"));
+    ASSERT_EQ(count_facts(mirrored, "link", 1, -1), 2);
+    ASSERT_EQ(count_facts(mirrored, "link", -1, -1), 4);
+    ASSERT_EQ(count_facts(mirrored, "r", 2, 1), 1);
+
+    /* A base fact added after solving answers only as given */
+    ASSERT_EQ(factdb_insert(&mirrored->facts, "r", 5, 6), 1);
+    ASSERT_EQ(count_facts(mirrored, "r", 5, 6), 1);
+    ASSERT_EQ(count_facts(mirrored, "r", 6, 5), 0);
+    free_engine(mirrored);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Filter Pushdown Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_where_pushdown_compile() {
+    char error_buf[256];
+    ASTNode *ast = parse_string(
+        "RULE p: SCAN edge, JOIN edge $1 $2, JOIN edge $2 $3, "
+        "WHERE $3 != $0, WHERE 5 > $2, WHERE $0 < $1, EMIT p $0 $3",
+        error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    JoinQuery query;
+    AtomTable atoms;
+    atom_table_init(&atoms);
+    ASSERT(join_rule_needs_query(ast->data.program.statements));
+    ASSERT(join_query_compile(&query, ast->data.program.statements, &atoms,
+                              error_buf, sizeof(error_buf)));
+    ASSERT_EQ(query.filter_count, 3);
+
+    /* Each filter moves to the atom binding its last variable */
+    ASSERT_EQ(query.filters[0].slot, 1);
+    ASSERT_EQ(query.filters[0].atom, 0);
+    ASSERT_EQ(query.filters[0].mask, JOIN_FILTER_LT);
+
+    /* 5 > $2 is mirrored to $2 < 5 */
+    ASSERT_EQ(query.filters[1].slot_a, 2);
+    ASSERT_EQ(query.filters[1].slot_b, -1);
+    ASSERT_EQ(query.filters[1].value, 5);
+    ASSERT_EQ(query.filters[1].mask, JOIN_FILTER_LT);
+    ASSERT_EQ(query.filters[1].atom, 1);
+
+    ASSERT_EQ(query.filters[2].slot, 3);
+    ASSERT_EQ(query.filters[2].atom, 2);
+    ASSERT_EQ(query.filters[2].mask, JOIN_FILTER_LT | JOIN_FILTER_GT);
+    join_query_free(&query);
+    ast_free_tree(ast);
+
+    /* Filters may only read variables the body binds */
+    ast = parse_string("RULE bad: SCAN edge, WHERE $4 = 1, EMIT bad $0 $1",
+                       error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+    ASSERT(!join_query_compile(&query, ast->data.program.statements, &atoms,
+                               error_buf, sizeof(error_buf)));
+    ASSERT(strstr(error_buf, "unbound where variable") != NULL);
+
+    atom_table_free(&atoms);
+    ast_free_tree(ast);
+    return true;
+}
+
+/* Frames of the unfiltered query that the WHERE clauses would keep */
+static bool count_filtered_frame(const int *frame, void *context) {
+    if (frame[0] < frame[1] && frame[2] >= 10) (*(long *)context)++;
+    return true;
+}
+
+static bool test_where_filter_agrees() {
+    char error_buf[256];
+    char *source = random_graph_program(40, 600, 7,
+        "RULE hop: SCAN edge, JOIN edge $1 $2, WHERE $0 < $1, WHERE $2 >= 10, EMIT hop $0 $2\n"
+        "RULE all: SCAN edge, JOIN edge $1 $2, EMIT all $0 $2\n");
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    free(source);
+    ASSERT(ast != NULL);
+
+    ExecutionEngine engine;
+    engine_init(&engine);
+    const ASTNode *rules[2];
+    int rule_count = 0;
+    for (ASTNode *stmt = ast->data.program.statements; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_FACT) engine_execute_statement(&engine, stmt);
+        if (stmt->type == AST_RULE) rules[rule_count++] = stmt;
+    }
+    ASSERT_EQ(rule_count, 2);
+
+    JoinQuery filtered, unfiltered;
+    ASSERT(join_query_compile(&filtered, rules[0], &engine.atoms, error_buf, sizeof(error_buf)));
+    ASSERT(join_query_compile(&unfiltered, rules[1], &engine.atoms, error_buf, sizeof(error_buf)));
+
+    JoinStrategy strategies[] = {JOIN_STRATEGY_PAIRWISE, JOIN_STRATEGY_LEAPFROG};
+    for (int s = 0; s < 2; s++) {
+        JoinStats with = {0, 0};
+        JoinStats without = {0, 0};
+        long kept = 0;
+        long expected = 0;
+        ASSERT(join_query_run(&filtered, &engine.facts, strategies[s],
+                              count_frame, &kept, &with));
+        ASSERT(join_query_run(&unfiltered, &engine.facts, strategies[s],
+                              count_filtered_frame, &expected, &without));
+
+        /* Same answers as filtering afterwards, with fewer partial bindings */
+        ASSERT(expected > 0);
+        ASSERT_EQ(kept, expected);
+        ASSERT(with.intermediate < without.intermediate);
+    }
+
+    join_query_free(&filtered);
+    join_query_free(&unfiltered);
+    engine_cleanup(&engine);
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_where_program() {
+    static const char *program =
+        "FACT parent alice bob\n"
+        "FACT parent alice carol\n"
+        "FACT parent bob dave\n"
+        "FACT parent carol erin\n"
+        "RULE grand: SCAN parent, JOIN parent $1 $2, WHERE $2 != dave, EMIT grand $0 $2\n"
+        "RULE never: SCAN parent, WHERE 1 > 2, EMIT never $0 $1\n"
+        "SOLVE\n";
+
+    JoinStrategy strategies[] = {JOIN_STRATEGY_AUTO, JOIN_STRATEGY_LEAPFROG};
+    for (int s = 0; s < 2; s++) {
+        ExecutionEngine *engine = run_program(program, strategies[s]);
+        ASSERT(engine != NULL);
+        ASSERT(!engine_has_errors(engine));
+
+        int alice = atom_table_lookup(&engine->atoms, "alice");
+        int erin = atom_table_lookup(&engine->atoms, "erin");
+        ASSERT_EQ(count_facts(engine, "grand", -1, -1), 1);
+        ASSERT_EQ(count_facts(engine, "grand", alice, erin), 1);
+        ASSERT_EQ(count_facts(engine, "never", -1, -1), 0);
+        free_engine(engine);
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Negation Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_negation_compile() {
+    char error_buf[256];
+    ASTNode *ast = parse_string(
+        "RULE p: SCAN edge, JOIN edge $1 $2, NOT JOIN edge $2 $0, NOT SCAN seen, EMIT p $0 $2",
+        error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    JoinQuery query;
+    AtomTable atoms;
+    atom_table_init(&atoms);
+    ASSERT(join_rule_needs_query(ast->data.program.statements));
+    ASSERT(join_query_compile(&query, ast->data.program.statements, &atoms,
+                              error_buf, sizeof(error_buf)));
+
+    /* Negations bind nothing and run where their variables are bound */
+    ASSERT_EQ(query.atom_count, 2);
+    ASSERT_EQ(query.filter_count, 2);
+    ASSERT(strcmp(query.filters[0].relation, "seen") == 0);
+    ASSERT_EQ(query.filters[0].slot_a, 0);
+    ASSERT_EQ(query.filters[0].slot_b, 1);
+    ASSERT_EQ(query.filters[0].atom, 0);
+    ASSERT(strcmp(query.filters[1].relation, "edge") == 0);
+    ASSERT_EQ(query.filters[1].slot_a, 2);
+    ASSERT_EQ(query.filters[1].slot_b, 0);
+    ASSERT_EQ(query.filters[1].atom, 1);
+    join_query_free(&query);
+    ast_free_tree(ast);
+
+    ast = parse_string("RULE bad: SCAN edge, NOT JOIN edge $1 $3, EMIT bad $0 $1",
+                       error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+    ASSERT(!join_query_compile(&query, ast->data.program.statements, &atoms,
+                               error_buf, sizeof(error_buf)));
+    ASSERT(strstr(error_buf, "unbound negated variable") != NULL);
+
+    atom_table_free(&atoms);
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_negation_difference() {
+    static const char *program =
+        "FACT x 1 2\nFACT x 2 3\nFACT x 3 4\nFACT x 4 4\nFACT x 5 6\n"
+        "FACT y 2 3\nFACT y 4 4\nFACT y 9 9\n"
+        "RULE only: SCAN x, NOT SCAN y, EMIT only $0 $1\n"
+        "RULE sink: SCAN x, NOT JOIN x $1, EMIT sink $0 $1\n"
+        "SOLVE\n";
+
+    JoinStrategy strategies[] = {JOIN_STRATEGY_AUTO, JOIN_STRATEGY_LEAPFROG};
+    for (int s = 0; s < 2; s++) {
+        ExecutionEngine *engine = run_program(program, strategies[s]);
+        ASSERT(engine != NULL);
+        ASSERT(!engine_has_errors(engine));
+
+        /* x minus y */
+        ASSERT_EQ(count_facts(engine, "only", -1, -1), 3);
+        ASSERT_EQ(count_facts(engine, "only", 1, 2), 1);
+        ASSERT_EQ(count_facts(engine, "only", 3, 4), 1);
+        ASSERT_EQ(count_facts(engine, "only", 2, 3), 0);
+
+        /* Edges into nodes without outgoing edges (4 loops onto itself) */
+        ASSERT_EQ(count_facts(engine, "sink", -1, -1), 1);
+        ASSERT_EQ(count_facts(engine, "sink", 5, 6), 1);
+        free_engine(engine);
+    }
+    return true;
+}
+
+static bool test_negation_stratified() {
+    /* unreached must wait for the whole closure of reach */
+    char *source = chain_program("REL edge");
+    size_t len = strlen(source);
+    source = realloc(source, len + 256);
+    snprintf(source + len, 256,
+             "FACT pair 0 20\nFACT pair 20 0\nFACT pair 5 7\nFACT pair 7 5\n"
+             "RULE unreached: SCAN pair, NOT JOIN reach $0 $1, EMIT unreached $0 $1\n"
+             "SOLVE\n");
+
+    ExecutionEngine *engine = run_program(source, JOIN_STRATEGY_AUTO);
+    free(source);
+    ASSERT(engine != NULL);
+    ASSERT(!engine_has_errors(engine));
+    ASSERT_EQ(count_facts(engine, "reach", 0, 20), 1);
+    ASSERT_EQ(count_facts(engine, "unreached", -1, -1), 2);
+    ASSERT_EQ(count_facts(engine, "unreached", 20, 0), 1);
+    ASSERT_EQ(count_facts(engine, "unreached", 7, 5), 1);
+    free_engine(engine);
+
+    /* Recursion through negation has no stratification */
+    engine = run_program(
+        "FACT q 1 2\n"
+        "RULE p: SCAN q, NOT SCAN r, EMIT p $0 $1\n"
+        "RULE r: SCAN p, EMIT r $1 $2\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+    ASSERT(engine_has_errors(engine));
+    ASSERT(strstr(engine_get_error(engine), "not stratified") != NULL);
+    ASSERT_EQ(count_facts(engine, "p", -1, -1), 0);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Vectorized Execution Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Legacy rule over several column batches, probing hash and sorted joins */
+static bool test_legacy_batches() {
+    const char *declarations[] = {"REL label HASH", "REL label SORTED"};
+    size_t capacity = 3000 * 48 + 256;
+
+    for (int d = 0; d < 2; d++) {
+        char *source = malloc(capacity);
+        size_t len = snprintf(source, capacity, "%s\n", declarations[d]);
+        for (int i = 0; i < 3000; i++) {
+            len += snprintf(source + len, capacity - len, "FACT edge %d %d\n", i, i + 1);
+            if (i % 2 == 0) {
+                len += snprintf(source + len, capacity - len, "FACT label %d %d\n", i, i % 7);
+            }
+        }
+        snprintf(source + len, capacity - len,
+                 "RULE hop: SCAN edge, JOIN label $2, EMIT hop $1 $2\nSOLVE\n");
+
+        ExecutionEngine *engine = run_program(source, JOIN_STRATEGY_AUTO);
+        free(source);
+        ASSERT(engine != NULL);
+        ASSERT(!engine_has_errors(engine));
+        ASSERT_EQ(factdb_get_storage(&engine->facts, "label"),
+                  d == 0 ? RELATION_STORAGE_HASH : RELATION_STORAGE_SORTED);
+
+        /* Odd sources reach an even, labelled target */
+        ASSERT_EQ(count_facts(engine, "hop", -1, -1), 1499);
+        ASSERT_EQ(count_facts(engine, "hop", 1, 2), 1);
+        ASSERT_EQ(count_facts(engine, "hop", 2999, 3000 % 7), 0);
+        ASSERT_EQ(count_facts(engine, "hop", 2997, 2998 % 7), 1);
+        ASSERT_EQ(count_facts(engine, "hop", 0, -1), 0);
+        free_engine(engine);
+    }
+    return true;
+}
+
+/* Batched inserts agree with one-at-a-time inserts on every storage */
+static bool test_insert_batch_agrees() {
+    RelationStorage storages[] = {RELATION_STORAGE_HASH, RELATION_STORAGE_SORTED,
+                                  RELATION_STORAGE_EQUIVALENCE};
+    FactPair pairs[100];
+    unsigned int seed = 5u;
+    for (int i = 0; i < 100; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pairs[i].arg_a = (int)((seed >> 8) % 12u);
+        seed = seed * 1103515245u + 12345u;
+        pairs[i].arg_b = (int)((seed >> 8) % 12u);
+    }
+
+    for (int s = 0; s < 3; s++) {
+        for (int symmetric = 0; symmetric < 2; symmetric++) {
+            FactDatabase single, batched;
+            factdb_init(&single);
+            factdb_init(&batched);
+            ASSERT(factdb_set_storage(&single, "r", storages[s], true));
+            ASSERT(factdb_set_storage(&batched, "r", storages[s], true));
+            if (symmetric) {
+                ASSERT(factdb_set_symmetric(&single, "r"));
+                ASSERT(factdb_set_symmetric(&batched, "r"));
+            }
+
+            /* Seed half so lookups both hit and miss the stored facts */
+            for (int i = 0; i < 50; i++) {
+                factdb_insert(&single, "r", pairs[i].arg_a, pairs[i].arg_b);
+                factdb_insert(&batched, "r", pairs[i].arg_a, pairs[i].arg_b);
+            }
+            factdb_merge(&single);
+            factdb_merge(&batched);
+
+            int inserted[100];
+            int added = 0;
+            for (int i = 0; i < 100; i++) {
+                added += factdb_insert(&single, "r", pairs[i].arg_a, pairs[i].arg_b);
+            }
+            ASSERT_EQ(factdb_insert_batch(&batched, "r", pairs, 100, inserted), added);
+            factdb_merge(&single);
+            factdb_merge(&batched);
+
+            ASSERT_EQ(factdb_count(&batched), factdb_count(&single));
+            for (int i = 0; i < 100; i++) {
+                ASSERT(inserted[i] == 0 || inserted[i] == 1);
+                ASSERT(factdb_has_fact(&batched, "r", pairs[i].arg_a, pairs[i].arg_b));
+            }
+            factdb_cleanup(&single);
+            factdb_cleanup(&batched);
+        }
+    }
+
+    /* A pair repeated within one probe group is added once */
+    FactDatabase db;
+    factdb_init(&db);
+    FactPair twice[2] = {{1, 2}, {1, 2}};
+    int inserted[2];
+    ASSERT_EQ(factdb_insert_batch(&db, "h", twice, 2, inserted), 1);
+    ASSERT_EQ(inserted[0], 1);
+    ASSERT_EQ(inserted[1], 0);
+    ASSERT_EQ(factdb_count(&db), 1);
+    factdb_cleanup(&db);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Concurrent Fact Set Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_factset_basic() {
+    FactSet set;
+    ASSERT(factset_init(&set, 0));
+
+    /* Keys equal to the slot sentinels, (INT_MIN, INT_MIN) and its successor */
+    ASSERT_EQ(factset_insert(&set, 0), 1);
+    ASSERT_EQ(factset_insert(&set, 0), 0);
+    ASSERT_EQ(factset_insert(&set, 1), 1);
+    ASSERT(factset_contains(&set, 1));
+    ASSERT(!factset_contains(&set, 2));
+
+    /* Grow well past the initial table */
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(factset_insert(&set, parallel_pack_pair(i, i * 7)), 1);
+    }
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(factset_insert(&set, parallel_pack_pair(i, i * 7)), 0);
+        ASSERT(factset_contains(&set, parallel_pack_pair(i, i * 7)));
+    }
+    ASSERT(!factset_contains(&set, parallel_pack_pair(3, 4)));
+    ASSERT_EQ(factset_count(&set), 5002);
+
+    /* Clearing keeps the grown table usable */
+    factset_clear(&set);
+    ASSERT_EQ(factset_count(&set), 0);
+    ASSERT(!factset_contains(&set, 0));
+    ASSERT(!factset_contains(&set, parallel_pack_pair(7, 49)));
+    ASSERT_EQ(factset_insert(&set, parallel_pack_pair(7, 49)), 1);
+    ASSERT_EQ(factset_insert(&set, 0), 1);
+
+    factset_free(&set);
+    return true;
+}
+
+typedef struct FactSetRace {
+    FactSet *set;
+    long claimed[PARALLEL_MAX_THREADS];
+    bool failed;
+} FactSetRace;
+
+/* Every worker inserts the same keys in a different order */
+static void factset_race_task(int index, int workers, void *context) {
+    FactSetRace *race = context;
+    (void)workers;
+    for (int i = 0; i < 60000; i++) {
+        int key = (i * 7919 + index * 104729) % 60000;
+        int result = factset_insert(race->set, parallel_pack_pair(key / 100, key % 100));
+        if (result < 0) race->failed = true;
+        if (result > 0) race->claimed[index]++;
+    }
+}
+
+static bool test_factset_concurrent() {
+    FactSet set;
+    ASSERT(factset_init(&set, 0));
+
+    /* The table migrates several times while all workers insert */
+    FactSetRace race = {&set, {0}, false};
+    parallel_run(8, factset_race_task, &race);
+    ASSERT(!race.failed);
+
+    long claimed = 0;
+    for (int w = 0; w < PARALLEL_MAX_THREADS; w++) claimed += race.claimed[w];
+    ASSERT_EQ(claimed, 60000);
+    ASSERT_EQ(factset_count(&set), 60000);
+    for (int key = 0; key < 60000; key++) {
+        ASSERT(factset_contains(&set, parallel_pack_pair(key / 100, key % 100)));
+    }
+
+    factset_free(&set);
+    return true;
+}
+
+/* A compiled rule over a large SCAN gives the same facts on any thread count */
+static bool test_parallel_join_agrees() {
+    size_t capacity = 20000 * 32 + 256;
+    char *source = malloc(capacity);
+    size_t len = snprintf(source, capacity, "REL edge\n");
+    for (int i = 0; i < 20000; i++) {
+        len += snprintf(source + len, capacity - len, "FACT edge %d %d\n", i % 5000, i);
+    }
+    snprintf(source + len, capacity - len,
+             "RULE hop: SCAN edge, JOIN edge $1 $2, EMIT hop $0 $2\nSOLVE\n");
+
+    int counts[2];
+    int threads[2] = {1, 4};
+    for (int t = 0; t < 2; t++) {
+        parallel_set_thread_count(threads[t]);
+        ExecutionEngine *engine = run_program(source, JOIN_STRATEGY_PAIRWISE);
+        parallel_set_thread_count(0);
+        ASSERT(engine != NULL);
+        ASSERT(!engine_has_errors(engine));
+        counts[t] = count_facts(engine, "hop", -1, -1);
+        ASSERT_EQ(count_facts(engine, "hop", 0, 5000), 1);
+        ASSERT_EQ(count_facts(engine, "hop", 0, 10000), 1);
+        ASSERT_EQ(count_facts(engine, "hop", 5000, -1), 0);
+        free_engine(engine);
+    }
+
+    free(source);
+    /* Each key's only successor that is itself a key is the key, so hop
+     * repeats edge */
+    ASSERT_EQ(counts[0], 20000);
+    ASSERT_EQ(counts[1], 20000);
+    return true;
+}
+
+static bool test_parallel_merge_agrees() {
+    int threads[2] = {1, 4};
+    long counts[2][2];
+    FactPair *tuples[2][2];
+    int exported[2][2];
+
+    for (int symmetric = 0; symmetric < 2; symmetric++) {
+        for (int t = 0; t < 2; t++) {
+            FactDatabase db;
+            factdb_init(&db);
+            ASSERT(factdb_set_storage(&db, "r", RELATION_STORAGE_SORTED, true));
+            if (symmetric) ASSERT(factdb_set_symmetric(&db, "r"));
+
+            /* Key 0 is promoted to a posting, the rest stay in the array */
+            for (int i = 0; i < 2000; i++) factdb_insert(&db, "r", 0, i);
+            for (int i = 0; i < 20000; i++) factdb_insert(&db, "r", i % 700 - 100, i % 311);
+            ASSERT(factdb_merge(&db) > 0);
+
+            /* Enough pending inserts, repeats and stored facts included,
+             * for the partitioned merge */
+            unsigned int seed = 11u;
+            for (int i = 0; i < 80000; i++) {
+                seed = seed * 1103515245u + 12345u;
+                int arg_a = (int)((seed >> 8) % 800u) - 150;
+                seed = seed * 1103515245u + 12345u;
+                int arg_b = (int)((seed >> 8) % 3000u);
+                factdb_insert(&db, "r", arg_a, arg_b);
+            }
+            parallel_set_thread_count(threads[t]);
+            int added = factdb_merge(&db);
+            parallel_set_thread_count(0);
+            ASSERT(added > 0);
+
+            counts[symmetric][t] = factdb_count(&db);
+            exported[symmetric][t] = factdb_export(&db, "r", &tuples[symmetric][t]);
+            ASSERT(exported[symmetric][t] > 0);
+            ASSERT(factdb_has_fact(&db, "r", 0, 1999));
+            factdb_cleanup(&db);
+        }
+
+        ASSERT_EQ(counts[symmetric][0], counts[symmetric][1]);
+        ASSERT_EQ(exported[symmetric][0], exported[symmetric][1]);
+        ASSERT(memcmp(tuples[symmetric][0], tuples[symmetric][1],
+                      (size_t)exported[symmetric][0] * sizeof(FactPair)) == 0);
+        free(tuples[symmetric][0]);
+        free(tuples[symmetric][1]);
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Relation Memory Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_relmem_blocks() {
+    /* Small blocks stay on the heap and grow into a mapping */
+    int *values = relmem_alloc(1000 * sizeof(int));
+    ASSERT(values != NULL);
+    ASSERT(relmem_backing(values) == RELMEM_HEAP);
+    for (int i = 0; i < 1000; i++) values[i] = i;
+
+    size_t large = RELMEM_HUGE_PAGE + 12345;
+    values = relmem_realloc(values, large);
+    ASSERT(values != NULL);
+    ASSERT(relmem_backing(values) != RELMEM_HEAP);
+    for (int i = 0; i < 1000; i++) ASSERT_EQ(values[i], i);
+    values[large / sizeof(int) - 1] = 42;
+
+    /* Shrinking within the mapping keeps the block in place */
+    int *same = relmem_realloc(values, large - 4096);
+    ASSERT(same == values);
+    ASSERT_EQ(same[999], 999);
+    relmem_free(same);
+
+    relmem_set_huge_pages(false);
+    void *plain = relmem_alloc(2 * RELMEM_HUGE_PAGE);
+    relmem_set_huge_pages(true);
+    ASSERT(plain != NULL);
+    ASSERT(relmem_backing(plain) == RELMEM_MAPPED);
+    memset(plain, 1, 2 * RELMEM_HUGE_PAGE);
+    relmem_free(plain);
+    relmem_free(NULL);
+    return true;
+}
+
+/* Each worker maps and fills a block of its own */
+static void relmem_local_task(int index, int count, void *context) {
+    (void)count;
+    bool *ok = context;
+    size_t size = 2 * RELMEM_HUGE_PAGE;
+    char *block = relmem_alloc_local(size);
+    ok[index] = block && relmem_backing(block) != RELMEM_HEAP;
+    if (!block) return;
+    memset(block, index, size);
+    ok[index] = ok[index] && block[size - 1] == (char)index;
+    relmem_free(block);
+}
+
+static bool test_relmem_local() {
+    bool ok[4] = {false};
+    parallel_run(4, relmem_local_task, ok);
+    for (int i = 0; i < 4; i++) ASSERT(ok[i]);
+    return true;
+}
+
+static bool test_relmem_spill() {
+    relmem_set_budget(1, NULL);
+    size_t size = 3 * RELMEM_HUGE_PAGE;
+    int *values = relmem_alloc(size);
+    relmem_set_budget(0, NULL);
+    ASSERT(values != NULL);
+    ASSERT(relmem_backing(values) == RELMEM_SPILLED);
+
+    /* Spilled blocks read back what was written and survive a move */
+    for (size_t i = 0; i < size / sizeof(int); i += 1024) values[i] = (int)i;
+    values = relmem_realloc(values, 2 * size);
+    ASSERT(values != NULL);
+    ASSERT(relmem_backing(values) != RELMEM_SPILLED);
+    for (size_t i = 0; i < size / sizeof(int); i += 1024) ASSERT_EQ(values[i], (int)i);
+    relmem_free(values);
+    return true;
+}
+
+static bool test_memory_budget_agrees() {
+    FactDatabase plain, budgeted;
+    factdb_init(&plain);
+    factdb_init(&budgeted);
+    factdb_set_memory_budget(&budgeted, 1, NULL);
+
+    /* Large enough that the budgeted tuple array spills */
+    unsigned int seed = 3u;
+    for (int i = 0; i < 400000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int arg_a = (int)((seed >> 8) % 5000u);
+        seed = seed * 1103515245u + 12345u;
+        int arg_b = (int)((seed >> 8) % 5000u);
+        ASSERT(factdb_insert(&plain, "r", arg_a, arg_b) >= 0);
+        ASSERT(factdb_insert(&budgeted, "r", arg_a, arg_b) >= 0);
+    }
+    ASSERT(factdb_merge(&plain) >= 0);
+    ASSERT(factdb_merge(&budgeted) > 0);
+    factdb_set_memory_budget(&budgeted, 0, NULL);
+
+    ASSERT_EQ(factdb_get_storage(&plain, "r"), RELATION_STORAGE_HASH);
+    ASSERT_EQ(factdb_get_storage(&budgeted, "r"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_count(&budgeted), factdb_count(&plain));
+
+    FactPair *expected, *actual;
+    int expected_count = factdb_export(&plain, "r", &expected);
+    int actual_count = factdb_export(&budgeted, "r", &actual);
+    ASSERT_EQ(actual_count, expected_count);
+    for (int i = 0; i < actual_count; i++) {
+        ASSERT(factdb_has_fact(&plain, "r", actual[i].arg_a, actual[i].arg_b));
+    }
+    free(expected);
+    free(actual);
+    factdb_cleanup(&plain);
+    factdb_cleanup(&budgeted);
+
+    /* Rules derive the same closure with every relation spillable */
+    char *source = chain_program("");
+    char error_buf[512];
+    ASTNode *ast = parse_string(source, error_buf, sizeof(error_buf));
+    free(source);
+    ASSERT(ast != NULL);
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    engine_set_memory_budget(engine, 1, NULL);
+    bool ok = engine_execute_program(engine, ast);
+    engine_set_memory_budget(engine, 0, NULL);
+    ast_free_tree(ast);
+    ASSERT(ok);
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "reach"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(count_facts(engine, "reach", -1, -1), 210);
+    ASSERT_EQ(factdb_count(&engine->facts), 230);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Log Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_factdb_retract() {
+    RelationStorage storages[] = {RELATION_STORAGE_HASH, RELATION_STORAGE_SORTED};
+
+    for (int s = 0; s < 2; s++) {
+        FactDatabase db;
+        factdb_init(&db);
+        ASSERT(factdb_set_storage(&db, "r", storages[s], true));
+        ASSERT(factdb_set_storage(&db, "sym", storages[s], true));
+        ASSERT(factdb_set_symmetric(&db, "sym"));
+
+        /* Key 1 is long enough to be posted in sorted storage */
+        for (int i = 0; i < 2000; i++) factdb_insert(&db, "r", 1, i);
+        factdb_insert(&db, "r", 2, 5);
+        factdb_insert(&db, "sym", 3, 4);
+        ASSERT(factdb_merge(&db) >= 0);
+        ASSERT_EQ(factdb_count(&db), 2003);
+
+        ASSERT_EQ(factdb_retract(&db, "r", 1, 7), 1);
+        ASSERT_EQ(factdb_retract(&db, "r", 1, 7), 0);
+        ASSERT_EQ(factdb_retract(&db, "r", 2, 5), 1);
+        ASSERT_EQ(factdb_retract(&db, "sym", 4, 3), 1);
+        ASSERT_EQ(factdb_retract(&db, "missing", 0, 0), 0);
+        ASSERT(!factdb_has_fact(&db, "r", 1, 7));
+        ASSERT(factdb_has_fact(&db, "r", 1, 8));
+        ASSERT(!factdb_has_fact(&db, "sym", 3, 4));
+        ASSERT_EQ(factdb_count(&db), 1999);
+        ASSERT_EQ(count_facts_db(&db, "r", 1, -1), 1999);
+
+        /* A pending insert is merged before it is retracted */
+        factdb_insert(&db, "r", 9, 9);
+        ASSERT_EQ(factdb_retract(&db, "r", 9, 9), 1);
+        ASSERT_EQ(factdb_count(&db), 1999);
+        factdb_cleanup(&db);
+    }
+
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_set_storage(&db, "eq", RELATION_STORAGE_EQUIVALENCE, true));
+    factdb_insert(&db, "eq", 1, 2);
+    ASSERT_EQ(factdb_retract(&db, "eq", 1, 2), -1);
+    factdb_cleanup(&db);
+    return true;
+}
+
+static ExecutionEngine* open_logged_engine(FactLog *log, const char *dir) {
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    if (!factlog_open(log, dir, engine)) {
+        printf("Log open failed: %s\n", log->error);
+        free_engine(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+static bool test_factlog_recovery() {
+    char dir[] = "/tmp/bytelog-log-XXXXXX";
+    ASSERT(mkdtemp(dir) != NULL);
+    char wal[64], snapshot[64];
+    snprintf(wal, sizeof(wal), "%s/facts.wal", dir);
+    snprintf(snapshot, sizeof(snapshot), "%s/facts.snapshot", dir);
+
+    FactLog log;
+    ExecutionEngine *engine = open_logged_engine(&log, dir);
+    ASSERT(engine != NULL);
+    int alice = atom_table_intern(&engine->atoms, "alice");
+    int bob = atom_table_intern(&engine->atoms, "bob");
+    ASSERT_EQ(factlog_insert(&log, engine, "likes", alice, bob), 1);
+    ASSERT_EQ(factlog_insert(&log, engine, "likes", bob, alice), 1);
+    ASSERT_EQ(factlog_insert(&log, engine, "likes", bob, alice), 0);
+    ASSERT_EQ(factlog_retract(&log, engine, "likes", bob, alice), 1);
+    ASSERT(factlog_close(&log));
+    free_engine(engine);
+
+    /* Replayed from the log alone, atoms keep their IDs */
+    engine = open_logged_engine(&log, dir);
+    ASSERT(engine != NULL);
+    ASSERT_EQ(atom_table_lookup(&engine->atoms, "bob"), bob);
+    ASSERT(factdb_has_fact(&engine->facts, "likes", alice, bob));
+    ASSERT(!factdb_has_fact(&engine->facts, "likes", bob, alice));
+
+    /* After a checkpoint only newer records are in the log */
+    for (int i = 0; i < 1000; i++) factlog_insert(&log, engine, "num", i, i + 1);
+    ASSERT(factlog_checkpoint(&log));
+    ASSERT_EQ(log.wal_bytes, 0);
+    int carol = atom_table_intern(&engine->atoms, "carol");
+    ASSERT_EQ(factlog_insert(&log, engine, "likes", carol, alice), 1);
+    ASSERT_EQ(factlog_retract(&log, engine, "num", 0, 1), 1);
+    ASSERT(factlog_close(&log));
+    free_engine(engine);
+
+    /* A torn record at the tail is dropped */
+    FILE *file = fopen(wal, "ab");
+    ASSERT(file != NULL);
+    fwrite("\x30\x00\x00\x00torn", 1, 8, file);
+    fclose(file);
+
+    engine = open_logged_engine(&log, dir);
+    ASSERT(engine != NULL);
+    ASSERT_EQ(atom_table_lookup(&engine->atoms, "carol"), carol);
+    ASSERT(factdb_has_fact(&engine->facts, "likes", carol, alice));
+    ASSERT(factdb_has_fact(&engine->facts, "likes", alice, bob));
+    ASSERT(!factdb_has_fact(&engine->facts, "num", 0, 1));
+    ASSERT_EQ(count_facts(engine, "num", -1, -1), 999);
+    ASSERT_EQ(factlog_insert(&log, engine, "likes", bob, carol), 1);
+    ASSERT(factlog_close(&log));
+    free_engine(engine);
+
+    /* A damaged snapshot is refused rather than half loaded */
+    file = fopen(snapshot, "r+b");
+    ASSERT(file != NULL);
+    fseek(file, 20, SEEK_SET);
+    fputc(0x7F, file);
+    fclose(file);
+    engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    ASSERT(!factlog_open(&log, dir, engine));
+    free_engine(engine);
+
+    unlink(wal);
+    unlink(snapshot);
+    rmdir(dir);
+    return true;
+}
+
+static bool test_factlog_large_snapshot() {
+    char dir[] = "/tmp/bytelog-log-XXXXXX";
+    ASSERT(mkdtemp(dir) != NULL);
+    char wal[64], snapshot[64];
+    snprintf(wal, sizeof(wal), "%s/facts.wal", dir);
+    snprintf(snapshot, sizeof(snapshot), "%s/facts.snapshot", dir);
+    int count = FACTDB_BULK_SORTED_FACTS * 2;
+
+    FactLog log;
+    ExecutionEngine *engine = open_logged_engine(&log, dir);
+    ASSERT(engine != NULL);
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(factlog_insert(&log, engine, "edge", i % 97, i), 1);
+    }
+    ASSERT_EQ(factdb_get_storage(&log.base, "edge"), RELATION_STORAGE_SORTED);
+
+    /* Facts already logged, pending or merged, are not logged again */
+    ASSERT(factlog_commit(&log));
+    long bytes = log.wal_bytes;
+    ASSERT_EQ(factlog_insert(&log, engine, "edge", 5, 5), 0);
+    ASSERT(factlog_checkpoint(&log));
+    ASSERT_EQ(factlog_insert(&log, engine, "edge", 5, 5), 0);
+    ASSERT(factlog_commit(&log));
+    ASSERT(bytes > 0);
+    ASSERT_EQ(log.wal_bytes, 0);
+    ASSERT(factlog_close(&log));
+    free_engine(engine);
+
+    /* The snapshot loads each relation at once, laid out as an import */
+    engine = open_logged_engine(&log, dir);
+    ASSERT(engine != NULL);
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_relation_size(&engine->facts, "edge"), count);
+    ASSERT_EQ(count_facts_db(&log.base, "edge", -1, -1), count);
+    ASSERT_EQ(count_facts(engine, "edge", 3, -1), count_facts_db(&log.base, "edge", 3, -1));
+    ASSERT(factlog_close(&log));
+    free_engine(engine);
+
+    unlink(wal);
+    unlink(snapshot);
+    rmdir(dir);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fact Import Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool write_file(const char *path, const char *text) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    fputs(text, file);
+    fclose(file);
+    return true;
+}
+
+static bool test_factfile_formats() {
+    char dir[] = "/tmp/bytelog-import-XXXXXX";
+    ASSERT(mkdtemp(dir) != NULL);
+    char tsv[64], csv[64], bad[64];
+    snprintf(tsv, sizeof(tsv), "%s/likes.tsv", dir);
+    snprintf(csv, sizeof(csv), "%s/likes.csv", dir);
+    snprintf(bad, sizeof(bad), "%s/bad.tsv", dir);
+
+    ASSERT(write_file(tsv, "# who likes whom\nalice\tbob\r\n\n bob \t 7\n-3\talice\nalice\tbob\n"));
+    ASSERT(write_file(csv, "\"carol\",alice\n  \n\"12\",\"bob\""));
+    ASSERT(write_file(bad, "alice\tbob\nalice\tbob\tcarol\n"));
+
+    FactDatabase db;
+    AtomTable atoms;
+    char error[256];
+    factdb_init(&db);
+    atom_table_init(&atoms);
+
+    /* Comments, blank lines, CRLF, padding and duplicates */
+    ASSERT_EQ(factfile_load(&db, &atoms, "likes", tsv, error, sizeof(error)), 3);
+    int alice = atom_table_lookup(&atoms, "alice");
+    int bob = atom_table_lookup(&atoms, "bob");
+    ASSERT(alice >= 0 && bob >= 0);
+    ASSERT(factdb_has_fact(&db, "likes", alice, bob));
+    ASSERT(factdb_has_fact(&db, "likes", bob, 7));
+    ASSERT(factdb_has_fact(&db, "likes", -3, alice));
+
+    /* Quoted fields and a missing final newline */
+    ASSERT_EQ(factfile_load(&db, &atoms, "likes", csv, error, sizeof(error)), 2);
+    ASSERT(factdb_has_fact(&db, "likes", atom_table_lookup(&atoms, "carol"), alice));
+    ASSERT(factdb_has_fact(&db, "likes", 12, bob));
+    ASSERT_EQ(count_facts_db(&db, "likes", -1, -1), 5);
+
+    /* Errors name the file and line, and load nothing */
+    ASSERT_EQ(factfile_load(&db, &atoms, "other", bad, error, sizeof(error)), -1);
+    ASSERT(strstr(error, "bad.tsv:2: expected two fields") != NULL);
+    ASSERT_EQ(count_facts_db(&db, "other", -1, -1), 0);
+    ASSERT_EQ(factfile_load(&db, &atoms, "other", "/nonexistent/x.tsv", error, sizeof(error)), -1);
+
+    factdb_cleanup(&db);
+    atom_table_free(&atoms);
+    unlink(tsv);
+    unlink(csv);
+    unlink(bad);
+    rmdir(dir);
+    return true;
+}
+
+static bool test_factfile_parallel_agrees() {
+    char path[] = "/tmp/bytelog-edges-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT(fd >= 0);
+    FILE *file = fdopen(fd, "w");
+    ASSERT(file != NULL);
+
+    /* Past FACTFILE_PARALLEL_BYTES, so chunks split mid-file */
+    unsigned int seed = 5u;
+    for (int i = 0; i < 150000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int a = (int)((seed >> 8) % 5000u);
+        seed = seed * 1103515245u + 12345u;
+        if (i % 3 == 0) {
+            fprintf(file, "n%d\t%d\n", a, (int)((seed >> 8) % 5000u));
+        } else {
+            fprintf(file, "%d\tn%d\n", a, (int)((seed >> 8) % 5000u));
+        }
+    }
+    fclose(file);
+
+    FactDatabase serial, parallel;
+    AtomTable serial_atoms, parallel_atoms;
+    char error[256];
+    factdb_init(&serial);
+    factdb_init(&parallel);
+    atom_table_init(&serial_atoms);
+    atom_table_init(&parallel_atoms);
+
+    parallel_set_thread_count(1);
+    long serial_count = factfile_load(&serial, &serial_atoms, "edge", path, error, sizeof(error));
+    parallel_set_thread_count(4);
+    long parallel_count = factfile_load(&parallel, &parallel_atoms, "edge", path, error, sizeof(error));
+    parallel_set_thread_count(0);
+    ASSERT(serial_count > 100000);
+    ASSERT_EQ(parallel_count, serial_count);
+
+    /* Same facts by name, whatever IDs each table assigned */
+    FactPair *tuples;
+    int count = factdb_export(&serial, "edge", &tuples);
+    ASSERT_EQ(count, serial_count);
+    for (int i = 0; i < count; i++) {
+        int a = tuples[i].arg_a, b = tuples[i].arg_b;
+        const char *name_a = atom_table_name(&serial_atoms, a);
+        const char *name_b = atom_table_name(&serial_atoms, b);
+        if (name_a && name_a[0] == 'n') a = atom_table_lookup(&parallel_atoms, name_a);
+        if (name_b && name_b[0] == 'n') b = atom_table_lookup(&parallel_atoms, name_b);
+        if (!factdb_contains(&parallel, "edge", a, b)) {
+            free(tuples);
+            ASSERT(false);
+        }
+    }
+    free(tuples);
+
+    factdb_cleanup(&serial);
+    factdb_cleanup(&parallel);
+    atom_table_free(&serial_atoms);
+    atom_table_free(&parallel_atoms);
+    unlink(path);
+    return true;
+}
+
+static bool test_engine_load_facts() {
+    char path[] = "/tmp/bytelog-people-XXXXXX.tsv";
+    int fd = mkstemps(path, 4);
+    ASSERT(fd >= 0);
+    close(fd);
+    ASSERT(write_file(path, "dave\terin\nerin\tfrank\n"));
+
+    /* Program atoms resolve against the imported ones */
+    char error_buf[512];
+    ASTNode *ast = parse_string(
+        "REL parent\nREL ancestor\n"
+        "FACT parent alice dave\n"
+        "RULE ancestor: SCAN parent, EMIT ancestor $1 $2\n"
+        "RULE ancestor: SCAN ancestor, JOIN parent $2, EMIT ancestor $1 $2\n"
+        "SOLVE\n", error_buf, sizeof(error_buf));
+    ASSERT(ast != NULL);
+
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    ASSERT(engine_load_facts(engine, "parent", path));
+    ASSERT(engine_execute_program(engine, ast));
+    int alice = atom_table_lookup(&engine->atoms, "alice");
+    int frank = atom_table_lookup(&engine->atoms, "frank");
+    ASSERT(alice >= 0 && frank >= 0 && alice != frank);
+    ASSERT(factdb_has_fact(&engine->facts, "ancestor", alice, frank));
+    ASSERT_EQ(count_facts(engine, "ancestor", -1, -1), 6);
+
+    ASSERT(!engine_load_facts(engine, "parent", "/nonexistent/x.tsv"));
+    ASSERT(engine_has_errors(engine));
+
+    ast_free_tree(ast);
+    free_engine(engine);
+    unlink(path);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Bulk Load Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_bulk_load_agrees() {
+    /* Enough pairs for the parallel pack and the undeclared switch */
+    int count = FACTDB_BULK_SORTED_FACTS * 10;
+    FactPair *pairs = malloc((size_t)count * sizeof(FactPair));
+    ASSERT(pairs != NULL);
+    unsigned int seed = 9u;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pairs[i].arg_a = (int)((seed >> 8) % 3000u);
+        seed = seed * 1103515245u + 12345u;
+        pairs[i].arg_b = (int)((seed >> 8) % 3000u);
+    }
+    /* Hub keys land in postings */
+    for (int i = 0; i < 2000; i++) pairs[i].arg_a = 7;
+    parallel_set_thread_count(4);
+
+    for (int symmetric = 0; symmetric < 2; symmetric++) {
+        FactDatabase single, bulk;
+        factdb_init(&single);
+        factdb_init(&bulk);
+        ASSERT(factdb_set_storage(&single, "r", RELATION_STORAGE_SORTED, true));
+        ASSERT(factdb_set_storage(&bulk, "r", RELATION_STORAGE_SORTED, true));
+        if (symmetric) {
+            ASSERT(factdb_set_symmetric(&single, "r"));
+            ASSERT(factdb_set_symmetric(&bulk, "r"));
+        }
+
+        /* Already stored facts and in-batch duplicates are dropped */
+        for (int i = 0; i < count; i++) factdb_insert(&single, "r", pairs[i].arg_a, pairs[i].arg_b);
+        ASSERT(factdb_bulk_load(&bulk, "r", pairs, count / 2));
+        ASSERT(factdb_merge(&bulk) >= 0);
+        ASSERT(factdb_bulk_load(&bulk, "r", pairs, count));
+        ASSERT(factdb_merge(&single) >= 0);
+        ASSERT(factdb_merge(&bulk) >= 0);
+
+        ASSERT_EQ(factdb_count(&bulk), factdb_count(&single));
+        ASSERT_EQ(factdb_relation_size(&bulk, "r"), factdb_relation_size(&single, "r"));
+        ASSERT_EQ(count_facts_db(&bulk, "r", 7, -1), count_facts_db(&single, "r", 7, -1));
+        for (int i = 0; i < count; i += 97) {
+            ASSERT(factdb_has_fact(&bulk, "r", pairs[i].arg_a, pairs[i].arg_b));
+            ASSERT(factdb_has_fact(&bulk, "r", pairs[i].arg_b, pairs[i].arg_a) ==
+                   factdb_has_fact(&single, "r", pairs[i].arg_b, pairs[i].arg_a));
+        }
+        factdb_cleanup(&single);
+        factdb_cleanup(&bulk);
+    }
+
+    /* Undeclared relations switch to sorted storage only for large loads */
+    FactDatabase db;
+    factdb_init(&db);
+    ASSERT(factdb_bulk_load(&db, "small", pairs, 100));
+    ASSERT(factdb_bulk_load(&db, "large", pairs, count));
+    ASSERT(factdb_set_storage(&db, "kept", RELATION_STORAGE_HASH, true));
+    ASSERT(factdb_bulk_load(&db, "kept", pairs, FACTDB_BULK_SORTED_FACTS));
+    ASSERT(factdb_merge(&db) >= 0);
+    ASSERT_EQ(factdb_get_storage(&db, "small"), RELATION_STORAGE_HASH);
+    ASSERT_EQ(factdb_get_storage(&db, "large"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_get_storage(&db, "kept"), RELATION_STORAGE_HASH);
+    int expected = 0;
+    for (int i = 0; i < 100; i++) expected += factdb_insert(&db, "check", pairs[i].arg_a, pairs[i].arg_b);
+    ASSERT_EQ(count_facts_db(&db, "small", -1, -1), expected);
+    factdb_cleanup(&db);
+    free(pairs);
+    parallel_set_thread_count(0);
+    return true;
+}
+
+static bool test_bulk_program_facts() {
+    /* Program facts agree whether bulk loaded sorted or chained one by one */
+    const char *rules = "RULE back: SCAN edge, EMIT back $1 $0";
+    char *source = random_graph_program(4000, FACTDB_BULK_SORTED_FACTS * 2, 21, rules);
+    size_t length = strlen(source) + 32;
+    char *declared = malloc(length);
+    snprintf(declared, length, "REL edge HASH\n%s", source);
+
+    ExecutionEngine *bulk = run_program(source, JOIN_STRATEGY_AUTO);
+    ExecutionEngine *chained = run_program(declared, JOIN_STRATEGY_AUTO);
+    free(source);
+    free(declared);
+    ASSERT(bulk != NULL && chained != NULL);
+
+    ASSERT_EQ(factdb_get_storage(&bulk->facts, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_get_storage(&chained->facts, "edge"), RELATION_STORAGE_HASH);
+    ASSERT(factdb_relation_size(&bulk->facts, "edge") > FACTDB_BULK_SORTED_FACTS);
+    ASSERT_EQ(factdb_count(&bulk->facts), factdb_count(&chained->facts));
+    ASSERT_EQ(count_facts(bulk, "back", -1, -1), count_facts(chained, "back", -1, -1));
+    free_engine(bulk);
+    free_engine(chained);
+
+    /* A declaration after some facts still converts them */
+    ExecutionEngine *engine = run_program(
+        "FACT likes alice bob\n"
+        "FACT likes bob alice\n"
+        "REL likes SYMMETRIC\n"
+        "FACT likes alice bob\n"
+        "FACT likes carol carol\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+    ASSERT(factdb_is_symmetric(&engine->facts, "likes"));
+    ASSERT_EQ(count_facts(engine, "likes", -1, -1), 3);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Frozen Storage Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Fill one relation of each layout with the same pseudo-random pairs */
+static bool fill_layouts(FactDatabase *db) {
+    const char *names[] = {"hashed", "sorted", "same", "mutual"};
+    if (!factdb_set_storage(db, "sorted", RELATION_STORAGE_SORTED, true) ||
+        !factdb_set_storage(db, "same", RELATION_STORAGE_EQUIVALENCE, true) ||
+        !factdb_set_storage(db, "mutual", RELATION_STORAGE_SORTED, true) ||
+        !factdb_set_symmetric(db, "mutual")) {
+        return false;
+    }
+
+    unsigned int seed = 17u;
+    for (int i = 0; i < 6000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int a = (int)((seed >> 8) % 400u);
+        seed = seed * 1103515245u + 12345u;
+        int b = (int)((seed >> 8) % 400u);
+        for (int r = 0; r < 4; r++) {
+            if (r == 2 && i % 20) continue;
+            if (factdb_insert(db, names[r], a, b) < 0) return false;
+        }
+    }
+    /* A hub key held in a posting */
+    for (int b = 0; b < ROARING_DEGREE_THRESHOLD + 100; b++) {
+        if (factdb_insert(db, "sorted", 5, b * 3) < 0) return false;
+    }
+    return factdb_merge(db) >= 0;
+}
+
+static bool test_freeze_agrees() {
+    const char *names[] = {"hashed", "sorted", "same", "mutual"};
+    FactDatabase live, frozen;
+    factdb_init(&live);
+    factdb_init(&frozen);
+    ASSERT(fill_layouts(&live));
+    ASSERT(fill_layouts(&frozen));
+    ASSERT(factdb_freeze(&frozen));
+
+    ASSERT_EQ(factdb_count(&frozen), factdb_count(&live));
+    for (int r = 0; r < 4; r++) {
+        ASSERT_EQ(factdb_get_storage(&frozen, names[r]), RELATION_STORAGE_FROZEN);
+        ASSERT_EQ(count_facts_db(&frozen, names[r], -1, -1), count_facts_db(&live, names[r], -1, -1));
+        for (int v = 0; v < 400; v += 7) {
+            ASSERT_EQ(count_facts_db(&frozen, names[r], v, -1), count_facts_db(&live, names[r], v, -1));
+            ASSERT_EQ(count_facts_db(&frozen, names[r], -1, v), count_facts_db(&live, names[r], -1, v));
+            for (int w = 0; w < 400; w += 3) {
+                ASSERT(factdb_has_fact(&frozen, names[r], v, w) == factdb_has_fact(&live, names[r], v, w));
+            }
+        }
+
+        /* Export yields every orientation in (arg_a, arg_b) order */
+        FactPair *tuples;
+        int count = factdb_export(&frozen, names[r], &tuples);
+        ASSERT_EQ(count, count_facts_db(&live, names[r], -1, -1));
+        for (int i = 1; i < count; i++) {
+            ASSERT(tuples[i - 1].arg_a < tuples[i].arg_a ||
+                   (tuples[i - 1].arg_a == tuples[i].arg_a && tuples[i - 1].arg_b < tuples[i].arg_b));
+        }
+        free(tuples);
+    }
+    ASSERT_EQ(count_facts_db(&frozen, "sorted", 5, -1), count_facts_db(&live, "sorted", 5, -1));
+    ASSERT(factdb_contains(&frozen, "sorted", 5, 3 * ROARING_DEGREE_THRESHOLD));
+    ASSERT(!factdb_has_fact(&frozen, "missing", 1, 2));
+
+    /* Nothing changes a frozen database */
+    ASSERT_EQ(factdb_insert(&frozen, "sorted", 1000, 1000), -1);
+    ASSERT_EQ(factdb_retract(&frozen, "hashed", 1, 2), -1);
+    ASSERT(!factdb_set_storage(&frozen, "hashed", RELATION_STORAGE_SORTED, true));
+    ASSERT(!factdb_set_symmetric(&frozen, "hashed"));
+    ASSERT_EQ(factdb_count(&frozen), factdb_count(&live));
+
+    factdb_cleanup(&live);
+    factdb_cleanup(&frozen);
+    return true;
+}
+
+typedef struct FrozenReaders {
+    FactDatabase *db;
+    bool failed[PARALLEL_MAX_THREADS];
+} FrozenReaders;
+
+/* Each worker walks the whole relation through a different access path */
+static void frozen_reader_task(int index, int workers, void *context) {
+    FrozenReaders *readers = context;
+    (void)workers;
+    for (int a = 0; a < 300; a++) {
+        int b = (a * 7 + index) % 300;
+        bool expected = (a + b) % 3 == 0;
+        if (factdb_contains(readers->db, "edge", a, b) != expected) readers->failed[index] = true;
+        QueryResult *row = factdb_query(readers->db, "edge", index % 2 ? a : -1, index % 2 ? -1 : a);
+        if (query_result_count(row) != 100) readers->failed[index] = true;
+        query_result_free(row);
+    }
+}
+
+static bool test_freeze_concurrent_readers() {
+    ExecutionEngine *engine = run_program("REL edge\nFACT edge 0 0\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+    for (int a = 0; a < 300; a++) {
+        for (int b = 0; b < 300; b++) {
+            if ((a + b) % 3 == 0) ASSERT(factdb_insert(&engine->facts, "edge", a, b) >= 0);
+        }
+    }
+    ASSERT(engine_freeze(engine));
+    ASSERT(engine_freeze(engine));
+
+    FrozenReaders readers = {&engine->facts, {false}};
+    parallel_run(8, frozen_reader_task, &readers);
+    for (int w = 0; w < PARALLEL_MAX_THREADS; w++) ASSERT(!readers.failed[w]);
+
+    /* Queries still run; statements that write are refused */
+    char error[512];
+    ASTNode *ast = parse_string("FACT edge 1 1\nQUERY edge 3 ?\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    const ASTNode *fact = ast->data.program.statements;
+    ASSERT(!engine_execute_statement(engine, fact));
+    ASSERT(strstr(engine_get_error(engine), "frozen") != NULL);
+    QueryResult *results = engine_query(engine, fact->next);
+    ASSERT_EQ(query_result_count(results), 100);
+    query_result_free(results);
+    ASSERT(!engine_execute_program(engine, ast));
+    ast_free_tree(ast);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Epoch Snapshot Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_epoch_publish() {
+    EpochStore store;
+    ASSERT(epoch_init(&store));
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    engine_set_epochs(engine, &store);
+
+    const EpochSnapshot *empty = epoch_pin(&store, 0);
+    ASSERT_EQ(empty->epoch, 1);
+    ASSERT(!epoch_contains(empty, "edge", 1, 2));
+    epoch_unpin(&store, 0);
+
+    char error[512];
+    ASTNode *ast = parse_string(
+        "REL edge\nREL same EQUIVALENCE\n"
+        "FACT edge 1 2\nFACT edge 2 3\nFACT same 1 2\n"
+        "RULE path: SCAN edge, EMIT path $1 $2\n"
+        "RULE path: SCAN path, JOIN edge $2, EMIT path $1 $2\n"
+        "SOLVE\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    ASSERT(engine_execute_program(engine, ast));
+    ast_free_tree(ast);
+
+    /* Reader 0 keeps the first solved epoch pinned */
+    const EpochSnapshot *first = epoch_pin(&store, 0);
+    ASSERT_EQ(first->epoch, 2);
+    ASSERT_EQ(first->count, factdb_count(&engine->facts));
+    ASSERT(epoch_contains(first, "path", 1, 3));
+    ASSERT(epoch_contains(first, "same", 2, 1));
+    QueryResult *results = epoch_query(first, "path", -1, 3);
+    ASSERT_EQ(query_result_count(results), 2);
+    query_result_free(results);
+
+    /* A change to edge rebuilds edge alone */
+    ASSERT(factdb_insert(&engine->facts, "edge", 3, 4) == 1);
+    ASSERT(epoch_publish(&store, &engine->facts));
+    const EpochSnapshot *second = epoch_pin(&store, 1);
+    ASSERT_EQ(second->epoch, 3);
+    ASSERT(epoch_contains(second, "edge", 3, 4));
+    ASSERT(!epoch_contains(first, "edge", 3, 4));
+    ASSERT(epoch_relation(second, "edge") != epoch_relation(first, "edge"));
+    ASSERT(epoch_relation(second, "path") == epoch_relation(first, "path"));
+    epoch_unpin(&store, 1);
+
+    /* The first snapshot is reclaimed only once reader 0 lets go */
+    ASSERT(epoch_publish(&store, &engine->facts));
+    ASSERT_EQ(epoch_reclaim(&store), 2);
+    ASSERT(epoch_contains(first, "path", 2, 3));
+    epoch_unpin(&store, 0);
+    ASSERT_EQ(epoch_reclaim(&store), 0);
+
+    free_engine(engine);
+    epoch_free(&store);
+    return true;
+}
+
+/* Converting a relation to equivalence classes changes what it answers,
+ * so the next epoch rebuilds it rather than reusing the old rows */
+static bool test_epoch_storage_change() {
+    EpochStore store;
+    ASSERT(epoch_init(&store));
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    engine_set_epochs(engine, &store);
+
+    char error[512];
+    ASTNode *ast = parse_string("FACT same 1 2\nFACT same 2 3\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    ASSERT(engine_execute_program(engine, ast));
+    ast_free_tree(ast);
+
+    const EpochSnapshot *first = epoch_pin(&store, 0);
+    ASSERT(!epoch_contains(first, "same", 1, 3));
+    epoch_unpin(&store, 0);
+
+    ast = parse_string(
+        "RULE same: SCAN same, EMIT same $2 $1\n"
+        "RULE same: SCAN same, JOIN same $1 $2, EMIT same $0 $2\n"
+        "SOLVE\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    ASSERT(engine_execute_program(engine, ast));
+    ast_free_tree(ast);
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "same"), RELATION_STORAGE_EQUIVALENCE);
+
+    const EpochSnapshot *second = epoch_pin(&store, 0);
+    ASSERT(factdb_contains(&engine->facts, "same", 1, 3));
+    ASSERT(epoch_contains(second, "same", 1, 3));
+    ASSERT(epoch_contains(second, "same", 3, 1));
+    ASSERT_EQ(second->count, factdb_count(&engine->facts));
+    epoch_unpin(&store, 0);
+
+    free_engine(engine);
+    epoch_free(&store);
+    return true;
+}
+
+typedef struct EpochRace {
+    EpochStore *store;
+    ExecutionEngine *engine;
+    int rounds;
+    int done;                   /* Set by the writer, read atomically */
+    bool failed[PARALLEL_MAX_THREADS];
+    long reads[PARALLEL_MAX_THREADS];
+} EpochRace;
+
+/* Worker 0 ingests and publishes; the others read whatever is current.
+ * Epoch e holds exactly the facts chain(i, i + 1) for i < e - 1. */
+static void epoch_race_task(int index, int workers, void *context) {
+    EpochRace *race = context;
+    (void)workers;
+    if (index == 0) {
+        for (int i = 0; i < race->rounds; i++) {
+            if (factdb_insert(&race->engine->facts, "chain", i, i + 1) < 0 ||
+                !epoch_publish(race->store, &race->engine->facts)) {
+                race->failed[0] = true;
+            }
+        }
+        __atomic_store_n(&race->done, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    uint64_t last = 0;
+    while (!__atomic_load_n(&race->done, __ATOMIC_ACQUIRE) || race->reads[index] == 0) {
+        const EpochSnapshot *snapshot = epoch_pin(race->store, index);
+        int n = (int)snapshot->epoch - 1;
+        if (snapshot->epoch < last || snapshot->count != n ||
+            (n > 0 && !epoch_contains(snapshot, "chain", n - 1, n)) ||
+            epoch_contains(snapshot, "chain", n, n + 1)) {
+            race->failed[index] = true;
+        }
+        QueryResult *results = epoch_query(snapshot, "chain", -1, -1);
+        if (query_result_count(results) != n) race->failed[index] = true;
+        query_result_free(results);
+        last = snapshot->epoch;
+        epoch_unpin(race->store, index);
+        race->reads[index]++;
+    }
+}
+
+static bool test_epoch_concurrent_readers() {
+    EpochStore store;
+    ASSERT(epoch_init(&store));
+    ExecutionEngine *engine = malloc(sizeof(ExecutionEngine));
+    engine_init(engine);
+    ASSERT(factdb_set_storage(&engine->facts, "chain", RELATION_STORAGE_SORTED, true));
+
+    EpochRace race = {&store, engine, 300, 0, {false}, {0}};
+    parallel_run(4, epoch_race_task, &race);
+    for (int w = 0; w < 4; w++) ASSERT(!race.failed[w]);
+    for (int w = 1; w < 4; w++) ASSERT(race.reads[w] > 0);
+
+    const EpochSnapshot *last = epoch_pin(&store, 0);
+    ASSERT_EQ(last->epoch, 301);
+    epoch_unpin(&store, 0);
+    ASSERT_EQ(epoch_reclaim(&store), 0);
+
+    free_engine(engine);
+    epoch_free(&store);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Query Cache Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Answer a parsed query and check it against an uncached factdb_query */
+static int cached_query(ExecutionEngine *engine, const ASTNode *query, bool *same) {
+    QueryResult *cached = engine_query(engine, query);
+    int count = query_result_count(cached);
+
+    /* Order must match a direct query with the same pattern */
+    int arg_a = query->data.query.atom_a ? atom_table_intern(&engine->atoms, query->data.query.atom_a)
+                                         : query->data.query.arg_a;
+    int arg_b = query->data.query.atom_b ? atom_table_intern(&engine->atoms, query->data.query.atom_b)
+                                         : query->data.query.arg_b;
+    QueryResult *fresh = factdb_query(&engine->facts, query->data.query.relation, arg_a, arg_b);
+    *same = query_result_count(fresh) == count;
+    for (QueryResult *a = cached, *b = fresh; a && b && *same; a = a->next, b = b->next) {
+        *same = a->arg_a == b->arg_a && a->arg_b == b->arg_b;
+    }
+    query_result_free(fresh);
+    query_result_free(cached);
+    return count;
+}
+
+static bool test_query_cache() {
+    ExecutionEngine *engine = run_program(
+        "REL parent\nREL likes\n"
+        "FACT parent alice bob\nFACT parent bob carol\nFACT likes alice carol\n"
+        "RULE ancestor: SCAN parent, EMIT ancestor $1 $2\n"
+        "RULE ancestor: SCAN ancestor, JOIN parent $2, EMIT ancestor $1 $2\n"
+        "SOLVE\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+
+    char error[512];
+    ASTNode *ast = parse_string("QUERY ancestor alice ?\nQUERY likes ? ?\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    const ASTNode *ancestors = ast->data.program.statements;
+    const ASTNode *likes = ancestors->next;
+    bool same;
+    QueryCacheStats stats;
+
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    ASSERT(same);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    ASSERT(same);
+    ASSERT_EQ(cached_query(engine, likes, &same), 1);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.entries, 2);
+    ASSERT_EQ(stats.facts, 3);
+
+    /* A change to ancestor invalidates its answers only */
+    ASSERT(factdb_insert(&engine->facts, "ancestor", atom_table_intern(&engine->atoms, "alice"),
+                         atom_table_intern(&engine->atoms, "dave")) == 1);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 3);
+    ASSERT(same);
+    ASSERT_EQ(cached_query(engine, likes, &same), 1);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.invalidations, 1);
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.misses, 3);
+
+    /* Retracting also counts as a change, even back to the old answer */
+    ASSERT(factdb_retract(&engine->facts, "ancestor", atom_table_intern(&engine->atoms, "alice"),
+                          atom_table_intern(&engine->atoms, "dave")) == 1);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.invalidations, 2);
+
+    /* A one-entry cache evicts; a disabled one keeps no statistics */
+    engine_set_query_cache(engine, 1);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    ASSERT_EQ(cached_query(engine, likes, &same), 1);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.evictions, 2);
+    ASSERT_EQ(stats.entries, 1);
+    engine_set_query_cache(engine, 0);
+    ASSERT_EQ(cached_query(engine, ancestors, &same), 2);
+    ASSERT(same);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.misses, 0);
+
+    ast_free_tree(ast);
+    free_engine(engine);
+    return true;
+}
+
+/* A storage change that alters the answers invalidates them, and a
+ * frozen database, read by concurrent threads, leaves the cache alone */
+static bool test_query_cache_storage_change() {
+    ExecutionEngine *engine = run_program("FACT same a b\nFACT same b c\n", JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+
+    char error[512];
+    ASTNode *query = parse_string("QUERY same a c\n", error, sizeof(error));
+    ASSERT(query != NULL);
+    const ASTNode *closed = query->data.program.statements;
+    bool same;
+    QueryCacheStats stats;
+
+    ASSERT_EQ(cached_query(engine, closed, &same), 0);
+    ASSERT(same);
+
+    ASTNode *ast = parse_string(
+        "RULE same: SCAN same, EMIT same $2 $1\n"
+        "RULE same: SCAN same, JOIN same $1 $2, EMIT same $0 $2\n"
+        "SOLVE\n", error, sizeof(error));
+    ASSERT(ast != NULL);
+    ASSERT(engine_execute_program(engine, ast));
+    ast_free_tree(ast);
+    ASSERT_EQ(factdb_get_storage(&engine->facts, "same"), RELATION_STORAGE_EQUIVALENCE);
+
+    ASSERT_EQ(cached_query(engine, closed, &same), 1);
+    ASSERT(same);
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.invalidations, 1);
+
+    ASSERT(engine_freeze(engine));
+    QueryCacheStats frozen;
+    ASSERT_EQ(cached_query(engine, closed, &same), 1);
+    ASSERT_EQ(cached_query(engine, closed, &same), 1);
+    engine_query_cache_stats(engine, &frozen);
+    ASSERT_EQ(frozen.hits, stats.hits);
+    ASSERT_EQ(frozen.misses, stats.misses);
+
+    ast_free_tree(query);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Prepared Query Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* A prepared query agrees, in order, with the ad hoc query it replaces */
+static bool prepared_agrees(PreparedQuery *prepared, int arg_a, int arg_b) {
+    QueryResult *ran = prepared_query_execute(prepared, arg_a, arg_b);
+    QueryResult *direct = factdb_query(&prepared->engine->facts, prepared->relation,
+                                       prepared->binding_a == QUERY_BOUND ? arg_a : -1,
+                                       prepared->binding_b == QUERY_BOUND ? arg_b : -1);
+    bool same = query_result_count(ran) == query_result_count(direct);
+    for (QueryResult *a = ran, *b = direct; a && b && same; a = a->next, b = b->next) {
+        same = a->arg_a == b->arg_a && a->arg_b == b->arg_b;
+    }
+    query_result_free(ran);
+    query_result_free(direct);
+    return same;
+}
+
+static bool test_prepared_layouts() {
+    ExecutionEngine engine;
+    engine_init(&engine);
+    ASSERT(fill_layouts(&engine.facts));
+
+    const char *names[] = {"hashed", "sorted", "same", "mutual"};
+    const QueryPlan plans[4] = {QUERY_PLAN_SCAN, QUERY_PLAN_SEEK, QUERY_PLAN_SEEK, QUERY_PLAN_PROBE};
+    for (int frozen = 0; frozen < 2; frozen++) {
+        for (int r = 0; r < 4; r++) {
+            for (int shape = 0; shape < 4; shape++) {
+                PreparedQuery *prepared = engine_prepare_query(
+                    &engine, names[r], shape & 1 ? QUERY_BOUND : QUERY_FREE,
+                    shape & 2 ? QUERY_BOUND : QUERY_FREE);
+                ASSERT(prepared != NULL);
+                ASSERT_EQ(prepared->plan, plans[shape]);
+                for (int v = 0; v < 60; v++) {
+                    ASSERT(prepared_agrees(prepared, v, (v * 7) % 400));
+                    ASSERT(prepared_agrees(prepared, 5, v * 3));
+                    if (shape == 0) break;
+                }
+                prepared_query_free(prepared);
+            }
+        }
+        ASSERT(engine_freeze(&engine));
+    }
+
+    engine_cleanup(&engine);
+    return true;
+}
+
+static bool test_prepared_before_facts() {
+    ExecutionEngine engine;
+    engine_init(&engine);
+    PreparedQuery *prepared = engine_prepare_query(&engine, "ancestor", QUERY_BOUND, QUERY_FREE);
+    ASSERT(prepared != NULL);
+    ASSERT(prepared->rel == NULL);
+
+    int alice = atom_table_intern(&engine.atoms, "alice");
+    int bob = atom_table_intern(&engine.atoms, "bob");
+    ASSERT(prepared_query_execute(prepared, alice, -1) == NULL);
+
+    /* The relation is resolved once a fact registers it */
+    ASSERT(factdb_insert(&engine.facts, "ancestor", alice, bob) == 1);
+    QueryResult *results = prepared_query_execute(prepared, alice, 12345);
+    ASSERT_EQ(query_result_count(results), 1);
+    ASSERT_EQ(results->arg_b, bob);
+    ASSERT(prepared->rel != NULL);
+    query_result_free(results);
+    ASSERT(prepared_query_execute(prepared, bob, -1) == NULL);
+
+    prepared_query_free(prepared);
+    ASSERT(engine_prepare_query(&engine, NULL, QUERY_FREE, QUERY_FREE) == NULL);
+    ASSERT(engine_has_errors(&engine));
+    engine_cleanup(&engine);
+    return true;
+}
+
+static bool test_prepared_probe_pending() {
+    ExecutionEngine engine;
+    engine_init(&engine);
+    ASSERT(factdb_set_storage(&engine.facts, "edge", RELATION_STORAGE_SORTED, true));
+    ASSERT(factdb_insert(&engine.facts, "edge", 1, 2) == 1);
+    PreparedQuery *prepared = engine_prepare_query(&engine, "edge", QUERY_BOUND, QUERY_BOUND);
+    ASSERT(prepared != NULL);
+    ASSERT_EQ(prepared->plan, QUERY_PLAN_PROBE);
+
+    /* A fact still pending in a sorted relation is found */
+    ASSERT(factdb_insert(&engine.facts, "edge", 5, 6) == 1);
+    QueryResult *results = prepared_query_execute(prepared, 5, 6);
+    ASSERT_EQ(query_result_count(results), 1);
+    query_result_free(results);
+    results = prepared_query_execute(prepared, 1, 2);
+    ASSERT_EQ(query_result_count(results), 1);
+    query_result_free(results);
+    ASSERT(prepared_query_execute(prepared, 6, 5) == NULL);
+
+    prepared_query_free(prepared);
+    engine_cleanup(&engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Batched Query Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+/* Answer a program's queries as one batch and one at a time; true when
+ * every answer matches in order */
+static bool batch_agrees(ExecutionEngine *engine, const ASTNode *program, int *answered) {
+    const ASTNode *queries[512];
+    QueryResult *batched[512];
+    int count = 0;
+    for (const ASTNode *stmt = program->data.program.statements; stmt && count < 512;
+         stmt = stmt->next) {
+        queries[count++] = stmt;
+    }
+    if (!engine_query_batch(engine, queries, count, batched)) return false;
+
+    bool same = true;
+    *answered = 0;
+    for (int i = 0; i < count; i++) {
+        QueryResult *single = engine_query(engine, queries[i]);
+        same = same && query_result_count(single) == query_result_count(batched[i]);
+        for (QueryResult *a = single, *b = batched[i]; a && b && same; a = a->next, b = b->next) {
+            same = a->arg_a == b->arg_a && a->arg_b == b->arg_b;
+        }
+        *answered += batched[i] != NULL;
+        query_result_free(single);
+        query_result_free(batched[i]);
+    }
+    return same;
+}
+
+static bool test_batch_layouts() {
+    ExecutionEngine engine;
+    engine_init(&engine);
+    engine_set_query_cache(&engine, 0);
+    ASSERT(fill_layouts(&engine.facts));
+
+    /* Every shape over every layout, with repeats and an unknown relation */
+    const char *names[] = {"hashed", "sorted", "same", "mutual", "missing"};
+    char *source = malloc(64 * 512);
+    ASSERT(source != NULL);
+    int length = 0;
+    for (int i = 0; i < 100; i++) {
+        int v = (i * 37) % 50;
+        const char *name = names[i % 5];
+        length += sprintf(source + length, "QUERY %s %d ?\nQUERY %s ? %d\n", name, v, name, v);
+        length += sprintf(source + length, "QUERY %s %d %d\n", name, v, (v * 7) % 400);
+        if (i % 25 == 0) length += sprintf(source + length, "QUERY %s ? ?\n", name);
+    }
+    char error[512];
+    ASTNode *program = parse_string(source, error, sizeof(error));
+    free(source);
+    ASSERT(program != NULL);
+
+    int answered, frozen_answered;
+    ASSERT(batch_agrees(&engine, program, &answered));
+    ASSERT(answered > 100);
+    ASSERT(engine_freeze(&engine));
+    ASSERT(batch_agrees(&engine, program, &frozen_answered));
+    ASSERT_EQ(frozen_answered, answered);
+
+    ast_free_tree(program);
+    engine_cleanup(&engine);
+    return true;
+}
+
+static bool test_batch_cache() {
+    ExecutionEngine *engine = run_program(
+        "REL parent\n"
+        "FACT parent alice bob\nFACT parent bob carol\nFACT parent alice dave\n",
+        JOIN_STRATEGY_AUTO);
+    ASSERT(engine != NULL);
+
+    char error[512];
+    ASTNode *program = parse_string("QUERY parent alice ?\nQUERY parent ? carol\n"
+                                    "QUERY parent alice ?\nQUERY parent ? ?\n",
+                                    error, sizeof(error));
+    ASSERT(program != NULL);
+    const ASTNode *queries[5];
+    QueryResult *results[5];
+    int count = 0;
+    for (const ASTNode *stmt = program->data.program.statements; stmt; stmt = stmt->next) {
+        queries[count++] = stmt;
+    }
+    ASTNode invalid = {0};
+    queries[count++] = &invalid;
+
+    /* Repeats are answered once; a second batch is all cache hits */
+    QueryCacheStats stats;
+    for (int round = 0; round < 2; round++) {
+        ASSERT(!engine_query_batch(engine, queries, count, results));
+        ASSERT_EQ(query_result_count(results[0]), 2);
+        ASSERT_EQ(query_result_count(results[1]), 1);
+        ASSERT_EQ(query_result_count(results[2]), 2);
+        ASSERT_EQ(query_result_count(results[3]), 3);
+        ASSERT(results[4] == NULL);
+        ASSERT(results[0] != results[2]);
+        for (int i = 0; i < count; i++) query_result_free(results[i]);
+    }
+    engine_query_cache_stats(engine, &stats);
+    ASSERT_EQ(stats.misses, 3);
+    ASSERT_EQ(stats.hits, 3);
+
+    ast_free_tree(program);
+    free_engine(engine);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Capacity Hint Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_reserve_layouts() {
+    FactDatabase db;
+    factdb_init(&db);
+
+    /* A large undeclared relation takes sorted storage with room for every
+     * fact pending; small ones and declared hash relations keep chaining */
+    ASSERT(factdb_reserve(&db, "edge", FACTDB_BULK_SORTED_FACTS * 4, 100));
+    ASSERT(factdb_reserve(&db, "small", 10, 0));
+    ASSERT(factdb_set_storage(&db, "kept", RELATION_STORAGE_HASH, true));
+    ASSERT(factdb_reserve(&db, "kept", FACTDB_BULK_SORTED_FACTS * 4, 0));
+    ASSERT_EQ(factdb_get_storage(&db, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(factdb_get_storage(&db, "small"), RELATION_STORAGE_HASH);
+    ASSERT_EQ(factdb_get_storage(&db, "kept"), RELATION_STORAGE_HASH);
+
+    Relation *edge = find_relation(&db, "edge");
+    ASSERT_EQ(edge->delta_capacity, 0);
+    ASSERT_EQ(edge->posting_capacity, FACTDB_BULK_SORTED_FACTS * 4 / ROARING_DEGREE_THRESHOLD);
+
+    /* The first insert sizes the buffer for the hint, so loading up to it
+     * never grows the buffer */
+    ASSERT(factdb_insert(&db, "edge", 0, 0) == 1);
+    ASSERT_EQ(edge->delta_capacity, FACTDB_BULK_SORTED_FACTS * 4);
+    uint64_t *delta = edge->delta;
+    for (int i = 1; i < FACTDB_BULK_SORTED_FACTS * 4; i++) {
+        ASSERT(factdb_insert(&db, "edge", i % 128, i) >= 0);
+    }
+    ASSERT(edge->delta == delta);
+    ASSERT(factdb_merge(&db) >= 0);
+    ASSERT_EQ(factdb_relation_size(&db, "edge"), FACTDB_BULK_SORTED_FACTS * 4);
+    ASSERT_EQ(count_facts_db(&db, "edge", 7, -1), FACTDB_BULK_SORTED_FACTS * 4 / 128);
+
+    /* Hints only grow, and survive a later change of layout */
+    ASSERT(factdb_reserve(&db, "edge", 10, 0));
+    ASSERT_EQ(edge->size_hint, FACTDB_BULK_SORTED_FACTS * 4);
+    ASSERT(factdb_reserve(&db, "same", 0, 500));
+    ASSERT(factdb_set_storage(&db, "same", RELATION_STORAGE_EQUIVALENCE, true));
+    Relation *same = find_relation(&db, "same");
+    ASSERT(same->classes.capacity >= 500);
+    ASSERT(same->classes.slot_capacity >= 1000);
+    int *values = same->classes.values;
+    for (int i = 0; i < 500; i++) ASSERT(factdb_insert(&db, "same", 0, i) >= 0);
+    ASSERT(same->classes.values == values);
+    ASSERT(factdb_has_fact(&db, "same", 17, 499));
+
+    /* A huge hint allocates nothing until used, and then a bounded buffer */
+    ASSERT(factdb_reserve(&db, "huge", FACTDB_MAX_HINT, 0));
+    Relation *huge = find_relation(&db, "huge");
+    ASSERT_EQ(huge->delta_capacity, 0);
+    ASSERT(factdb_insert(&db, "huge", 1, 2) == 1);
+    ASSERT(huge->delta_capacity > 0);
+    ASSERT((size_t)huge->delta_capacity * sizeof(uint64_t) < RELMEM_HUGE_PAGE);
+
+    ASSERT(!factdb_reserve(&db, "edge", -1, 0));
+    ASSERT(!factdb_reserve(&db, "edge", FACTDB_MAX_HINT + 1, 0));
+    ASSERT(!factdb_reserve(&db, "edge", 0, FACTDB_MAX_HINT + 1));
+    ASSERT(factdb_freeze(&db));
+    ASSERT(!factdb_reserve(&db, "edge", 10, 0));
+    factdb_cleanup(&db);
+    return true;
+}
+
+static bool test_reserve_program() {
+    /* SIZE and DOMAIN change allocation, never results */
+    const char *rules = "RULE reach: SCAN edge, EMIT reach $0 $1\n"
+                        "RULE reach: SCAN reach, JOIN edge $1 $2, EMIT reach $0 $2";
+    char *source = random_graph_program(300, 900, 7, rules);
+    size_t length = strlen(source) + 128;
+    char *hinted = malloc(length);
+    snprintf(hinted, length, "REL edge SIZE 20000 DOMAIN 300\nREL reach SORTED SIZE 90000\n%s",
+             source);
+
+    ExecutionEngine *plain = run_program(source, JOIN_STRATEGY_AUTO);
+    ExecutionEngine *sized = run_program(hinted, JOIN_STRATEGY_AUTO);
+    free(source);
+    free(hinted);
+    ASSERT(plain != NULL && sized != NULL);
+    ASSERT(!engine_has_errors(sized));
+
+    ASSERT_EQ(factdb_get_storage(&sized->facts, "edge"), RELATION_STORAGE_SORTED);
+    ASSERT_EQ(find_relation(&sized->facts, "reach")->size_hint, 90000);
+    ASSERT_EQ(factdb_count(&sized->facts), factdb_count(&plain->facts));
+    ASSERT_EQ(count_facts(sized, "reach", -1, -1), count_facts(plain, "reach", -1, -1));
+    ASSERT_EQ(count_facts(sized, "reach", 3, -1), count_facts(plain, "reach", 3, -1));
+
+    ASSERT(engine_reserve(sized, "later", 100, 0));
+    ASSERT(!engine_reserve(sized, "later", -5, 0));
+    ASSERT(strcmp(engine_get_error(sized), "Capacity hint out of range") == 0);
+    ASSERT(!engine_reserve(sized, "later", 0, FACTDB_MAX_HINT + 1));
+    ASSERT(strcmp(engine_get_error(sized), "Capacity hint out of range") == 0);
+    ASSERT(engine_freeze(sized));
+    ASSERT(!engine_reserve(sized, "later", 100, 0));
+    ASSERT(strcmp(engine_get_error(sized), "Database is frozen") == 0);
+    free_engine(plain);
+    free_engine(sized);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Test Runner
+ * ───────────────────────────────────────────────────────────────────────── */
+
+int main(void) {
+    printf("ByteLog Engine Tests\n");
+    printf("═══════════════════════════════════════\n\n");
+
+    /* Basic Evaluation Tests */
+    printf("Basic Evaluation Tests:\n");
+    printf("───────────────────────\n");
+    TEST(facts_loaded);
+    printf("\n");
+
+    /* Multi-way Join Tests */
+    printf("Multi-way Join Tests:\n");
+    printf("─────────────────────\n");
+    TEST(join_query_compile_cyclic);
+    TEST(join_query_compile_unbound);
+    TEST(join_query_slots);
+    TEST(triangle_rule);
+    TEST(explicit_bind_chain);
+    TEST(long_chain_rule);
+    TEST(strategies_agree);
+    TEST(leapfrog_fewer_intermediates);
+    printf("\n");
+
+    /* Relation Storage Tests */
+    printf("Relation Storage Tests:\n");
+    printf("───────────────────────\n");
+    TEST(sorted_relation_queries);
+    TEST(sorted_pending_duplicates);
+    TEST(storage_conversion);
+    TEST(adaptive_storage);
+    TEST(storage_modes_agree);
+    TEST(parallel_radix_sort);
+    printf("\n");
+
+    /* Posting List Tests */
+    printf("Posting List Tests:\n");
+    printf("───────────────────\n");
+    TEST(roaring_bitmap);
+    TEST(posting_promotion);
+    TEST(leapfrog_bitmap_intersection);
+    printf("\n");
+
+    /* Dense Closure Tests */
+    printf("Dense Closure Tests:\n");
+    printf("────────────────────\n");
+    TEST(closure_plan_shapes);
+    TEST(dense_closure_agrees);
+    TEST(dense_closure_long_chain);
+    printf("\n");
+
+    /* Equivalence Storage Tests */
+    printf("Equivalence Storage Tests:\n");
+    printf("──────────────────────────\n");
+    TEST(unionfind_classes);
+    TEST(equivalence_storage);
+    TEST(equivalence_detection);
+    printf("\n");
+
+    /* Symmetric Storage Tests */
+    printf("Symmetric Storage Tests:\n");
+    printf("────────────────────────\n");
+    TEST(symmetric_storage);
+    TEST(symmetric_detection);
+    printf("\n");
+
+    /* Filter Pushdown Tests */
+    printf("Filter Pushdown Tests:\n");
+    printf("──────────────────────\n");
+    TEST(where_pushdown_compile);
+    TEST(where_filter_agrees);
+    TEST(where_program);
+    printf("\n");
+
+    /* Negation Tests */
+    printf("Negation Tests:\n");
+    printf("───────────────\n");
+    TEST(negation_compile);
+    TEST(negation_difference);
+    TEST(negation_stratified);
+    printf("\n");
+
+    /* Vectorized Execution Tests */
+    printf("Vectorized Execution Tests:\n");
+    printf("───────────────────────────\n");
+    TEST(legacy_batches);
+    TEST(insert_batch_agrees);
+    printf("\n");
+
+    /* Concurrent Fact Set Tests */
+    printf("Concurrent Fact Set Tests:\n");
+    printf("──────────────────────────\n");
+    TEST(factset_basic);
+    TEST(factset_concurrent);
+    TEST(parallel_join_agrees);
+    TEST(parallel_merge_agrees);
+    printf("\n");
+
+    /* Relation Memory Tests */
+    printf("Relation Memory Tests:\n");
+    printf("──────────────────────\n");
+    TEST(relmem_blocks);
+    TEST(relmem_local);
+    TEST(relmem_spill);
+    TEST(memory_budget_agrees);
+    printf("\n");
+
+    /* Fact Log Tests */
+    printf("Fact Log Tests:\n");
+    printf("───────────────\n");
+    TEST(factdb_retract);
+    TEST(factlog_recovery);
+    TEST(factlog_large_snapshot);
+    printf("\n");
+
+    /* Fact Import Tests */
+    printf("Fact Import Tests:\n");
+    printf("──────────────────\n");
+    TEST(factfile_formats);
+    TEST(factfile_parallel_agrees);
+    TEST(engine_load_facts);
+    printf("\n");
+
+    /* Bulk Load Tests */
+    printf("Bulk Load Tests:\n");
+    printf("────────────────\n");
+    TEST(bulk_load_agrees);
+    TEST(bulk_program_facts);
+    printf("\n");
+
+    /* Frozen Storage Tests */
+    printf("Frozen Storage Tests:\n");
+    printf("─────────────────────\n");
+    TEST(freeze_agrees);
+    TEST(freeze_concurrent_readers);
+    printf("\n");
+
+    /* Epoch Snapshot Tests */
+    printf("Epoch Snapshot Tests:\n");
+    printf("─────────────────────\n");
+    TEST(epoch_publish);
+    TEST(epoch_storage_change);
+    TEST(epoch_concurrent_readers);
+    printf("\n");
+
+    /* Query Cache Tests */
+    printf("Query Cache Tests:\n");
+    printf("──────────────────\n");
+    TEST(query_cache);
+    TEST(query_cache_storage_change);
+    printf("\n");
+
+    /* Prepared Query Tests */
+    printf("Prepared Query Tests:\n");
+    printf("─────────────────────\n");
+    TEST(prepared_layouts);
+    TEST(prepared_before_facts);
+    TEST(prepared_probe_pending);
+    printf("\n");
+
+    /* Batched Query Tests */
+    printf("Batched Query Tests:\n");
+    printf("────────────────────\n");
+    TEST(batch_layouts);
+    TEST(batch_cache);
+    printf("\n");
+
+    /* Capacity Hint Tests */
+    printf("Capacity Hint Tests:\n");
+    printf("────────────────────\n");
+    TEST(reserve_layouts);
+    TEST(reserve_program);
+    printf("\n");
+
+    printf("Test Results:\n");
+    printf("═════════════\n");
+    printf("Tests run: %d\n", test_count);
+    printf("Tests passed: %d\n", test_passed);
+    printf("Tests failed: %d\n", test_count - test_passed);
+
+    if (test_passed == test_count) {
+        printf("\n✅ All tests passed!\n");
+        return 0;
+    } else {
+        printf("\n❌ Some tests failed!\n");
+        return 1;
+    }
+}
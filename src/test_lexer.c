@@ -126,6 +126,14 @@ static bool test_symbols() {
     return tokenize_and_check(": , ?", expected, values, 3);
 }
 
+static bool test_comparison_operators() {
+    TokenType expected[] = {TOK_LT, TOK_LE, TOK_GT, TOK_GE, TOK_EQ, TOK_EQ,
+                           TOK_NE, TOK_NE};
+    const char *values[] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+    
+    return tokenize_and_check("< <= > >= = == != <>", expected, values, 8);
+}
+
 static bool test_variables() {
     Lexer lexer;
     lexer_init(&lexer, "$0 $1 $42 $123");
@@ -291,6 +299,38 @@ static bool test_rule_statement() {
     return tokenize_and_check(source, expected, values, 14);
 }
 
+static bool test_negated_operation() {
+    const char *source = "NOT SCAN y, not JOIN r $1";
+    
+    TokenType expected[] = {
+        TOK_NOT, TOK_SCAN, TOK_IDENTIFIER, TOK_COMMA,
+        TOK_NOT, TOK_JOIN, TOK_IDENTIFIER, TOK_VARIABLE
+    };
+    
+    const char *values[] = {
+        NULL, NULL, "y", NULL,
+        NULL, NULL, "r", NULL
+    };
+    
+    return tokenize_and_check(source, expected, values, 8);
+}
+
+static bool test_where_operation() {
+    const char *source = "WHERE $1 >= -3, where $0 != alice";
+    
+    TokenType expected[] = {
+        TOK_WHERE, TOK_VARIABLE, TOK_GE, TOK_INTEGER, TOK_COMMA,
+        TOK_WHERE, TOK_VARIABLE, TOK_NE, TOK_IDENTIFIER
+    };
+    
+    const char *values[] = {
+        NULL, NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, "alice"
+    };
+    
+    return tokenize_and_check(source, expected, values, 9);
+}
+
 static bool test_query_statement() {
     Lexer lexer;
     lexer_init(&lexer, "QUERY parent 0 ?");
@@ -475,6 +515,7 @@ int main() {
     TEST(keywords);
     TEST(keywords_case_insensitive);
     TEST(symbols);
+    TEST(comparison_operators);
     TEST(variables);
     TEST(integers);
     TEST(identifiers);
@@ -489,6 +530,8 @@ int main() {
     TEST(fact_statement);
     TEST(rule_statement);
     TEST(query_statement);
+    TEST(where_operation);
+    TEST(negated_operation);
     
     /* Error handling tests */
     TEST(invalid_variable);
@@ -0,0 +1,257 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * test_library.c - Unit Tests for the ByteLog Embedding API
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Tests for bytelog.h, linked against libbytelog.so so that only the
+ * symbols the library exports are reachable.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "bytelog.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Test Framework
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static int test_count = 0;
+static int test_passed = 0;
+
+#define TEST(name) \
+    do { \
+        test_count++; \
+        printf("Test %d: %s ... ", test_count, #name); \
+        if (test_##name()) { \
+            test_passed++; \
+            printf("PASS\n"); \
+        } else { \
+            printf("FAIL\n"); \
+        } \
+    } while(0)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("ASSERTION FAILED: %s\n", #condition); \
+            return false; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(actual, expected) \
+    do { \
+        if ((actual) != (expected)) { \
+            printf("ASSERTION FAILED: %s != %s (got %d, expected %d)\n", \
+                   #actual, #expected, (int)(actual), (int)(expected)); \
+            return false; \
+        } \
+    } while(0)
+
+#define ASSERT_STR_EQ(actual, expected) \
+    do { \
+        if (strcmp((actual), (expected)) != 0) { \
+            printf("ASSERTION FAILED: %s != %s (got '%s', expected '%s')\n", \
+                   #actual, #expected, (actual), (expected)); \
+            return false; \
+        } \
+    } while(0)
+
+static const char *FAMILY =
+    "REL parent\n"
+    "FACT parent alice bob\n"
+    "FACT parent bob carol\n"
+    "FACT parent carol dave\n"
+    "RULE ancestor: SCAN parent, EMIT ancestor $1 $2\n"
+    "RULE ancestor: SCAN ancestor, JOIN parent $2, EMIT ancestor $1 $2\n"
+    "SOLVE\n"
+    "QUERY ancestor alice ?\n";
+
+/* Number of facts matching a pattern, -1 on error */
+static int count_matches(ByteLog *db, const char *relation, const char *a, const char *b) {
+    ByteLogResults *results = bytelog_query(db, relation, a, b);
+    if (!results) return -1;
+    int count = bytelog_results_count(results);
+    bytelog_results_free(results);
+    return count;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Handle Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_load_solve_query() {
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+    ASSERT(bytelog_load_source(db, FAMILY));
+
+    ByteLogResults *results = bytelog_query(db, "ancestor", "alice", NULL);
+    ASSERT(results != NULL);
+    ASSERT_EQ(bytelog_results_count(results), 3);
+
+    /* Iteration yields every fact once, then stops */
+    int a, b, seen = 0;
+    bool found_dave = false;
+    while (bytelog_results_next(results, &a, &b)) {
+        ASSERT_STR_EQ(bytelog_atom_name(db, a), "alice");
+        found_dave = found_dave || strcmp(bytelog_atom_name(db, b), "dave") == 0;
+        seen++;
+    }
+    ASSERT_EQ(seen, 3);
+    ASSERT(found_dave);
+    ASSERT(!bytelog_results_next(results, &a, &b));
+    bytelog_results_free(results);
+
+    ASSERT_EQ(count_matches(db, "ancestor", NULL, "dave"), 3);
+    ASSERT_EQ(count_matches(db, "ancestor", "alice", "dave"), 1);
+    ASSERT_EQ(count_matches(db, "ancestor", NULL, NULL), 6);
+
+    bytelog_free(db);
+    return true;
+}
+
+static bool test_rules_persist() {
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+
+    /* Rules from one load apply to facts from later ones */
+    ASSERT(bytelog_load_source(db,
+        "RULE reach: SCAN edge, EMIT reach $1 $2\n"
+        "RULE reach: SCAN reach, JOIN edge $2, EMIT reach $1 $2\n"));
+    ASSERT(bytelog_load_source(db, "FACT edge a b\nFACT edge b c\nSOLVE\n"));
+    ASSERT_EQ(count_matches(db, "reach", "a", NULL), 2);
+
+    /* Facts added between solves extend the solved state */
+    ASSERT(bytelog_insert(db, "edge", "c", "d"));
+    ASSERT_EQ(count_matches(db, "reach", "a", NULL), 2);
+    ASSERT(bytelog_solve(db));
+    ASSERT_EQ(count_matches(db, "reach", "a", NULL), 3);
+    ASSERT_EQ(count_matches(db, "reach", NULL, "d"), 3);
+
+    bytelog_free(db);
+    return true;
+}
+
+static bool test_atoms_and_integers() {
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+    ASSERT(bytelog_load_source(db, "FACT score alice 42\nFACT score bob 7\n"));
+
+    ASSERT_EQ(count_matches(db, "score", NULL, "42"), 1);
+    ASSERT_EQ(bytelog_atom(db, "42"), 42);
+    ASSERT(bytelog_atom_name(db, 42) == NULL);
+
+    int alice = bytelog_atom(db, "alice");
+    ASSERT_EQ(bytelog_atom(db, "alice"), alice);
+    ByteLogResults *results = bytelog_query_ids(db, "score", alice, BYTELOG_ANY);
+    int a, b;
+    ASSERT(bytelog_results_next(results, &a, &b));
+    ASSERT_EQ(a, alice);
+    ASSERT_EQ(b, 42);
+    bytelog_results_free(results);
+
+    /* Unknown atoms and relations match nothing */
+    ASSERT_EQ(count_matches(db, "score", "zed", NULL), 0);
+    ASSERT_EQ(count_matches(db, "nothing", NULL, NULL), 0);
+
+    bytelog_free(db);
+    return true;
+}
+
+static bool test_load_facts_file() {
+    char path[] = "/tmp/bytelog_library_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT(fd >= 0);
+    const char *rows = "alice\tbob\nbob\tcarol\n";
+    ASSERT(write(fd, rows, strlen(rows)) == (ssize_t)strlen(rows));
+    close(fd);
+
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+    ASSERT(bytelog_load_source(db, "RULE ancestor: SCAN parent, EMIT ancestor $1 $2\n"
+                                   "RULE ancestor: SCAN ancestor, JOIN parent $2, EMIT ancestor $1 $2\n"));
+    bool loaded = bytelog_load_facts(db, "parent", path);
+    unlink(path);
+    ASSERT(loaded);
+    ASSERT(bytelog_solve(db));
+    ASSERT_EQ(count_matches(db, "ancestor", "alice", NULL), 2);
+
+    bytelog_free(db);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Error Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_errors() {
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+
+    ASSERT(!bytelog_load_source(db, "FACT parent alice\n"));
+    ASSERT(strlen(bytelog_error(db)) > 0);
+    ASSERT(!bytelog_load_file(db, "/nonexistent/program.bl"));
+    ASSERT(!bytelog_load_facts(db, "parent", "/nonexistent/facts.tsv"));
+    ASSERT(strlen(bytelog_error(db)) > 0);
+    ASSERT(bytelog_query(db, NULL, NULL, NULL) == NULL);
+
+    /* A failed load leaves the handle usable */
+    ASSERT(bytelog_load_source(db, FAMILY));
+    ASSERT_EQ(count_matches(db, "ancestor", "alice", NULL), 3);
+
+    bytelog_free(db);
+    return true;
+}
+
+static bool test_freeze() {
+    ByteLog *db = bytelog_create();
+    ASSERT(db != NULL);
+    ASSERT(bytelog_load_source(db, FAMILY));
+    ASSERT(bytelog_freeze(db));
+
+    ASSERT_EQ(count_matches(db, "ancestor", "alice", NULL), 3);
+    ASSERT_EQ(count_matches(db, "ancestor", NULL, "carol"), 2);
+    ASSERT(!bytelog_insert(db, "parent", "dave", "erin"));
+    ASSERT_STR_EQ(bytelog_error(db), "Database is frozen");
+    ASSERT(!bytelog_load_source(db, "FACT parent dave erin\n"));
+
+    bytelog_free(db);
+    return true;
+}
+
+int main(void) {
+    printf("ByteLog Library Tests\n");
+    printf("═══════════════════════════════════════\n\n");
+
+    /* Handle Tests */
+    printf("Handle Tests:\n");
+    printf("─────────────\n");
+    TEST(load_solve_query);
+    TEST(rules_persist);
+    TEST(atoms_and_integers);
+    TEST(load_facts_file);
+    printf("\n");
+
+    /* Error Tests */
+    printf("Error Tests:\n");
+    printf("────────────\n");
+    TEST(errors);
+    TEST(freeze);
+    printf("\n");
+
+    printf("Test Results:\n");
+    printf("═════════════\n");
+    printf("Tests run: %d\n", test_count);
+    printf("Tests passed: %d\n", test_passed);
+    printf("Tests failed: %d\n", test_count - test_passed);
+
+    if (test_passed == test_count) {
+        printf("\n✅ All tests passed!\n");
+        return 0;
+    } else {
+        printf("\n❌ Some tests failed!\n");
+        return 1;
+    }
+}
@@ -188,6 +188,79 @@ static bool test_rel_declaration_underscore_names() {
     return true;
 }
 
+static bool test_rel_declaration_attributes() {
+    ASTNode *ast = parse_and_check("REL edge SORTED\nREL node hash\nREL plain\n"
+                                   "REL same Equivalence\nREL road SORTED SYMMETRIC\n"
+                                   "FACT edge 1 2", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *stmt = get_first_statement(ast);
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "edge");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_SORTED);
+    
+    stmt = stmt->next;
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "node");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_HASH);
+    
+    stmt = stmt->next;
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "plain");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, 0);
+    
+    stmt = stmt->next;
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "same");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_EQUIVALENCE);
+    
+    /* SYMMETRIC is not a layout, so it combines with one */
+    stmt = stmt->next;
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "road");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_SORTED | REL_ATTR_SYMMETRIC);
+    ASSERT_EQ(stmt->next->type, AST_FACT);
+    
+    ast_free_tree(ast);
+    
+    /* Unknown and conflicting attributes are rejected */
+    ASSERT(parse_and_check("REL edge BOGUS", false) == NULL);
+    ASSERT(parse_and_check("REL edge SORTED HASH", false) == NULL);
+    ASSERT(parse_and_check("REL edge HASH EQUIVALENCE", false) == NULL);
+    return true;
+}
+
+static bool test_rel_declaration_hints() {
+    ASTNode *ast = parse_and_check("REL edge SIZE 5000000\nREL same EQUIVALENCE domain 300\n"
+                                   "REL road SIZE 10 SORTED DOMAIN 4\nREL plain\n", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *stmt = get_first_statement(ast);
+    ASSERT_STR_EQ(stmt->data.rel_decl.name, "edge");
+    ASSERT_EQ(stmt->data.rel_decl.attributes, 0);
+    ASSERT_EQ(stmt->data.rel_decl.size_hint, 5000000);
+    ASSERT_EQ(stmt->data.rel_decl.domain_hint, 0);
+    
+    stmt = stmt->next;
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_EQUIVALENCE);
+    ASSERT_EQ(stmt->data.rel_decl.size_hint, 0);
+    ASSERT_EQ(stmt->data.rel_decl.domain_hint, 300);
+    
+    /* Hints and attributes mix in any order */
+    stmt = stmt->next;
+    ASSERT_EQ(stmt->data.rel_decl.attributes, REL_ATTR_SORTED);
+    ASSERT_EQ(stmt->data.rel_decl.size_hint, 10);
+    ASSERT_EQ(stmt->data.rel_decl.domain_hint, 4);
+    
+    stmt = stmt->next;
+    ASSERT_EQ(stmt->data.rel_decl.size_hint, 0);
+    ASSERT_EQ(stmt->data.rel_decl.domain_hint, 0);
+    
+    ast_free_tree(ast);
+    
+    /* A hint needs a positive count */
+    ASSERT(parse_and_check("REL edge SIZE", false) == NULL);
+    ASSERT(parse_and_check("REL edge SIZE 0", false) == NULL);
+    ASSERT(parse_and_check("REL edge DOMAIN -3", false) == NULL);
+    ASSERT(parse_and_check("REL edge SIZE many", false) == NULL);
+    return true;
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * FACT Statement Tests
  * ───────────────────────────────────────────────────────────────────────── */
@@ -395,6 +468,115 @@ static bool test_join_high_variable_numbers() {
     return true;
 }
 
+static bool test_join_bind_variable() {
+    ASTNode *ast = parse_and_check("RULE tri: SCAN e, JOIN e $1 $2, JOIN e $2 $0, EMIT tri $0 $1", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *rule = get_first_statement(ast);
+    ASTNode *join1 = rule->data.rule.body->next;
+    ASTNode *join2 = join1->next;
+    
+    ASSERT_NOT_NULL(join1);
+    ASSERT(join1->data.join.has_bind);
+    ASSERT_EQ(join1->data.join.match_var, 1);
+    ASSERT_EQ(join1->data.join.bind_var, 2);
+    
+    ASSERT_NOT_NULL(join2);
+    ASSERT(join2->data.join.has_bind);
+    ASSERT_EQ(join2->data.join.match_var, 2);
+    ASSERT_EQ(join2->data.join.bind_var, 0);
+    
+    /* Single-variable JOIN keeps the implicit binding */
+    ast_free_tree(ast);
+    ast = parse_and_check("RULE t: SCAN r1, JOIN r2 $1, EMIT t $0 $2", true);
+    ASSERT_NOT_NULL(ast);
+    ASSERT(!get_first_statement(ast)->data.rule.body->next->data.join.has_bind);
+    
+    ast_free_tree(ast);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * WHERE Operation Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_where_comparisons() {
+    ASTNode *ast = parse_and_check(
+        "RULE t: SCAN e, JOIN e $1 $2, WHERE $0 < $2, WHERE -5 <= $1, EMIT t $0 $2", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *rule = get_first_statement(ast);
+    ASTNode *where1 = rule->data.rule.body->next->next;
+    ASTNode *where2 = where1->next;
+    
+    ASSERT_EQ(where1->type, AST_WHERE);
+    ASTNode *cond = where1->data.where.condition;
+    ASSERT_EQ(cond->type, AST_CONDITION);
+    ASSERT_EQ(cond->data.condition.op, OP_LT);
+    ASSERT_EQ(cond->data.condition.left->type, AST_EXPR_VAR);
+    ASSERT_EQ(cond->data.condition.left->data.expr.var_num, 0);
+    ASSERT_EQ(cond->data.condition.right->data.expr.var_num, 2);
+    
+    ASSERT_EQ(where2->type, AST_WHERE);
+    cond = where2->data.where.condition;
+    ASSERT_EQ(cond->data.condition.op, OP_LE);
+    ASSERT_EQ(cond->data.condition.left->type, AST_EXPR_INT);
+    ASSERT_EQ(cond->data.condition.left->data.expr.int_val, -5);
+    ASSERT_NULL(where2->next);
+    
+    ast_free_tree(ast);
+    return true;
+}
+
+static bool test_where_atom_operand() {
+    ASTNode *ast = parse_and_check("RULE t: SCAN e, WHERE $0 != alice, EMIT t $0 $1", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *where = get_first_statement(ast)->data.rule.body->next;
+    ASTNode *cond = where->data.where.condition;
+    ASSERT_EQ(cond->data.condition.op, OP_NE);
+    ASSERT_EQ(cond->data.condition.right->type, AST_EXPR_STRING);
+    ASSERT_STR_EQ(cond->data.condition.right->data.expr.string_val, "alice");
+    
+    ast_free_tree(ast);
+    
+    /* A WHERE needs a comparison operator and two operands */
+    ASSERT_NULL(parse_and_check("RULE t: SCAN e, WHERE $0 $1, EMIT t $0 $1", false));
+    ASSERT_NULL(parse_and_check("RULE t: SCAN e, WHERE $0 >, EMIT t $0 $1", false));
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * NOT Operation Tests
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static bool test_not_operations() {
+    ASTNode *ast = parse_and_check(
+        "RULE t: SCAN x, NOT SCAN y, NOT JOIN r $1 $0, EMIT t $0 $1", true);
+    ASSERT_NOT_NULL(ast);
+    
+    ASTNode *not_scan = get_first_statement(ast)->data.rule.body->next;
+    ASSERT_EQ(not_scan->type, AST_NOT);
+    ASSERT_EQ(not_scan->data.negation.operation->type, AST_SCAN);
+    ASSERT_STR_EQ(not_scan->data.negation.operation->data.scan.relation, "y");
+    
+    ASTNode *not_join = not_scan->next;
+    ASSERT_EQ(not_join->type, AST_NOT);
+    ASTNode *join = not_join->data.negation.operation;
+    ASSERT_EQ(join->type, AST_JOIN);
+    ASSERT_STR_EQ(join->data.join.relation, "r");
+    ASSERT(join->data.join.has_bind);
+    ASSERT_EQ(join->data.join.bind_var, 0);
+    ASSERT_NULL(not_join->next);
+    
+    ast_free_tree(ast);
+    
+    /* Only SCAN and JOIN can be negated */
+    ASSERT_NULL(parse_and_check("RULE t: SCAN x, NOT WHERE $0 < 1, EMIT t $0 $1", false));
+    ASSERT_NULL(parse_and_check("RULE t: SCAN x, NOT, EMIT t $0 $1", false));
+    return true;
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * EMIT Operation Tests
  * ───────────────────────────────────────────────────────────────────────── */
@@ -907,6 +1089,8 @@ int main() {
     TEST(rel_declaration_multiple);
     TEST(rel_declaration_case_insensitive);
     TEST(rel_declaration_underscore_names);
+    TEST(rel_declaration_attributes);
+    TEST(rel_declaration_hints);
     printf("\n");
     
     /* FACT statement tests */
@@ -929,6 +1113,18 @@ int main() {
     TEST(join_basic);
     TEST(join_multiple);
     TEST(join_high_variable_numbers);
+    TEST(join_bind_variable);
+    printf("\n");
+    
+    /* WHERE operation tests */
+    printf("Testing WHERE operations:\n");
+    TEST(where_comparisons);
+    TEST(where_atom_operand);
+    printf("\n");
+    
+    /* NOT operation tests */
+    printf("Testing NOT operations:\n");
+    TEST(not_operations);
     printf("\n");
     
     /* EMIT operation tests */
@@ -0,0 +1,181 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+ * unionfind.c - ByteLog Equivalence Classes
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Union by size with path halving, so finds are near O(1) amortized.
+ * Atom values map to dense node numbers through a linear-probing table.
+ * Merging two classes splices their circular member lists by swapping the
+ * roots' next pointers.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "unionfind.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Value Table
+ * ───────────────────────────────────────────────────────────────────────── */
+
+static unsigned int slot_hash(int value, int slot_capacity) {
+    return ((uint32_t)value * 2654435761u) & (unsigned int)(slot_capacity - 1);
+}
+
+static bool slots_resize(UnionFind *uf, int capacity) {
+    int *slots = calloc((size_t)capacity, sizeof(int));
+    if (!slots) return false;
+
+    for (int node = 0; node < uf->count; node++) {
+        unsigned int slot = slot_hash(uf->values[node], capacity);
+        while (slots[slot]) {
+            slot = (slot + 1) & (unsigned int)(capacity - 1);
+        }
+        slots[slot] = node + 1;
+    }
+
+    free(uf->slots);
+    uf->slots = slots;
+    uf->slot_capacity = capacity;
+    return true;
+}
+
+static bool nodes_resize(UnionFind *uf, int capacity) {
+    int *values = realloc(uf->values, (size_t)capacity * sizeof(int));
+    if (values) uf->values = values;
+    int *parent = realloc(uf->parent, (size_t)capacity * sizeof(int));
+    if (parent) uf->parent = parent;
+    int *size = realloc(uf->size, (size_t)capacity * sizeof(int));
+    if (size) uf->size = size;
+    int *next = realloc(uf->next, (size_t)capacity * sizeof(int));
+    if (next) uf->next = next;
+
+    if (!values || !parent || !size || !next) return false;
+    uf->capacity = capacity;
+    return true;
+}
+
+/* Node of a value, creating a singleton class when absent (-1 on error) */
+static int unionfind_add(UnionFind *uf, int value) {
+    int node = unionfind_node(uf, value);
+    if (node >= 0) return node;
+
+    /* Keep the table at most half full */
+    if (2 * (uf->count + 1) > uf->slot_capacity &&
+        !slots_resize(uf, uf->slot_capacity ? uf->slot_capacity * 2 : 64)) {
+        return -1;
+    }
+    if (uf->count == uf->capacity && !nodes_resize(uf, uf->capacity ? uf->capacity * 2 : 32)) {
+        return -1;
+    }
+
+    node = uf->count++;
+    uf->values[node] = value;
+    uf->parent[node] = node;
+    uf->size[node] = 1;
+    uf->next[node] = node;
+    uf->pairs++;
+
+    unsigned int slot = slot_hash(value, uf->slot_capacity);
+    while (uf->slots[slot]) {
+        slot = (slot + 1) & (unsigned int)(uf->slot_capacity - 1);
+    }
+    uf->slots[slot] = node + 1;
+    return node;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Union-Find Implementation
+ * ───────────────────────────────────────────────────────────────────────── */
+
+void unionfind_init(UnionFind *uf) {
+    uf->values = NULL;
+    uf->parent = NULL;
+    uf->size = NULL;
+    uf->next = NULL;
+    uf->count = 0;
+    uf->capacity = 0;
+    uf->slots = NULL;
+    uf->slot_capacity = 0;
+    uf->pairs = 0;
+}
+
+void unionfind_free(UnionFind *uf) {
+    free(uf->values);
+    free(uf->parent);
+    free(uf->size);
+    free(uf->next);
+    free(uf->slots);
+    unionfind_init(uf);
+}
+
+bool unionfind_reserve(UnionFind *uf, int values) {
+    if (values > UNIONFIND_MAX_VALUES) return false;
+
+    int slot_capacity = uf->slot_capacity ? uf->slot_capacity : 64;
+    while (slot_capacity < 2 * values) slot_capacity *= 2;
+    if (slot_capacity > uf->slot_capacity && !slots_resize(uf, slot_capacity)) return false;
+    return values <= uf->capacity || nodes_resize(uf, values);
+}
+
+int unionfind_node(const UnionFind *uf, int value) {
+    if (uf->slot_capacity == 0) return -1;
+
+    unsigned int slot = slot_hash(value, uf->slot_capacity);
+    while (uf->slots[slot]) {
+        int node = uf->slots[slot] - 1;
+        if (uf->values[node] == value) return node;
+        slot = (slot + 1) & (unsigned int)(uf->slot_capacity - 1);
+    }
+    return -1;
+}
+
+int unionfind_root(const UnionFind *uf, int node) {
+    while (uf->parent[node] != node) {
+        node = uf->parent[node];
+    }
+    return node;
+}
+
+/* Root with path halving: every other node on the path skips a level */
+static int unionfind_find(UnionFind *uf, int node) {
+    while (uf->parent[node] != node) {
+        uf->parent[node] = uf->parent[uf->parent[node]];
+        node = uf->parent[node];
+    }
+    return node;
+}
+
+long unionfind_union(UnionFind *uf, int a, int b) {
+    long before = uf->pairs;
+    int node_a = unionfind_add(uf, a);
+    if (node_a < 0) return -1;
+    int node_b = unionfind_add(uf, b);
+    if (node_b < 0) return -1;
+
+    int root_a = unionfind_find(uf, node_a);
+    int root_b = unionfind_find(uf, node_b);
+    if (root_a != root_b) {
+        if (uf->size[root_a] < uf->size[root_b]) {
+            int swap = root_a;
+            root_a = root_b;
+            root_b = swap;
+        }
+
+        uf->pairs += 2L * uf->size[root_a] * uf->size[root_b];
+        uf->parent[root_b] = root_a;
+        uf->size[root_a] += uf->size[root_b];
+
+        int next = uf->next[root_a];
+        uf->next[root_a] = uf->next[root_b];
+        uf->next[root_b] = next;
+    }
+    return uf->pairs - before;
+}
+
+bool unionfind_same(UnionFind *uf, int a, int b) {
+    int node_a = unionfind_node(uf, a);
+    int node_b = unionfind_node(uf, b);
+    if (node_a < 0 || node_b < 0) return false;
+    return unionfind_find(uf, node_a) == unionfind_find(uf, node_b);
+}